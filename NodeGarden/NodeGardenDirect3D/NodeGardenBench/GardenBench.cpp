@@ -0,0 +1,772 @@
+// Headless benchmark for the garden simulation: the node update, connection pass and finish
+// step that XTKRenderer::Update runs every frame, plus the cull test Render does on the result.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenbench GardenBench.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp ../NodeGardenDirect3DComp/CullRect.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp
+//         ../NodeGardenDirect3DComp/AllocationTracker.cpp PerfCounters.cpp -DNODEGARDEN_TRACK_ALLOCATIONS -pthread
+// and add -DNODEGARDEN_PROFILE to compile the profiler scopes in. Without
+// NODEGARDEN_TRACK_ALLOCATIONS the allocation counts are all zero.
+//
+// gardenbench [options]
+//     --nodes 50,100,...          node counts to sweep (default 50 up to 100000)
+//     --distributions a,b,...     uniform, clustered, ring, cell (default all)
+//     --search a,b,...            how the connection pass finds pairs: brute, quadtree, adaptive, or
+//                                 density, which estimates the sums instead (default adaptive, what
+//                                 the app runs); see ConnectionSearch
+//     --max-degree 0              connections kept per node, 0 for no limit; see Garden::SetMaxDegree
+//     --garden-screens 0          fix the garden at this many phone screens of area, 0 to grow it
+//                                 with the node count
+//     --seconds 0.5               minimum time measured per case
+//     --frames 300                maximum frames measured per case
+//     --seed 1
+//     --memory-mb 4096            address space limit per case; a case that runs out reports an error
+//     --output file.json          write the results here instead of stdout
+//     --baseline file.json        compare against an earlier run
+//     --threshold 10              percent slower than the baseline that counts as a regression
+//     --trace folder              write a Chrome trace and scope histograms of each case's
+//                                 measured frames (needs NODEGARDEN_PROFILE)
+//     --counters                  read hardware counters around each step; reported per pair for
+//                                 the connection pass and per node for the others, or with the
+//                                 reason they couldn't be read
+//
+// Each case runs in its own process so peak RSS belongs to that case alone. The JSON has one
+// case per line. With --baseline the exit code is 2 if any case regressed; baseline cases
+// from before --search existed count as brute, from before --max-degree as uncapped, and
+// from before --garden-screens as grown.
+//
+// The cull test always looks at one screen in the middle of the garden, so by default, with
+// the garden growing to keep density level, the share drawn falls as the nodes go up.
+// --garden-screens 10 holds the garden at ten screens instead, the case Render's culling is
+// there for: the view stays put and the nodes crowd in, and nodes_drawn and lines_drawn
+// against the node and connection counts show how much of the frame the cull saves for
+// cull_ns.
+
+#include "Garden.h"
+#include "CullRect.h"
+#include "Scenario.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "PerfCounters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    std::vector<ConnectionSearch> Searches;
+    int MaxDegree;
+    float GardenScreens;
+    double Seconds;
+    int MaxFrames;
+    uint32_t Seed;
+    int MemoryMB;
+    const char* OutputPath;
+    const char* BaselinePath;
+    double Threshold;
+    const char* TracePath;
+    bool Counters;
+};
+
+// Written by the child process straight in to the pipe, so plain data only
+struct CaseResult
+{
+    int Ok;
+    int Frames;
+    double UpdateNs;            // per frame, for each step
+    double ConnectNs;
+    double FinishNs;
+    double CullNs;
+    double UpdateAllocs;        // per frame, for each step
+    double ConnectAllocs;
+    double FinishAllocs;
+    double CullAllocs;
+    double BytesPerFrame;
+    int CountersOpen;           // bit per PerfCounter
+    char CounterError[96];
+    double UpdateCounters[PerfCounter_Count];   // per frame, for each step
+    double ConnectCounters[PerfCounter_Count];
+    double FinishCounters[PerfCounter_Count];
+    double PairsPerFrame;
+    double QuadtreeFrames;      // fraction of frames the connection pass used the quadtree
+    double QuadtreeBuilds;      // per frame
+    double ConnectionsPerFrame;
+    int LargestDegree;          // most connections any one node had, on the last frame
+    double NodesDrawnPerFrame;
+    double LinesDrawnPerFrame;
+    long PeakRssKB;
+    char Error[64];
+};
+
+struct BaselineCase
+{
+    std::string Distribution;
+    std::string Search;
+    int MaxDegree;
+    float GardenScreens;
+    int Nodes;
+    double NsPerFrame;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static const int WarmupFrames = 2;
+static const float FrameDelta = 1.0f / 60.0f;
+static const int DefaultNodeCounts[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+static const char* SearchNames[] = { "brute", "quadtree", "adaptive", "density" };
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void Cull(const Garden& garden, const CullRect& visible, int* nodesDrawn, int* linesDrawn)
+{
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (visible.IntersectsCircle(nodes[i].X, nodes[i].Y, Garden::GetDrawRadius(nodes[i])))
+            (*nodesDrawn)++;
+    }
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const GardenNode& node1 = nodes[edges[i].First];
+        const GardenNode& node2 = nodes[edges[i].Second];
+
+        // same stroke LineConnection draws with
+        float stroke = Garden::Map(edges[i].Distance, 0, Garden::MinDist, 7.0f, 2.0f);
+        if (visible.IntersectsSegment(node1.X, node1.Y, node2.X, node2.Y, stroke))
+            (*linesDrawn)++;
+    }
+}
+
+static void RunCase(const Options& options, Distribution distribution, int nodeCount, ConnectionSearch search, CaseResult* result)
+{
+    Garden garden;
+    garden.SetConnectionSearch(search);
+    garden.SetMaxDegree(options.MaxDegree);
+    if (options.GardenScreens > 0)
+        Scenario::Populate(garden, distribution, nodeCount, options.Seed, options.GardenScreens);
+    else
+        Scenario::Populate(garden, distribution, nodeCount, options.Seed);
+
+    // the phone's view of the middle of the garden
+    float left = (garden.GetWidth() - Scenario::ScreenWidth) / 2;
+    float top = (garden.GetHeight() - Scenario::ScreenHeight) / 2;
+    CullRect visible(left, top, left + Scenario::ScreenWidth, top + Scenario::ScreenHeight);
+
+    float timeTotal = 0;
+    for (int i = 0; i < WarmupFrames; i++)
+    {
+        timeTotal += FrameDelta;
+        garden.Update(timeTotal, FrameDelta);
+    }
+
+    double updateNs = 0, connectNs = 0, finishNs = 0, cullNs = 0;
+    uint64_t updateAllocs = 0, connectAllocs = 0, finishAllocs = 0, cullAllocs = 0;
+    uint64_t startBytes = AllocationTracker::GetBytes();
+
+    // opened here so they count this process's own thread
+    PerfCounters counters;
+    PerfSample updateCounters = PerfSample(), connectCounters = PerfSample(), finishCounters = PerfSample();
+    PerfSample before, after, delta;
+    bool readCounters = options.Counters && counters.Open();
+    double pairs = 0, connections = 0;
+    int quadtreeFrames = 0;
+    uint32_t builds = garden.GetQuadtree().GetBuildCount();
+    int nodesDrawn = 0, linesDrawn = 0;
+    int frames = 0;
+    double minimumNs = options.Seconds * 1e9;
+
+    if (options.TracePath != nullptr)
+        Profiler::StartCapture(options.MaxFrames);
+
+    while (frames < options.MaxFrames && (frames == 0 || updateNs + connectNs + finishNs < minimumNs))
+    {
+        timeTotal += FrameDelta;
+
+        // counters are read between the clock reads, so the syscalls aren't timed
+        if (readCounters)
+            counters.Read(&before);
+
+        uint64_t allocs = AllocationTracker::GetCount();
+        Clock::time_point start = Clock::now();
+        garden.UpdateNodes(FrameDelta);
+        Clock::time_point updated = Clock::now();
+
+        if (readCounters)
+        {
+            counters.Read(&after);
+            PerfCounters::Subtract(after, before, &delta);
+            PerfCounters::Add(delta, &updateCounters);
+            before = after;
+        }
+
+        uint64_t updatedAllocs = AllocationTracker::GetCount();
+        Clock::time_point connectStart = Clock::now();
+        garden.FindConnections();
+        Clock::time_point connected = Clock::now();
+
+        if (readCounters)
+        {
+            counters.Read(&after);
+            PerfCounters::Subtract(after, before, &delta);
+            PerfCounters::Add(delta, &connectCounters);
+            before = after;
+        }
+
+        uint64_t connectedAllocs = AllocationTracker::GetCount();
+        Clock::time_point finishStart = Clock::now();
+        garden.FinishConnections();
+        Clock::time_point finished = Clock::now();
+
+        if (readCounters)
+        {
+            counters.Read(&after);
+            PerfCounters::Subtract(after, before, &delta);
+            PerfCounters::Add(delta, &finishCounters);
+        }
+
+        uint64_t finishedAllocs = AllocationTracker::GetCount();
+        Cull(garden, visible, &nodesDrawn, &linesDrawn);
+        Clock::time_point culled = Clock::now();
+
+        updateAllocs += updatedAllocs - allocs;
+        connectAllocs += connectedAllocs - updatedAllocs;
+        finishAllocs += finishedAllocs - connectedAllocs;
+        cullAllocs += AllocationTracker::GetCount() - finishedAllocs;
+
+        updateNs += Elapsed(start, updated);
+        connectNs += Elapsed(connectStart, connected);
+        finishNs += Elapsed(finishStart, finished);
+        cullNs += Elapsed(finished, culled);
+        pairs += (double)garden.GetPairsTested();
+        quadtreeFrames += garden.GetLastSearch() == ConnectionSearch_Quadtree ? 1 : 0;
+        connections += (double)garden.GetEdges().size();
+        frames++;
+
+        Profiler::EndFrame();
+    }
+
+    if (options.TracePath != nullptr)
+    {
+        Profiler::StopCapture();
+
+        char name[64];
+        snprintf(name, sizeof(name), "/trace_%s_%d", DistributionName(distribution), nodeCount);
+        Profiler::WriteChromeTrace(std::string(options.TracePath) + name + ".json");
+        Profiler::WriteHistograms(std::string(options.TracePath) + name + ".txt");
+    }
+
+    result->Ok = 1;
+    result->Frames = frames;
+    result->UpdateNs = updateNs / frames;
+    result->ConnectNs = connectNs / frames;
+    result->FinishNs = finishNs / frames;
+    result->CullNs = cullNs / frames;
+    result->UpdateAllocs = (double)updateAllocs / frames;
+    result->ConnectAllocs = (double)connectAllocs / frames;
+    result->FinishAllocs = (double)finishAllocs / frames;
+    result->CullAllocs = (double)cullAllocs / frames;
+    result->BytesPerFrame = (double)(AllocationTracker::GetBytes() - startBytes) / frames;
+    result->PairsPerFrame = pairs / frames;
+    result->QuadtreeFrames = (double)quadtreeFrames / frames;
+    result->QuadtreeBuilds = (double)(garden.GetQuadtree().GetBuildCount() - builds) / frames;
+
+    if (options.Counters)
+        snprintf(result->CounterError, sizeof(result->CounterError), "%s", counters.GetError());
+
+    for (int i = 0; readCounters && i < PerfCounter_Count; i++)
+    {
+        if (counters.IsAvailable((PerfCounter)i))
+            result->CountersOpen |= 1 << i;
+
+        result->UpdateCounters[i] = (double)updateCounters.Values[i] / frames;
+        result->ConnectCounters[i] = (double)connectCounters.Values[i] / frames;
+        result->FinishCounters[i] = (double)finishCounters.Values[i] / frames;
+    }
+    result->ConnectionsPerFrame = connections / frames;
+
+    std::vector<int> degrees(garden.GetNodeCount(), 0);
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        degrees[edges[i].First]++;
+        degrees[edges[i].Second]++;
+    }
+    result->LargestDegree = degrees.empty() ? 0 : *std::max_element(degrees.begin(), degrees.end());
+    result->NodesDrawnPerFrame = (double)nodesDrawn / frames;
+    result->LinesDrawnPerFrame = (double)linesDrawn / frames;
+}
+
+static void RunCaseInChild(const Options& options, Distribution distribution, int nodeCount, ConnectionSearch search, CaseResult* result)
+{
+    memset(result, 0, sizeof(*result));
+
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        snprintf(result->Error, sizeof(result->Error), "pipe failed");
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        snprintf(result->Error, sizeof(result->Error), "fork failed");
+        return;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+
+        // fail with bad_alloc rather than waking the OOM killer; the all-in-one-cell case
+        // keeps N*(N-1)/2 edges
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = (rlim_t)options.MemoryMB * 1024 * 1024;
+        setrlimit(RLIMIT_AS, &limit);
+
+        CaseResult childResult;
+        memset(&childResult, 0, sizeof(childResult));
+        try
+        {
+            RunCase(options, distribution, nodeCount, search, &childResult);
+        }
+        catch (const std::bad_alloc&)
+        {
+            childResult.Ok = 0;
+            snprintf(childResult.Error, sizeof(childResult.Error), "out of memory");
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        childResult.PeakRssKB = usage.ru_maxrss;
+
+        ssize_t written = write(fds[1], &childResult, sizeof(childResult));
+        _exit(written == (ssize_t)sizeof(childResult) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (got != (ssize_t)sizeof(*result))
+    {
+        memset(result, 0, sizeof(*result));
+        if (WIFSIGNALED(status))
+            snprintf(result->Error, sizeof(result->Error), "killed by signal %d", WTERMSIG(status));
+        else
+            snprintf(result->Error, sizeof(result->Error), "no result");
+    }
+}
+
+static bool ParseNodeCounts(const char* text, std::vector<int>* counts)
+{
+    counts->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long count = strtol(text, &end, 10);
+        if (end == text || count < 1)
+            return false;
+
+        counts->push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !counts->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseSearches(const char* text, std::vector<ConnectionSearch>* searches)
+{
+    searches->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        std::string name = list.substr(start, comma - start);
+        size_t i = 0;
+        while (i < sizeof(SearchNames) / sizeof(SearchNames[0]) && name != SearchNames[i])
+        {
+            i++;
+        }
+        if (i == sizeof(SearchNames) / sizeof(SearchNames[0]))
+            return false;
+
+        searches->push_back((ConnectionSearch)i);
+        start = comma + 1;
+    }
+
+    return !searches->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Distributions.clear();
+    for (int i = 0; i < Distribution_Count; i++)
+    {
+        options->Distributions.push_back((Distribution)i);
+    }
+    options->Searches.assign(1, ConnectionSearch_Adaptive);
+    options->MaxDegree = 0;
+    options->GardenScreens = 0;
+    options->Seconds = 0.5;
+    options->MaxFrames = 300;
+    options->Seed = 1;
+    options->MemoryMB = 4096;
+    options->OutputPath = nullptr;
+    options->BaselinePath = nullptr;
+    options->Threshold = 10;
+    options->TracePath = nullptr;
+    options->Counters = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (strcmp(name, "--counters") == 0)
+        {
+            options->Counters = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseNodeCounts(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--search") == 0)
+        {
+            if (!ParseSearches(value, &options->Searches))
+                return false;
+        }
+        else if (strcmp(name, "--max-degree") == 0)
+            options->MaxDegree = atoi(value) > 0 ? atoi(value) : 0;
+        else if (strcmp(name, "--garden-screens") == 0)
+            options->GardenScreens = atof(value) > 0 ? (float)atof(value) : 0;
+        else if (strcmp(name, "--seconds") == 0)
+            options->Seconds = atof(value);
+        else if (strcmp(name, "--frames") == 0)
+            options->MaxFrames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(name, "--memory-mb") == 0)
+            options->MemoryMB = atoi(value);
+        else if (strcmp(name, "--output") == 0)
+            options->OutputPath = value;
+        else if (strcmp(name, "--baseline") == 0)
+            options->BaselinePath = value;
+        else if (strcmp(name, "--threshold") == 0)
+            options->Threshold = atof(value);
+        else if (strcmp(name, "--trace") == 0)
+            options->TracePath = value;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+// Only needs to read what WriteCase writes: one case per line
+static bool FindValue(const char* line, const char* key, std::string* value)
+{
+    std::string pattern = std::string("\"") + key + "\": ";
+    const char* found = strstr(line, pattern.c_str());
+    if (found == nullptr)
+        return false;
+
+    found += pattern.size();
+    const char* end = found;
+    if (*found == '"')
+    {
+        found++;
+        end = strchr(found, '"');
+        if (end == nullptr)
+            return false;
+    }
+    else
+    {
+        end = found + strcspn(found, ",}");
+    }
+
+    value->assign(found, end);
+    return true;
+}
+
+static bool LoadBaseline(const char* path, std::vector<BaselineCase>* cases)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr)
+        return false;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        std::string distribution, search, maxDegree, gardenScreens, nodes, nsPerFrame;
+        if (FindValue(line, "distribution", &distribution) && FindValue(line, "nodes", &nodes) && FindValue(line, "ns_per_frame", &nsPerFrame))
+        {
+            BaselineCase baseline;
+            baseline.Distribution = distribution;
+            baseline.Search = FindValue(line, "search", &search) ? search : SearchNames[ConnectionSearch_BruteForce];
+            baseline.MaxDegree = FindValue(line, "max_degree", &maxDegree) ? atoi(maxDegree.c_str()) : 0;
+            baseline.GardenScreens = FindValue(line, "garden_screens", &gardenScreens) ? (float)atof(gardenScreens.c_str()) : 0;
+            baseline.Nodes = atoi(nodes.c_str());
+            baseline.NsPerFrame = atof(nsPerFrame.c_str());
+            cases->push_back(baseline);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+static const BaselineCase* FindBaseline(const std::vector<BaselineCase>& cases, Distribution distribution, int nodeCount, ConnectionSearch search, int maxDegree, float gardenScreens)
+{
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        if (cases[i].Nodes == nodeCount && cases[i].Distribution == DistributionName(distribution) && cases[i].Search == SearchNames[search] &&
+            cases[i].MaxDegree == maxDegree && cases[i].GardenScreens == gardenScreens)
+            return &cases[i];
+    }
+
+    return nullptr;
+}
+
+// What an empty scope costs while a capture is running, and while one isn't
+static void MeasureScopeCost(double* capturingNs, double* idleNs)
+{
+    const int iterations = 1000000;
+
+    Profiler::StartCapture(1);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        PROFILE_SCOPE("Overhead");
+    }
+    Clock::time_point captured = Clock::now();
+    Profiler::StopCapture();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        PROFILE_SCOPE("Overhead");
+    }
+    Clock::time_point idle = Clock::now();
+
+    *capturingNs = Elapsed(start, captured) / iterations;
+    *idleNs = Elapsed(captured, idle) / iterations;
+}
+
+// one object of counters divided by what they're per; null for counters that didn't open
+static void WriteCounters(FILE* out, const char* name, const double* values, double per, int open)
+{
+    fprintf(out, ", \"%s\": {", name);
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        fprintf(out, "%s\"%s\": ", i > 0 ? ", " : "", PerfCounterName((PerfCounter)i));
+        if ((open & (1 << i)) != 0 && per > 0)
+            fprintf(out, "%.4g", values[i] / per);
+        else
+            fprintf(out, "null");
+    }
+    fprintf(out, "}");
+}
+
+static void WriteCase(FILE* out, Distribution distribution, int nodeCount, ConnectionSearch search, int maxDegree, float gardenScreens,
+    const CaseResult& result, const BaselineCase* baseline, bool last)
+{
+    fprintf(out, "    {\"distribution\": \"%s\", \"nodes\": %d, \"search\": \"%s\", \"max_degree\": %d, \"garden_screens\": %g",
+        DistributionName(distribution), nodeCount, SearchNames[search], maxDegree, gardenScreens);
+
+    if (!result.Ok)
+    {
+        fprintf(out, ", \"error\": \"%s\", \"peak_rss_kb\": %ld}%s\n", result.Error, result.PeakRssKB, last ? "" : ",");
+        return;
+    }
+
+    double nsPerFrame = result.UpdateNs + result.ConnectNs + result.FinishNs;
+    fprintf(out, ", \"frames\": %d, \"ns_per_frame\": %.1f, \"update_ns\": %.1f, \"connect_ns\": %.1f, \"finish_ns\": %.1f",
+        result.Frames, nsPerFrame, result.UpdateNs, result.ConnectNs, result.FinishNs);
+    fprintf(out, ", \"pairs_per_frame\": %.0f, \"pairs_per_second\": %.4g, \"connections_per_frame\": %.1f",
+        result.PairsPerFrame, result.ConnectNs > 0 ? result.PairsPerFrame * 1e9 / result.ConnectNs : 0.0, result.ConnectionsPerFrame);
+    fprintf(out, ", \"largest_degree\": %d", result.LargestDegree);
+    fprintf(out, ", \"quadtree_frames\": %.3f, \"quadtree_builds_per_frame\": %.3f", result.QuadtreeFrames, result.QuadtreeBuilds);
+    fprintf(out, ", \"cull_ns\": %.1f, \"nodes_drawn\": %.1f, \"lines_drawn\": %.1f, \"peak_rss_kb\": %ld",
+        result.CullNs, result.NodesDrawnPerFrame, result.LinesDrawnPerFrame, result.PeakRssKB);
+    fprintf(out, ", \"update_allocs\": %.2f, \"connect_allocs\": %.2f, \"finish_allocs\": %.2f, \"cull_allocs\": %.2f, \"alloc_bytes_per_frame\": %.0f",
+        result.UpdateAllocs, result.ConnectAllocs, result.FinishAllocs, result.CullAllocs, result.BytesPerFrame);
+
+    if (result.CountersOpen != 0)
+    {
+        WriteCounters(out, "connect_counters_per_pair", result.ConnectCounters, result.PairsPerFrame, result.CountersOpen);
+        WriteCounters(out, "update_counters_per_node", result.UpdateCounters, nodeCount, result.CountersOpen);
+        WriteCounters(out, "finish_counters_per_node", result.FinishCounters, nodeCount, result.CountersOpen);
+    }
+    if (result.CounterError[0] != 0)
+        fprintf(out, ", \"counters_error\": \"%s\"", result.CounterError);
+
+    if (baseline != nullptr && baseline->NsPerFrame > 0)
+    {
+        fprintf(out, ", \"baseline_ns_per_frame\": %.1f, \"change_percent\": %.1f",
+            baseline->NsPerFrame, (nsPerFrame / baseline->NsPerFrame - 1) * 100);
+    }
+
+    fprintf(out, "}%s\n", last ? "" : ",");
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 50,100,...] [--distributions uniform,clustered,ring,cell]\n"
+                        "       [--search brute,quadtree,adaptive,density] [--max-degree k] [--garden-screens n] [--seconds s] [--frames n]\n"
+                        "       [--seed n] [--memory-mb n] [--output file] [--baseline file] [--threshold percent] [--trace folder]\n"
+                        "       [--counters]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<BaselineCase> baseline;
+    if (options.BaselinePath != nullptr && !LoadBaseline(options.BaselinePath, &baseline))
+    {
+        fprintf(stderr, "can't read baseline %s\n", options.BaselinePath);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (options.OutputPath != nullptr)
+    {
+        out = fopen(options.OutputPath, "w");
+        if (out == nullptr)
+        {
+            fprintf(stderr, "can't write %s\n", options.OutputPath);
+            return 1;
+        }
+    }
+
+    double scopeNs, idleScopeNs;
+    MeasureScopeCost(&scopeNs, &idleScopeNs);
+
+    fprintf(out, "{\n  \"benchmark\": \"garden\",\n  \"seed\": %u,\n", options.Seed);
+    fprintf(out, "  \"profiler\": {\"enabled\": %s, \"scope_ns\": %.1f, \"idle_scope_ns\": %.1f},\n",
+        PROFILER_ENABLED ? "true" : "false", scopeNs, idleScopeNs);
+    fprintf(out, "  \"allocations_tracked\": %s,\n", AllocationTracker::IsCompiledIn() ? "true" : "false");
+    fprintf(out, "  \"cases\": [\n");
+    fflush(out);
+
+    int regressions = 0;
+    size_t caseCount = options.Distributions.size() * options.NodeCounts.size() * options.Searches.size();
+    size_t caseIndex = 0;
+
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t n = 0; n < options.NodeCounts.size(); n++)
+        {
+            for (size_t s = 0; s < options.Searches.size(); s++)
+            {
+                Distribution distribution = options.Distributions[d];
+                int nodeCount = options.NodeCounts[n];
+                ConnectionSearch search = options.Searches[s];
+
+                CaseResult result;
+                RunCaseInChild(options, distribution, nodeCount, search, &result);
+
+                const BaselineCase* previous = FindBaseline(baseline, distribution, nodeCount, search, options.MaxDegree, options.GardenScreens);
+                WriteCase(out, distribution, nodeCount, search, options.MaxDegree, options.GardenScreens, result, previous, ++caseIndex == caseCount);
+                fflush(out);
+
+                double nsPerFrame = result.UpdateNs + result.ConnectNs + result.FinishNs;
+                if (!result.Ok)
+                {
+                    fprintf(stderr, "%-10s %7d %-8s  %s\n", DistributionName(distribution), nodeCount, SearchNames[search], result.Error);
+                }
+                else if (previous != nullptr && previous->NsPerFrame > 0)
+                {
+                    double change = (nsPerFrame / previous->NsPerFrame - 1) * 100;
+                    bool regressed = change > options.Threshold;
+                    regressions += regressed ? 1 : 0;
+                    fprintf(stderr, "%-10s %7d %-8s  %12.0f ns/frame  %+6.1f%%%s\n", DistributionName(distribution), nodeCount, SearchNames[search], nsPerFrame, change, regressed ? "  REGRESSION" : "");
+                }
+                else if (options.GardenScreens > 0)
+                {
+                    fprintf(stderr, "%-10s %7d %-8s  %12.0f ns/frame  cull %10.0f ns  drawn %8.1f of %d nodes, %8.1f of %.1f lines\n",
+                        DistributionName(distribution), nodeCount, SearchNames[search], nsPerFrame, result.CullNs,
+                        result.NodesDrawnPerFrame, nodeCount, result.LinesDrawnPerFrame, result.ConnectionsPerFrame);
+                }
+                else
+                {
+                    fprintf(stderr, "%-10s %7d %-8s  %12.0f ns/frame  %10.1f connections\n", DistributionName(distribution), nodeCount, SearchNames[search], nsPerFrame, result.ConnectionsPerFrame);
+                }
+            }
+        }
+    }
+
+    fprintf(out, "  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    if (regressions > 0)
+    {
+        fprintf(stderr, "%d case(s) more than %.0f%% slower than the baseline\n", regressions, options.Threshold);
+        return 2;
+    }
+
+    return 0;
+}
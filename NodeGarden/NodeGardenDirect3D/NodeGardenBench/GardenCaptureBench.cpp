@@ -0,0 +1,226 @@
+// Measures how many frames FrameCaptureQueue gets encoded, and how many it drops, when a CPU
+// framebuffer stands in for the staging textures FrameCapture maps each frame.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardencapturebench GardenCaptureBench.cpp
+//         ../NodeGardenDirect3DComp/FrameCaptureQueue.cpp ../NodeGardenDirect3DComp/FrameEncoder.cpp -pthread
+//
+// gardencapturebench [options]
+//     --formats png,yuv       encoders to run
+//     --width 480 --height 800
+//     --frames 300            frames offered to the queue per format
+//     --fps 60                how fast the producer offers them, 0 for as fast as it can
+//     --slots 8               FrameCapture::QueueSlots
+//     --out /tmp              a scratch folder is made here for each format and removed after
+//
+// The producer renders a scrolling gradient into its framebuffer, then copies it row by row into
+// the queue, as FrameCapture does from a mapped staging texture; the copy is all the render
+// thread pays. encoded_fps is the frames encoded over the time from the first frame until the
+// queue has drained, and dropped counts the frames the producer found the ring full for.
+// Prints one JSON object per format per line.
+
+#include "FrameCaptureQueue.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+    std::vector<CaptureFormat> Formats;
+    uint32_t Width;
+    uint32_t Height;
+    int Frames;
+    double Fps;
+    int Slots;
+    std::string Out;
+};
+
+static bool ParseFormats(const char* text, std::vector<CaptureFormat>* formats)
+{
+    formats->clear();
+    std::string list = text;
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string name = list.substr(start, end - start);
+        if (name == "png")
+            formats->push_back(CaptureFormat_Png);
+        else if (name == "yuv")
+            formats->push_back(CaptureFormat_Yuv);
+        else
+            return false;
+        start = end + 1;
+    }
+    return !formats->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->Formats.clear();
+    options->Formats.push_back(CaptureFormat_Png);
+    options->Formats.push_back(CaptureFormat_Yuv);
+    options->Width = 480;
+    options->Height = 800;
+    options->Frames = 300;
+    options->Fps = 60;
+    options->Slots = 8;
+    options->Out = "/tmp";
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool ok = true;
+        if (strcmp(argv[i], "--formats") == 0 && i + 1 < argc)
+            ok = ParseFormats(argv[++i], &options->Formats);
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+            options->Width = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+            options->Height = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            options->Frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            options->Fps = atof(argv[++i]);
+        else if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc)
+            options->Slots = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            options->Out = argv[++i];
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "usage: %s [--formats png,yuv] [--width w] [--height h] [--frames n] [--fps f] [--slots n] [--out folder]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (options->Width < 2)
+        options->Width = 2;
+    if (options->Height < 2)
+        options->Height = 2;
+    if (options->Frames < 1)
+        options->Frames = 1;
+    return true;
+}
+
+// BGRA, shifted a little each frame so no two frames encode alike
+static void Render(std::vector<uint8_t>* framebuffer, uint32_t width, uint32_t height, int frame)
+{
+    uint8_t* pixel = &(*framebuffer)[0];
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++, pixel += 4)
+        {
+            pixel[0] = (uint8_t)(x + frame * 3);
+            pixel[1] = (uint8_t)(y + frame);
+            pixel[2] = (uint8_t)((x ^ y) + frame * 7);
+            pixel[3] = 255;
+        }
+    }
+}
+
+static void RemoveFolder(const std::string& folder)
+{
+    DIR* dir = opendir(folder.c_str());
+    if (dir != nullptr)
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                unlink((folder + "/" + entry->d_name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(folder.c_str());
+}
+
+static bool Run(const Options& options, CaptureFormat format)
+{
+    const char* name = format == CaptureFormat_Png ? "png" : "yuv";
+    char folder[512];
+    snprintf(folder, sizeof(folder), "%s/gardencapturebench-%d-%s", options.Out.c_str(), (int)getpid(), name);
+    if (mkdir(folder, 0755) != 0)
+    {
+        fprintf(stderr, "couldn't make %s\n", folder);
+        return false;
+    }
+
+    size_t rowBytes = (size_t)options.Width * 4;
+    std::vector<uint8_t> framebuffer(rowBytes * options.Height);
+
+    FrameCaptureQueue queue;
+    queue.Start(format, folder, options.Slots);
+
+    double frameNs = options.Fps > 0 ? 1e9 / options.Fps : 0;
+    double copyNs = 0;
+    Clock::time_point start = Clock::now();
+
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        if (frameNs > 0)
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds((long long)(frame * frameNs)));
+
+        Render(&framebuffer, options.Width, options.Height, frame);
+
+        Clock::time_point copyStart = Clock::now();
+        uint8_t* pixels = queue.BeginFrame(options.Width, options.Height);
+        if (pixels != nullptr)
+        {
+            for (uint32_t y = 0; y < options.Height; y++)
+                memcpy(pixels + y * rowBytes, &framebuffer[y * rowBytes], rowBytes);
+            queue.EndFrame();
+        }
+        copyNs += std::chrono::duration<double, std::nano>(Clock::now() - copyStart).count();
+    }
+
+    Clock::time_point offered = Clock::now();
+    queue.Stop();
+    Clock::time_point drained = Clock::now();
+
+    double seconds = std::chrono::duration<double>(drained - start).count();
+    double offeredSeconds = std::chrono::duration<double>(offered - start).count();
+    uint32_t encoded = queue.GetEncodedFrames();
+    uint32_t dropped = queue.GetDroppedFrames();
+    uint32_t failed = queue.GetFailedFrames();
+
+    printf("{\"format\": \"%s\", \"width\": %u, \"height\": %u, \"frames\": %d, \"fps\": %g, \"slots\": %d, "
+           "\"encoded\": %u, \"dropped\": %u, \"failed\": %u, \"encoded_fps\": %.1f, \"offered_fps\": %.1f, "
+           "\"copy_ns\": %.0f, \"drain_ms\": %.1f}\n",
+        name, options.Width, options.Height, options.Frames, options.Fps, options.Slots,
+        encoded, dropped, failed, encoded / seconds, options.Frames / offeredSeconds,
+        copyNs / options.Frames, std::chrono::duration<double, std::milli>(drained - offered).count());
+    fprintf(stderr, "%s %ux%u: %u of %d encoded at %.1f fps, %u dropped, %u failed, %.0f us a copy\n",
+        name, options.Width, options.Height, encoded, options.Frames, encoded / seconds, dropped, failed,
+        copyNs / options.Frames / 1000);
+
+    RemoveFolder(folder);
+
+    // every frame offered has to be accounted for
+    return failed == 0 && encoded + dropped == (uint32_t)options.Frames;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+        return 1;
+
+    bool ok = true;
+    for (size_t i = 0; i < options.Formats.size(); i++)
+        ok = Run(options, options.Formats[i]) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+// Compares loading a DDS file through DDSReader's mapping against the read into a buffer path
+// DDSTextureLoader takes for CreateDDSTextureFromFile: the whole file read into a heap block,
+// the header parsed and the subresources laid out over that block.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenddsbench GardenDDSBench.cpp
+//         ../NodeGardenDirect3DComp/DDSFile.cpp ../NodeGardenDirect3DComp/DDSReader.cpp
+//
+// gardenddsbench [options]
+//     --file ../NodeGardenDirect3DComp/node.dds
+//     --make 2048         instead of --file, write a DX10 R8G8B8A8 texture this wide with a
+//                         full mip chain to /tmp and load that
+//     --loads 200         loads timed per path, after two warmup loads each
+//
+// DDSTextureLoader itself needs a D3D device, so the read path is rebuilt here from what it
+// does before CreateTexture2D; both paths index the subresources with the same DDSFile code.
+// views_ns is open until every subresource view is ready. upload_ns adds reading every byte of
+// every view, which CreateTexture2D does with the initial data; the mapping only faults its
+// pages in there. heap_bytes is what each load allocates for the file's bytes. Files are in
+// the page cache after the warmup, so this is the warm load, as for a texture the app reloads.
+// Prints one JSON object per path per line.
+
+#include "DDSFile.h"
+#include "DDSReader.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int WarmupLoads = 2;
+
+struct Options
+{
+    std::string File;
+    int Make;
+    int Loads;
+};
+
+struct LoadCost
+{
+    double ViewsNs;
+    double UploadNs;
+    size_t HeapBytes;
+    uint32_t Checksum;
+};
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->File = "../NodeGardenDirect3DComp/node.dds";
+    options->Make = 0;
+    options->Loads = 200;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+            options->File = argv[++i];
+        else if (strcmp(argv[i], "--make") == 0 && i + 1 < argc)
+            options->Make = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--loads") == 0 && i + 1 < argc)
+            options->Loads = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--file path | --make width] [--loads n]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (options->Loads < 1)
+        options->Loads = 1;
+    return true;
+}
+
+static void Put(std::vector<uint8_t>* bytes, size_t at, uint32_t value)
+{
+    memcpy(&(*bytes)[at], &value, sizeof(value));
+}
+
+// a square DX10 R8G8B8A8 texture with every mip down to 1x1
+static bool MakeTexture(const std::string& path, int width)
+{
+    uint32_t mips = 1;
+    size_t dataSize = 0;
+    for (uint32_t w = (uint32_t)width; ; w >>= 1, mips++)
+    {
+        dataSize += (size_t)w * w * 4;
+        if (w == 1)
+            break;
+    }
+
+    std::vector<uint8_t> bytes(148 + dataSize);
+    Put(&bytes, 0, 0x20534444);
+    Put(&bytes, 4, 124);
+    Put(&bytes, 8, 0x21007);
+    Put(&bytes, 12, (uint32_t)width);
+    Put(&bytes, 16, (uint32_t)width);
+    Put(&bytes, 28, mips);
+    Put(&bytes, 76, 32);
+    Put(&bytes, 80, 0x4);
+    Put(&bytes, 84, 0x30315844);        // "DX10"
+    Put(&bytes, 108, 0x401008);
+    Put(&bytes, 128, 28);               // DXGI_FORMAT_R8G8B8A8_UNORM
+    Put(&bytes, 132, 3);                // 2D
+    Put(&bytes, 140, 1);
+
+    uint32_t x = 1;
+    for (size_t i = 148; i < bytes.size(); i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        bytes[i] = (uint8_t)x;
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool written = fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+// what CreateTexture2D does with the initial data: read all of it
+static uint32_t Upload(const DDSReader& reader)
+{
+    uint32_t sum = 0;
+    const DDSSubresource* subresources = reader.GetSubresources();
+    for (size_t i = 0; i < reader.GetSubresourceCount(); i++)
+    {
+        const uint32_t* words = (const uint32_t*)subresources[i].Data;
+        size_t count = subresources[i].SlicePitch * subresources[i].Depth / sizeof(uint32_t);
+        for (size_t j = 0; j < count; j++)
+            sum += words[j];
+    }
+    return sum;
+}
+
+// DDSTextureLoader's LoadTextureDataFromFile and FillInitData
+static bool LoadRead(const char* path, LoadCost* cost)
+{
+    Clock::time_point start = Clock::now();
+
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileInfo;
+    if (fstat(file, &fileInfo) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    size_t size = (size_t)fileInfo.st_size;
+    std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    size_t offset = 0;
+    while (offset < size)
+    {
+        ssize_t got = read(file, data.get() + offset, size - offset);
+        if (got <= 0)
+            break;
+        offset += (size_t)got;
+    }
+    close(file);
+    if (offset != size)
+        return false;
+
+    DDSReader reader;
+    if (reader.Attach(data.get(), size) != DDSResult_Ok)
+        return false;
+    Clock::time_point views = Clock::now();
+
+    cost->Checksum = Upload(reader);
+    Clock::time_point uploaded = Clock::now();
+
+    cost->ViewsNs += std::chrono::duration<double, std::nano>(views - start).count();
+    cost->UploadNs += std::chrono::duration<double, std::nano>(uploaded - start).count();
+    cost->HeapBytes = size;
+    return true;
+}
+
+// ResourceCache's path
+static bool LoadMap(const char* path, LoadCost* cost)
+{
+    Clock::time_point start = Clock::now();
+
+    DDSReader reader;
+    if (reader.Open(path) != DDSResult_Ok)
+        return false;
+    Clock::time_point views = Clock::now();
+
+    cost->Checksum = Upload(reader);
+    Clock::time_point uploaded = Clock::now();
+
+    cost->ViewsNs += std::chrono::duration<double, std::nano>(views - start).count();
+    cost->UploadNs += std::chrono::duration<double, std::nano>(uploaded - start).count();
+    cost->HeapBytes = 0;
+    return true;
+}
+
+static bool Measure(bool (*load)(const char*, LoadCost*), const Options& options, LoadCost* cost)
+{
+    LoadCost warmup;
+    memset(&warmup, 0, sizeof(warmup));
+    for (int i = 0; i < WarmupLoads; i++)
+    {
+        if (!load(options.File.c_str(), &warmup))
+            return false;
+    }
+
+    memset(cost, 0, sizeof(*cost));
+    for (int i = 0; i < options.Loads; i++)
+    {
+        if (!load(options.File.c_str(), cost))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+        return 1;
+
+    if (options.Make > 0)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/gardenddsbench-%d.dds", options.Make);
+        options.File = path;
+        if (!MakeTexture(options.File, options.Make))
+        {
+            fprintf(stderr, "couldn't write %s\n", path);
+            return 1;
+        }
+    }
+
+    DDSReader probe;
+    DDSResult result = probe.Open(options.File.c_str());
+    if (result != DDSResult_Ok)
+    {
+        fprintf(stderr, "couldn't load %s (result %d)\n", options.File.c_str(), (int)result);
+        return 1;
+    }
+    const DDSInfo info = probe.GetInfo();
+    size_t fileSize = probe.GetSize();
+    probe.Close();
+
+    LoadCost read, map;
+    if (!Measure(LoadRead, options, &read) || !Measure(LoadMap, options, &map))
+    {
+        fprintf(stderr, "a load of %s failed\n", options.File.c_str());
+        return 1;
+    }
+
+    // both paths must hand the device the same bytes
+    if (read.Checksum != map.Checksum)
+    {
+        fprintf(stderr, "the paths read different bytes\n");
+        return 1;
+    }
+
+    const char* names[] = { "read", "map" };
+    const LoadCost* costs[] = { &read, &map };
+    for (int i = 0; i < 2; i++)
+    {
+        printf("{\"path\": \"%s\", \"file_bytes\": %zu, \"width\": %u, \"height\": %u, \"mips\": %u, \"loads\": %d, "
+               "\"views_ns\": %.0f, \"upload_ns\": %.0f, \"heap_bytes\": %zu}\n",
+            names[i], fileSize, info.Width, info.Height, info.MipCount, options.Loads,
+            costs[i]->ViewsNs / options.Loads, costs[i]->UploadNs / options.Loads, costs[i]->HeapBytes);
+    }
+
+    fprintf(stderr, "%s, %zu bytes: read %.1f us (views %.1f), map %.1f us (views %.1f), read / map %.2fx\n",
+        options.File.c_str(), fileSize,
+        read.UploadNs / options.Loads / 1000, read.ViewsNs / options.Loads / 1000,
+        map.UploadNs / options.Loads / 1000, map.ViewsNs / options.Loads / 1000,
+        read.UploadNs / map.UploadNs);
+    return 0;
+}
@@ -0,0 +1,196 @@
+// Checks the DDS files the app ships against what ResourceCache expects of them: each one is
+// opened through DDSReader (memory mapped, the way the device loads it) and parsed again from a
+// copy through DDSFile::Parse, and both must agree with the format, size and mip count below.
+//
+// Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenddscheck GardenDDSCheck.cpp
+//         ../NodeGardenDirect3DComp/DDSFile.cpp ../NodeGardenDirect3DComp/DDSReader.cpp
+//
+// gardenddscheck [--dir ../NodeGardenDirect3DComp]
+//     Every subresource must sit inside the file, follow the previous one, and have the pitch
+//     GetSurfaceInfo gives for its mip. Cutting the last byte off a file must make it Truncated
+//     and breaking its magic must make it BadMagic. Exits 1 on any failure.
+
+#include "DDSFile.h"
+#include "DDSReader.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ShippedTexture
+{
+    const char* Name;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t MipCount;
+    uint32_t Format;            // DXGI_FORMAT value
+};
+
+// NodeSprite draws node.dds as a single level; it is stored as D3DFMT_A16B16G16R16F, which
+// DDSFile maps to DXGI_FORMAT_R16G16B16A16_FLOAT
+static const ShippedTexture Shipped[] =
+{
+    { "node.dds", 128, 128, 1, 10 },
+};
+
+static const char* ResultName(DDSResult result)
+{
+    switch (result)
+    {
+    case DDSResult_Ok: return "ok";
+    case DDSResult_OpenFailed: return "open_failed";
+    case DDSResult_TooSmall: return "too_small";
+    case DDSResult_BadMagic: return "bad_magic";
+    case DDSResult_BadHeader: return "bad_header";
+    case DDSResult_UnsupportedFormat: return "unsupported_format";
+    case DDSResult_Truncated: return "truncated";
+    }
+    return "unknown";
+}
+
+static const char* CheckInfo(const DDSInfo& info, const ShippedTexture& expected, size_t fileSize)
+{
+    if (info.Width != expected.Width || info.Height != expected.Height)
+        return "wrong size";
+    if (info.MipCount != expected.MipCount)
+        return "wrong mip count";
+    if (info.Format != expected.Format)
+        return "wrong format";
+    if (info.Depth != 1 || info.ArraySize != 1 || info.IsCubeMap || info.IsVolume)
+        return "not a plain 2D texture";
+    if (info.DataOffset + info.DataSize > fileSize)
+        return "data runs past the file";
+    return nullptr;
+}
+
+static const char* CheckSubresources(const DDSReader& reader)
+{
+    const DDSInfo& info = reader.GetInfo();
+    if (reader.GetSubresourceCount() != (size_t)info.MipCount * info.ArraySize)
+        return "wrong subresource count";
+
+    const uint8_t* begin = reader.GetData();
+    const uint8_t* end = begin + reader.GetSize();
+    const uint8_t* next = begin + info.DataOffset;
+
+    for (uint32_t slice = 0; slice < info.ArraySize; slice++)
+    {
+        for (uint32_t mip = 0; mip < info.MipCount; mip++)
+        {
+            const DDSSubresource& subresource = reader.GetSubresource(mip, slice);
+            uint32_t width = info.Width >> mip > 0 ? info.Width >> mip : 1;
+            uint32_t height = info.Height >> mip > 0 ? info.Height >> mip : 1;
+            if (subresource.Width != width || subresource.Height != height)
+                return "wrong mip dimensions";
+
+            size_t rowBytes, numRows, numBytes;
+            if (!DDSFile::GetSurfaceInfo(width, height, info.Format, &rowBytes, &numRows, &numBytes))
+                return "format can't be sized";
+            if (subresource.RowPitch != rowBytes || subresource.SlicePitch != numBytes)
+                return "wrong pitch";
+
+            if (subresource.Data != next)
+                return "subresources aren't contiguous";
+            next += numBytes * subresource.Depth;
+            if (next > end)
+                return "subresource runs past the file";
+        }
+    }
+
+    if ((size_t)(next - begin) != info.DataOffset + info.DataSize)
+        return "subresources don't cover DataSize";
+    return nullptr;
+}
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>* bytes)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    bytes->clear();
+    uint8_t buffer[65536];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes->insert(bytes->end(), buffer, buffer + got);
+
+    fclose(file);
+    return true;
+}
+
+static bool CheckTexture(const std::string& dir, const ShippedTexture& expected)
+{
+    std::string path = dir + "/" + expected.Name;
+    const char* failure = nullptr;
+    DDSResult result = DDSResult_Ok;
+
+    DDSReader reader;
+    std::vector<uint8_t> bytes;
+    DDSInfo parsed;
+    memset(&parsed, 0, sizeof(parsed));
+
+    if ((result = reader.Open(path.c_str())) != DDSResult_Ok)
+        failure = "DDSReader couldn't open it";
+    else if ((failure = CheckInfo(reader.GetInfo(), expected, reader.GetSize())) != nullptr)
+        ;
+    else if ((failure = CheckSubresources(reader)) != nullptr)
+        ;
+    else if (!ReadFile(path, &bytes) || bytes.size() != reader.GetSize() ||
+             memcmp(&bytes[0], reader.GetData(), bytes.size()) != 0)
+        failure = "mapped bytes differ from the file";
+    else if ((result = DDSFile::Parse(&bytes[0], bytes.size(), &parsed)) != DDSResult_Ok)
+        failure = "DDSFile couldn't parse a copy";
+    else if (memcmp(&parsed, &reader.GetInfo(), sizeof(parsed)) != 0)
+        failure = "DDSFile and DDSReader disagree";
+    else if ((result = DDSFile::Parse(&bytes[0], parsed.DataOffset + parsed.DataSize - 1, &parsed)) != DDSResult_Truncated)
+        failure = "a short copy wasn't truncated";
+    else
+    {
+        bytes[0] ^= 0xFF;
+        if ((result = DDSFile::Parse(&bytes[0], bytes.size(), &parsed)) != DDSResult_BadMagic)
+            failure = "a broken magic wasn't caught";
+        else
+            result = DDSResult_Ok;
+    }
+
+    const DDSInfo& info = reader.GetInfo();
+    printf("{\"file\": \"%s\", \"width\": %u, \"height\": %u, \"mips\": %u, \"format\": %u, "
+           "\"bytes\": %zu, \"subresources\": %zu, \"result\": \"%s\", \"ok\": %s}\n",
+        expected.Name, info.Width, info.Height, info.MipCount, info.Format,
+        reader.GetSize(), reader.GetSubresourceCount(), ResultName(result), failure == nullptr ? "true" : "false");
+
+    if (failure != nullptr)
+        fprintf(stderr, "%s: %s (%s)\n", path.c_str(), failure, ResultName(result));
+    else
+        fprintf(stderr, "%s: %ux%u, %u mip(s), format %u\n", expected.Name, info.Width, info.Height, info.MipCount, info.Format);
+
+    return failure == nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = "../NodeGardenDirect3DComp";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+            dir = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--dir path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(Shipped) / sizeof(Shipped[0]); i++)
+    {
+        if (!CheckTexture(dir, Shipped[i]))
+            failed++;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// Fuzzes DDSFile::Parse and DDSReader's subresource views with mutated DDS headers. Every input
+// is copied into a heap block of exactly its size, so under AddressSanitizer any read past the
+// bytes a header claims is caught where it happens.
+//
+// Linux only. Build from this folder with
+//     g++ -O1 -g -std=c++11 -fsanitize=address,undefined -I../NodeGardenDirect3DComp -o gardenddsfuzz
+//         GardenDDSFuzz.cpp ../NodeGardenDirect3DComp/DDSFile.cpp ../NodeGardenDirect3DComp/DDSReader.cpp
+// or, with clang, as a libFuzzer target by adding -DNODEGARDEN_LIBFUZZER -fsanitize=fuzzer.
+//
+// gardenddsfuzz [options]
+//     --iterations 200000     mutated inputs to try
+//     --seed 1
+//     --dir ../NodeGardenDirect3DComp     where node.dds is; it joins the built in seeds
+//     --save ddsfuzz-failure.dds          where the first failing input is written
+//
+// Seeds are node.dds plus small DX10 files built here: a mipped 2D texture, a block compressed
+// cube map and a volume, and a cube map whose array size wraps when multiplied by six. Each
+// input gets one to four mutations: header bytes flipped, header fields set to boundary values,
+// or the file cut short. When Attach accepts an input its views must lie inside the input,
+// cover exactly DataSize, and a cube map must have six slices per cube; the first and last
+// byte of every view is read. Exits 1 on the first input that breaks one of these.
+
+#include "DDSFile.h"
+#include "DDSReader.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// header field offsets in the file, magic included
+static const size_t HeaderFlagsAt = 8;
+static const size_t HeightAt = 12;
+static const size_t WidthAt = 16;
+static const size_t DepthAt = 24;
+static const size_t MipCountAt = 28;
+static const size_t PixelFlagsAt = 80;
+static const size_t FourCCAt = 84;
+static const size_t Caps2At = 112;
+static const size_t FormatAt = 128;
+static const size_t DimensionAt = 132;
+static const size_t MiscFlagAt = 136;
+static const size_t ArraySizeAt = 140;
+static const size_t DX10DataAt = 148;
+
+static const size_t FieldOffsets[] =
+{
+    HeaderFlagsAt, HeightAt, WidthAt, DepthAt, MipCountAt, PixelFlagsAt, FourCCAt, 88, Caps2At,
+    FormatAt, DimensionAt, MiscFlagAt, ArraySizeAt,
+};
+
+static const uint32_t InterestingValues[] =
+{
+    0, 1, 2, 3, 4, 6, 15, 16, 17, 255, 16383, 16384, 16385, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF,
+    0x2AAAAAAB,     // times six wraps a uint32_t to 2
+    0x30315844,     // "DX10"
+    71, 98, 28, 10, // BC1, BC7, R8G8B8A8, R16G16B16A16_FLOAT
+};
+
+struct Options
+{
+    int Iterations;
+    uint32_t Seed;
+    std::string Dir;
+    std::string Save;
+};
+
+struct FuzzStats
+{
+    int Inputs;
+    int Accepted;
+    int Results[DDSResult_Truncated + 1];
+};
+
+static FuzzStats Stats;
+
+static const char* CheckViews(const DDSReader& reader, const uint8_t* data, size_t size)
+{
+    const DDSInfo& info = reader.GetInfo();
+    if (info.DataOffset > size || info.DataSize > size - info.DataOffset)
+        return "DataSize runs past the input";
+    if (info.IsCubeMap && info.ArraySize % 6 != 0)
+        return "cube map without six faces per cube";
+    if (reader.GetSubresourceCount() != (size_t)info.MipCount * info.ArraySize)
+        return "wrong subresource count";
+
+    // volatile so the touches aren't optimised away; ASan checks each one
+    volatile uint8_t sink = 0;
+    size_t covered = 0;
+    const DDSSubresource* subresources = reader.GetSubresources();
+    for (size_t i = 0; i < reader.GetSubresourceCount(); i++)
+    {
+        const DDSSubresource& subresource = subresources[i];
+        size_t bytes = subresource.SlicePitch * subresource.Depth;
+        if (subresource.Data < data || bytes > size || subresource.Data > data + size - bytes)
+            return "view runs past the input";
+        if (bytes > 0)
+            sink ^= subresource.Data[0] ^ subresource.Data[bytes - 1];
+        covered += bytes;
+    }
+    (void)sink;
+
+    if (covered != info.DataSize)
+        return "views don't cover DataSize";
+    return nullptr;
+}
+
+// one input, already in a block of exactly its size
+static const char* RunOne(const uint8_t* data, size_t size)
+{
+    Stats.Inputs++;
+
+    DDSReader reader;
+    DDSResult result = reader.Attach(data, size);
+    Stats.Results[result]++;
+    if (result != DDSResult_Ok)
+        return nullptr;
+
+    Stats.Accepted++;
+    return CheckViews(reader, data, size);
+}
+
+#if defined(NODEGARDEN_LIBFUZZER)
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (RunOne(data, size) != nullptr)
+        abort();
+    return 0;
+}
+#else
+static const char* Failure;
+
+static uint32_t Next(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void Put(std::vector<uint8_t>* bytes, size_t at, uint32_t value)
+{
+    if (at + sizeof(value) <= bytes->size())
+        memcpy(&(*bytes)[at], &value, sizeof(value));
+}
+
+static std::vector<uint8_t> MakeDX10(uint32_t width, uint32_t height, uint32_t depth, uint32_t mips,
+    uint32_t format, uint32_t dimension, uint32_t miscFlag, uint32_t arraySize, size_t dataSize)
+{
+    std::vector<uint8_t> bytes(DX10DataAt + dataSize, 0x5A);
+    memset(&bytes[0], 0, DX10DataAt);
+    Put(&bytes, 0, 0x20534444);
+    Put(&bytes, 4, 124);
+    Put(&bytes, HeaderFlagsAt, 0x1007 | 0x20000 | (depth > 1 ? 0x800000 : 0));
+    Put(&bytes, HeightAt, height);
+    Put(&bytes, WidthAt, width);
+    Put(&bytes, DepthAt, depth);
+    Put(&bytes, MipCountAt, mips);
+    Put(&bytes, 76, 32);
+    Put(&bytes, PixelFlagsAt, 0x4);
+    Put(&bytes, FourCCAt, 0x30315844);
+    Put(&bytes, 108, 0x1000);
+    Put(&bytes, FormatAt, format);
+    Put(&bytes, DimensionAt, dimension);
+    Put(&bytes, MiscFlagAt, miscFlag);
+    Put(&bytes, ArraySizeAt, arraySize);
+    return bytes;
+}
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>* bytes)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    bytes->clear();
+    uint8_t buffer[65536];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes->insert(bytes->end(), buffer, buffer + got);
+
+    fclose(file);
+    return true;
+}
+
+static void Mutate(std::vector<uint8_t>* bytes, uint32_t* rng)
+{
+    int mutations = 1 + Next(rng) % 4;
+    for (int i = 0; i < mutations && !bytes->empty(); i++)
+    {
+        switch (Next(rng) % 4)
+        {
+        case 0:
+        {
+            // mostly the headers, where the parser makes its decisions
+            size_t limit = bytes->size() < DX10DataAt ? bytes->size() : DX10DataAt;
+            (*bytes)[Next(rng) % limit] ^= (uint8_t)(1 << (Next(rng) % 8));
+            break;
+        }
+        case 1:
+        case 2:
+        {
+            size_t at = FieldOffsets[Next(rng) % (sizeof(FieldOffsets) / sizeof(FieldOffsets[0]))];
+            Put(bytes, at, InterestingValues[Next(rng) % (sizeof(InterestingValues) / sizeof(InterestingValues[0]))]);
+            break;
+        }
+        default:
+            bytes->resize(Next(rng) % (bytes->size() + 1));
+            break;
+        }
+    }
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->Iterations = 200000;
+    options->Seed = 1;
+    options->Dir = "../NodeGardenDirect3DComp";
+    options->Save = "ddsfuzz-failure.dds";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            options->Iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            options->Seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+            options->Dir = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            options->Save = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--iterations n] [--seed s] [--dir path] [--save file]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (options->Seed == 0)
+        options->Seed = 1;
+    return true;
+}
+
+static void Save(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return;
+    if (!bytes.empty())
+        fwrite(&bytes[0], 1, bytes.size(), file);
+    fclose(file);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+        return 1;
+
+    // R8G8B8A8 16x16 with five mips: 1024 + 256 + 64 + 16 + 4 texels
+    std::vector<std::vector<uint8_t> > seeds;
+    seeds.push_back(MakeDX10(16, 16, 1, 5, 28, 3, 0, 1, 1364 * 4));
+    // BC1 8x8 cube with two mips, one 8 byte block per 4x4: (4 + 1) blocks a face
+    seeds.push_back(MakeDX10(8, 8, 1, 2, 71, 3, 0x4, 1, 6 * 5 * 8));
+    // R16G16B16A16_FLOAT 4x4x4 volume, one mip
+    seeds.push_back(MakeDX10(4, 4, 4, 1, 10, 4, 0, 1, 4 * 4 * 4 * 8));
+    // regression: 0x2AAAAAAB cubes is 2 slices once multiplied by six in 32 bits
+    seeds.push_back(MakeDX10(4, 4, 1, 1, 28, 3, 0x4, 0x2AAAAAAB, 2 * 4 * 4 * 4));
+
+    std::vector<uint8_t> node;
+    if (ReadFile(options.Dir + "/node.dds", &node))
+        seeds.push_back(node);
+    else
+        fprintf(stderr, "couldn't read %s/node.dds, fuzzing the built in seeds only\n", options.Dir.c_str());
+
+    uint32_t rng = options.Seed;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> exact;
+    int iteration = 0;
+
+    // every seed runs once as it is before any mutation
+    for (; iteration < options.Iterations + (int)seeds.size() && Failure == nullptr; iteration++)
+    {
+        if (iteration < (int)seeds.size())
+            input = seeds[iteration];
+        else
+        {
+            input = seeds[Next(&rng) % seeds.size()];
+            Mutate(&input, &rng);
+        }
+
+        // a fresh block of exactly this size, so ASan sees the end of the input
+        exact.assign(input.begin(), input.end());
+        exact.shrink_to_fit();
+        Failure = RunOne(exact.empty() ? nullptr : &exact[0], exact.size());
+    }
+
+    printf("{\"inputs\": %d, \"accepted\": %d, \"too_small\": %d, \"bad_magic\": %d, \"bad_header\": %d, "
+           "\"unsupported_format\": %d, \"truncated\": %d, \"ok\": %s}\n",
+        Stats.Inputs, Stats.Accepted, Stats.Results[DDSResult_TooSmall], Stats.Results[DDSResult_BadMagic],
+        Stats.Results[DDSResult_BadHeader], Stats.Results[DDSResult_UnsupportedFormat], Stats.Results[DDSResult_Truncated],
+        Failure == nullptr ? "true" : "false");
+
+    if (Failure != nullptr)
+    {
+        Save(options.Save, input);
+        fprintf(stderr, "input %d: %s, saved to %s\n", iteration - 1, Failure, options.Save.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "%d inputs, %d accepted, no failures\n", Stats.Inputs, Stats.Accepted);
+    return 0;
+}
+#endif
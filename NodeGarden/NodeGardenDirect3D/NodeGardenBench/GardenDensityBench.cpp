@@ -0,0 +1,290 @@
+// Compares the density field estimate of connectedness against the exact connection pass:
+// how far off each node's sum and size come out, and what each costs per frame.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardendensitybench GardenDensityBench.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardendensitybench [options]
+//     --nodes 100,300,...         node counts to sweep (default 100 up to 100000)
+//     --distributions a,b,...     uniform, clustered, ring, cell (default all but cell, which
+//                                 connects every pair and doesn't fit in memory past a few thousand)
+//     --resolutions 2,4,8         cells per MinDist to try; see DensityField
+//     --frames 10                 frames measured per case
+//     --seed 1
+//
+// Two gardens start from the same state, one exact with the adaptive search and one
+// estimating, and step together; nodes move the same whatever their sizes, so every frame
+// compares the same positions. Sums are compared before FinishConnections clears them:
+// sum_error is the mean absolute error over the mean exact sum, sum_p99 the 99th percentile
+// absolute error over the same. size_error and size_max are how far apart the drawn sizes
+// end up, in pixels out of the NodeSizeMin to NodeSizeMax range. Prints one JSON object per
+// case per line, then for each distribution and resolution the smallest node count from
+// which the estimate was faster.
+
+#include "Garden.h"
+#include "Scenario.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int WarmupFrames = 2;
+static const float FrameDelta = 1.0f / 60.0f;
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    std::vector<int> Resolutions;
+    int Frames;
+    uint32_t Seed;
+};
+
+struct CaseResult
+{
+    double ExactNs;
+    double EstimateNs;
+    double SumError;
+    double SumP99;
+    double SizeError;
+    double SizeMax;
+    bool Diverged;              // positions stopped matching, so the comparison means nothing
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void RunCase(const Options& options, Distribution distribution, int nodeCount, int resolution, CaseResult* result)
+{
+    Garden exact;
+    Scenario::Populate(exact, distribution, nodeCount, options.Seed);
+
+    GardenState state;
+    exact.SaveState(&state);
+
+    Garden estimated;
+    estimated.LoadState(state);
+    estimated.SetConnectionSearch(ConnectionSearch_DensityField);
+    estimated.SetDensityFieldResolution(resolution);
+
+    double exactNs = 0, estimateNs = 0, errorSum = 0, exactSum = 0, sizeError = 0, sizeMax = 0;
+    std::vector<float> errors;
+    errors.reserve((size_t)nodeCount * options.Frames);
+    bool diverged = false;
+
+    for (int frame = -WarmupFrames; frame < options.Frames; frame++)
+    {
+        exact.UpdateOrder();
+        exact.UpdateNodes(FrameDelta);
+        estimated.UpdateOrder();
+        estimated.UpdateNodes(FrameDelta);
+
+        Clock::time_point start = Clock::now();
+        exact.FindConnections();
+        Clock::time_point found = Clock::now();
+        estimated.FindConnections();
+        Clock::time_point estimatedAt = Clock::now();
+
+        const std::vector<GardenNode>& exactNodes = exact.GetNodes();
+        const std::vector<GardenNode>& estimatedNodes = estimated.GetNodes();
+        if (frame >= 0)
+        {
+            exactNs += Elapsed(start, found);
+            estimateNs += Elapsed(found, estimatedAt);
+
+            for (size_t i = 0; i < exactNodes.size(); i++)
+            {
+                if (exactNodes[i].X != estimatedNodes[i].X || exactNodes[i].Y != estimatedNodes[i].Y)
+                    diverged = true;
+
+                float error = fabsf(estimatedNodes[i].Connectedness - exactNodes[i].Connectedness);
+                errors.push_back(error);
+                errorSum += error;
+                exactSum += exactNodes[i].Connectedness;
+            }
+        }
+
+        exact.FinishConnections();
+        estimated.FinishConnections();
+
+        if (frame >= 0)
+        {
+            for (size_t i = 0; i < exactNodes.size(); i++)
+            {
+                float error = fabsf(estimatedNodes[i].Size - exactNodes[i].Size);
+                sizeError += error;
+                if (error > sizeMax)
+                    sizeMax = error;
+            }
+        }
+    }
+
+    double samples = errors.empty() ? 1 : (double)errors.size();
+    double meanSum = exactSum / samples;
+    size_t p99 = errors.empty() ? 0 : (size_t)(errors.size() * 0.99);
+    if (p99 < errors.size())
+        std::nth_element(errors.begin(), errors.begin() + p99, errors.end());
+
+    result->ExactNs = exactNs / options.Frames;
+    result->EstimateNs = estimateNs / options.Frames;
+    result->SumError = meanSum > 0 ? errorSum / samples / meanSum : 0;
+    result->SumP99 = meanSum > 0 && p99 < errors.size() ? errors[p99] / meanSum : 0;
+    result->SizeError = sizeError / samples;
+    result->SizeMax = sizeMax;
+    result->Diverged = diverged;
+
+    printf("{\"distribution\": \"%s\", \"nodes\": %d, \"resolution\": %d, \"frames\": %d, \"exact_ns\": %.0f, \"estimate_ns\": %.0f, "
+        "\"speedup\": %.2f, \"mean_sum\": %.3f, \"sum_error\": %.4f, \"sum_p99\": %.4f, \"size_error\": %.3f, \"size_max\": %.3f, \"diverged\": %s}\n",
+        DistributionName(distribution), exact.GetNodeCount(), resolution, options.Frames, result->ExactNs, result->EstimateNs,
+        result->EstimateNs > 0 ? result->ExactNs / result->EstimateNs : 0.0, meanSum, result->SumError, result->SumP99,
+        result->SizeError, result->SizeMax, diverged ? "true" : "false");
+    fflush(stdout);
+
+    fprintf(stderr, "%-10s %7d  res %2d  exact %9.3f ms  estimate %9.3f ms  sum error %6.2f%% (p99 %6.2f%%)  size error %.2f px (max %.2f)%s\n",
+        DistributionName(distribution), nodeCount, resolution, result->ExactNs / 1e6, result->EstimateNs / 1e6,
+        result->SumError * 100, result->SumP99 * 100, result->SizeError, result->SizeMax, diverged ? "  DIVERGED" : "");
+}
+
+static bool ParseList(const char* text, std::vector<int>* values)
+{
+    values->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long value = strtol(text, &end, 10);
+        if (end == text || value < 1)
+            return false;
+
+        values->push_back((int)value);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !values->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultNodeCounts[] = { 100, 300, 1000, 3000, 10000, 30000, 100000 };
+    static const int DefaultResolutions[] = { 2, 4, 8 };
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Resolutions.assign(DefaultResolutions, DefaultResolutions + sizeof(DefaultResolutions) / sizeof(DefaultResolutions[0]));
+    options->Distributions.clear();
+    options->Distributions.push_back(Distribution_Uniform);
+    options->Distributions.push_back(Distribution_Clustered);
+    options->Distributions.push_back(Distribution_Ring);
+    options->Frames = 10;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseList(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--resolutions") == 0)
+        {
+            if (!ParseList(value, &options->Resolutions))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 100,300,...] [--distributions uniform,clustered,ring,cell]\n"
+                        "       [--resolutions 2,4,8] [--frames n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    std::sort(options.NodeCounts.begin(), options.NodeCounts.end());
+
+    bool diverged = false;
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t r = 0; r < options.Resolutions.size(); r++)
+        {
+            // the smallest count from which the estimate stayed faster
+            int crossover = -1;
+            for (size_t n = 0; n < options.NodeCounts.size(); n++)
+            {
+                CaseResult result;
+                RunCase(options, options.Distributions[d], options.NodeCounts[n], options.Resolutions[r], &result);
+                diverged = diverged || result.Diverged;
+
+                if (result.EstimateNs < result.ExactNs)
+                {
+                    if (crossover < 0)
+                        crossover = options.NodeCounts[n];
+                }
+                else
+                    crossover = -1;
+            }
+
+            printf("{\"distribution\": \"%s\", \"resolution\": %d, \"crossover_nodes\": %d}\n",
+                DistributionName(options.Distributions[d]), options.Resolutions[r], crossover);
+            if (crossover > 0)
+                fprintf(stderr, "%-10s res %2d  estimate faster from %d nodes\n", DistributionName(options.Distributions[d]), options.Resolutions[r], crossover);
+            else
+                fprintf(stderr, "%-10s res %2d  estimate never faster by the largest count\n", DistributionName(options.Distributions[d]), options.Resolutions[r]);
+        }
+    }
+
+    return diverged ? 3 : 0;
+}
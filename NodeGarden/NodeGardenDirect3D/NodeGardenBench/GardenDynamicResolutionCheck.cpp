@@ -0,0 +1,278 @@
+// Checks DynamicResolution's decisions by feeding it made up frame and busy times, the way
+// Direct3DInterop::GetTexture does with the real ones each frame.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardendynamicresolutioncheck
+//         GardenDynamicResolutionCheck.cpp ../NodeGardenDirect3DComp/DynamicResolution.cpp
+//
+// gardendynamicresolutioncheck [--frames 10000] [--seed 1]
+//     A full window of overloaded frames must shrink the scale one step, and not a frame
+//     sooner. Growing must wait for ScaleUpSampleCount cheap frames, starting over after an
+//     expensive one. Frames in the cooldown after a change must not count towards the next
+//     one. The scale must stay within SetBounds however long the load pushes it, and steady or
+//     jittery load a size can afford must leave it alone for --frames frames. Exits 1 on any
+//     failure.
+
+#include "DynamicResolution.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// DynamicResolution's own, which it keeps to itself
+static const int SampleCount = 30;
+static const int ScaleUpSampleCount = 90;
+static const int CooldownFrames = 30;
+static const float ScaleDownStep = 0.1f;
+static const float ScaleUpStep = 0.05f;
+
+static const float Target = 1.0f / 60.0f;
+static const float Overloaded = Target * 1.5f;
+static const float Cheap = Target * 0.3f;              // busy time well under HeadroomRatio
+static const float Affordable = Target * 0.8f;         // busy time between headroom and overload
+
+struct FeedResult
+{
+    int Changes;
+    int FirstChange;                                    // 1 based, 0 for none
+    float MinScale;                                     // the smallest and largest seen
+    float MaxScale;
+    bool Consistent;                                    // AddFrame true exactly when the scale moved
+};
+
+static uint32_t Random(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// -1 to 1
+static float Jitter(uint32_t* state)
+{
+    return (float)((double)Random(state) / 4294967295.0 * 2 - 1);
+}
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+static void Start(FeedResult* result, const DynamicResolution& controller)
+{
+    memset(result, 0, sizeof(*result));
+    result->MinScale = controller.GetScale();
+    result->MaxScale = controller.GetScale();
+    result->Consistent = true;
+}
+
+static void Add(DynamicResolution* controller, float frameTime, float busyTime, FeedResult* result, int frame)
+{
+    float before = controller->GetScale();
+    bool changed = controller->AddFrame(frameTime, busyTime);
+    float after = controller->GetScale();
+
+    if (changed != (after != before))
+        result->Consistent = false;
+    if (changed && result->Changes++ == 0)
+        result->FirstChange = frame;
+    if (after < result->MinScale)
+        result->MinScale = after;
+    if (after > result->MaxScale)
+        result->MaxScale = after;
+}
+
+static FeedResult Feed(DynamicResolution* controller, int frames, float frameTime, float busyTime)
+{
+    FeedResult result;
+    Start(&result, *controller);
+    for (int i = 1; i <= frames; i++)
+        Add(controller, frameTime, busyTime, &result, i);
+    return result;
+}
+
+static void Prepare(DynamicResolution* controller, float minScale, float maxScale, float scale)
+{
+    controller->SetTargetFrameTime(Target);
+    controller->SetBounds(minScale, maxScale);
+    controller->Reset(scale);
+}
+
+static const char* CheckShrink()
+{
+    DynamicResolution controller;
+    Prepare(&controller, 0.5f, 1.0f, 1.0f);
+
+    FeedResult result = Feed(&controller, SampleCount, Overloaded, Overloaded);
+    if (!result.Consistent)
+        return "AddFrame and the scale disagree while shrinking";
+    if (result.Changes != 1 || result.FirstChange != SampleCount)
+        return "overload didn't shrink after exactly one window";
+    if (!Near(controller.GetScale(), 1.0f - ScaleDownStep))
+        return "overload shrank by the wrong step";
+    return nullptr;
+}
+
+static const char* CheckGrow()
+{
+    DynamicResolution controller;
+    Prepare(&controller, 0.5f, 1.0f, 0.5f);
+
+    // the first decision comes with the first full window, and each one after is a cheap frame
+    int growsAt = SampleCount - 1 + ScaleUpSampleCount;
+    FeedResult result = Feed(&controller, growsAt, Target, Cheap);
+    if (!result.Consistent)
+        return "AddFrame and the scale disagree while growing";
+    if (result.Changes != 1 || result.FirstChange != growsAt)
+        return "cheap frames didn't grow after exactly ScaleUpSampleCount of them";
+    if (!Near(controller.GetScale(), 0.5f + ScaleUpStep))
+        return "cheap frames grew by the wrong step";
+
+    // one expensive frame starts the run over, counting again only once it has left the window
+    Prepare(&controller, 0.5f, 1.0f, 0.5f);
+    result = Feed(&controller, growsAt - 1, Target, Cheap);
+    if (result.Changes != 0)
+        return "grew before ScaleUpSampleCount cheap frames";
+
+    Start(&result, controller);
+    Add(&controller, Target, Target * SampleCount, &result, 1);
+    for (int i = 2; i <= SampleCount + ScaleUpSampleCount; i++)
+        Add(&controller, Target, Cheap, &result, i);
+    if (result.Changes != 1 || result.FirstChange != SampleCount + ScaleUpSampleCount)
+        return "an expensive frame didn't start the cheap run over";
+    return nullptr;
+}
+
+static const char* CheckCooldown()
+{
+    DynamicResolution controller;
+    Prepare(&controller, 0.5f, 1.0f, 1.0f);
+
+    if (Feed(&controller, SampleCount, Overloaded, Overloaded).Changes != 1)
+        return "overload didn't shrink before the cooldown";
+
+    // wild frames while the new size settles must be forgotten...
+    FeedResult result = Feed(&controller, CooldownFrames, Target * 10, Target * 10);
+    if (result.Changes != 0)
+        return "changed during the cooldown";
+
+    // ...so cheap frames after it grow on time, rather than the wild ones shrinking it again
+    result = Feed(&controller, SampleCount - 1 + ScaleUpSampleCount, Target, Cheap);
+    if (result.Changes != 1 || result.FirstChange != SampleCount - 1 + ScaleUpSampleCount)
+        return "frames from the cooldown counted towards the next change";
+    if (!Near(controller.GetScale(), 1.0f - ScaleDownStep + ScaleUpStep))
+        return "wrong scale after the cooldown";
+    return nullptr;
+}
+
+static const char* CheckBounds(int frames)
+{
+    DynamicResolution controller;
+
+    // either order, and the current scale is pulled inside
+    Prepare(&controller, 0.9f, 0.6f, 1.0f);
+    if (!Near(controller.GetMinScale(), 0.6f) || !Near(controller.GetMaxScale(), 0.9f))
+        return "swapped bounds weren't put in order";
+    if (!Near(controller.GetScale(), 0.9f))
+        return "Reset left the scale above the bounds";
+
+    FeedResult result = Feed(&controller, frames, Target * 4, Target * 4);
+    if (!result.Consistent)
+        return "AddFrame and the scale disagree at the bounds";
+    if (result.MinScale < 0.6f - 1e-4f || !Near(controller.GetScale(), 0.6f))
+        return "overload didn't stop at the lower bound";
+
+    result = Feed(&controller, frames, Target, Cheap);
+    if (result.MaxScale > 0.9f + 1e-4f || !Near(controller.GetScale(), 0.9f))
+        return "cheap frames didn't stop at the upper bound";
+
+    controller.SetBounds(0.7f, 0.8f);
+    if (!Near(controller.GetScale(), 0.8f))
+        return "narrowing the bounds left the scale outside them";
+    return nullptr;
+}
+
+static const char* CheckSteady(int frames, uint32_t seed)
+{
+    DynamicResolution controller;
+
+    // right on the target with no room to grow
+    Prepare(&controller, 0.5f, 1.0f, 1.0f);
+    if (Feed(&controller, frames, Target, Affordable).Changes != 0)
+        return "steady affordable load changed the scale";
+
+    // the same, with every frame up to 10% either way
+    uint32_t random = seed != 0 ? seed : 1;
+    FeedResult result;
+    Start(&result, controller);
+    for (int i = 1; i <= frames; i++)
+    {
+        float frameTime = Target * (1 + 0.1f * Jitter(&random));
+        Add(&controller, frameTime, frameTime * 0.8f, &result, i);
+    }
+    if (result.Changes != 0)
+        return "jittery affordable load changed the scale";
+
+    // a cost that grows with the pixels: too much at full size, affordable one step down but
+    // without the headroom to come back up, so it should settle after the one change
+    Prepare(&controller, 0.5f, 1.0f, 1.0f);
+    Start(&result, controller);
+    for (int i = 1; i <= frames; i++)
+    {
+        float scale = controller.GetScale();
+        float busyTime = Target * 1.3f * scale * scale;
+        float frameTime = (busyTime > Target ? busyTime : Target) * (1 + 0.05f * Jitter(&random));
+        Add(&controller, frameTime, busyTime, &result, i);
+    }
+    if (result.Changes != 1)
+        return "a load one step down can afford didn't settle there";
+    if (!Near(controller.GetScale(), 1.0f - ScaleDownStep))
+        return "settled at the wrong scale";
+    return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 10000;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--frames n] [--seed n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // enough for the bounds check to walk the whole range both ways
+    if (frames < 2000)
+        frames = 2000;
+
+    const char* names[] = { "shrink", "grow", "cooldown", "bounds", "steady" };
+    const char* failures[] = { CheckShrink(), CheckGrow(), CheckCooldown(), CheckBounds(frames), CheckSteady(frames, seed) };
+
+    int failed = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        printf("{\"check\": \"%s\", \"frames\": %d, \"ok\": %s}\n", names[i], frames, failures[i] == nullptr ? "true" : "false");
+        if (failures[i] != nullptr)
+        {
+            fprintf(stderr, "%s failed: %s\n", names[i], failures[i]);
+            failed++;
+        }
+    }
+
+    if (failed != 0)
+        return 1;
+
+    fprintf(stderr, "shrink, grow, cooldown, bounds and steady load all behave\n");
+    return 0;
+}
@@ -0,0 +1,241 @@
+// Checks GardenExport under load: this process publishes frames as fast as it can while a
+// forked reader process copies them out and checks every copy is one whole frame.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenexportcheck GardenExportCheck.cpp
+//         ../NodeGardenDirect3DComp/GardenExport.cpp ../NodeGardenDirect3DComp/Garden.cpp
+//         ../NodeGardenDirect3DComp/Quadtree.cpp ../NodeGardenDirect3DComp/DensityField.cpp
+//         ../NodeGardenDirect3DComp/TaskPool.cpp ../NodeGardenDirect3DComp/TimerWheel.cpp
+//         ../NodeGardenDirect3DComp/MotionIntegrator.cpp ../NodeGardenDirect3DComp/Profiler.cpp -pthread -lrt
+//
+// gardenexportcheck [--seconds 3] [--nodes 2000] [--garden]
+//     By default every value in a frame is derived from its frame number, so a copy mixing two
+//     frames is caught wherever it tears. With --garden a real garden is stepped and published,
+//     and the reader checks what it can: counts within capacity and edges within the node list.
+//     Either way frame numbers must never go backwards. Exits 1 on any failure.
+
+#include "GardenExport.h"
+#include "Garden.h"
+
+#include <chrono>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ReaderResult
+{
+    uint64_t Reads;
+    uint64_t Failed;            // gave up after being lapped every attempt
+    uint64_t Torn;
+    uint64_t Backwards;
+    uint64_t DistinctFrames;
+    uint64_t LastFrame;
+};
+
+static float FrameNodeX(uint64_t frame)
+{
+    return (float)(frame % 1000000);
+}
+
+static uint32_t FrameNodeCount(uint64_t frame, uint32_t capacity)
+{
+    return capacity / 2 + (uint32_t)(frame % (capacity / 2));
+}
+
+// frame is the number EndFrame is about to hand out
+static void WriteSyntheticFrame(GardenExport& region, uint64_t frame)
+{
+    GardenExportSlot slot;
+    region.BeginFrame(&slot);
+
+    uint32_t nodeCount = FrameNodeCount(frame, slot.NodeCapacity);
+    for (uint32_t i = 0; i < nodeCount; i++)
+    {
+        slot.Nodes[i].X = FrameNodeX(frame);
+        slot.Nodes[i].Y = (float)i;
+        slot.Nodes[i].Size = (float)(frame % 50);
+        slot.Nodes[i].Id = (int)((uint32_t)frame ^ i);
+    }
+
+    uint32_t edgeCount = nodeCount < slot.EdgeCapacity ? nodeCount : slot.EdgeCapacity;
+    for (uint32_t i = 0; i < edgeCount; i++)
+    {
+        slot.Edges[i].First = i;
+        slot.Edges[i].Second = (uint32_t)((i + frame) % nodeCount);
+    }
+
+    region.EndFrame((float)frame, (float)frame, nodeCount, edgeCount, nodeCount, edgeCount);
+}
+
+static bool CheckSyntheticFrame(const GardenExportFrame& copy, uint32_t capacity)
+{
+    uint64_t frame = copy.Frame;
+    if (copy.Width != (float)frame || copy.Nodes.size() != FrameNodeCount(frame, capacity))
+        return false;
+
+    for (uint32_t i = 0; i < copy.Nodes.size(); i++)
+    {
+        const GardenExportNode& node = copy.Nodes[i];
+        if (node.X != FrameNodeX(frame) || node.Y != (float)i || node.Size != (float)(frame % 50) || node.Id != (int)((uint32_t)frame ^ i))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < copy.Edges.size(); i++)
+    {
+        if (copy.Edges[i].First != i || copy.Edges[i].Second != (uint32_t)((i + frame) % copy.Nodes.size()))
+            return false;
+    }
+
+    return true;
+}
+
+static bool CheckGardenFrame(const GardenExportFrame& copy)
+{
+    if (copy.Nodes.size() > copy.TotalNodes || copy.Edges.size() > copy.TotalEdges)
+        return false;
+
+    for (size_t i = 0; i < copy.Edges.size(); i++)
+    {
+        if (copy.Edges[i].First >= copy.Edges[i].Second || copy.Edges[i].Second >= copy.Nodes.size())
+            return false;
+    }
+
+    return true;
+}
+
+static void RunReader(const std::string& name, double seconds, uint32_t capacity, bool garden, ReaderResult* result)
+{
+    memset(result, 0, sizeof(*result));
+
+    GardenExport region;
+    Clock::time_point start = Clock::now();
+    while (!region.Open(name))
+    {
+        if (Clock::now() - start > std::chrono::seconds(5))
+            return;
+        usleep(1000);
+    }
+
+    GardenExportFrame copy;
+    Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    while (Clock::now() < end)
+    {
+        if (!region.Read(&copy))
+        {
+            // before the first publish there's nothing to read, which isn't being lapped
+            if (result->Reads > 0)
+                result->Failed++;
+            continue;
+        }
+
+        result->Reads++;
+        if (copy.Frame < result->LastFrame)
+            result->Backwards++;
+        if (copy.Frame != result->LastFrame)
+            result->DistinctFrames++;
+        result->LastFrame = copy.Frame;
+
+        if (garden ? !CheckGardenFrame(copy) : !CheckSyntheticFrame(copy, capacity))
+            result->Torn++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 3;
+    uint32_t nodes = 2000;
+    bool garden = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc)
+            nodes = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--garden") == 0)
+            garden = true;
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds s] [--nodes n] [--garden]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (nodes < 2)
+        nodes = 2;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/gardenexportcheck-%d", (int)getpid());
+
+    GardenExport region;
+    uint32_t edgeCapacity = garden ? nodes * 8 : nodes;
+    if (!region.Create(name, nodes, edgeCapacity))
+    {
+        fprintf(stderr, "can't create shared memory %s\n", name);
+        return 1;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        return 1;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        ReaderResult result;
+        RunReader(name, seconds, nodes, garden, &result);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+
+    Garden simulation;
+    if (garden)
+    {
+        simulation.SetSeed(1);
+        simulation.SetSize(480, 800);
+        simulation.AddMyNode();
+        simulation.SetNodeCount((int)nodes);
+    }
+
+    // keep publishing a little past the reader's deadline so it never sits waiting
+    uint64_t published = 0;
+    Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds + 0.5));
+    while (Clock::now() < end)
+    {
+        if (garden)
+        {
+            simulation.Update(0, 1.0f / 60.0f);
+            region.Publish(simulation);
+        }
+        else
+        {
+            WriteSyntheticFrame(region, published + 1);
+        }
+        published++;
+    }
+
+    ReaderResult result;
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (got != (ssize_t)sizeof(result) || result.Reads == 0)
+    {
+        fprintf(stderr, "reader never read a frame\n");
+        return 1;
+    }
+
+    printf("{\"mode\": \"%s\", \"nodes\": %u, \"published\": %llu, \"reads\": %llu, \"distinct_frames\": %llu, \"lapped\": %llu, \"torn\": %llu, \"backwards\": %llu}\n",
+        garden ? "garden" : "synthetic", nodes, (unsigned long long)published, (unsigned long long)result.Reads, (unsigned long long)result.DistinctFrames,
+        (unsigned long long)result.Failed, (unsigned long long)result.Torn, (unsigned long long)result.Backwards);
+
+    return result.Torn == 0 && result.Backwards == 0 ? 0 : 1;
+}
@@ -0,0 +1,475 @@
+// Headless check of TaskPool and FrameGraph, and of the frame XTKRenderer runs on them: the
+// update, then capturing it side by side with a stand-in for the state export, then the
+// heatmap and LOD builds side by side, as Simulate and Render do.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenframegraphcheck GardenFrameGraphCheck.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/FrameGraph.cpp
+//         ../NodeGardenDirect3DComp/MotionIntegrator.cpp ../NodeGardenDirect3DComp/FrameState.cpp
+//         ../NodeGardenDirect3DComp/Heatmap.cpp ../NodeGardenDirect3DComp/GardenLod.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenframegraphcheck [options]
+//     --nodes 1000,10000          node counts to sweep
+//     --distributions a,b,...     uniform, clustered, ring, cell (default uniform,clustered)
+//     --frames 100                frames run per case, each way
+//     --workers n                 pool workers (default one fewer than the cores, at least 1)
+//     --seed 1
+//
+// First the pool on its own: ForEach must run every index exactly once, a graph of stages
+// with a diamond of dependencies must start no stage before the ones it waits on have
+// finished, and of two graphs run from two threads at once neither thread may run a stage of
+// the other's, all many times over. spawn_us against foreach_us is what the connection pass
+// used to pay starting and joining threads every frame against handing the same slices to
+// the pool.
+//
+// Then each case runs the frame twice from the same seed, once with the stages called one
+// after another and once as graphs on the pool, and the captured state, heatmap levels and
+// LOD must match frame for frame. Reports the average time of each stage, where it started
+// in its graph and the graphs' wall time, as JSON. Exits 1 on any failure.
+
+#include "Garden.h"
+#include "TaskPool.h"
+#include "FrameGraph.h"
+#include "FrameState.h"
+#include "Heatmap.h"
+#include "GardenLod.h"
+#include "Scenario.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float FrameDelta = 1.0f / 60.0f;
+static const int PoolRounds = 2000;
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    int Frames;
+    int Workers;
+    uint32_t Seed;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static uint64_t Fnv(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+template <typename T>
+static uint64_t Fnv(uint64_t hash, const std::vector<T>& values)
+{
+    return values.empty() ? hash : Fnv(hash, &values[0], values.size() * sizeof(T));
+}
+
+// which graph this thread is calling Run on, -1 on pool workers and the main thread
+static thread_local int t_runningGraph = -1;
+
+static bool CheckPool(TaskPool& pool)
+{
+    bool ok = true;
+
+    // every index once, for slice counts around the worker count
+    std::vector<std::atomic<int> > hits(64);
+    for (int round = 0; round < PoolRounds && ok; round++)
+    {
+        int count = 1 + round % 64;
+        for (int i = 0; i < count; i++)
+            hits[i] = 0;
+
+        pool.ForEach(count, [&hits](int i) { hits[i]++; });
+
+        for (int i = 0; i < count; i++)
+        {
+            if (hits[i] != 1)
+            {
+                fprintf(stderr, "ForEach(%d) ran index %d %d times\n", count, i, (int)hits[i]);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    // a diamond, a, then b and c side by side, then d, with an independent e; each stage
+    // stamps when it started and finished on one shared clock
+    std::atomic<int> clock(0);
+    int started[5], finished[5];
+    FrameGraph graph;
+    for (int s = 0; s < 5; s++)
+    {
+        static const char* names[] = { "a", "b", "c", "d", "e" };
+        graph.AddStage(names[s], [&clock, &started, &finished, s]()
+        {
+            started[s] = clock++;
+            std::this_thread::yield();
+            finished[s] = clock++;
+        });
+    }
+    graph.AddDependency(1, 0);
+    graph.AddDependency(2, 0);
+    graph.AddDependency(3, 1);
+    graph.AddDependency(3, 2);
+
+    static const int Edges[][2] = { { 1, 0 }, { 2, 0 }, { 3, 1 }, { 3, 2 } };
+    for (int round = 0; round < PoolRounds && ok; round++)
+    {
+        graph.Run(pool);
+        for (int e = 0; e < 4; e++)
+        {
+            if (started[Edges[e][0]] < finished[Edges[e][1]])
+            {
+                fprintf(stderr, "stage %s started before %s finished\n",
+                    graph.GetStageName(Edges[e][0]), graph.GetStageName(Edges[e][1]));
+                ok = false;
+            }
+        }
+    }
+
+    // two graphs run from two threads on the one pool, as the frame worker's simulation and
+    // the render thread's drawing are; neither caller may end up running the other's stages
+    std::atomic<int> foreign(0);
+    FrameGraph shared[2];
+    for (int g = 0; g < 2; g++)
+    {
+        for (int s = 0; s < 4; s++)
+        {
+            static const char* names[] = { "w", "x", "y", "z" };
+            shared[g].AddStage(names[s], [&foreign, g]()
+            {
+                if (t_runningGraph >= 0 && t_runningGraph != g)
+                    foreign++;
+                std::this_thread::yield();
+            });
+        }
+    }
+    std::thread runners[2];
+    for (int g = 0; g < 2; g++)
+    {
+        runners[g] = std::thread([&pool, &shared, g]()
+        {
+            t_runningGraph = g;
+            for (int round = 0; round < PoolRounds; round++)
+                shared[g].Run(pool);
+        });
+    }
+    runners[0].join();
+    runners[1].join();
+    if (foreign != 0)
+    {
+        fprintf(stderr, "a graph's caller ran %d stages of the other graph\n", (int)foreign);
+        ok = false;
+    }
+
+    // what a frame's thread handling costs, without the work
+    int slices = pool.GetWorkerCount() + 1;
+    Clock::time_point start = Clock::now();
+    for (int round = 0; round < PoolRounds; round++)
+    {
+        std::vector<std::thread> threads;
+        for (int t = 1; t < slices; t++)
+            threads.push_back(std::thread([]() {}));
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+    }
+    Clock::time_point spawned = Clock::now();
+    for (int round = 0; round < PoolRounds; round++)
+    {
+        pool.ForEach(slices, [](int) {});
+    }
+    Clock::time_point pooled = Clock::now();
+
+    printf("{\"pool\": {\"workers\": %d, \"slices\": %d, \"spawn_us\": %.2f, \"foreach_us\": %.2f, \"ok\": %s}}\n",
+        pool.GetWorkerCount(), slices, Elapsed(start, spawned) / PoolRounds, Elapsed(spawned, pooled) / PoolRounds,
+        ok ? "true" : "false");
+    fflush(stdout);
+    return ok;
+}
+
+// the frame's stages, on one garden; run either through the graphs or straight through
+class Frame
+{
+public:
+    Frame(Distribution distribution, int nodeCount, uint32_t seed)
+    {
+        Scenario::Populate(m_garden, distribution, nodeCount, seed);
+        m_number = 0;
+        m_summary = 0;
+        m_heatmap.SetSource(HeatmapSource_Edges);
+
+        int update = m_simGraph.AddStage("Update", [this]() { Update(); });
+        int capture = m_simGraph.AddStage("CaptureFrame", [this]() { Capture(); });
+        int summarise = m_simGraph.AddStage("StateExport", [this]() { Summarise(); });
+        m_simGraph.AddDependency(capture, update);
+        m_simGraph.AddDependency(summarise, update);
+        m_drawGraph.AddStage("BuildHeatmap", [this]() { BuildHeatmap(); });
+        m_drawGraph.AddStage("BuildLod", [this]() { BuildLod(); });
+    }
+
+    void Step(TaskPool* pool)
+    {
+        m_number++;
+        if (pool != nullptr)
+        {
+            m_simGraph.Run(*pool);
+            m_frames.Swap();
+            m_drawGraph.Run(*pool);
+        }
+        else
+        {
+            Update();
+            Capture();
+            Summarise();
+            m_frames.Swap();
+            BuildHeatmap();
+            BuildLod();
+        }
+    }
+
+    uint64_t Hash() const
+    {
+        const FrameState& front = m_frames.Front();
+        uint64_t hash = Fnv(14695981039346656037ull, front.Nodes);
+        hash = Fnv(hash, front.Edges);
+        hash = Fnv(hash, m_heatmap.GetLevels());
+        hash = Fnv(hash, m_lod.GetNodes());
+        hash = Fnv(hash, m_lod.GetEdges());
+        return Fnv(hash, &m_summary, sizeof(m_summary));
+    }
+
+    const FrameGraph& GetSimGraph() const { return m_simGraph; }
+    const FrameGraph& GetDrawGraph() const { return m_drawGraph; }
+
+private:
+    void Update()
+    {
+        m_garden.Update(m_number * FrameDelta, FrameDelta);
+    }
+
+    void Capture()
+    {
+        m_frames.Back().Capture(m_garden, m_number);
+    }
+
+    // reads the whole garden as Publish does
+    void Summarise()
+    {
+        const std::vector<GardenNode>& nodes = m_garden.GetNodes();
+        double summary = 0;
+        for (size_t i = 0; i < nodes.size(); i++)
+            summary += nodes[i].X + nodes[i].Y + nodes[i].Size;
+        m_summary = summary + m_garden.GetEdges().size();
+    }
+
+    void BuildHeatmap()
+    {
+        const FrameState& front = m_frames.Front();
+        m_heatmap.Build(front.Nodes, front.Edges, m_garden.GetWidth(), m_garden.GetHeight());
+    }
+
+    void BuildLod()
+    {
+        const FrameState& front = m_frames.Front();
+        m_lod.Build(front.Nodes, front.Edges, front.HasMyNode, m_garden.GetWidth() / 2, m_garden.GetHeight() / 2);
+    }
+
+    Garden m_garden;
+    FrameStateBuffer m_frames;
+    Heatmap m_heatmap;
+    GardenLod m_lod;
+    FrameGraph m_simGraph;
+    FrameGraph m_drawGraph;
+    uint64_t m_number;
+    double m_summary;
+};
+
+static void AppendStages(const FrameGraph& graph, const std::vector<double>& times, const std::vector<double>& starts,
+    int frames, std::string* json)
+{
+    char text[160];
+    for (int i = 0; i < graph.GetStageCount(); i++)
+    {
+        snprintf(text, sizeof(text), "%s\"%s\": {\"ms\": %.4f, \"start_ms\": %.4f}", json->empty() ? "" : ", ",
+            graph.GetStageName(i), times[i] / frames, starts[i] / frames);
+        *json += text;
+    }
+}
+
+static bool RunCase(const Options& options, TaskPool& pool, Distribution distribution, int nodeCount)
+{
+    Frame serial(distribution, nodeCount, options.Seed);
+    Frame graphed(distribution, nodeCount, options.Seed);
+
+    int mismatched = 0;
+    double serialUs = 0, graphedUs = 0, simRun = 0, drawRun = 0;
+    std::vector<double> simTimes(FrameGraph::MaxStages), simStarts(FrameGraph::MaxStages);
+    std::vector<double> drawTimes(FrameGraph::MaxStages), drawStarts(FrameGraph::MaxStages);
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        Clock::time_point start = Clock::now();
+        serial.Step(nullptr);
+        Clock::time_point stepped = Clock::now();
+        graphed.Step(&pool);
+        Clock::time_point graphedEnd = Clock::now();
+        serialUs += Elapsed(start, stepped);
+        graphedUs += Elapsed(stepped, graphedEnd);
+
+        if (serial.Hash() != graphed.Hash())
+            mismatched++;
+
+        const FrameGraph& sim = graphed.GetSimGraph();
+        const FrameGraph& draw = graphed.GetDrawGraph();
+        for (int i = 0; i < sim.GetStageCount(); i++)
+        {
+            simTimes[i] += sim.GetStageTime(i);
+            simStarts[i] += sim.GetStageStart(i);
+        }
+        for (int i = 0; i < draw.GetStageCount(); i++)
+        {
+            drawTimes[i] += draw.GetStageTime(i);
+            drawStarts[i] += draw.GetStageStart(i);
+        }
+        simRun += sim.GetRunTime();
+        drawRun += draw.GetRunTime();
+    }
+
+    bool ok = mismatched == 0;
+    if (!ok)
+        fprintf(stderr, "%s %d: %d of %d frames differ between the graphs and the serial run\n",
+            DistributionName(distribution), nodeCount, mismatched, options.Frames);
+
+    std::string stages;
+    AppendStages(graphed.GetSimGraph(), simTimes, simStarts, options.Frames, &stages);
+    AppendStages(graphed.GetDrawGraph(), drawTimes, drawStarts, options.Frames, &stages);
+    double frames = options.Frames;
+    printf("{\"distribution\": \"%s\", \"nodes\": %d, \"frames\": %d, \"workers\": %d, \"serial_ms\": %.4f, \"graph_ms\": %.4f, "
+        "\"sim_graph_ms\": %.4f, \"draw_graph_ms\": %.4f, \"stages\": {%s}, \"mismatched\": %d, \"ok\": %s}\n",
+        DistributionName(distribution), nodeCount, options.Frames, pool.GetWorkerCount(), serialUs / frames / 1000,
+        graphedUs / frames / 1000, simRun / frames, drawRun / frames, stages.c_str(), mismatched, ok ? "true" : "false");
+    fflush(stdout);
+
+    fprintf(stderr, "%-10s %7d  serial %8.3f ms  graphs %8.3f ms%s\n", DistributionName(distribution), nodeCount,
+        serialUs / frames / 1000, graphedUs / frames / 1000, ok ? "" : "  FAILED");
+
+    return ok;
+}
+
+static bool ParseNodeCounts(const char* text, std::vector<int>* counts)
+{
+    counts->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long count = strtol(text, &end, 10);
+        if (end == text || count < 1)
+            return false;
+
+        counts->push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !counts->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultNodeCounts[] = { 1000, 10000 };
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Distributions.clear();
+    options->Distributions.push_back(Distribution_Uniform);
+    options->Distributions.push_back(Distribution_Clustered);
+    options->Frames = 100;
+    options->Workers = TaskPool::DefaultWorkerCount() > 0 ? TaskPool::DefaultWorkerCount() : 1;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseNodeCounts(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--workers") == 0)
+            options->Workers = atoi(value) > 0 ? atoi(value) : 0;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 1000,10000,...] [--distributions uniform,clustered,ring,cell] [--frames n]\n"
+                        "       [--workers n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    TaskPool pool(options.Workers);
+    bool ok = CheckPool(pool);
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t n = 0; n < options.NodeCounts.size(); n++)
+        {
+            ok = RunCase(options, pool, options.Distributions[d], options.NodeCounts[n]) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
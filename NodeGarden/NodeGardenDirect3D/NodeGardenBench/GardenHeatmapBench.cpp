@@ -0,0 +1,370 @@
+// Compares drawing a garden's connections as lines against drawing them as a Heatmap: what
+// each costs the frame on the CPU and how many sprites each submits. Also the headless check
+// of the heatmap, through Heatmap::Colourise in place of the pixel shader.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenheatmapbench GardenHeatmapBench.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/Heatmap.cpp
+//         ../NodeGardenDirect3DComp/CullRect.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenheatmapbench [options]
+//     --nodes 1000,10000,100000   node counts to sweep
+//     --distributions a,b,...     uniform, clustered, ring, cell (default all but cell, which
+//                                 connects every pair and doesn't fit in memory past a few thousand)
+//     --frames 10                 frames measured per case
+//     --seed 1
+//     --cell-size 16              see Heatmap::SetCellSize
+//     --blur 3                    see Heatmap::SetBlurRadius
+//     --connectedness             build from node connectedness instead of edges
+//     --image prefix              write each case's last frame as prefix-<distribution>-<nodes>.ppm,
+//                                 over the background the app clears to
+//
+// lines_ns is the CPU side of XTKRenderer::Render's line loop, the cull tests and line geometry
+// without SpriteBatch; heatmap_ns is Heatmap::Build plus filling the levels texture as
+// DrawHeatmap does. lines_over_heatmap is the first over the second, so above 1 the heatmap is
+// the cheaper. The GPU side is one sprite against one per line. Each case also checks that the
+// same garden builds the same levels twice, how much of the density the blur keeps on screen,
+// and that Colourise covers every pixel; exits 1 if any of that fails.
+
+#include "Garden.h"
+#include "Heatmap.h"
+#include "CullRect.h"
+#include "Scenario.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int WarmupFrames = 2;
+static const float FrameDelta = 1.0f / 60.0f;
+static const uint8_t Background[3] = { 26, 26, 26 };   // XTKRenderer's bgColor
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    int Frames;
+    uint32_t Seed;
+    float CellSize;
+    int BlurRadius;
+    HeatmapSource Source;
+    std::string ImagePrefix;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Render's line loop without the device, as GardenLodBench walks it
+static int WalkLines(const Garden& garden, const CullRect& visible, double* checksum)
+{
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+    int linesDrawn = 0;
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const GardenNode& node1 = nodes[edges[i].First];
+        const GardenNode& node2 = nodes[edges[i].Second];
+        float stroke = Garden::Map(edges[i].Distance, 0, Garden::MinDist, 7.0f, 2.0f);
+        float length = sqrtf((node2.X - node1.X) * (node2.X - node1.X) + (node2.Y - node1.Y) * (node2.Y - node1.Y));
+        float rotation = atan2f(node2.Y - node1.Y, node1.X - node2.X);
+        if (visible.IntersectsSegment(node1.X, node1.Y, node2.X, node2.Y, stroke))
+        {
+            *checksum += length + rotation;
+            linesDrawn++;
+        }
+    }
+
+    return linesDrawn;
+}
+
+// DrawHeatmap's copy in to the mapped texture, rows padded as a driver might
+static void FillTexture(const Heatmap& heatmap, std::vector<uint32_t>* texels)
+{
+    int columns = heatmap.GetColumns();
+    int pitch = (columns + 15) & ~15;
+    texels->resize((size_t)pitch * heatmap.GetRows());
+
+    const std::vector<uint8_t>& levels = heatmap.GetLevels();
+    for (int row = 0; row < heatmap.GetRows(); row++)
+    {
+        uint32_t* out = &(*texels)[(size_t)row * pitch];
+        for (int column = 0; column < columns; column++)
+        {
+            out[column] = levels[row * columns + column] * 0x01010101u;
+        }
+    }
+}
+
+static bool WriteImage(const std::string& path, const std::vector<uint32_t>& pixels, int width, int height)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<uint8_t> row(width * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            // blended over the background as the blend state does
+            uint32_t pixel = pixels[(size_t)y * width + x];
+            float alpha = (pixel >> 24) / 255.0f;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                float colour = ((pixel >> (channel * 8)) & 0xff) * alpha + Background[channel] * (1 - alpha);
+                row[x * 3 + channel] = (uint8_t)(colour + 0.5f);
+            }
+        }
+        fwrite(&row[0], 1, row.size(), file);
+    }
+
+    return fclose(file) == 0;
+}
+
+static double Total(const std::vector<float>& values)
+{
+    double total = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        total += values[i];
+    }
+    return total;
+}
+
+static bool RunCase(const Options& options, Distribution distribution, int nodeCount)
+{
+    Garden garden;
+    Scenario::Populate(garden, distribution, nodeCount, options.Seed);
+
+    Heatmap heatmap;
+    heatmap.SetSource(options.Source);
+    heatmap.SetCellSize(options.CellSize);
+    heatmap.SetBlurRadius(options.BlurRadius);
+
+    float width = garden.GetWidth();
+    float height = garden.GetHeight();
+    CullRect visible(0, 0, width, height);
+    std::vector<uint32_t> texels;
+
+    float timeTotal = 0;
+    for (int i = 0; i < WarmupFrames; i++)
+    {
+        timeTotal += FrameDelta;
+        garden.Update(timeTotal, FrameDelta);
+        heatmap.Build(garden, width, height);
+    }
+
+    double linesNs = 0, heatmapNs = 0, lines = 0, edges = 0, checksum = 0;
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        timeTotal += FrameDelta;
+        garden.Update(timeTotal, FrameDelta);
+        edges += (double)garden.GetEdges().size();
+
+        Clock::time_point start = Clock::now();
+        lines += WalkLines(garden, visible, &checksum);
+        Clock::time_point walked = Clock::now();
+        heatmap.Build(garden, width, height);
+        FillTexture(heatmap, &texels);
+        Clock::time_point built = Clock::now();
+
+        linesNs += Elapsed(start, walked);
+        heatmapNs += Elapsed(walked, built);
+    }
+
+    // a second heatmap that has seen the same peaks must come out the same
+    bool ok = true;
+    Heatmap again = heatmap;
+    again.Build(garden, width, height);
+    heatmap.Build(garden, width, height);
+    if (again.GetLevels() != heatmap.GetLevels())
+    {
+        fprintf(stderr, "%s %d: levels differ between builds of the same garden\n", DistributionName(distribution), nodeCount);
+        ok = false;
+    }
+
+    Heatmap unblurred = heatmap;
+    unblurred.SetBlurRadius(0);
+    unblurred.Build(garden, width, height);
+    double before = Total(unblurred.GetDensity());
+    double kept = before > 0 ? Total(heatmap.GetDensity()) / before : 1;
+    if (kept > 1.0001)
+    {
+        fprintf(stderr, "%s %d: the blur added density (%.6f)\n", DistributionName(distribution), nodeCount, kept);
+        ok = false;
+    }
+
+    int imageWidth = (int)width, imageHeight = (int)height;
+    std::vector<uint32_t> pixels;
+    Clock::time_point start = Clock::now();
+    heatmap.Colourise(imageWidth, imageHeight, &pixels);
+    double colouriseNs = Elapsed(start, Clock::now());
+    if (pixels.size() != (size_t)imageWidth * imageHeight)
+    {
+        fprintf(stderr, "%s %d: Colourise gave %zu pixels for %dx%d\n", DistributionName(distribution), nodeCount, pixels.size(), imageWidth, imageHeight);
+        ok = false;
+    }
+
+    int lit = 0;
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        if ((pixels[i] >> 24) != 0)
+            lit++;
+    }
+
+    if (!options.ImagePrefix.empty())
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s-%s-%d.ppm", options.ImagePrefix.c_str(), DistributionName(distribution), nodeCount);
+        if (!WriteImage(path, pixels, imageWidth, imageHeight))
+        {
+            fprintf(stderr, "couldn't write %s\n", path);
+            ok = false;
+        }
+    }
+
+    double frames = options.Frames;
+    printf("{\"distribution\": \"%s\", \"nodes\": %d, \"frames\": %d, \"edges\": %.0f, \"cells\": %d, "
+        "\"lines\": {\"drawn\": %.0f, \"sprites\": %.0f, \"cpu_ns\": %.0f}, "
+        "\"heatmap\": {\"sprites\": 1, \"cpu_ns\": %.0f, \"colourise_ns\": %.0f, \"lit_fraction\": %.4f, \"density_kept\": %.4f}, "
+        "\"lines_over_heatmap\": %.3f, \"ok\": %s, \"checksum\": %.6g}\n",
+        DistributionName(distribution), garden.GetNodeCount(), options.Frames, edges / frames, heatmap.GetColumns() * heatmap.GetRows(),
+        lines / frames, lines / frames, linesNs / frames, heatmapNs / frames, colouriseNs,
+        pixels.empty() ? 0.0 : (double)lit / pixels.size(), kept, heatmapNs > 0 ? linesNs / heatmapNs : 0.0,
+        ok ? "true" : "false", checksum);
+    fflush(stdout);
+
+    fprintf(stderr, "%-10s %7d  %9.0f lines %9.3f ms  heatmap %9.3f ms  lines/heatmap %5.2fx%s\n",
+        DistributionName(distribution), nodeCount, lines / frames, linesNs / frames / 1e6, heatmapNs / frames / 1e6,
+        heatmapNs > 0 ? linesNs / heatmapNs : 0.0, ok ? "" : "  FAILED");
+
+    return ok;
+}
+
+static bool ParseNodeCounts(const char* text, std::vector<int>* counts)
+{
+    counts->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long count = strtol(text, &end, 10);
+        if (end == text || count < 1)
+            return false;
+
+        counts->push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !counts->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultNodeCounts[] = { 1000, 10000, 100000 };
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Distributions.clear();
+    options->Distributions.push_back(Distribution_Uniform);
+    options->Distributions.push_back(Distribution_Clustered);
+    options->Distributions.push_back(Distribution_Ring);
+    options->Frames = 10;
+    options->Seed = 1;
+    options->CellSize = Heatmap::DefaultCellSize;
+    options->BlurRadius = Heatmap::DefaultBlurRadius;
+    options->Source = HeatmapSource_Edges;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (strcmp(name, "--connectedness") == 0)
+        {
+            options->Source = HeatmapSource_Connectedness;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseNodeCounts(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(name, "--cell-size") == 0)
+            options->CellSize = (float)atof(value);
+        else if (strcmp(name, "--blur") == 0)
+            options->BlurRadius = atoi(value);
+        else if (strcmp(name, "--image") == 0)
+            options->ImagePrefix = value;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 1000,10000,...] [--distributions uniform,clustered,ring,cell] [--frames n]\n"
+                        "       [--seed n] [--cell-size s] [--blur cells] [--connectedness] [--image prefix]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t n = 0; n < options.NodeCounts.size(); n++)
+        {
+            ok = RunCase(options, options.Distributions[d], options.NodeCounts[n]) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
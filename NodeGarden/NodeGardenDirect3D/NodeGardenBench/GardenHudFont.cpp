@@ -0,0 +1,244 @@
+// Writes hud.spritefont, the font PerformanceHud draws its text with. MakeSpriteFont needs
+// Windows and an installed font, so the HUD uses a 5x7 pixel font built in here instead, which
+// also keeps the package free of font licensing.
+//
+// Build from this folder with
+//     g++ -O2 -std=c++11 -o gardenhudfont GardenHudFont.cpp
+//
+// gardenhudfont [--out ../NodeGardenDirect3DComp/hud.spritefont] [--scale 2]
+//     Every printable ASCII character, each pixel drawn scale x scale, in the DXTKfont layout
+//     SpriteFont reads: the glyphs sorted by character, line spacing, the default character
+//     ('?'), then an R8G8B8A8 texture. Texels are premultiplied white, as SpriteBatch expects,
+//     and glyphs sit a texel apart so filtering never pulls in a neighbour.
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int GlyphWidth = 5;
+static const int GlyphHeight = 7;
+static const int FirstCharacter = 32;
+static const int CharacterCount = 95;
+static const int Columns = 16;
+static const uint32_t FormatR8G8B8A8 = 28;      // DXGI_FORMAT_R8G8B8A8_UNORM
+
+// one byte per row, top first, the leftmost pixel in bit 4
+static const uint8_t Glyphs[CharacterCount][GlyphHeight] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // space
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   // !
+    { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 },   // "
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },   // #
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },   // $
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // %
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },   // &
+    { 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00 },   // '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   // (
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   // )
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },   // *
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   // +
+    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },   // ,
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   // .
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // /
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // 2
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // 4
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // 6
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // 8
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   // :
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },   // ;
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },   // <
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },   // =
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },   // >
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },   // ?
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },   // @
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // A
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   // B
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   // C
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   // D
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   // E
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   // F
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   // G
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // H
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   // L
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // N
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // O
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   // P
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   // Q
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   // R
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   // S
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   // W
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   // X
+    { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },   // Y
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },   // Z
+    { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },   // [
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },   // backslash
+    { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },   // ]
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },   // ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },   // _
+    { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },   // `
+    { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },   // a
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },   // b
+    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },   // c
+    { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },   // d
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },   // e
+    { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },   // f
+    { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // g
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },   // h
+    { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },   // i
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },   // j
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },   // k
+    { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // l
+    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },   // m
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },   // n
+    { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },   // o
+    { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },   // p
+    { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },   // q
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },   // r
+    { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },   // s
+    { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },   // t
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },   // u
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // v
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },   // w
+    { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },   // x
+    { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // y
+    { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },   // z
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },   // {
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // |
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },   // }
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },   // ~
+};
+
+// SpriteFont's Glyph: the character, its RECT in the texture, then offsets and advance
+struct FontGlyph
+{
+    uint32_t Character;
+    int32_t Left;
+    int32_t Top;
+    int32_t Right;
+    int32_t Bottom;
+    float XOffset;
+    float YOffset;
+    float XAdvance;
+};
+
+static uint32_t RoundUpToPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+static bool Write(FILE* file, const void* data, size_t size)
+{
+    return fwrite(data, 1, size, file) == size;
+}
+
+int main(int argc, char** argv)
+{
+    std::string out = "../NodeGardenDirect3DComp/hud.spritefont";
+    int scale = 2;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            out = argv[++i];
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+            scale = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--out file] [--scale n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (scale < 1)
+        scale = 1;
+
+    // feature level 9_3 only takes other sizes conditionally, so keep to powers of two
+    int cellWidth = GlyphWidth * scale + 1;
+    int cellHeight = GlyphHeight * scale + 1;
+    int rows = (CharacterCount + Columns - 1) / Columns;
+    uint32_t textureWidth = RoundUpToPowerOfTwo(Columns * cellWidth);
+    uint32_t textureHeight = RoundUpToPowerOfTwo(rows * cellHeight);
+    uint32_t stride = textureWidth * 4;
+
+    std::vector<FontGlyph> glyphs(CharacterCount);
+    std::vector<uint8_t> texels((size_t)stride * textureHeight, 0);
+
+    for (int c = 0; c < CharacterCount; c++)
+    {
+        int left = (c % Columns) * cellWidth;
+        int top = (c / Columns) * cellHeight;
+
+        FontGlyph& glyph = glyphs[c];
+        glyph.Character = FirstCharacter + c;
+        glyph.Left = left;
+        glyph.Top = top;
+        glyph.Right = left + GlyphWidth * scale;
+        glyph.Bottom = top + GlyphHeight * scale;
+        glyph.XOffset = 0;
+        glyph.YOffset = 0;
+        glyph.XAdvance = (float)scale;
+
+        for (int y = 0; y < GlyphHeight * scale; y++)
+        {
+            uint8_t bits = Glyphs[c][y / scale];
+            for (int x = 0; x < GlyphWidth * scale; x++)
+            {
+                if (bits & (0x10 >> (x / scale)))
+                    memset(&texels[(size_t)(top + y) * stride + (left + x) * 4], 0xFF, 4);
+            }
+        }
+    }
+
+    FILE* file = fopen(out.c_str(), "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "couldn't write %s\n", out.c_str());
+        return 1;
+    }
+
+    uint32_t glyphCount = CharacterCount;
+    float lineSpacing = (float)((GlyphHeight + 3) * scale);
+    uint32_t defaultCharacter = '?';
+
+    bool ok = Write(file, "DXTKfont", 8) &&
+        Write(file, &glyphCount, sizeof(glyphCount)) &&
+        Write(file, &glyphs[0], glyphs.size() * sizeof(FontGlyph)) &&
+        Write(file, &lineSpacing, sizeof(lineSpacing)) &&
+        Write(file, &defaultCharacter, sizeof(defaultCharacter)) &&
+        Write(file, &textureWidth, sizeof(textureWidth)) &&
+        Write(file, &textureHeight, sizeof(textureHeight)) &&
+        Write(file, &FormatR8G8B8A8, sizeof(FormatR8G8B8A8)) &&
+        Write(file, &stride, sizeof(stride)) &&
+        Write(file, &textureHeight, sizeof(textureHeight)) &&
+        Write(file, &texels[0], texels.size());
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok)
+    {
+        fprintf(stderr, "couldn't write %s\n", out.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %u glyphs, %ux%u texture, line spacing %g\n", out.c_str(), glyphCount, textureWidth, textureHeight, lineSpacing);
+    return 0;
+}
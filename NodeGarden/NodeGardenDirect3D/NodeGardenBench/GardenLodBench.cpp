@@ -0,0 +1,277 @@
+// Compares drawing a big garden node by node against drawing it through GardenLod: how many
+// sprites each would submit, and what each costs the frame on the CPU.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenlodbench GardenLodBench.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp ../NodeGardenDirect3DComp/DensityField.cpp
+//         ../NodeGardenDirect3DComp/GardenLod.cpp ../NodeGardenDirect3DComp/CullRect.cpp
+//         ../NodeGardenDirect3DComp/TaskPool.cpp ../NodeGardenDirect3DComp/TimerWheel.cpp
+//         ../NodeGardenDirect3DComp/MotionIntegrator.cpp ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenlodbench [options]
+//     --nodes 1000,10000,100000   node counts to sweep
+//     --distributions a,b,...     uniform, clustered, ring, cell (default all but cell, which
+//                                 connects every pair and doesn't fit in memory past a few thousand)
+//     --frames 10                 frames measured per case
+//     --seed 1
+//     --detail-radius 500         see GardenLod::SetDetailRadius
+//     --angle 0.5                 see GardenLod::SetAngle
+//
+// The whole garden is in view, as on the phone, with the detail around the middle where a
+// local node would be. walk_ns is the CPU side of XTKRenderer::Render's loop over what it
+// draws, the cull tests and line geometry without SpriteBatch; sprites counts four per node,
+// as NodeSprite draws them, and one per line. frame_ns is the simulation plus the walk, and
+// for the LOD the build too. Prints one JSON object per case per line.
+
+#include "Garden.h"
+#include "GardenLod.h"
+#include "CullRect.h"
+#include "Scenario.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int WarmupFrames = 2;
+static const float FrameDelta = 1.0f / 60.0f;
+static const int SpritesPerNode = 4;        // NodeSprite::SpritesPerNode
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    int Frames;
+    uint32_t Seed;
+    float DetailRadius;
+    float Angle;
+};
+
+// what one way of drawing cost, summed over the frames
+struct DrawCost
+{
+    double WalkNs;
+    double Nodes;
+    double Lines;
+    double Checksum;            // so the walk can't be optimised away
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Render's loop without the device: cull every node and line, and work out each line's
+// length and rotation as LineConnection::FormConnection does
+static void Walk(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges, const CullRect& visible, DrawCost* cost)
+{
+    Clock::time_point start = Clock::now();
+    double checksum = 0;
+    int nodesDrawn = 0, linesDrawn = 0;
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (visible.IntersectsCircle(nodes[i].X, nodes[i].Y, Garden::GetDrawRadius(nodes[i])))
+        {
+            checksum += nodes[i].Size;
+            nodesDrawn++;
+        }
+    }
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const GardenNode& node1 = nodes[edges[i].First];
+        const GardenNode& node2 = nodes[edges[i].Second];
+        float stroke = Garden::Map(edges[i].Distance, 0, Garden::MinDist, 7.0f, 2.0f);
+        float length = sqrtf((node2.X - node1.X) * (node2.X - node1.X) + (node2.Y - node1.Y) * (node2.Y - node1.Y));
+        float rotation = atan2f(node2.Y - node1.Y, node1.X - node2.X);
+        if (visible.IntersectsSegment(node1.X, node1.Y, node2.X, node2.Y, stroke))
+        {
+            checksum += length + rotation;
+            linesDrawn++;
+        }
+    }
+
+    cost->WalkNs += Elapsed(start, Clock::now());
+    cost->Nodes += nodesDrawn;
+    cost->Lines += linesDrawn;
+    cost->Checksum += checksum;
+}
+
+static void RunCase(const Options& options, Distribution distribution, int nodeCount)
+{
+    Garden garden;
+    Scenario::Populate(garden, distribution, nodeCount, options.Seed);
+
+    GardenLod lod;
+    lod.SetDetailRadius(options.DetailRadius);
+    lod.SetAngle(options.Angle);
+
+    CullRect visible(0, 0, garden.GetWidth(), garden.GetHeight());
+    float focusX = garden.GetWidth() / 2;
+    float focusY = garden.GetHeight() / 2;
+
+    float timeTotal = 0;
+    for (int i = 0; i < WarmupFrames; i++)
+    {
+        timeTotal += FrameDelta;
+        garden.Update(timeTotal, FrameDelta);
+        lod.Build(garden, focusX, focusY);
+    }
+
+    DrawCost full = DrawCost(), reduced = DrawCost();
+    double simNs = 0, lodNs = 0, clusters = 0, edges = 0;
+    int largest = 0;
+
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        timeTotal += FrameDelta;
+        Clock::time_point start = Clock::now();
+        garden.Update(timeTotal, FrameDelta);
+        Clock::time_point updated = Clock::now();
+        lod.Build(garden, focusX, focusY);
+        Clock::time_point built = Clock::now();
+
+        simNs += Elapsed(start, updated);
+        lodNs += Elapsed(updated, built);
+        clusters += lod.GetClusterCount();
+        edges += (double)garden.GetEdges().size();
+
+        Walk(garden.GetNodes(), garden.GetEdges(), visible, &full);
+        Walk(lod.GetNodes(), lod.GetEdges(), visible, &reduced);
+
+        const std::vector<int>& members = lod.GetMemberCounts();
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            if (members[i] > largest)
+                largest = members[i];
+        }
+    }
+
+    double frames = options.Frames;
+    printf("{\"distribution\": \"%s\", \"nodes\": %d, \"frames\": %d, \"edges\": %.0f, \"sim_ns\": %.0f, "
+        "\"full\": {\"nodes_drawn\": %.0f, \"lines_drawn\": %.0f, \"sprites\": %.0f, \"walk_ns\": %.0f, \"frame_ns\": %.0f}, "
+        "\"lod\": {\"nodes_drawn\": %.0f, \"lines_drawn\": %.0f, \"sprites\": %.0f, \"clusters\": %.1f, \"largest_cluster\": %d, "
+        "\"build_ns\": %.0f, \"walk_ns\": %.0f, \"frame_ns\": %.0f}, \"sprite_ratio\": %.4f, \"checksum\": %.6g}\n",
+        DistributionName(distribution), garden.GetNodeCount(), options.Frames, edges / frames, simNs / frames,
+        full.Nodes / frames, full.Lines / frames, (full.Nodes * SpritesPerNode + full.Lines) / frames, full.WalkNs / frames, (simNs + full.WalkNs) / frames,
+        reduced.Nodes / frames, reduced.Lines / frames, (reduced.Nodes * SpritesPerNode + reduced.Lines) / frames, clusters / frames, largest,
+        lodNs / frames, reduced.WalkNs / frames, (simNs + lodNs + reduced.WalkNs) / frames,
+        full.Nodes * SpritesPerNode + full.Lines > 0 ? (reduced.Nodes * SpritesPerNode + reduced.Lines) / (full.Nodes * SpritesPerNode + full.Lines) : 0.0,
+        full.Checksum + reduced.Checksum);
+    fflush(stdout);
+
+    fprintf(stderr, "%-10s %7d  sprites %9.0f -> %6.0f  frame %9.2f ms -> %9.2f ms (lod build %.2f ms)\n",
+        DistributionName(distribution), nodeCount, (full.Nodes * SpritesPerNode + full.Lines) / frames, (reduced.Nodes * SpritesPerNode + reduced.Lines) / frames,
+        (simNs + full.WalkNs) / frames / 1e6, (simNs + lodNs + reduced.WalkNs) / frames / 1e6, lodNs / frames / 1e6);
+}
+
+static bool ParseNodeCounts(const char* text, std::vector<int>* counts)
+{
+    counts->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long count = strtol(text, &end, 10);
+        if (end == text || count < 1)
+            return false;
+
+        counts->push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !counts->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultNodeCounts[] = { 1000, 10000, 100000 };
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Distributions.clear();
+    options->Distributions.push_back(Distribution_Uniform);
+    options->Distributions.push_back(Distribution_Clustered);
+    options->Distributions.push_back(Distribution_Ring);
+    options->Frames = 10;
+    options->Seed = 1;
+    options->DetailRadius = GardenLod::DefaultDetailRadius;
+    options->Angle = GardenLod::DefaultAngle;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseNodeCounts(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(name, "--detail-radius") == 0)
+            options->DetailRadius = (float)atof(value);
+        else if (strcmp(name, "--angle") == 0)
+            options->Angle = (float)atof(value);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 1000,10000,...] [--distributions uniform,clustered,ring,cell] [--frames n]\n"
+                        "       [--seed n] [--detail-radius r] [--angle a]\n", argv[0]);
+        return 1;
+    }
+
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t n = 0; n < options.NodeCounts.size(); n++)
+        {
+            RunCase(options, options.Distributions[d], options.NodeCounts[n]);
+        }
+    }
+
+    return 0;
+}
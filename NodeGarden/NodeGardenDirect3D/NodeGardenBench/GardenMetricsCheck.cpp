@@ -0,0 +1,275 @@
+// Checks MetricsServer against a headless garden: this thread steps the garden and publishes a
+// snapshot every frame, the way XTKRenderer does, while a scraper thread fetches /metrics over
+// loopback as fast as the server answers.
+//
+// Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenmetricscheck GardenMetricsCheck.cpp
+//         ../NodeGardenDirect3DComp/MetricsServer.cpp ../NodeGardenDirect3DComp/FrameMetrics.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenmetricscheck [--seconds 3] [--nodes 1000] [--port 0]
+//     Every scrape must be a 200 in the text exposition format with each metric present, the
+//     node count must be the garden's, and the frame count must never go backwards. Any other
+//     path must be a 404. Reports the scrape count and what publishing cost the frame loop.
+//     Exits 1 on any failure.
+
+#include "MetricsServer.h"
+#include "FrameMetrics.h"
+#include "Garden.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* RequiredMetrics[] =
+{
+    "nodegarden_frame_seconds{quantile=\"0.5\"} ",
+    "nodegarden_frame_seconds{quantile=\"0.9\"} ",
+    "nodegarden_frame_seconds{quantile=\"0.99\"} ",
+    "nodegarden_frame_seconds_sum ",
+    "nodegarden_frame_seconds_count ",
+    "nodegarden_sim_seconds ",
+    "nodegarden_render_seconds ",
+    "nodegarden_nodes ",
+    "nodegarden_connections ",
+    "nodegarden_pairs_tested ",
+    "nodegarden_network_updates_total ",
+    "nodegarden_network_updates_per_second ",
+    "nodegarden_network_updates_dropped_total ",
+};
+
+struct ScrapeResult
+{
+    uint64_t Scrapes;
+    uint64_t Failed;
+    uint64_t Backwards;
+    uint64_t WrongNodes;
+    double LastFrames;
+    double SlowestScrape;       // seconds
+    std::string FirstFailure;
+};
+
+static bool Fetch(uint16_t port, const char* path, std::string* response)
+{
+    int client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (client < 0)
+        return false;
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(client, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        close(client);
+        return false;
+    }
+
+    char request[256];
+    int length = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", path);
+    if (send(client, request, length, 0) != length)
+    {
+        close(client);
+        return false;
+    }
+
+    response->clear();
+    char buffer[4096];
+    for (;;)
+    {
+        ssize_t got = recv(client, buffer, sizeof(buffer), 0);
+        if (got <= 0)
+            break;
+        response->append(buffer, got);
+    }
+
+    close(client);
+    return !response->empty();
+}
+
+static bool ReadValue(const std::string& body, const char* name, double* value)
+{
+    size_t at = body.find(std::string("\n") + name);
+    if (at == std::string::npos)
+        return false;
+
+    *value = atof(body.c_str() + at + 1 + strlen(name));
+    return true;
+}
+
+static const char* CheckScrape(const std::string& response, double* frames, double* nodes)
+{
+    if (response.compare(0, 15, "HTTP/1.1 200 OK") != 0)
+        return "status wasn't 200";
+    if (response.find("\r\nContent-Type: text/plain; version=0.0.4") == std::string::npos)
+        return "wrong content type";
+
+    size_t headerEnd = response.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+        return "no end to the headers";
+
+    // from the blank line on, so every metric line starts after a newline
+    std::string body = response.substr(headerEnd + 3);
+    for (size_t i = 0; i < sizeof(RequiredMetrics) / sizeof(RequiredMetrics[0]); i++)
+    {
+        if (body.find(std::string("\n") + RequiredMetrics[i]) == std::string::npos)
+            return RequiredMetrics[i];
+    }
+
+    if (body.find("\n# TYPE nodegarden_frame_seconds summary\n") == std::string::npos ||
+        body.find("\n# TYPE nodegarden_network_updates_total counter\n") == std::string::npos)
+        return "missing TYPE lines";
+
+    if (!ReadValue(body, "nodegarden_frame_seconds_count ", frames) || !ReadValue(body, "nodegarden_nodes ", nodes))
+        return "unreadable values";
+
+    return nullptr;
+}
+
+static void Scrape(uint16_t port, int expectedNodes, std::atomic<bool>* stop, ScrapeResult* result)
+{
+    std::string response;
+    while (!stop->load())
+    {
+        Clock::time_point start = Clock::now();
+        bool fetched = Fetch(port, "/metrics", &response);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        // the server answers 503 until the first frame is published
+        if (fetched && response.compare(0, 12, "HTTP/1.1 503") == 0)
+            continue;
+
+        double frames = 0;
+        double nodes = 0;
+        const char* failure = fetched ? CheckScrape(response, &frames, &nodes) : "couldn't fetch";
+        if (failure != nullptr)
+        {
+            if (result->Failed++ == 0)
+                result->FirstFailure = failure;
+            continue;
+        }
+
+        result->Scrapes++;
+        if (frames < result->LastFrames)
+            result->Backwards++;
+        if (nodes != expectedNodes)
+            result->WrongNodes++;
+        result->LastFrames = frames;
+        if (seconds > result->SlowestScrape)
+            result->SlowestScrape = seconds;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 3;
+    int nodes = 1000;
+    int port = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc)
+            nodes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+            port = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds s] [--nodes n] [--port p]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (nodes < 1)
+        nodes = 1;
+
+    MetricsServer server;
+    if (!server.Start((uint16_t)port))
+    {
+        fprintf(stderr, "can't listen on 127.0.0.1:%d\n", port);
+        return 1;
+    }
+
+    Garden garden;
+    garden.SetSeed(1);
+    garden.SetSize(480, 800);
+    garden.AddMyNode();
+    garden.SetNodeCount(nodes);
+
+    std::atomic<bool> stop(false);
+    ScrapeResult result;
+    result.Scrapes = 0;
+    result.Failed = 0;
+    result.Backwards = 0;
+    result.WrongNodes = 0;
+    result.LastFrames = 0;
+    result.SlowestScrape = 0;
+    std::thread scraper(Scrape, server.GetPort(), garden.GetNodeCount(), &stop, &result);
+
+    FrameMetrics metrics;
+    MetricsSnapshot snapshot;
+    FrameSample sample;
+    memset(&sample, 0, sizeof(sample));
+
+    double publishTotal = 0;
+    double publishMax = 0;
+    uint64_t frames = 0;
+    Clock::time_point previous = Clock::now();
+    Clock::time_point end = previous + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    while (previous < end)
+    {
+        garden.Update(0, 1.0f / 60.0f);
+        metrics.AddNetworkUpdate();
+
+        Clock::time_point now = Clock::now();
+        sample.FrameTime = std::chrono::duration<float>(now - previous).count();
+        sample.SimTime = sample.FrameTime;
+        sample.Nodes = (uint32_t)garden.GetNodeCount();
+        sample.PairsTested = garden.GetPairsTested();
+        sample.Connections = (uint32_t)garden.GetEdges().size();
+        metrics.AddFrame(sample);
+        previous = now;
+
+        MetricsServer::FromFrameMetrics(metrics, &snapshot);
+        server.Publish(snapshot);
+        double publish = std::chrono::duration<double>(Clock::now() - now).count();
+        publishTotal += publish;
+        if (publish > publishMax)
+            publishMax = publish;
+        frames++;
+    }
+
+    stop = true;
+    scraper.join();
+
+    std::string missing;
+    bool notFound = Fetch(server.GetPort(), "/nothing", &missing) && missing.compare(0, 12, "HTTP/1.1 404") == 0;
+    server.Stop();
+
+    printf("{\"nodes\": %d, \"frames\": %llu, \"scrapes\": %llu, \"server_scrapes\": %u, \"failed\": %llu, \"backwards\": %llu, \"wrong_nodes\": %llu, "
+        "\"slowest_scrape_ms\": %.3f, \"publish_mean_us\": %.3f, \"publish_max_us\": %.3f, \"not_found\": %s}\n",
+        garden.GetNodeCount(), (unsigned long long)frames, (unsigned long long)result.Scrapes, server.GetScrapeCount(), (unsigned long long)result.Failed,
+        (unsigned long long)result.Backwards, (unsigned long long)result.WrongNodes, result.SlowestScrape * 1000,
+        frames > 0 ? publishTotal / frames * 1e6 : 0.0, publishMax * 1e6, notFound ? "true" : "false");
+
+    if (result.Failed > 0)
+        fprintf(stderr, "first failure: %s\n", result.FirstFailure.c_str());
+
+    bool passed = result.Scrapes > 0 && result.Failed == 0 && result.Backwards == 0 && result.WrongNodes == 0 && notFound;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+// Checks MotionIntegrator, which Garden::UpdateNodes eases nodes towards their targets with,
+// against its scalar reference, and times it against the loop it replaced.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenmotionbench GardenMotionBench.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+// and again with -mavx2 for the AVX path, or -DNODEGARDEN_SCALAR_MOTION for none; "path" in
+// the output says which one ran.
+//
+// gardenmotionbench [options]
+//     --nodes 100000              nodes timed
+//     --moving 1,0.1,0.01         shares of them with somewhere to go
+//     --frames 600                frames timed per share
+//     --seed 1
+//
+// Trajectories: Step and StepScalar move two copies of the same nodes, every seventh level
+// with its target on one axis, retargeting a few each frame and then none until everything
+// is at rest. The copies have to match bit for bit every frame, the active list has to hold
+// exactly the nodes still moving, and it has to be empty at the end; old_stuck is how many
+// nodes the old test, which only moved a node off target on both axes, left short. Then a
+// garden with nodes being added, removed, moved and reordered is saved and loaded in to a
+// second garden before every frame, which builds its list from scratch, and both have to
+// step to the same checksum, so a node the first garden forgot to wake shows up. Exits 1 if
+// any check fails.
+//
+// Timing: that share of the nodes gets a target across the garden and the rest sit on
+// theirs. old_ns is the old loop, which tests every node; scalar_ns is StepScalar over every
+// node; step_ns is Step, which only touches the active list.
+
+#include "Garden.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float GardenSize = 20000.0f;
+static const float FrameDelta = 1.0f / 60.0f;
+
+struct Options
+{
+    int Nodes;
+    std::vector<float> Moving;
+    int Frames;
+    uint32_t Seed;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static float Random(uint32_t* state, float max)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (float)((double)*state / 4294967295.0 * max);
+}
+
+static bool IsMoving(const GardenNode& node)
+{
+    return fabsf(node.TargetX - node.X) > MotionIntegrator::RestDistance ||
+        fabsf(node.TargetY - node.Y) > MotionIntegrator::RestDistance;
+}
+
+static int CountMoving(const std::vector<GardenNode>& nodes)
+{
+    int moving = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (IsMoving(nodes[i]))
+            moving++;
+    }
+    return moving;
+}
+
+// Garden::UpdateNodes's motion as it was
+static void StepOld(std::vector<GardenNode>& nodes, float timeDelta)
+{
+    size_t count = nodes.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        GardenNode& node = nodes[i];
+
+        if (fabsf(node.X - node.TargetX) > 0.5f && fabsf(node.Y - node.TargetY) > 0.5f)
+        {
+            node.X += (node.TargetX - node.X) * Garden::Speed * timeDelta;
+            node.Y += (node.TargetY - node.Y) * Garden::Speed * timeDelta;
+        }
+    }
+}
+
+static std::vector<GardenNode> MakeNodes(int count, float size, uint32_t seed)
+{
+    Garden garden;
+    garden.SetSeed(seed);
+    garden.SetSize(size, size);
+    garden.SetNodeCount(count);
+    return garden.GetNodes();
+}
+
+static bool CheckTrajectories(const Options& options)
+{
+    static const int RetargetFrames = 300;
+    static const int RestFrames = 1500;
+    static const float Size = 2000.0f;
+    int count = options.Nodes < 20000 ? options.Nodes : 20000;
+
+    std::vector<GardenNode> stepped = MakeNodes(count, Size, options.Seed);
+    for (size_t i = 0; i < stepped.size(); i += 7)
+    {
+        stepped[i].TargetY = stepped[i].Y;
+    }
+    std::vector<GardenNode> reference = stepped;
+    std::vector<GardenNode> old = stepped;
+
+    MotionIntegrator integrator;
+    uint32_t random = options.Seed * 2654435761u + 1;
+    int frames = RetargetFrames + RestFrames;
+    int firstMismatch = -1;
+    int firstBadList = -1;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // a few new targets, some of them close enough to come to rest and be woken again
+        for (int r = 0; frame < RetargetFrames && r < count / 100; r++)
+        {
+            int index = (int)Random(&random, count - 1.0f);
+            float reach = r % 2 == 0 ? Size : 4.0f;
+            GardenNode& node = stepped[index];
+            node.TargetX = node.X + Random(&random, reach) - reach / 2;
+            node.TargetY = r % 3 == 0 ? node.Y : node.Y + Random(&random, reach) - reach / 2;
+            reference[index].TargetX = old[index].TargetX = node.TargetX;
+            reference[index].TargetY = old[index].TargetY = node.TargetY;
+            integrator.Wake(stepped, index);
+        }
+
+        int active = integrator.Step(stepped, 0, Garden::Speed, FrameDelta);
+        MotionIntegrator::StepScalar(reference, 0, Garden::Speed, FrameDelta);
+        StepOld(old, FrameDelta);
+
+        if (firstMismatch < 0 && memcmp(&stepped[0], &reference[0], count * sizeof(GardenNode)) != 0)
+            firstMismatch = frame;
+        if (firstBadList < 0 && (active != integrator.GetActiveCount() || active != CountMoving(reference)))
+            firstBadList = frame;
+    }
+
+    int left = integrator.GetActiveCount();
+    int oldStuck = CountMoving(old);
+    bool ok = firstMismatch < 0 && firstBadList < 0 && left == 0;
+
+    printf("{\"trajectories\": {\"path\": \"%s\", \"lanes\": %d, \"nodes\": %d, \"frames\": %d, "
+        "\"first_mismatch_frame\": %d, \"first_bad_list_frame\": %d, \"left_moving\": %d, \"old_stuck\": %d, \"ok\": %s}}\n",
+        MotionIntegrator::GetPath(), MotionIntegrator::GetLanes(), count, frames,
+        firstMismatch, firstBadList, left, oldStuck, ok ? "true" : "false");
+    fflush(stdout);
+
+    if (firstMismatch >= 0)
+        fprintf(stderr, "Step and StepScalar went apart at frame %d\n", firstMismatch);
+    if (firstBadList >= 0)
+        fprintf(stderr, "the active list didn't match the moving nodes at frame %d\n", firstBadList);
+    if (left != 0)
+        fprintf(stderr, "%d nodes still on the active list after %d quiet frames\n", left, RestFrames);
+
+    return ok;
+}
+
+// adds, removes, moves and reorders nodes, some only a little so they settle and are woken
+static void Churn(Garden& garden, int frame, std::vector<int>* ids, uint32_t* random)
+{
+    if (frame % 5 == 0)
+        ids->push_back(garden.AddNode(Random(random, 2000.0f), Random(random, 2000.0f)));
+    if (frame % 3 == 0 && !ids->empty())
+    {
+        int id = (*ids)[(size_t)Random(random, ids->size() - 1.0f)];
+        float x = 100.0f + (id % 17) * 100.0f + Random(random, 3.0f);
+        garden.UpdateNodePosition(id, x, frame % 2 == 0 ? 500.0f : 500.0f + Random(random, 3.0f));
+    }
+    if (frame % 11 == 0 && ids->size() > 1)
+    {
+        size_t which = (size_t)Random(random, ids->size() - 1.0f);
+        garden.RemoveNode((*ids)[which]);
+        ids->erase(ids->begin() + which);
+    }
+    if (frame % 50 == 0)
+        garden.ReorderNodes();
+}
+
+static bool CheckGarden(const Options& options)
+{
+    static const int Frames = 1200;
+    int count = options.Nodes < 5000 ? options.Nodes : 5000;
+
+    Garden garden;
+    garden.SetSeed(options.Seed);
+    garden.SetSize(2000.0f, 2000.0f);
+    garden.AddMyNode();
+    garden.SetNodeCount(count);
+
+    std::vector<int> ids;
+    uint32_t random = options.Seed + 12345;
+    int firstMismatch = -1;
+    for (int frame = 1; frame <= Frames && firstMismatch < 0; frame++)
+    {
+        Churn(garden, frame, &ids, &random);
+
+        GardenState state;
+        garden.SaveState(&state);
+        Garden loaded;
+        loaded.LoadState(state);
+
+        garden.UpdateNodes(FrameDelta);
+        loaded.UpdateNodes(FrameDelta);
+        if (garden.Checksum() != loaded.Checksum())
+            firstMismatch = frame;
+    }
+
+    bool ok = firstMismatch < 0;
+    printf("{\"garden\": {\"nodes\": %d, \"frames\": %d, \"first_mismatch_frame\": %d, \"ok\": %s}}\n",
+        count, Frames, firstMismatch, ok ? "true" : "false");
+    fflush(stdout);
+
+    if (!ok)
+        fprintf(stderr, "a garden stepped differently from its own reloaded copy at frame %d\n", firstMismatch);
+
+    return ok;
+}
+
+static void Time(const Options& options, float moving)
+{
+    std::vector<GardenNode> nodes = MakeNodes(options.Nodes, GardenSize, options.Seed);
+    int movingCount = (int)(options.Nodes * moving + 0.5f);
+    for (int i = movingCount; i < options.Nodes; i++)
+    {
+        nodes[i].TargetX = nodes[i].X;
+        nodes[i].TargetY = nodes[i].Y;
+    }
+
+    std::vector<GardenNode> old = nodes;
+    std::vector<GardenNode> scalar = nodes;
+    MotionIntegrator integrator;
+    double oldNs = 0, scalarNs = 0, stepNs = 0, active = 0;
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        Clock::time_point start = Clock::now();
+        StepOld(old, FrameDelta);
+        Clock::time_point end = Clock::now();
+        oldNs += Elapsed(start, end);
+
+        start = Clock::now();
+        MotionIntegrator::StepScalar(scalar, 0, Garden::Speed, FrameDelta);
+        end = Clock::now();
+        scalarNs += Elapsed(start, end);
+
+        start = Clock::now();
+        active += integrator.Step(nodes, 0, Garden::Speed, FrameDelta);
+        end = Clock::now();
+        stepNs += Elapsed(start, end);
+    }
+
+    int frames = options.Frames;
+    printf("{\"path\": \"%s\", \"nodes\": %d, \"moving\": %.3f, \"frames\": %d, \"mean_active\": %.0f, "
+        "\"old_ns\": %.0f, \"scalar_ns\": %.0f, \"step_ns\": %.0f}\n",
+        MotionIntegrator::GetPath(), options.Nodes, moving, frames, active / frames,
+        oldNs / frames, scalarNs / frames, stepNs / frames);
+    fflush(stdout);
+
+    fprintf(stderr, "%-6s %7d nodes %6.1f%% moving   old %8.3f ms   scalar %8.3f ms   step %8.3f ms\n",
+        MotionIntegrator::GetPath(), options.Nodes, moving * 100, oldNs / frames / 1e6,
+        scalarNs / frames / 1e6, stepNs / frames / 1e6);
+}
+
+static bool ParseShares(const char* text, std::vector<float>* shares)
+{
+    shares->clear();
+    while (*text != 0)
+    {
+        char* end;
+        double share = strtod(text, &end);
+        if (end == text || share < 0 || share > 1)
+            return false;
+
+        shares->push_back((float)share);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !shares->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const float DefaultMoving[] = { 1.0f, 0.1f, 0.01f };
+    options->Nodes = 100000;
+    options->Moving.assign(DefaultMoving, DefaultMoving + sizeof(DefaultMoving) / sizeof(DefaultMoving[0]));
+    options->Frames = 600;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--nodes") == 0)
+            options->Nodes = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--moving") == 0)
+        {
+            if (!ParseShares(value, &options->Moving))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes n] [--moving 1,0.1,...] [--frames n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = CheckTrajectories(options);
+    ok = CheckGarden(options) && ok;
+    for (size_t m = 0; m < options.Moving.size(); m++)
+    {
+        Time(options, options.Moving[m]);
+    }
+
+    return ok ? 0 : 1;
+}
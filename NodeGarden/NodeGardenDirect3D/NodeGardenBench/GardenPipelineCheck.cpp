@@ -0,0 +1,320 @@
+// Headless check of XTKRenderer's pipelined frames: a FrameWorker simulates the next frame in
+// to the back of a FrameStateBuffer while this thread "draws" the front, exactly as
+// BeginUpdate, Render and EndUpdate do, and every drawn frame is checked for tearing.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenpipelinecheck GardenPipelineCheck.cpp Scenario.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/FrameState.cpp
+//         ../NodeGardenDirect3DComp/Heatmap.cpp ../NodeGardenDirect3DComp/CullRect.cpp
+//         ../NodeGardenDirect3DComp/TaskPool.cpp ../NodeGardenDirect3DComp/TimerWheel.cpp
+//         ../NodeGardenDirect3DComp/MotionIntegrator.cpp ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenpipelinecheck [options]
+//     --nodes 1000,10000          node counts to sweep
+//     --distributions a,b,...     uniform, clustered, ring, cell (default uniform,clustered)
+//     --frames 200                frames run per case, each way
+//     --seed 1
+//
+// Each case runs the garden twice from the same seed, once serially (update, capture, swap,
+// draw) and once pipelined. While a frame is drawn the check hashes the front state before
+// and after, so a write from the simulation shows up as a changed hash; makes sure every edge
+// indexes a node and its Distance matches the two node positions it was captured with, so a
+// state mixing two frames shows up too; and that the frame number goes up by one each swap.
+// The pipelined run must draw the serial run's frames one behind, hash for hash. Exits 1 on
+// any failure.
+//
+// serial_ms and pipelined_ms are the average wall time per frame. The pipelined frame is the
+// longer of the update and the draw plus a capture, so it only comes out ahead with a core to
+// spare; on one core expect it level or a little behind.
+
+#include "Garden.h"
+#include "FrameState.h"
+#include "Heatmap.h"
+#include "CullRect.h"
+#include "Scenario.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float FrameDelta = 1.0f / 60.0f;
+
+struct Options
+{
+    std::vector<int> NodeCounts;
+    std::vector<Distribution> Distributions;
+    int Frames;
+    uint32_t Seed;
+};
+
+struct DrawResult
+{
+    uint64_t Hash;
+    bool Ok;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// FNV-1a over the parts of the state the renderer reads
+static uint64_t Hash(const FrameState& state)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const uint8_t* bytes = state.Nodes.empty() ? nullptr : (const uint8_t*)&state.Nodes[0];
+    for (size_t i = 0; i < state.Nodes.size() * sizeof(GardenNode); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    bytes = state.Edges.empty() ? nullptr : (const uint8_t*)&state.Edges[0];
+    for (size_t i = 0; i < state.Edges.size() * sizeof(GardenEdge); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    return (hash ^ state.Frame) * 1099511628211ull;
+}
+
+// Render's CPU side against a frame state: the heatmap build and the line loop, with the
+// consistency checks in the loop
+static DrawResult Draw(const FrameState& state, Heatmap& heatmap, const CullRect& visible, float width, float height, double* checksum)
+{
+    DrawResult result;
+    result.Hash = Hash(state);
+    result.Ok = true;
+
+    heatmap.Build(state.Nodes, state.Edges, width, height);
+
+    int nodeCount = (int)state.Nodes.size();
+    for (size_t i = 0; i < state.Edges.size(); i++)
+    {
+        const GardenEdge& edge = state.Edges[i];
+        if (edge.First < 0 || edge.First >= nodeCount || edge.Second < 0 || edge.Second >= nodeCount)
+        {
+            fprintf(stderr, "frame %llu: edge %zu joins %d and %d of %d nodes\n",
+                (unsigned long long)state.Frame, i, edge.First, edge.Second, nodeCount);
+            result.Ok = false;
+            break;
+        }
+
+        const GardenNode& node1 = state.Nodes[edge.First];
+        const GardenNode& node2 = state.Nodes[edge.Second];
+        float dx = node2.X - node1.X;
+        float dy = node2.Y - node1.Y;
+        float length = sqrtf(dx * dx + dy * dy);
+        if (fabsf(length - edge.Distance) > 1e-3f * (1 + edge.Distance))
+        {
+            fprintf(stderr, "frame %llu: edge %zu is %.4f long but was found at %.4f\n",
+                (unsigned long long)state.Frame, i, length, edge.Distance);
+            result.Ok = false;
+            break;
+        }
+
+        float stroke = Garden::Map(edge.Distance, 0, Garden::MinDist, 7.0f, 2.0f);
+        if (visible.IntersectsSegment(node1.X, node1.Y, node2.X, node2.Y, stroke))
+            *checksum += length + atan2f(dy, -dx);
+    }
+
+    if (Hash(state) != result.Hash)
+    {
+        fprintf(stderr, "frame %llu: the front state changed while it was drawn\n", (unsigned long long)state.Frame);
+        result.Ok = false;
+    }
+
+    return result;
+}
+
+static void Simulate(Garden& garden, FrameStateBuffer& frames, uint64_t frame)
+{
+    float timeTotal = frame * FrameDelta;
+    garden.Update(timeTotal, FrameDelta);
+    frames.Back().Capture(garden, frame);
+}
+
+static bool RunCase(const Options& options, Distribution distribution, int nodeCount)
+{
+    bool ok = true;
+    double checksum = 0;
+    std::vector<uint64_t> serialHashes;
+    double serialMs, pipelinedMs;
+
+    {
+        Garden garden;
+        Scenario::Populate(garden, distribution, nodeCount, options.Seed);
+        float width = garden.GetWidth(), height = garden.GetHeight();
+        CullRect visible(0, 0, width, height);
+        Heatmap heatmap;
+        FrameStateBuffer frames;
+
+        Clock::time_point start = Clock::now();
+        for (int frame = 1; frame <= options.Frames; frame++)
+        {
+            Simulate(garden, frames, frame);
+            frames.Swap();
+            DrawResult drawn = Draw(frames.Front(), heatmap, visible, width, height, &checksum);
+            serialHashes.push_back(drawn.Hash);
+            ok = drawn.Ok && ok;
+        }
+        serialMs = Elapsed(start, Clock::now()) / options.Frames;
+    }
+
+    int behind = 0, mismatched = 0, skipped = 0;
+    {
+        Garden garden;
+        Scenario::Populate(garden, distribution, nodeCount, options.Seed);
+        float width = garden.GetWidth(), height = garden.GetHeight();
+        CullRect visible(0, 0, width, height);
+        Heatmap heatmap;
+        FrameStateBuffer frames;
+        FrameWorker worker;
+        uint64_t lastDrawn = 0;
+
+        // one extra frame, so the pipelined run draws as many simulated frames as the serial one
+        Clock::time_point start = Clock::now();
+        for (int frame = 1; frame <= options.Frames + 1; frame++)
+        {
+            if (frame <= options.Frames)
+                worker.Start([&garden, &frames, frame]() { Simulate(garden, frames, frame); });
+
+            const FrameState& front = frames.Front();
+            DrawResult drawn = Draw(front, heatmap, visible, width, height, &checksum);
+            ok = drawn.Ok && ok;
+
+            if (frame > 1)
+            {
+                if (front.Frame != lastDrawn + 1)
+                    skipped++;
+                if (front.Frame + 1 == (uint64_t)frame)
+                    behind++;
+                if (front.Frame < 1 || front.Frame > serialHashes.size() || serialHashes[front.Frame - 1] != drawn.Hash)
+                    mismatched++;
+            }
+            lastDrawn = front.Frame;
+
+            worker.Wait();
+            frames.Swap();
+        }
+        pipelinedMs = Elapsed(start, Clock::now()) / (options.Frames + 1);
+    }
+
+    if (skipped != 0 || mismatched != 0 || behind != options.Frames)
+    {
+        fprintf(stderr, "%s %d: pipelined frames %d skipped, %d differ from the serial run, %d of %d one behind\n",
+            DistributionName(distribution), nodeCount, skipped, mismatched, behind, options.Frames);
+        ok = false;
+    }
+
+    printf("{\"distribution\": \"%s\", \"nodes\": %d, \"frames\": %d, \"serial_ms\": %.3f, \"pipelined_ms\": %.3f, "
+        "\"skipped\": %d, \"mismatched\": %d, \"one_behind\": %d, \"ok\": %s, \"checksum\": %.6g}\n",
+        DistributionName(distribution), nodeCount, options.Frames, serialMs, pipelinedMs,
+        skipped, mismatched, behind, ok ? "true" : "false", checksum);
+    fflush(stdout);
+
+    fprintf(stderr, "%-10s %7d  serial %8.3f ms  pipelined %8.3f ms%s\n",
+        DistributionName(distribution), nodeCount, serialMs, pipelinedMs, ok ? "" : "  FAILED");
+
+    return ok;
+}
+
+static bool ParseNodeCounts(const char* text, std::vector<int>* counts)
+{
+    counts->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long count = strtol(text, &end, 10);
+        if (end == text || count < 1)
+            return false;
+
+        counts->push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !counts->empty();
+}
+
+static bool ParseDistributions(const char* text, std::vector<Distribution>* distributions)
+{
+    distributions->clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.size();
+
+        Distribution distribution;
+        if (!ParseDistribution(list.substr(start, comma - start).c_str(), &distribution))
+            return false;
+
+        distributions->push_back(distribution);
+        start = comma + 1;
+    }
+
+    return !distributions->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultNodeCounts[] = { 1000, 10000 };
+    options->NodeCounts.assign(DefaultNodeCounts, DefaultNodeCounts + sizeof(DefaultNodeCounts) / sizeof(DefaultNodeCounts[0]));
+    options->Distributions.clear();
+    options->Distributions.push_back(Distribution_Uniform);
+    options->Distributions.push_back(Distribution_Clustered);
+    options->Frames = 200;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--nodes") == 0)
+        {
+            if (!ParseNodeCounts(value, &options->NodeCounts))
+                return false;
+        }
+        else if (strcmp(name, "--distributions") == 0)
+        {
+            if (!ParseDistributions(value, &options->Distributions))
+                return false;
+        }
+        else if (strcmp(name, "--frames") == 0)
+            options->Frames = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes 1000,10000,...] [--distributions uniform,clustered,ring,cell] [--frames n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (size_t d = 0; d < options.Distributions.size(); d++)
+    {
+        for (size_t n = 0; n < options.NodeCounts.size(); n++)
+        {
+            ok = RunCase(options, options.Distributions[d], options.NodeCounts[n]) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
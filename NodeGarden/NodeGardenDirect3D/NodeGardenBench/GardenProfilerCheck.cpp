@@ -0,0 +1,285 @@
+// Checks Profiler with several threads recording nested scopes while another thread reads the
+// events back, as the HUD's capture does while the frame worker and pool threads are busy.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -DNODEGARDEN_PROFILE -I../NodeGardenDirect3DComp -o gardenprofilercheck
+//         GardenProfilerCheck.cpp ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+// (add -fsanitize=thread to have the reader's view of each ring checked too)
+//
+// gardenprofilercheck [--writers 4] [--iterations 9000]
+//     Each writer repeats an outer scope holding two middle scopes holding two inner scopes,
+//     seven events an iteration, kept under EventsPerThread so no ring wraps while it is read.
+//     Every snapshot the reader takes must hold only those scopes, at their depths, in the order
+//     they close on each thread, each inside its parent, and no thread's count may go
+//     backwards. Once the writers finish, each thread must have exactly its events, the
+//     histograms must count every scope, and nothing may have been dropped. A second capture
+//     then overruns one ring and must report exactly what it overwrote. Exits 1 on any failure.
+
+#include "Profiler.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !PROFILER_ENABLED
+#error build with -DNODEGARDEN_PROFILE so the scopes are compiled in
+#endif
+
+static const int EventsPerIteration = 7;
+
+static const char* const OuterName = "outer";
+static const char* const MiddleName = "middle";
+static const char* const InnerName = "inner";
+
+// the order scopes close in on one thread within an iteration, and each one's depth
+static const char* const Pattern[EventsPerIteration] =
+{
+    InnerName, InnerName, MiddleName, InnerName, InnerName, MiddleName, OuterName,
+};
+static const uint32_t PatternDepths[EventsPerIteration] = { 2, 2, 1, 2, 2, 1, 0 };
+
+struct ReadResult
+{
+    uint64_t Snapshots;
+    uint64_t EventsSeen;
+    uint64_t Failures;
+    std::string FirstFailure;
+};
+
+static std::atomic<uint32_t> Sink(0);
+
+// something for the inner scopes to time
+static uint32_t Work(uint32_t x, int amount)
+{
+    for (int i = 0; i < amount; i++)
+        x = x * 1664525 + 1013904223;
+    return x;
+}
+
+static void Write(int writer, int iterations, std::atomic<int>* running)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "writer %d", writer);
+    Profiler::SetThreadName(name);
+
+    uint32_t x = writer;
+    for (int i = 0; i < iterations; i++)
+    {
+        PROFILE_SCOPE(OuterName);
+        for (int m = 0; m < 2; m++)
+        {
+            PROFILE_SCOPE(MiddleName);
+            for (int n = 0; n < 2; n++)
+            {
+                PROFILE_SCOPE(InnerName);
+                x = Work(x, 16);
+            }
+        }
+
+        // hand the core over now and then, so the reader sees rings mid-write even on one core
+        if (i % 256 == 255)
+            std::this_thread::yield();
+    }
+
+    Sink.fetch_add(x, std::memory_order_relaxed);
+    running->fetch_sub(1);
+}
+
+static void Fail(ReadResult* result, const char* failure)
+{
+    if (result->Failures++ == 0)
+        result->FirstFailure = failure;
+}
+
+// events from one snapshot, grouped by thread in the order each thread closed them
+static void CheckThread(const std::vector<const ProfileEvent*>& events, ReadResult* result)
+{
+    for (size_t k = 0; k < events.size(); k++)
+    {
+        const ProfileEvent& event = *events[k];
+        size_t slot = k % EventsPerIteration;
+
+        if (event.Name != Pattern[slot])
+            return Fail(result, "scopes closed out of order");
+        if (event.Depth != PatternDepths[slot])
+            return Fail(result, "wrong depth");
+        if (event.End < event.Start)
+            return Fail(result, "scope ended before it started");
+
+        // a middle holds the two inners before it, the outer holds everything since the last outer
+        size_t children = slot == 2 || slot == 5 ? 2 : slot == 6 ? 6 : 0;
+        for (size_t c = 1; c <= children; c++)
+        {
+            const ProfileEvent& child = *events[k - c];
+            if (child.Start < event.Start || child.End > event.End)
+                return Fail(result, "scope not inside its parent");
+        }
+    }
+}
+
+static void Read(std::atomic<int>* running, ReadResult* result)
+{
+    std::vector<ProfileEvent> events;
+    std::map<uint32_t, size_t> lastCounts;
+
+    while (running->load() > 0)
+    {
+        Profiler::GetEvents(&events);
+        result->Snapshots++;
+        result->EventsSeen += events.size();
+
+        std::map<uint32_t, std::vector<const ProfileEvent*> > threads;
+        for (size_t i = 0; i < events.size(); i++)
+            threads[events[i].Thread].push_back(&events[i]);
+
+        for (std::map<uint32_t, std::vector<const ProfileEvent*> >::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+        {
+            CheckThread(thread->second, result);
+
+            size_t& last = lastCounts[thread->first];
+            if (thread->second.size() < last)
+                Fail(result, "a thread's event count went backwards");
+            last = thread->second.size();
+        }
+
+        if (Profiler::GetDroppedEvents() != 0)
+            Fail(result, "events dropped while the rings had room");
+
+        std::this_thread::yield();
+    }
+}
+
+static const char* CheckFinal(int writers, int iterations)
+{
+    std::vector<ProfileEvent> events;
+    Profiler::GetEvents(&events);
+
+    std::map<uint32_t, std::vector<const ProfileEvent*> > threads;
+    for (size_t i = 0; i < events.size(); i++)
+        threads[events[i].Thread].push_back(&events[i]);
+
+    if ((int)threads.size() != writers)
+        return "wrong number of threads recorded";
+
+    ReadResult result = ReadResult();
+    for (std::map<uint32_t, std::vector<const ProfileEvent*> >::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+    {
+        if (thread->second.size() != (size_t)iterations * EventsPerIteration)
+            return "a thread lost or gained events";
+        CheckThread(thread->second, &result);
+    }
+    if (result.Failures != 0)
+        return "final events out of order";
+
+    if (Profiler::GetDroppedEvents() != 0)
+        return "events dropped";
+
+    std::vector<ScopeHistogram> histograms;
+    Profiler::GetHistograms(&histograms);
+    if (histograms.size() != 3)
+        return "wrong number of histograms";
+
+    for (size_t i = 0; i < histograms.size(); i++)
+    {
+        uint32_t perIteration = histograms[i].Name == OuterName ? 1 : histograms[i].Name == MiddleName ? 2 : 4;
+        if (histograms[i].Count != (uint32_t)(writers * iterations) * perIteration)
+            return "histogram counts are wrong";
+
+        uint32_t bucketed = 0;
+        for (int b = 0; b < ScopeHistogram::BucketCount; b++)
+            bucketed += histograms[i].Buckets[b];
+        if (bucketed != histograms[i].Count)
+            return "histogram buckets don't add up";
+    }
+
+    return nullptr;
+}
+
+// one thread writes past the end of its ring; the oldest events go and are counted
+static const char* CheckOverrun()
+{
+    const int iterations = Profiler::EventsPerThread / EventsPerIteration + 100;
+
+    Profiler::StartCapture(1);
+    std::atomic<int> running(1);
+    std::thread writer(Write, 99, iterations, &running);
+    writer.join();
+    Profiler::StopCapture();
+
+    uint64_t written = (uint64_t)iterations * EventsPerIteration;
+    if (Profiler::GetDroppedEvents() != written - Profiler::EventsPerThread)
+        return "overrun dropped the wrong number of events";
+
+    std::vector<ProfileEvent> events;
+    Profiler::GetEvents(&events);
+    if (events.size() != (size_t)Profiler::EventsPerThread)
+        return "overrun kept the wrong number of events";
+
+    return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    int writers = 4;
+    int iterations = 9000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--writers") == 0 && i + 1 < argc)
+            writers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--writers n] [--iterations n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (writers < 1)
+        writers = 1;
+    if (iterations < 1)
+        iterations = 1;
+    if (iterations > Profiler::EventsPerThread / EventsPerIteration)
+        iterations = Profiler::EventsPerThread / EventsPerIteration;
+
+    Profiler::StartCapture(1);
+
+    std::atomic<int> running(writers);
+    ReadResult result = ReadResult();
+    std::thread reader(Read, &running, &result);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < writers; i++)
+        threads.push_back(std::thread(Write, i, iterations, &running));
+    for (int i = 0; i < writers; i++)
+        threads[i].join();
+    reader.join();
+
+    Profiler::StopCapture();
+
+    const char* failure = result.Failures != 0 ? result.FirstFailure.c_str() : CheckFinal(writers, iterations);
+    if (failure == nullptr)
+        failure = CheckOverrun();
+
+    printf("{\"writers\": %d, \"iterations\": %d, \"events\": %d, \"snapshots\": %llu, \"events_read\": %llu, "
+           "\"read_failures\": %llu, \"ok\": %s}\n",
+        writers, iterations, writers * iterations * EventsPerIteration,
+        (unsigned long long)result.Snapshots, (unsigned long long)result.EventsSeen,
+        (unsigned long long)result.Failures, failure == nullptr ? "true" : "false");
+
+    if (failure != nullptr)
+    {
+        fprintf(stderr, "failed: %s\n", failure);
+        return 1;
+    }
+
+    fprintf(stderr, "%d writers, %d events each, %llu snapshots read while writing, no failures\n",
+        writers, iterations * EventsPerIteration, (unsigned long long)result.Snapshots);
+    return 0;
+}
@@ -0,0 +1,308 @@
+// Re-runs a garden recording (Direct3DInterop.StartRecording) headlessly at full speed,
+// checking every frame against the checksum taken when it was recorded.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenreplay GardenReplay.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp ../NodeGardenDirect3DComp/DensityField.cpp
+//         ../NodeGardenDirect3DComp/GardenRecording.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenreplay log.ngrl [--repeat n] [--output file.json]
+//     replays the log n times and reports per frame timings as JSON. Exits 3 if any frame or
+//     node id differs from the recording.
+// gardenreplay --record log.ngrl [--nodes 200] [--frames 600] [--seed 1]
+//     writes a seeded session with drags, remote nodes joining, moving, leaving and going
+//     silent, and the degree cap, the density field estimate and node expiry going on and
+//     off, for checking replays without a phone.
+//
+// Replays are bit exact when built with the same compiler settings as the recording; a
+// different compiler or CPU may round differently, which shows up as a checksum mismatch.
+
+#include "Garden.h"
+#include "GardenRecording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ReplayResult
+{
+    uint32_t Events;
+    uint32_t Frames;
+    uint32_t Mismatches;
+    int64_t FirstMismatchFrame;
+    bool Truncated;
+    std::vector<double> FrameNs;
+};
+
+static void Replay(GardenReplayer& replayer, ReplayResult* result)
+{
+    Garden garden;
+    replayer.Restart(garden);
+
+    result->Events = 0;
+    result->Frames = 0;
+    result->Mismatches = 0;
+    result->FirstMismatchFrame = -1;
+
+    GardenEvent recorded;
+    while (replayer.Next(&recorded))
+    {
+        GardenEvent event = recorded;
+        result->Events++;
+
+        if (event.Type == GardenEvent_Frame)
+        {
+            Clock::time_point start = Clock::now();
+            GardenRecording::Apply(garden, event);
+            result->FrameNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+            result->Frames++;
+        }
+        else
+        {
+            GardenRecording::Apply(garden, event);
+        }
+
+        bool same = event.Checksum == recorded.Checksum;
+        if ((event.Type == GardenEvent_MyNode || event.Type == GardenEvent_AddNode) && event.Id != recorded.Id)
+            same = false;
+
+        if (!same)
+        {
+            if (result->Mismatches == 0)
+                result->FirstMismatchFrame = result->Frames;
+            result->Mismatches++;
+        }
+    }
+
+    result->Truncated = replayer.IsTruncated();
+}
+
+static bool Record(const char* path, int nodeCount, int frameCount, uint32_t seed)
+{
+    Garden garden;
+    garden.SetSeed(seed);
+
+    // sorted as often as the app sorts, so replays go through reordering too
+    garden.SetReorderInterval(120);
+
+    GardenRecorder recorder;
+    if (!recorder.Start(path, garden))
+        return false;
+
+    std::minstd_rand random(seed);
+    std::vector<int> remoteIds;
+    float timeTotal = 0;
+    bool dragging = false;
+
+    GardenEvent setup[] =
+    {
+        { GardenEvent_Size, 0, 480, 800, 0 },
+        { GardenEvent_MyNode, 0, 0, 0, 0 },
+        { GardenEvent_NodeCount, nodeCount, 0, 0, 0 },
+    };
+    for (size_t i = 0; i < sizeof(setup) / sizeof(setup[0]); i++)
+    {
+        GardenRecording::Apply(garden, setup[i]);
+        recorder.Record(setup[i]);
+    }
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        std::vector<GardenEvent> events;
+        const GardenNode& myNode = garden.GetNodes()[0];
+
+        // drag the local node about for a second every few seconds
+        if (frame % 240 == 0)
+        {
+            GardenEvent press = { GardenEvent_PointerPressed, 0, myNode.X + 5, myNode.Y - 5, 0 };
+            events.push_back(press);
+            dragging = true;
+        }
+        else if (dragging && frame % 240 == 60)
+        {
+            GardenEvent release = { GardenEvent_PointerReleased, 0, 0, 0, 0 };
+            events.push_back(release);
+            dragging = false;
+        }
+        else if (dragging)
+        {
+            GardenEvent move = { GardenEvent_PointerMoved, 0, myNode.X + (float)(random() % 9) - 4, myNode.Y + (float)(random() % 9) - 4, 0 };
+            events.push_back(move);
+        }
+
+        // remote nodes join, report positions and leave
+        if (frame % 20 == 0)
+        {
+            GardenEvent add = { GardenEvent_AddNode, 0, (float)(random() % 480), (float)(random() % 800), 0 };
+            events.push_back(add);
+        }
+        if (frame % 7 == 0 && !remoteIds.empty())
+        {
+            GardenEvent update = { GardenEvent_UpdateNode, remoteIds[random() % remoteIds.size()], (float)(random() % 480), (float)(random() % 800), 0 };
+            events.push_back(update);
+        }
+        if (frame % 90 == 45 && !remoteIds.empty())
+        {
+            size_t index = random() % remoteIds.size();
+            GardenEvent remove = { GardenEvent_RemoveNode, remoteIds[index], 0, 0, 0 };
+            events.push_back(remove);
+            remoteIds.erase(remoteIds.begin() + index);
+        }
+
+        // the degree cap goes on and off, so replays go through both passes
+        if (frame % 300 == 150)
+        {
+            GardenEvent cap = { GardenEvent_MaxDegree, frame % 600 == 150 ? 6 : 0, 0, 0, 0 };
+            events.push_back(cap);
+        }
+
+        // and the estimate, which takes over the whole pass while it's on
+        if (frame % 400 == 200)
+        {
+            GardenEvent density = { GardenEvent_DensityField, frame % 800 == 200 ? 1 : 0, (float)DensityField::DefaultResolution, 0, 0 };
+            events.push_back(density);
+        }
+
+        // and expiry, short enough that remote nodes the updates pass over for a while fade
+        // out and go, and any update after that brings them back as a new node
+        if (frame % 500 == 100)
+        {
+            GardenEvent expiry = { GardenEvent_NodeExpiry, 0, frame % 1000 == 100 ? 2.0f : 0.0f, 0, 0 };
+            events.push_back(expiry);
+        }
+
+        // frame times wobble around 60Hz like BasicTimer's do
+        float timeDelta = 1.0f / 60.0f + (float)((int)(random() % 2001) - 1000) * 0.000002f;
+        timeTotal += timeDelta;
+        GardenEvent tick = { GardenEvent_Frame, 0, timeTotal, timeDelta, 0 };
+        events.push_back(tick);
+
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            int id = GardenRecording::Apply(garden, events[i]);
+            if (events[i].Type == GardenEvent_AddNode)
+                remoteIds.push_back(id);
+            recorder.Record(events[i]);
+        }
+    }
+
+    recorder.Stop();
+    return !recorder.HasFailed();
+}
+
+static double Percentile(std::vector<double> values, double percentile)
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values[(size_t)(percentile * (values.size() - 1) + 0.5)];
+}
+
+int main(int argc, char** argv)
+{
+    const char* logPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* outputPath = nullptr;
+    int repeat = 1;
+    int nodeCount = 200;
+    int frameCount = 600;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--record") == 0 && hasValue)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+            repeat = atoi(argv[++i]) > 0 ? atoi(argv[i]) : 1;
+        else if (strcmp(argv[i], "--output") == 0 && hasValue)
+            outputPath = argv[++i];
+        else if (strcmp(argv[i], "--nodes") == 0 && hasValue)
+            nodeCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+            frameCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (argv[i][0] != '-' && logPath == nullptr)
+            logPath = argv[i];
+        else
+            logPath = recordPath = nullptr, i = argc;
+    }
+
+    if (recordPath != nullptr)
+    {
+        if (!Record(recordPath, nodeCount, frameCount, seed))
+        {
+            fprintf(stderr, "can't write %s\n", recordPath);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (logPath == nullptr)
+    {
+        fprintf(stderr, "usage: %s log.ngrl [--repeat n] [--output file.json]\n"
+                        "       %s --record log.ngrl [--nodes n] [--frames n] [--seed n]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    GardenReplayer replayer;
+    if (!replayer.Open(logPath))
+    {
+        fprintf(stderr, "%s isn't a garden recording\n", logPath);
+        return 1;
+    }
+
+    ReplayResult result;
+    uint32_t mismatches = 0;
+    int64_t firstMismatch = -1;
+    std::vector<double> frameNs;
+    Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < repeat; i++)
+    {
+        result.FrameNs.clear();
+        Replay(replayer, &result);
+
+        mismatches += result.Mismatches;
+        if (firstMismatch < 0)
+            firstMismatch = result.FirstMismatchFrame;
+        frameNs.insert(frameNs.end(), result.FrameNs.begin(), result.FrameNs.end());
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double totalFrameNs = 0;
+    for (size_t i = 0; i < frameNs.size(); i++)
+    {
+        totalFrameNs += frameNs[i];
+    }
+
+    FILE* out = outputPath != nullptr ? fopen(outputPath, "w") : stdout;
+    if (out == nullptr)
+    {
+        fprintf(stderr, "can't write %s\n", outputPath);
+        return 1;
+    }
+
+    fprintf(out, "{\"log\": \"%s\", \"repeat\": %d, \"events\": %u, \"frames\": %u, \"truncated\": %s,\n",
+        logPath, repeat, result.Events, result.Frames, result.Truncated ? "true" : "false");
+    fprintf(out, " \"mismatches\": %u, \"first_mismatch_frame\": %lld,\n", mismatches, (long long)firstMismatch);
+    fprintf(out, " \"ns_per_frame\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f, \"seconds\": %.3f}\n",
+        frameNs.empty() ? 0.0 : totalFrameNs / frameNs.size(), Percentile(frameNs, 0.5), Percentile(frameNs, 0.99),
+        Percentile(frameNs, 1.0), seconds);
+
+    if (out != stdout)
+        fclose(out);
+
+    return mismatches > 0 ? 3 : 0;
+}
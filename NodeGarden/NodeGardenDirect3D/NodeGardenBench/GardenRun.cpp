@@ -0,0 +1,408 @@
+// Runs the garden simulation headlessly for load testing: the same garden ChangeNodeAmount
+// sets up on the phone, local node and all, stepped at 60Hz.
+//
+// Garden.cpp, Quadtree.cpp, DensityField.cpp, TaskPool.cpp, TimerWheel.cpp, MotionIntegrator.cpp
+// and Profiler.cpp are the whole simulation and need nothing but the standard library, so they
+// build as a library anywhere GCC or Clang does. From this folder
+//     g++ -O2 -std=c++11 -c ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp
+//     ar rcs libgarden.a Garden.o Quadtree.o DensityField.o TaskPool.o TimerWheel.o
+//         MotionIntegrator.o Profiler.o
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenrun GardenRun.cpp
+//         PerfCounters.cpp ../NodeGardenDirect3DComp/AllocationTracker.cpp -DNODEGARDEN_TRACK_ALLOCATIONS
+//         libgarden.a -pthread
+// (clang++ takes the same arguments). Build libgarden.a with -DNODEGARDEN_TRACK_ALLOCATIONS too
+// for the allocations to be counted per step rather than all under "(none)".
+//
+// gardenrun [options]
+//     --nodes 1000            including the local node
+//     --seed 1
+//     --frames 600
+//     --width 480             screen size in pixels; the garden is this size whatever the node count
+//     --height 800
+//     --threads 1             threads for the connection pass; see Garden::SetThreadCount
+//     --reorder 0             sort the nodes along a Morton curve every n frames, 0 for never;
+//                             see Garden::SetReorderInterval
+//     --clusters 0            start the nodes, and keep their targets, in this many gaussian
+//                             clusters rather than spread evenly over the garden
+//     --output file.json      write the report here instead of stdout
+//     --zero-allocations n    test mode: after n warmup frames, fail with exit code 4 if any frame
+//                             allocates, writing the allocation report to stderr
+//     --allocation-report file
+//                             allocations per step, with the stacks of the last few made after
+//                             warmup (from the start without --zero-allocations)
+//     --counters              hardware counters for the connection pass per pair tested and for
+//                             the whole frame per node, where perf_event_open allows
+//
+// Reports frame time percentiles and the time in each step, peak and garden memory, heap
+// allocations, and connection statistics averaged over the frames run. edge_walk_ns is a pass
+// reading both ends of every edge the way XTKRenderer draws lines, which is where node order
+// shows most; it isn't part of the frame time.
+
+#include "Garden.h"
+#include "AllocationTracker.h"
+#include "PerfCounters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float FrameDelta = 1.0f / 60.0f;
+
+struct Options
+{
+    int Nodes;
+    uint32_t Seed;
+    int Frames;
+    float Width;
+    float Height;
+    int Threads;
+    int ReorderInterval;
+    int Clusters;
+    const char* OutputPath;
+    int ZeroAllocationWarmup;   // -1 when not testing
+    const char* AllocationReportPath;
+    bool Counters;
+};
+
+struct ConnectionStats
+{
+    double Edges;               // summed over frames
+    double ConnectedNodes;
+    double MeanDegree;
+    int MaxDegree;
+    double MeanDistance;
+    std::vector<int> Degrees;   // reused each frame
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static double Percentile(const std::vector<double>& sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0;
+
+    return sorted[(size_t)(percentile * (sorted.size() - 1) + 0.5)];
+}
+
+static void CountConnections(const Garden& garden, ConnectionStats* stats)
+{
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+
+    stats->Degrees.assign(garden.GetNodeCount(), 0);
+    double distance = 0;
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        stats->Degrees[edges[i].First]++;
+        stats->Degrees[edges[i].Second]++;
+        distance += edges[i].Distance;
+    }
+
+    int connected = 0;
+    for (size_t i = 0; i < stats->Degrees.size(); i++)
+    {
+        if (stats->Degrees[i] > 0)
+            connected++;
+        if (stats->Degrees[i] > stats->MaxDegree)
+            stats->MaxDegree = stats->Degrees[i];
+    }
+
+    stats->Edges += (double)edges.size();
+    stats->ConnectedNodes += connected;
+    if (!stats->Degrees.empty())
+        stats->MeanDegree += 2.0 * edges.size() / stats->Degrees.size();
+    if (!edges.empty())
+        stats->MeanDistance += distance / edges.size();
+}
+
+// Moves every node but the local one in to one of count clusters, targets included, in
+// index order round the clusters so neighbours in the list are never neighbours in space
+static void Cluster(Garden& garden, int count, uint32_t seed)
+{
+    GardenState state;
+    garden.SaveState(&state);
+
+    std::minstd_rand random(seed);
+    float width = garden.GetWidth();
+    float height = garden.GetHeight();
+    float spread = 0.15f * sqrtf(width * height / count);
+    std::uniform_real_distribution<float> centreX((float)Garden::NodeSizeMax, width - Garden::NodeSizeMax);
+    std::uniform_real_distribution<float> centreY((float)Garden::NodeSizeMax, height - Garden::NodeSizeMax);
+    std::normal_distribution<float> offset(0, spread);
+
+    std::vector<float> centres;
+    for (int i = 0; i < count; i++)
+    {
+        centres.push_back(centreX(random));
+        centres.push_back(centreY(random));
+    }
+
+    for (size_t i = state.HasMyNode ? 1 : 0; i < state.Nodes.size(); i++)
+    {
+        GardenNode& node = state.Nodes[i];
+        size_t cluster = i % (size_t)count;
+        node.X = centres[cluster * 2] + offset(random);
+        node.Y = centres[cluster * 2 + 1] + offset(random);
+        node.TargetX = centres[cluster * 2] + offset(random);
+        node.TargetY = centres[cluster * 2 + 1] + offset(random);
+    }
+
+    garden.LoadState(state);
+}
+
+// reads both ends of every edge, as drawing the lines does
+static double WalkEdges(const Garden& garden)
+{
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+
+    double length = 0;
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const GardenNode& node1 = nodes[edges[i].First];
+        const GardenNode& node2 = nodes[edges[i].Second];
+        length += fabsf(node1.X - node2.X) + fabsf(node1.Y - node2.Y) + node1.Size + node2.Size;
+    }
+
+    return length;
+}
+
+static void WriteCounters(FILE* out, const char* name, const PerfCounters& counters, const PerfSample& total, double per)
+{
+    fprintf(out, " \"%s\": {", name);
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        fprintf(out, "%s\"%s\": ", i > 0 ? ", " : "", PerfCounterName((PerfCounter)i));
+        if (counters.IsAvailable((PerfCounter)i) && per > 0)
+            fprintf(out, "%.4g", total.Values[i] / per);
+        else
+            fprintf(out, "null");
+    }
+    fprintf(out, "},\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->Nodes = 1000;
+    options->Seed = 1;
+    options->Frames = 600;
+    options->Width = 480;
+    options->Height = 800;
+    options->Threads = 1;
+    options->ReorderInterval = 0;
+    options->Clusters = 0;
+    options->OutputPath = nullptr;
+    options->ZeroAllocationWarmup = -1;
+    options->AllocationReportPath = nullptr;
+    options->Counters = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--counters") == 0)
+        {
+            options->Counters = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--nodes") == 0)
+            options->Nodes = atoi(value);
+        else if (strcmp(argv[i - 1], "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "--frames") == 0)
+            options->Frames = atoi(value);
+        else if (strcmp(argv[i - 1], "--width") == 0)
+            options->Width = (float)atof(value);
+        else if (strcmp(argv[i - 1], "--height") == 0)
+            options->Height = (float)atof(value);
+        else if (strcmp(argv[i - 1], "--threads") == 0)
+            options->Threads = atoi(value);
+        else if (strcmp(argv[i - 1], "--reorder") == 0)
+            options->ReorderInterval = atoi(value);
+        else if (strcmp(argv[i - 1], "--clusters") == 0)
+            options->Clusters = atoi(value);
+        else if (strcmp(argv[i - 1], "--output") == 0)
+            options->OutputPath = value;
+        else if (strcmp(argv[i - 1], "--zero-allocations") == 0)
+            options->ZeroAllocationWarmup = atoi(value);
+        else if (strcmp(argv[i - 1], "--allocation-report") == 0)
+            options->AllocationReportPath = value;
+        else
+            return false;
+    }
+
+    // nodes are placed NodeSizeMax in from each edge
+    return options->Nodes > 0 && options->Frames > 0 && options->Threads > 0 && options->ReorderInterval >= 0 && options->Clusters >= 0 &&
+        options->Width > 2 * Garden::NodeSizeMax && options->Height > 2 * Garden::NodeSizeMax;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes n] [--seed n] [--frames n] [--width px] [--height px] [--threads n]\n"
+                        "       [--reorder n] [--clusters n] [--output file.json]\n"
+                        "       [--zero-allocations warmup] [--allocation-report file] [--counters]\n", argv[0]);
+        return 1;
+    }
+
+    Garden garden;
+    garden.SetSeed(options.Seed);
+    garden.SetSize(options.Width, options.Height);
+    garden.SetThreadCount(options.Threads);
+    garden.SetReorderInterval(options.ReorderInterval);
+    garden.AddMyNode();
+    garden.SetNodeCount(options.Nodes);
+    if (options.Clusters > 0)
+        Cluster(garden, options.Clusters, options.Seed);
+
+    std::vector<double> frameNs;
+    frameNs.reserve(options.Frames);
+    double reorderNs = 0, updateNs = 0, connectNs = 0, finishNs = 0, walkNs = 0;
+    double walked = 0;
+    double pairs = 0;
+    ConnectionStats stats = ConnectionStats();
+    uint64_t allocations = 0, allocatingFrames = 0;
+    uint64_t startBytes = AllocationTracker::GetBytes();
+
+    PerfCounters counters;
+    PerfSample frameStart, connectStart, connectEnd, frameEnd, delta;
+    PerfSample connectCounters = PerfSample(), frameCounters = PerfSample();
+    bool readCounters = options.Counters && counters.Open();
+
+    Clock::time_point runStart = Clock::now();
+
+    for (int frame = 0; frame < options.Frames; frame++)
+    {
+        // past warmup every allocation is worth a stack
+        if (frame == options.ZeroAllocationWarmup || (frame == 0 && options.AllocationReportPath != nullptr))
+            AllocationTracker::SetStackSampling(1);
+
+        // counters are read outside the timed steps
+        if (readCounters)
+            counters.Read(&frameStart);
+
+        uint64_t frameAllocations = AllocationTracker::GetCount();
+        Clock::time_point start = Clock::now();
+        garden.UpdateOrder();
+        Clock::time_point reordered = Clock::now();
+        garden.UpdateNodes(FrameDelta);
+        Clock::time_point updated = Clock::now();
+
+        if (readCounters)
+            counters.Read(&connectStart);
+
+        Clock::time_point connectStartTime = Clock::now();
+        garden.FindConnections();
+        Clock::time_point connected = Clock::now();
+
+        if (readCounters)
+            counters.Read(&connectEnd);
+
+        Clock::time_point finishStartTime = Clock::now();
+        garden.FinishConnections();
+        Clock::time_point finished = Clock::now();
+        frameAllocations = AllocationTracker::GetCount() - frameAllocations;
+
+        if (readCounters)
+        {
+            counters.Read(&frameEnd);
+            PerfCounters::Subtract(connectEnd, connectStart, &delta);
+            PerfCounters::Add(delta, &connectCounters);
+            PerfCounters::Subtract(frameEnd, frameStart, &delta);
+            PerfCounters::Add(delta, &frameCounters);
+        }
+
+        allocations += frameAllocations;
+        if (frameAllocations > 0 && options.ZeroAllocationWarmup >= 0 && frame >= options.ZeroAllocationWarmup)
+            allocatingFrames++;
+
+        double frameReorderNs = Elapsed(start, reordered);
+        double frameUpdateNs = Elapsed(reordered, updated);
+        double frameConnectNs = Elapsed(connectStartTime, connected);
+        double frameFinishNs = Elapsed(finishStartTime, finished);
+        reorderNs += frameReorderNs;
+        updateNs += frameUpdateNs;
+        connectNs += frameConnectNs;
+        finishNs += frameFinishNs;
+        frameNs.push_back(frameReorderNs + frameUpdateNs + frameConnectNs + frameFinishNs);
+        pairs += (double)garden.GetPairsTested();
+
+        CountConnections(garden, &stats);
+
+        Clock::time_point walkStart = Clock::now();
+        walked += WalkEdges(garden);
+        walkNs += Elapsed(walkStart, Clock::now());
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+    AllocationTracker::SetStackSampling(0);
+    uint64_t allocatedBytes = AllocationTracker::GetBytes() - startBytes;
+    double totalNs = reorderNs + updateNs + connectNs + finishNs;
+    std::sort(frameNs.begin(), frameNs.end());
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    size_t gardenBytes = garden.GetNodes().capacity() * sizeof(GardenNode) + garden.GetEdges().capacity() * sizeof(GardenEdge);
+
+    FILE* out = options.OutputPath != nullptr ? fopen(options.OutputPath, "w") : stdout;
+    if (out == nullptr)
+    {
+        fprintf(stderr, "can't write %s\n", options.OutputPath);
+        return 1;
+    }
+
+    double frames = options.Frames;
+    fprintf(out, "{\"nodes\": %d, \"seed\": %u, \"frames\": %d, \"width\": %g, \"height\": %g, \"threads\": %d, \"reorder\": %d, \"clusters\": %d,\n",
+        options.Nodes, options.Seed, options.Frames, options.Width, options.Height, options.Threads, options.ReorderInterval, options.Clusters);
+    fprintf(out, " \"ns_per_frame\": %.1f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f,\n",
+        totalNs / frames, Percentile(frameNs, 0.5), Percentile(frameNs, 0.9), Percentile(frameNs, 0.99), Percentile(frameNs, 1.0));
+    fprintf(out, " \"reorder_ns\": %.1f, \"update_ns\": %.1f, \"connect_ns\": %.1f, \"finish_ns\": %.1f, \"edge_walk_ns\": %.1f,\n",
+        reorderNs / frames, updateNs / frames, connectNs / frames, finishNs / frames, walkNs / frames);
+    fprintf(out, " \"pairs_per_frame\": %.0f, \"seconds\": %.3f, \"edge_walk_length\": %.6g,\n", pairs / frames, seconds, walked / frames);
+    fprintf(out, " \"peak_rss_kb\": %ld, \"garden_bytes\": %zu, \"allocations_tracked\": %s, \"allocs_per_frame\": %.2f, \"alloc_bytes_per_frame\": %.0f,\n",
+        usage.ru_maxrss, gardenBytes, AllocationTracker::IsCompiledIn() ? "true" : "false", allocations / frames, allocatedBytes / frames);
+    fprintf(out, " \"connections_per_frame\": %.1f, \"connected_nodes_per_frame\": %.1f, \"mean_degree\": %.3f, \"max_degree\": %d,\n",
+        stats.Edges / frames, stats.ConnectedNodes / frames, stats.MeanDegree / frames, stats.MaxDegree);
+    if (readCounters)
+    {
+        WriteCounters(out, "connect_counters_per_pair", counters, connectCounters, pairs);
+        WriteCounters(out, "frame_counters_per_node", counters, frameCounters, frames * options.Nodes);
+    }
+    if (options.Counters && counters.GetError()[0] != 0)
+        fprintf(out, " \"counters_error\": \"%s\",\n", counters.GetError());
+    fprintf(out, " \"mean_distance\": %.2f, \"checksum\": %u}\n", stats.MeanDistance / frames, garden.Checksum());
+
+    if (out != stdout)
+        fclose(out);
+
+    if (options.AllocationReportPath != nullptr)
+        AllocationTracker::WriteReport(options.AllocationReportPath);
+
+    if (allocatingFrames > 0)
+    {
+        fprintf(stderr, "%llu of %d steady state frames allocated\n", (unsigned long long)allocatingFrames, options.Frames - options.ZeroAllocationWarmup);
+        if (options.AllocationReportPath == nullptr)
+            AllocationTracker::WriteReport("/dev/stderr");
+        return 4;
+    }
+
+    return 0;
+}
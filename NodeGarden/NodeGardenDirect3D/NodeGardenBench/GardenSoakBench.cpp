@@ -0,0 +1,490 @@
+// Soaks a garden in peers that come and go for hours of simulated time, some leaving without
+// a RemoveNode, and checks Garden::SetNodeExpiry keeps it from filling up with their nodes.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardensoakbench GardenSoakBench.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardensoakbench [options]
+//     --minutes 120               simulated time
+//     --rate 20                   frames per simulated second
+//     --peers 100                 peers in the garden at any one time
+//     --wanderers 50              nodes nobody owns
+//     --lifetime 300              mean seconds a peer stays
+//     --update 2                  mean seconds between a peer's moves
+//     --vanish 0.5                share of peers that leave without a RemoveNode
+//     --expiry 10                 seconds of silence before a node fades out
+//     --sample 60                 seconds between samples
+//     --seed 1
+//
+// The same peers, joining, moving and leaving at the same moments, run through two gardens
+// one after the other: one with the expiry set and a control without. Each sample prints
+// both gardens' node count, the pairs the last connection pass tested, the mean Update time
+// since the last sample, and heap_bytes, what malloc had handed out above where the run
+// started. A garden counts as bounded when neither its node count nor its heap peaks more
+// than 10% higher in the second half of the run than in the first.
+//
+// With expiry, at every sample each peer still around has to have its node at full opacity,
+// and no peer silent for longer than the expiry, the fade and a frame either side may still
+// have one. Then a garden with expiry and the same churn is saved part way and loaded in to
+// another, and both have to carry on to the same checksum. Exits 1 unless the expiring
+// garden is bounded and every check passes; the control is expected to grow.
+
+#include "Garden.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float GardenSize = 4000.0f;
+static const double Growth = 1.1;
+
+struct Options
+{
+    float Minutes;
+    int Rate;
+    int Peers;
+    int Wanderers;
+    float Lifetime;
+    float Update;
+    float Vanish;
+    float Expiry;
+    float Sample;
+    uint32_t Seed;
+};
+
+struct Peer
+{
+    int Id;
+    double Leaves;
+    double NextMove;
+    double LastSeen;
+    bool Vanishes;
+};
+
+struct Sample
+{
+    int Nodes;
+    uint64_t Pairs;
+    double UpdateNs;
+    int64_t HeapBytes;
+};
+
+struct Pass
+{
+    std::vector<Sample> Samples;
+    int Vanished;
+    int Expired;                            // vanished peers whose node was gone by the end
+    int Failures;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static float Random(uint32_t* state, float max)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (float)((double)*state / 4294967295.0 * max);
+}
+
+static double Exponential(uint32_t* state, double mean)
+{
+    return -log(1.0 - Random(state, 1) * 0.9999999) * mean;
+}
+
+static int64_t HeapBytes()
+{
+    return (int64_t)mallinfo2().uordblks;
+}
+
+// the peers' side of a run: who joins, moves and leaves when, the same for every garden
+// started with the same seed
+class Peers
+{
+public:
+    Peers(const Options& options, uint32_t seed)
+    {
+        m_options = options;
+        m_randomState = seed != 0 ? seed : 0x9E3779B9;
+    }
+
+    // everything due by now. Peers that vanish are added to vanished, silent from then on
+    void Step(Garden& garden, double now, std::vector<Peer>* vanished)
+    {
+        for (size_t i = 0; i < m_live.size(); )
+        {
+            Peer& peer = m_live[i];
+            if (now >= peer.Leaves)
+            {
+                if (peer.Vanishes)
+                    vanished->push_back(peer);
+                else
+                    garden.RemoveNode(peer.Id);
+                m_live[i] = m_live.back();
+                m_live.pop_back();
+                continue;
+            }
+
+            if (now >= peer.NextMove)
+            {
+                garden.UpdateNodePosition(peer.Id, Position(), Position());
+                peer.LastSeen = now;
+                peer.NextMove = now + m_options.Update * (0.5 + Random(&m_randomState, 1));
+            }
+            i++;
+        }
+
+        while ((int)m_live.size() < m_options.Peers)
+        {
+            Peer peer;
+            float x = Position();
+            float y = Position();
+            peer.Id = garden.AddNode(x, y);
+            peer.Leaves = now + Exponential(&m_randomState, m_options.Lifetime);
+            peer.NextMove = now + m_options.Update * (0.5 + Random(&m_randomState, 1));
+            peer.LastSeen = now;
+            peer.Vanishes = Random(&m_randomState, 1) < m_options.Vanish;
+            m_live.push_back(peer);
+        }
+    }
+
+    const std::vector<Peer>& GetLive() const { return m_live; }
+
+private:
+    float Position()
+    {
+        return Garden::NodeSizeMax + Random(&m_randomState, GardenSize - 2 * Garden::NodeSizeMax);
+    }
+
+    Options m_options;
+    uint32_t m_randomState;
+    std::vector<Peer> m_live;
+};
+
+static void MakeGarden(Garden& garden, const Options& options, float expiry)
+{
+    garden.SetSeed(options.Seed);
+    garden.SetSize(GardenSize, GardenSize);
+    garden.AddMyNode();
+    garden.SetNodeCount(options.Wanderers + 1);
+    garden.SetNodeExpiry(expiry);
+}
+
+static std::unordered_set<int> NodeIds(const Garden& garden)
+{
+    std::unordered_set<int> ids;
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        ids.insert(nodes[i].Id);
+    }
+    return ids;
+}
+
+// every live peer on screen, every long silent one gone. Vanished peers whose node has gone
+// are dropped from the list, so the list itself doesn't grow the heap being measured
+static int CheckPeers(const Garden& garden, const Options& options, const Peers& peers,
+    std::vector<Peer>* vanished, double now, bool report, int* expired)
+{
+    double gone = options.Expiry + Garden::NodeFadeTime + 2.0 / options.Rate + 1.0 / Garden::TicksPerSecond;
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    std::unordered_set<int> faded;
+    std::unordered_set<int> ids;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        ids.insert(nodes[i].Id);
+        if (nodes[i].Opacity < 1)
+            faded.insert(nodes[i].Id);
+    }
+
+    int failures = 0;
+    const std::vector<Peer>& live = peers.GetLive();
+    for (size_t i = 0; i < live.size(); i++)
+    {
+        if (ids.count(live[i].Id) == 0 || faded.count(live[i].Id) != 0)
+        {
+            if (report && failures == 0)
+                fprintf(stderr, "peer %d, still around, lost its node at %.1fs\n", live[i].Id, now);
+            failures++;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < vanished->size(); i++)
+    {
+        const Peer& peer = (*vanished)[i];
+        if (now - peer.LastSeen <= gone)
+        {
+            (*vanished)[kept++] = peer;
+            continue;
+        }
+
+        if (ids.count(peer.Id) == 0)
+        {
+            (*expired)++;
+            continue;
+        }
+
+        if (report && failures == 0)
+            fprintf(stderr, "peer %d, silent since %.1fs, still had a node at %.1fs\n", peer.Id, peer.LastSeen, now);
+        failures++;
+    }
+    vanished->resize(kept);
+
+    return failures;
+}
+
+static Pass RunPass(const Options& options, float expiry)
+{
+    Pass pass = { std::vector<Sample>(), 0, 0, 0 };
+    int64_t heapStart = HeapBytes();
+
+    {
+        Garden garden;
+        MakeGarden(garden, options, expiry);
+        Peers peers(options, options.Seed);
+        std::vector<Peer> vanished;
+
+        float delta = 1.0f / options.Rate;
+        int frames = (int)(options.Minutes * 60 * options.Rate + 0.5f);
+        int sampleFrames = (int)(options.Sample * options.Rate + 0.5f);
+        if (sampleFrames < 1)
+            sampleFrames = 1;
+
+        double updateNs = 0;
+        for (int frame = 1; frame <= frames; frame++)
+        {
+            double now = frame * (double)delta;
+            peers.Step(garden, now, &vanished);
+            if (expiry == 0)
+            {
+                pass.Vanished += (int)vanished.size();
+                vanished.clear();
+            }
+
+            Clock::time_point start = Clock::now();
+            garden.Update((float)now, delta);
+            updateNs += Elapsed(start, Clock::now());
+
+            if (frame % sampleFrames != 0)
+                continue;
+
+            Sample sample = { garden.GetNodeCount(), garden.GetPairsTested(), updateNs / sampleFrames,
+                HeapBytes() - heapStart };
+            pass.Samples.push_back(sample);
+            updateNs = 0;
+
+            if (expiry > 0)
+            {
+                int expired = 0;
+                pass.Failures += CheckPeers(garden, options, peers, &vanished, now, pass.Failures == 0, &expired);
+                pass.Vanished += expired;
+                pass.Expired += expired;
+            }
+        }
+
+        // the ones too recently silent to have had to go yet; always none for the control
+        std::unordered_set<int> ids = NodeIds(garden);
+        pass.Vanished += (int)vanished.size();
+        for (size_t i = 0; i < vanished.size(); i++)
+        {
+            if (ids.count(vanished[i].Id) == 0)
+                pass.Expired++;
+        }
+    }
+
+    return pass;
+}
+
+// neither the node count nor the heap peaks more than Growth higher in the second half
+static bool IsBounded(const Pass& pass)
+{
+    size_t half = pass.Samples.size() / 2;
+    if (half == 0)
+        return true;
+
+    int nodes[2] = { 0, 0 };
+    int64_t heap[2] = { 0, 0 };
+    for (size_t i = 0; i < pass.Samples.size(); i++)
+    {
+        int h = i < half ? 0 : 1;
+        if (pass.Samples[i].Nodes > nodes[h])
+            nodes[h] = pass.Samples[i].Nodes;
+        if (pass.Samples[i].HeapBytes > heap[h])
+            heap[h] = pass.Samples[i].HeapBytes;
+    }
+
+    return nodes[1] <= nodes[0] * Growth && heap[1] <= heap[0] * Growth;
+}
+
+static void PrintSample(const char* name, const Sample& sample)
+{
+    printf("\"%s\": {\"nodes\": %d, \"pairs\": %llu, \"update_ns\": %.0f, \"heap_bytes\": %lld}",
+        name, sample.Nodes, (unsigned long long)sample.Pairs, sample.UpdateNs, (long long)sample.HeapBytes);
+}
+
+// churns the same way as a soak, then saves and loads part way through
+static bool CheckState(const Options& options)
+{
+    static const int SaveAt = 1200;
+    static const int RunFor = 2400;
+    float delta = 1.0f / options.Rate;
+
+    Options quick = options;
+    quick.Lifetime = options.Expiry * 2;
+    quick.Update = options.Expiry / 4;
+
+    Garden garden;
+    MakeGarden(garden, quick, options.Expiry);
+    Peers peers(quick, options.Seed);
+    std::vector<Peer> vanished;
+    for (int frame = 1; frame <= SaveAt; frame++)
+    {
+        peers.Step(garden, frame * (double)delta, &vanished);
+        if (frame % 500 == 0)
+            garden.ReorderNodes();
+        garden.Update(frame * delta, delta);
+    }
+
+    GardenState state;
+    garden.SaveState(&state);
+    Garden loaded;
+    loaded.LoadState(state);
+
+    // the peers carry on against both; they only read the ids each call returns, which match
+    Peers loadedPeers = peers;
+    std::vector<Peer> loadedVanished = vanished;
+    int firstDiverged = 0;
+    for (int frame = SaveAt + 1; frame <= RunFor; frame++)
+    {
+        peers.Step(garden, frame * (double)delta, &vanished);
+        loadedPeers.Step(loaded, frame * (double)delta, &loadedVanished);
+        if (frame % 500 == 0)
+        {
+            garden.ReorderNodes();
+            loaded.ReorderNodes();
+        }
+        garden.Update(frame * delta, delta);
+        loaded.Update(frame * delta, delta);
+        if (firstDiverged == 0 && garden.Checksum() != loaded.Checksum())
+            firstDiverged = frame;
+    }
+
+    bool ok = firstDiverged == 0;
+    printf("{\"state\": {\"saved_at\": %d, \"frames\": %d, \"nodes\": %d, \"ok\": %s}}\n",
+        SaveAt, RunFor, garden.GetNodeCount(), ok ? "true" : "false");
+    fflush(stdout);
+    if (!ok)
+        fprintf(stderr, "a loaded garden went its own way at frame %d\n", firstDiverged);
+
+    return ok;
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    options->Minutes = 120;
+    options->Rate = 20;
+    options->Peers = 100;
+    options->Wanderers = 50;
+    options->Lifetime = 300;
+    options->Update = 2;
+    options->Vanish = 0.5f;
+    options->Expiry = 10;
+    options->Sample = 60;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        float number = (float)atof(value);
+        if (strcmp(name, "--minutes") == 0)
+            options->Minutes = number > 0 ? number : 1;
+        else if (strcmp(name, "--rate") == 0)
+            options->Rate = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--peers") == 0)
+            options->Peers = atoi(value) > 0 ? atoi(value) : 0;
+        else if (strcmp(name, "--wanderers") == 0)
+            options->Wanderers = atoi(value) > 0 ? atoi(value) : 0;
+        else if (strcmp(name, "--lifetime") == 0)
+            options->Lifetime = number > 0 ? number : 1;
+        else if (strcmp(name, "--update") == 0)
+            options->Update = number > 0 ? number : 1;
+        else if (strcmp(name, "--vanish") == 0)
+            options->Vanish = number > 0 ? (number < 1 ? number : 1) : 0;
+        else if (strcmp(name, "--expiry") == 0)
+            options->Expiry = number > 0 ? number : 1;
+        else if (strcmp(name, "--sample") == 0)
+            options->Sample = number > 0 ? number : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    // a peer that moves less often than the expiry would rightly be expired
+    return options->Update * 1.5f < options->Expiry && options->Minutes * 60 >= options->Sample;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--minutes m] [--rate hz] [--peers n] [--wanderers n] [--lifetime s] "
+            "[--update s] [--vanish share] [--expiry s] [--sample s] [--seed n]\n"
+            "the longest wait between moves, 1.5 * update, has to be under the expiry, and the run at least a sample long\n",
+            argv[0]);
+        return 1;
+    }
+
+    Pass expiring = RunPass(options, options.Expiry);
+    Pass control = RunPass(options, 0);
+
+    for (size_t i = 0; i < expiring.Samples.size() && i < control.Samples.size(); i++)
+    {
+        printf("{\"minute\": %.1f, ", (i + 1) * options.Sample / 60.0);
+        PrintSample("expiry", expiring.Samples[i]);
+        printf(", ");
+        PrintSample("control", control.Samples[i]);
+        printf("}\n");
+    }
+
+    bool bounded = IsBounded(expiring);
+    bool controlBounded = IsBounded(control);
+    const Sample& last = expiring.Samples.back();
+    const Sample& controlLast = control.Samples.back();
+    bool ok = bounded && expiring.Failures == 0;
+    printf("{\"minutes\": %.1f, \"expiry_seconds\": %.1f, \"vanished\": %d, \"expired\": %d, \"failures\": %d, "
+        "\"bounded\": %s, \"control_bounded\": %s, \"ok\": %s}\n",
+        options.Minutes, options.Expiry, expiring.Vanished, expiring.Expired, expiring.Failures,
+        bounded ? "true" : "false", controlBounded ? "true" : "false", ok ? "true" : "false");
+    fflush(stdout);
+
+    fprintf(stderr, "after %.0f min  expiry %5d nodes %8.1f KB %7.3f ms   control %5d nodes %8.1f KB %7.3f ms   "
+        "%d of %d vanished peers expired%s\n",
+        options.Minutes, last.Nodes, last.HeapBytes / 1024.0, last.UpdateNs / 1e6,
+        controlLast.Nodes, controlLast.HeapBytes / 1024.0, controlLast.UpdateNs / 1e6,
+        expiring.Expired, expiring.Vanished, ok ? "" : "  FAILED");
+
+    ok = CheckState(options) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+// Compares scheduling wandering nodes' retargets in a TimerWheel, as Garden::UpdateNodes does,
+// against the old roll of a one in a thousand chance for every wandering node every frame.
+//
+// Linux only. Build from this folder with
+//     g++ -O2 -std=c++11 -I../NodeGardenDirect3DComp -o gardenwanderbench GardenWanderBench.cpp
+//         ../NodeGardenDirect3DComp/Garden.cpp ../NodeGardenDirect3DComp/Quadtree.cpp
+//         ../NodeGardenDirect3DComp/DensityField.cpp ../NodeGardenDirect3DComp/TaskPool.cpp
+//         ../NodeGardenDirect3DComp/TimerWheel.cpp ../NodeGardenDirect3DComp/MotionIntegrator.cpp
+//         ../NodeGardenDirect3DComp/Profiler.cpp -pthread
+//
+// gardenwanderbench [options]
+//     --nodes 100000              wandering nodes
+//     --rates 30,60,120           frame rates to simulate, in Hz
+//     --seconds 120               simulated time per rate
+//     --seed 1
+//
+// For each frame rate both ways run the same garden for the same simulated time.
+// update_ns is UpdateNodes against the old loop, rolls and all; retargets_per_second is how
+// many nodes picked a new target, against the expected count of nodes / WanderInterval. The
+// wheel has to land within 2% of that at every rate; the old roll only does at 60Hz. Then a
+// garden saved part way through, with nodes being adopted and reordered, has to carry on to
+// the same checksum once loaded in to another. Exits 1 if either check fails.
+
+#include "Garden.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float GardenSize = 20000.0f;
+static const double Tolerance = 0.02;
+
+struct Options
+{
+    int Nodes;
+    std::vector<int> Rates;
+    float Seconds;
+    uint32_t Seed;
+};
+
+struct Run
+{
+    double UpdateNs;
+    double Retargets;
+    int Frames;
+};
+
+static double Elapsed(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// nodes whose target moved since last time; targets holds last time's
+static int CountRetargets(const std::vector<GardenNode>& nodes, std::vector<float>* targets)
+{
+    int changed = 0;
+    targets->resize(nodes.size() * 2);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        float* target = &(*targets)[i * 2];
+        if (target[0] != nodes[i].TargetX || target[1] != nodes[i].TargetY)
+        {
+            target[0] = nodes[i].TargetX;
+            target[1] = nodes[i].TargetY;
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// Garden::UpdateNodes as it was, on a copy of the nodes
+class OldWander
+{
+public:
+    OldWander(const std::vector<GardenNode>& nodes, uint32_t seed)
+    {
+        m_nodes = nodes;
+        m_randomState = seed != 0 ? seed : 0x9E3779B9;
+    }
+
+    void UpdateNodes(float timeDelta)
+    {
+        size_t count = m_nodes.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            GardenNode& node = m_nodes[i];
+
+            if (node.Id == -1)
+            {
+                if (Random(1000) > 999)
+                {
+                    node.TargetX = Garden::NodeSizeMax + Random(GardenSize - 2 * Garden::NodeSizeMax);
+                    node.TargetY = Garden::NodeSizeMax + Random(GardenSize - 2 * Garden::NodeSizeMax);
+                }
+            }
+
+            if (fabsf(node.X - node.TargetX) > 0.5f && fabsf(node.Y - node.TargetY) > 0.5f)
+            {
+                node.X += (node.TargetX - node.X) * Garden::Speed * timeDelta;
+                node.Y += (node.TargetY - node.Y) * Garden::Speed * timeDelta;
+            }
+        }
+    }
+
+    const std::vector<GardenNode>& GetNodes() const { return m_nodes; }
+
+private:
+    float Random(float max)
+    {
+        m_randomState ^= m_randomState << 13;
+        m_randomState ^= m_randomState >> 17;
+        m_randomState ^= m_randomState << 5;
+        return (float)((double)m_randomState / 4294967295.0 * max);
+    }
+
+    std::vector<GardenNode> m_nodes;
+    uint32_t m_randomState;
+};
+
+static void MakeGarden(Garden& garden, const Options& options)
+{
+    garden.SetSeed(options.Seed);
+    garden.SetSize(GardenSize, GardenSize);
+    garden.SetNodeCount(options.Nodes);
+}
+
+static bool RunRate(const Options& options, int rate)
+{
+    float delta = 1.0f / rate;
+    int frames = (int)(options.Seconds * rate + 0.5f);
+
+    Garden garden;
+    MakeGarden(garden, options);
+    OldWander old(garden.GetNodes(), options.Seed);
+
+    Run wheel = { 0, 0, frames };
+    Run roll = { 0, 0, frames };
+    std::vector<float> wheelTargets, rollTargets;
+    CountRetargets(garden.GetNodes(), &wheelTargets);
+    CountRetargets(old.GetNodes(), &rollTargets);
+    for (int frame = 0; frame < frames; frame++)
+    {
+        Clock::time_point start = Clock::now();
+        garden.UpdateNodes(delta);
+        Clock::time_point updated = Clock::now();
+        wheel.UpdateNs += Elapsed(start, updated);
+        wheel.Retargets += CountRetargets(garden.GetNodes(), &wheelTargets);
+
+        start = Clock::now();
+        old.UpdateNodes(delta);
+        updated = Clock::now();
+        roll.UpdateNs += Elapsed(start, updated);
+        roll.Retargets += CountRetargets(old.GetNodes(), &rollTargets);
+    }
+
+    double seconds = frames * (double)delta;
+    double expected = options.Nodes / (double)Garden::WanderInterval;
+    double wheelRate = wheel.Retargets / seconds;
+    double rollRate = roll.Retargets / seconds;
+    bool ok = fabs(wheelRate / expected - 1) <= Tolerance;
+
+    printf("{\"nodes\": %d, \"rate_hz\": %d, \"frames\": %d, \"expected_retargets_per_second\": %.1f, "
+        "\"wheel\": {\"update_ns\": %.0f, \"retargets_per_second\": %.1f}, "
+        "\"roll\": {\"update_ns\": %.0f, \"retargets_per_second\": %.1f}, \"ok\": %s}\n",
+        options.Nodes, rate, frames, expected, wheel.UpdateNs / frames, wheelRate,
+        roll.UpdateNs / frames, rollRate, ok ? "true" : "false");
+    fflush(stdout);
+
+    fprintf(stderr, "%4d Hz  wheel %8.3f ms %8.1f/s   roll %8.3f ms %8.1f/s   expected %8.1f/s%s\n",
+        rate, wheel.UpdateNs / frames / 1e6, wheelRate, roll.UpdateNs / frames / 1e6, rollRate, expected,
+        ok ? "" : "  FAILED");
+
+    return ok;
+}
+
+// adopts a few wanderers and reorders now and then, so the timers are renumbered under it
+static void Step(Garden& garden, int frame)
+{
+    if (frame % 97 == 0)
+        garden.UpdateNodePosition(1000 + frame, 100.0f + frame, 200.0f);
+    if (frame % 50 == 0)
+        garden.ReorderNodes();
+    if (frame % 131 == 0)
+        garden.RemoveNode(1000 + frame - 97 * 3);
+
+    garden.UpdateNodes(1.0f / 60);
+}
+
+static bool CheckState(const Options& options)
+{
+    static const int SaveAt = 600;
+    static const int RunFor = 1200;
+    int nodes = options.Nodes < 20000 ? options.Nodes : 20000;
+
+    Garden garden;
+    garden.SetSeed(options.Seed);
+    garden.SetSize(GardenSize, GardenSize);
+    garden.SetNodeCount(nodes);
+
+    GardenState state;
+    for (int frame = 1; frame <= SaveAt; frame++)
+        Step(garden, frame);
+    garden.SaveState(&state);
+
+    Garden loaded;
+    loaded.LoadState(state);
+    for (int frame = SaveAt + 1; frame <= RunFor; frame++)
+    {
+        Step(garden, frame);
+        Step(loaded, frame);
+    }
+
+    bool ok = garden.Checksum() == loaded.Checksum();
+    printf("{\"state\": {\"nodes\": %d, \"saved_at\": %d, \"frames\": %d, \"ok\": %s}}\n",
+        nodes, SaveAt, RunFor, ok ? "true" : "false");
+    if (!ok)
+        fprintf(stderr, "a loaded garden went its own way after frame %d\n", SaveAt);
+
+    return ok;
+}
+
+static bool ParseRates(const char* text, std::vector<int>* rates)
+{
+    rates->clear();
+    while (*text != 0)
+    {
+        char* end;
+        long rate = strtol(text, &end, 10);
+        if (end == text || rate < 1)
+            return false;
+
+        rates->push_back((int)rate);
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return !rates->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    static const int DefaultRates[] = { 30, 60, 120 };
+    options->Nodes = 100000;
+    options->Rates.assign(DefaultRates, DefaultRates + sizeof(DefaultRates) / sizeof(DefaultRates[0]));
+    options->Seconds = 120;
+    options->Seed = 1;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--nodes") == 0)
+            options->Nodes = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(name, "--rates") == 0)
+        {
+            if (!ParseRates(value, &options->Rates))
+                return false;
+        }
+        else if (strcmp(name, "--seconds") == 0)
+            options->Seconds = atof(value) > 0 ? (float)atof(value) : 1;
+        else if (strcmp(name, "--seed") == 0)
+            options->Seed = (uint32_t)strtoul(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--nodes n] [--rates 30,60,...] [--seconds s] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (size_t r = 0; r < options.Rates.size(); r++)
+    {
+        ok = RunRate(options, options.Rates[r]) && ok;
+    }
+    ok = CheckState(options) && ok;
+
+    return ok ? 0 : 1;
+}
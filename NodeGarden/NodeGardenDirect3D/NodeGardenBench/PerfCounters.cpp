@@ -0,0 +1,162 @@
+#include "PerfCounters.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static const char* PerfCounterNames[PerfCounter_Count] = { "cycles", "instructions", "l1_misses", "llc_misses", "branch_misses" };
+
+const char* PerfCounterName(PerfCounter counter)
+{
+    return PerfCounterNames[counter];
+}
+
+static void Describe(PerfCounter counter, struct perf_event_attr* attr)
+{
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = PERF_TYPE_HARDWARE;
+
+    switch (counter)
+    {
+    case PerfCounter_Cycles:
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+
+    case PerfCounter_Instructions:
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+
+    case PerfCounter_L1Misses:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+
+    case PerfCounter_LLCMisses:
+        attr->config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+
+    default:
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+
+    // the simulation's own work only; the kernel is usually off limits anyway
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+
+    // counts threads started after opening too, once they have been joined, so the threaded
+    // connection pass is measured whole
+    attr->inherit = 1;
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+PerfCounters::PerfCounters(void)
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        m_fds[i] = -1;
+    }
+    m_error[0] = 0;
+}
+
+PerfCounters::~PerfCounters(void)
+{
+    Close();
+}
+
+bool PerfCounters::Open()
+{
+    Close();
+
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        struct perf_event_attr attr;
+        Describe((PerfCounter)i, &attr);
+
+        // this thread, any CPU
+        int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd < 0)
+        {
+            if (m_error[0] == 0)
+                snprintf(m_error, sizeof(m_error), "%s: %s", PerfCounterNames[i], strerror(errno));
+            continue;
+        }
+
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        m_fds[i] = fd;
+    }
+
+    return IsAnyAvailable();
+}
+
+void PerfCounters::Close()
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        if (m_fds[i] >= 0)
+            close(m_fds[i]);
+        m_fds[i] = -1;
+    }
+    m_error[0] = 0;
+}
+
+bool PerfCounters::IsAvailable(PerfCounter counter) const
+{
+    return m_fds[counter] >= 0;
+}
+
+bool PerfCounters::IsAnyAvailable() const
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        if (m_fds[i] >= 0)
+            return true;
+    }
+
+    return false;
+}
+
+const char* PerfCounters::GetError() const
+{
+    return m_error;
+}
+
+void PerfCounters::Read(PerfSample* sample) const
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        uint64_t values[3];     // count, time enabled, time running
+        sample->Values[i] = 0;
+
+        if (m_fds[i] < 0 || read(m_fds[i], values, sizeof(values)) != (ssize_t)sizeof(values))
+            continue;
+
+        // more events than hardware counters means each one only runs part of the time
+        if (values[2] > 0 && values[2] < values[1])
+            sample->Values[i] = (uint64_t)((double)values[0] * values[1] / values[2]);
+        else
+            sample->Values[i] = values[0];
+    }
+}
+
+void PerfCounters::Subtract(const PerfSample& after, const PerfSample& before, PerfSample* delta)
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        // scaling can make a multiplexed total step backwards a little
+        delta->Values[i] = after.Values[i] > before.Values[i] ? after.Values[i] - before.Values[i] : 0;
+    }
+}
+
+void PerfCounters::Add(const PerfSample& delta, PerfSample* total)
+{
+    for (int i = 0; i < PerfCounter_Count; i++)
+    {
+        total->Values[i] += delta.Values[i];
+    }
+}
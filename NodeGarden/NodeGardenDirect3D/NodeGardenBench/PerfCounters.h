@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// The hardware counters the benchmarks read around each step
+enum PerfCounter
+{
+    PerfCounter_Cycles,
+    PerfCounter_Instructions,
+    PerfCounter_L1Misses,           // L1 data cache read misses
+    PerfCounter_LLCMisses,          // last level cache misses
+    PerfCounter_BranchMisses,
+    PerfCounter_Count,
+};
+
+const char* PerfCounterName(PerfCounter counter);
+
+// Running totals at one moment, scaled up for any time the kernel had the counter switched out
+struct PerfSample
+{
+    uint64_t Values[PerfCounter_Count];
+};
+
+// This thread's user space counts through perf_event_open. Each counter is opened on its own,
+// so a machine that has cycles but no cache events (most VMs) still reports what it can, and
+// one with none at all (containers with perf_event_paranoid set high, seccomp) reports none
+// rather than failing. Reading is one syscall per counter that opened.
+class PerfCounters
+{
+public:
+    PerfCounters(void);
+    ~PerfCounters(void);
+
+    // false if no counter opened; GetError then says why the first one didn't
+    bool Open();
+    void Close();
+
+    bool IsAvailable(PerfCounter counter) const;
+    bool IsAnyAvailable() const;
+    const char* GetError() const;
+
+    // counters that didn't open read as zero
+    void Read(PerfSample* sample) const;
+
+    // after - before, per counter
+    static void Subtract(const PerfSample& after, const PerfSample& before, PerfSample* delta);
+    static void Add(const PerfSample& delta, PerfSample* total);
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int m_fds[PerfCounter_Count];
+    char m_error[96];
+};
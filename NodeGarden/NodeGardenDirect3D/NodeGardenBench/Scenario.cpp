@@ -0,0 +1,109 @@
+#include "Scenario.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+const float Scenario::ScreenWidth = 480.0f;
+const float Scenario::ScreenHeight = 800.0f;
+const float Scenario::BlobSpread = 60.0f;
+
+static const char* DistributionNames[Distribution_Count] = { "uniform", "clustered", "ring", "cell" };
+
+const char* DistributionName(Distribution distribution)
+{
+    return DistributionNames[distribution];
+}
+
+bool ParseDistribution(const char* name, Distribution* distribution)
+{
+    for (int i = 0; i < Distribution_Count; i++)
+    {
+        if (strcmp(name, DistributionNames[i]) == 0)
+        {
+            *distribution = (Distribution)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Scenario::Populate(Garden& garden, Distribution distribution, int nodeCount, uint32_t seed)
+{
+    Populate(garden, distribution, nodeCount, seed, nodeCount > ScreenNodes ? (float)nodeCount / ScreenNodes : 1.0f);
+}
+
+void Scenario::Populate(Garden& garden, Distribution distribution, int nodeCount, uint32_t seed, float screens)
+{
+    float scale = sqrtf(screens);
+
+    garden.Clear();
+    garden.SetSeed(seed);
+    garden.SetSize(ScreenWidth * scale, ScreenHeight * scale);
+
+    int blobCount = nodeCount / BlobSize > 1 ? nodeCount / BlobSize : 1;
+    std::vector<float> blobs(blobCount * 2);
+    for (int i = 0; i < blobCount; i++)
+    {
+        Sample(garden, Distribution_Uniform, nullptr, 0, &blobs[i * 2], &blobs[i * 2 + 1]);
+    }
+
+    for (int i = 0; i < nodeCount; i++)
+    {
+        float x, y, targetX, targetY;
+        Sample(garden, distribution, blobs.data(), blobCount, &x, &y);
+        Sample(garden, distribution, blobs.data(), blobCount, &targetX, &targetY);
+
+        garden.AddNode(x, y);
+        garden.SetNodeTarget(i, targetX, targetY);
+    }
+}
+
+void Scenario::Sample(Garden& garden, Distribution distribution, const float* blobs, int blobCount, float* x, float* y)
+{
+    float width = garden.GetWidth();
+    float height = garden.GetHeight();
+
+    switch (distribution)
+    {
+    case Distribution_Clustered:
+        {
+            int blob = (int)garden.Random((float)blobCount - 0.001f);
+            *x = blobs[blob * 2] + Gaussian(garden) * BlobSpread;
+            *y = blobs[blob * 2 + 1] + Gaussian(garden) * BlobSpread;
+        }
+        break;
+
+    case Distribution_Ring:
+        {
+            float radius = (width < height ? width : height) * 0.4f + garden.Random(20.0f) - 10.0f;
+            float angle = garden.Random(6.2831853f);
+            *x = width / 2 + radius * cosf(angle);
+            *y = height / 2 + radius * sinf(angle);
+        }
+        break;
+
+    case Distribution_Cell:
+        {
+            // a square with a diagonal under MinDist
+            float side = Garden::MinDist * 0.7f;
+            *x = (width - side) / 2 + garden.Random(side);
+            *y = (height - side) / 2 + garden.Random(side);
+        }
+        break;
+
+    default:
+        *x = Garden::NodeSizeMax + garden.Random(width - 2 * Garden::NodeSizeMax);
+        *y = Garden::NodeSizeMax + garden.Random(height - 2 * Garden::NodeSizeMax);
+        break;
+    }
+}
+
+float Scenario::Gaussian(Garden& garden)
+{
+    // Box-Muller; keep away from log(0)
+    float u1 = garden.Random(1.0f) * 0.999999f + 0.000001f;
+    float u2 = garden.Random(1.0f);
+
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Garden.h"
+
+// How benchmark nodes are laid out
+enum Distribution
+{
+    Distribution_Uniform,       // spread evenly over the garden
+    Distribution_Clustered,     // gaussian blobs of about BlobSize nodes
+    Distribution_Ring,          // a thin circle, so every node has a long run of neighbours
+    Distribution_Cell,          // everything inside one MinDist cell: every pair connects
+    Distribution_Count,
+};
+
+const char* DistributionName(Distribution distribution);
+bool ParseDistribution(const char* name, Distribution* distribution);
+
+// The garden grows with the node count so uniform density matches 50 nodes on a phone
+// screen; a big garden is what a shared garden looks like from one device.
+class Scenario
+{
+public:
+    static const float ScreenWidth;
+    static const float ScreenHeight;
+    static const int ScreenNodes = 50;
+    static const int BlobSize = 200;
+    static const float BlobSpread;
+
+    // fills an empty garden with remote nodes easing towards a second sample of the same
+    // distribution, so the layout holds while the update still has work to do
+    static void Populate(Garden& garden, Distribution distribution, int nodeCount, uint32_t seed);
+    // the same in a garden of a fixed area, this many screens, whatever the node count
+    static void Populate(Garden& garden, Distribution distribution, int nodeCount, uint32_t seed, float screens);
+
+private:
+    static void Sample(Garden& garden, Distribution distribution, const float* blobs, int blobCount, float* x, float* y);
+    static float Gaussian(Garden& garden);
+};
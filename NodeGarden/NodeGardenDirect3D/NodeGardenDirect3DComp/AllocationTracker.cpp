@@ -0,0 +1,284 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define ALLOCATION_THREAD_LOCAL __declspec(thread)
+#else
+#include <execinfo.h>
+#define ALLOCATION_THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+    // All of this is touched from inside operator new, so none of it may allocate. The
+    // counters are plain zero initialised atomics, ready before any constructor runs.
+    struct PhaseCounters
+    {
+        std::atomic<uint64_t> Count;
+        std::atomic<uint64_t> Bytes;
+    };
+
+    const char* s_phaseNames[AllocationTracker::MaxPhases] = { "(none)" };
+    PhaseCounters s_phases[AllocationTracker::MaxPhases];
+    std::atomic<int> s_phaseCount(1);
+    std::mutex s_phaseMutex;
+
+    std::atomic<uint64_t> s_count(0);
+    std::atomic<uint64_t> s_bytes(0);
+
+    std::atomic<uint32_t> s_sampleEvery(0);
+    std::mutex s_sampleMutex;
+    AllocationSample s_samples[AllocationTracker::MaxSamples];
+    uint64_t s_samplesWritten;
+
+    ALLOCATION_THREAD_LOCAL int t_phase;
+    ALLOCATION_THREAD_LOCAL bool t_sampling;
+
+    uint32_t CaptureStack(void** frames, int maxFrames)
+    {
+#if defined(_WIN32)
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+        return CaptureStackBackTrace(2, maxFrames, frames, nullptr);
+#else
+        // phone apps can't walk the stack; samples still say which phase and how big
+        (void)frames;
+        (void)maxFrames;
+        return 0;
+#endif
+#else
+        int count = backtrace(frames, maxFrames);
+        return count > 0 ? (uint32_t)count : 0;
+#endif
+    }
+
+    void Sample(int phase, size_t size)
+    {
+        // in case walking the stack allocates through operator new itself
+        if (t_sampling)
+            return;
+        t_sampling = true;
+
+        AllocationSample sample;
+        sample.Phase = s_phaseNames[phase];
+        sample.Size = size;
+        sample.FrameCount = CaptureStack(sample.Frames, AllocationSample::MaxFrames);
+
+        {
+            std::lock_guard<std::mutex> lock(s_sampleMutex);
+            s_samples[s_samplesWritten % AllocationTracker::MaxSamples] = sample;
+            s_samplesWritten++;
+        }
+
+        t_sampling = false;
+    }
+}
+
+bool AllocationTracker::IsCompiledIn()
+{
+    return ALLOCATION_TRACKING_ENABLED != 0;
+}
+
+int AllocationTracker::RegisterPhase(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_phaseMutex);
+
+    int count = s_phaseCount.load(std::memory_order_relaxed);
+    for (int i = 1; i < count; i++)
+    {
+        if (strcmp(s_phaseNames[i], name) == 0)
+            return i;
+    }
+
+    if (count == MaxPhases)
+        return 0;
+
+    s_phaseNames[count] = name;
+    s_phaseCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+int AllocationTracker::EnterPhase(int phase)
+{
+    int previous = t_phase;
+    t_phase = phase;
+    return previous;
+}
+
+void AllocationTracker::LeavePhase(int previous)
+{
+    t_phase = previous;
+}
+
+uint64_t AllocationTracker::GetCount()
+{
+    return s_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::GetBytes()
+{
+    return s_bytes.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::GetStats(std::vector<AllocationStats>* stats)
+{
+    stats->clear();
+
+    int count = s_phaseCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        AllocationStats phase = { s_phaseNames[i], s_phases[i].Count.load(std::memory_order_relaxed), s_phases[i].Bytes.load(std::memory_order_relaxed) };
+        stats->push_back(phase);
+    }
+}
+
+void AllocationTracker::Reset()
+{
+    for (int i = 0; i < MaxPhases; i++)
+    {
+        s_phases[i].Count.store(0, std::memory_order_relaxed);
+        s_phases[i].Bytes.store(0, std::memory_order_relaxed);
+    }
+
+    s_count.store(0, std::memory_order_relaxed);
+    s_bytes.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(s_sampleMutex);
+    s_samplesWritten = 0;
+}
+
+void AllocationTracker::SetStackSampling(uint32_t every)
+{
+    s_sampleEvery.store(every, std::memory_order_relaxed);
+}
+
+void AllocationTracker::GetSamples(std::vector<AllocationSample>* samples)
+{
+    samples->clear();
+
+    // copied out under the lock first; the vector allocating mustn't happen while it's held
+    std::vector<AllocationSample> copy(MaxSamples);
+    uint64_t written;
+    {
+        std::lock_guard<std::mutex> lock(s_sampleMutex);
+        written = s_samplesWritten;
+        memcpy(&copy[0], s_samples, sizeof(s_samples));
+    }
+
+    uint64_t first = written > MaxSamples ? written - MaxSamples : 0;
+    for (uint64_t i = first; i < written; i++)
+    {
+        samples->push_back(copy[i % MaxSamples]);
+    }
+}
+
+bool AllocationTracker::WriteReport(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    std::vector<AllocationStats> stats;
+    GetStats(&stats);
+
+    fprintf(file, "%-24s %12s %14s\n", "phase", "allocations", "bytes");
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        fprintf(file, "%-24s %12llu %14llu\n", stats[i].Phase, (unsigned long long)stats[i].Count, (unsigned long long)stats[i].Bytes);
+    }
+
+    std::vector<AllocationSample> samples;
+    GetSamples(&samples);
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        const AllocationSample& sample = samples[i];
+        fprintf(file, "\n%zu bytes in %s\n", sample.Size, sample.Phase);
+
+#if defined(_WIN32)
+        for (uint32_t f = 0; f < sample.FrameCount; f++)
+        {
+            fprintf(file, "    %p\n", sample.Frames[f]);
+        }
+#else
+        char** symbols = backtrace_symbols(sample.Frames, (int)sample.FrameCount);
+        for (uint32_t f = 0; f < sample.FrameCount; f++)
+        {
+            fprintf(file, "    %s\n", symbols != nullptr ? symbols[f] : "?");
+        }
+        free(symbols);
+#endif
+    }
+
+    return fclose(file) == 0;
+}
+
+void AllocationTracker::Record(size_t size)
+{
+    int phase = t_phase;
+    s_phases[phase].Count.fetch_add(1, std::memory_order_relaxed);
+    s_phases[phase].Bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t count = s_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    s_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    uint32_t every = s_sampleEvery.load(std::memory_order_relaxed);
+    if (every != 0 && count % every == 0)
+        Sample(phase, size);
+}
+
+#if ALLOCATION_TRACKING_ENABLED
+
+// The array and nothrow forms are replaced too, so the library's own can't skip the count
+void* operator new(size_t size)
+{
+    AllocationTracker::Record(size);
+
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    AllocationTracker::Record(size);
+    return malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+    free(p);
+}
+
+#endif
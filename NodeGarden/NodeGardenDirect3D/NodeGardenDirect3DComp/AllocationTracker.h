@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Builds that define NODEGARDEN_TRACK_ALLOCATIONS replace the global operator new so every heap
+// allocation made through it is counted against the phase its thread is in. Otherwise nothing
+// is replaced, ALLOCATION_PHASE expands to nothing and every count stays at zero.
+#if defined(NODEGARDEN_TRACK_ALLOCATIONS)
+#define ALLOCATION_TRACKING_ENABLED 1
+#else
+#define ALLOCATION_TRACKING_ENABLED 0
+#endif
+
+struct AllocationStats
+{
+    const char* Phase;
+    uint64_t Count;
+    uint64_t Bytes;
+};
+
+// One sampled allocation and the return addresses above it
+struct AllocationSample
+{
+    static const int MaxFrames = 16;
+
+    const char* Phase;
+    size_t Size;
+    uint32_t FrameCount;
+    void* Frames[MaxFrames];
+};
+
+// Counts allocations and bytes per phase. Counting is a thread local read and two relaxed
+// atomic adds per allocation; with stack sampling on, every Nth allocation also walks the stack
+// in to a small ring. Phases nest: an allocation belongs to the innermost one.
+class AllocationTracker
+{
+public:
+    static const int MaxPhases = 32;        // later phases are counted as phase 0
+    static const int MaxSamples = 256;      // older samples are overwritten
+
+    static bool IsCompiledIn();
+
+    // Phase 0 is everything outside a phase. Names are kept, not copied
+    static int RegisterPhase(const char* name);
+
+    // returns the phase the thread was in, for LeavePhase
+    static int EnterPhase(int phase);
+    static void LeavePhase(int previous);
+
+    // totals across all phases and threads since the last Reset
+    static uint64_t GetCount();
+    static uint64_t GetBytes();
+
+    static void GetStats(std::vector<AllocationStats>* stats);
+    static void Reset();
+
+    // record the stack of every Nth allocation; 0 turns sampling off
+    static void SetStackSampling(uint32_t every);
+    static void GetSamples(std::vector<AllocationSample>* samples);
+
+    // per phase totals then the samples, symbolised where the platform can
+    static bool WriteReport(const std::string& path);
+
+    // for the operator new replacement
+    static void Record(size_t size);
+};
+
+class AllocationPhase
+{
+public:
+    explicit AllocationPhase(int phase)
+    {
+        m_previous = AllocationTracker::EnterPhase(phase);
+    }
+
+    ~AllocationPhase()
+    {
+        AllocationTracker::LeavePhase(m_previous);
+    }
+
+private:
+    AllocationPhase(const AllocationPhase&);
+    AllocationPhase& operator=(const AllocationPhase&);
+
+    int m_previous;
+};
+
+#define ALLOCATION_JOIN2(a, b) a##b
+#define ALLOCATION_JOIN(a, b) ALLOCATION_JOIN2(a, b)
+
+#if ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_PHASE(name) \
+    static const int ALLOCATION_JOIN(allocationPhaseId, __LINE__) = AllocationTracker::RegisterPhase(name); \
+    AllocationPhase ALLOCATION_JOIN(allocationPhase, __LINE__)(ALLOCATION_JOIN(allocationPhaseId, __LINE__))
+#else
+#define ALLOCATION_PHASE(name)
+#endif
@@ -0,0 +1,65 @@
+#include "CullRect.h"
+
+CullRect::CullRect(void) : m_left(0), m_top(0), m_right(0), m_bottom(0)
+{
+}
+
+CullRect::CullRect(float left, float top, float right, float bottom) :
+    m_left(left), m_top(top), m_right(right), m_bottom(bottom)
+{
+}
+
+bool CullRect::IntersectsCircle(float x, float y, float radius) const
+{
+    // distance from the centre to the closest point of the rectangle
+    float dx = x < m_left ? m_left - x : (x > m_right ? x - m_right : 0.0f);
+    float dy = y < m_top ? m_top - y : (y > m_bottom ? y - m_bottom : 0.0f);
+
+    return dx * dx + dy * dy <= radius * radius;
+}
+
+bool CullRect::IntersectsSegment(float x1, float y1, float x2, float y2, float strokeThickness) const
+{
+    float left = m_left - strokeThickness;
+    float top = m_top - strokeThickness;
+    float right = m_right + strokeThickness;
+    float bottom = m_bottom + strokeThickness;
+
+    // Liang-Barsky clip of the segment against the (grown) rectangle
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float p[4] = { -dx, dx, -dy, dy };
+    float q[4] = { x1 - left, right - x1, y1 - top, bottom - y1 };
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0.0f)
+        {
+            // parallel to this edge, so it's either fully inside or fully outside it
+            if (q[i] < 0.0f)
+                return false;
+        }
+        else
+        {
+            float t = q[i] / p[i];
+            if (p[i] < 0.0f)
+            {
+                if (t > t1)
+                    return false;
+                if (t > t0)
+                    t0 = t;
+            }
+            else
+            {
+                if (t < t0)
+                    return false;
+                if (t < t1)
+                    t1 = t;
+            }
+        }
+    }
+
+    return true;
+}
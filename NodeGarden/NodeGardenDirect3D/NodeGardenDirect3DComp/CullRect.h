@@ -0,0 +1,33 @@
+#pragma once
+
+// Axis aligned visible region used to skip sprites that can't land on the render target.
+// Plain floats only so the same tests run outside of DirectX.
+class CullRect
+{
+public:
+    CullRect(void);
+    CullRect(float left, float top, float right, float bottom);
+    ~CullRect(void) {};
+
+    bool IntersectsCircle(float x, float y, float radius) const;
+
+    // a segment drawn with the given stroke, which may hang off either side of it
+    bool IntersectsSegment(float x1, float y1, float x2, float y2, float strokeThickness) const;
+
+private:
+    float m_left;
+    float m_top;
+    float m_right;
+    float m_bottom;
+};
+
+// Per frame counts of what the cull stage let through
+struct CullStats
+{
+    int NodesDrawn;
+    int NodesCulled;
+    int LinesDrawn;
+    int LinesCulled;
+
+    void Reset() { NodesDrawn = NodesCulled = LinesDrawn = LinesCulled = 0; }
+};
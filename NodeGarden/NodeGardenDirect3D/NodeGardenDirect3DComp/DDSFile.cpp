@@ -0,0 +1,367 @@
+#include "DDSFile.h"
+#include <string.h>
+
+namespace
+{
+    // On-disk layouts, see "DDS File Layout" in the DirectX documentation
+    struct DDSPixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t RGBBitCount;
+        uint32_t RBitMask;
+        uint32_t GBitMask;
+        uint32_t BBitMask;
+        uint32_t ABitMask;
+    };
+
+    struct DDSHeader
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DDSPixelFormat ddspf;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+
+    struct DDSHeaderDXT10
+    {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    const uint32_t DDPF_ALPHA = 0x2;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDPF_RGB = 0x40;
+    const uint32_t DDPF_LUMINANCE = 0x20000;
+
+    const uint32_t DDSD_DEPTH = 0x800000;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+
+    const uint32_t DIMENSION_TEXTURE1D = 2;
+    const uint32_t DIMENSION_TEXTURE2D = 3;
+    const uint32_t DIMENSION_TEXTURE3D = 4;
+    const uint32_t MISC_TEXTURECUBE = 0x4;
+
+    // the DXGI_FORMAT values we map legacy headers on to
+    enum
+    {
+        FORMAT_UNKNOWN = 0,
+        FORMAT_R32G32B32A32_FLOAT = 2,
+        FORMAT_R16G16B16A16_FLOAT = 10,
+        FORMAT_R16G16B16A16_UNORM = 11,
+        FORMAT_R16G16B16A16_SNORM = 13,
+        FORMAT_R32G32_FLOAT = 16,
+        FORMAT_R10G10B10A2_UNORM = 24,
+        FORMAT_R8G8B8A8_UNORM = 28,
+        FORMAT_R16G16_FLOAT = 34,
+        FORMAT_R16G16_UNORM = 35,
+        FORMAT_R32_FLOAT = 41,
+        FORMAT_R8G8_UNORM = 49,
+        FORMAT_R16_FLOAT = 54,
+        FORMAT_R16_UNORM = 56,
+        FORMAT_R8_UNORM = 61,
+        FORMAT_A8_UNORM = 65,
+        FORMAT_R8G8_B8G8_UNORM = 68,
+        FORMAT_G8R8_G8B8_UNORM = 69,
+        FORMAT_BC1_UNORM = 71,
+        FORMAT_BC2_UNORM = 74,
+        FORMAT_BC3_UNORM = 77,
+        FORMAT_BC4_UNORM = 80,
+        FORMAT_BC4_SNORM = 81,
+        FORMAT_BC5_UNORM = 83,
+        FORMAT_BC5_SNORM = 84,
+        FORMAT_B5G6R5_UNORM = 85,
+        FORMAT_B5G5R5A1_UNORM = 86,
+        FORMAT_B8G8R8A8_UNORM = 87,
+        FORMAT_B8G8R8X8_UNORM = 88,
+        FORMAT_B4G4R4A4_UNORM = 115,
+    };
+
+    uint32_t MakeFourCC(char a, char b, char c, char d)
+    {
+        return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+    }
+
+    bool HasMasks(const DDSPixelFormat& pf, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return pf.RBitMask == r && pf.GBitMask == g && pf.BBitMask == b && pf.ABitMask == a;
+    }
+
+    // same mapping as DDSTextureLoader's GetDXGIFormat
+    uint32_t GetLegacyFormat(const DDSPixelFormat& pf)
+    {
+        if (pf.flags & DDPF_RGB)
+        {
+            switch (pf.RGBBitCount)
+            {
+            case 32:
+                if (HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+                    return FORMAT_R8G8B8A8_UNORM;
+                if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+                    return FORMAT_B8G8R8A8_UNORM;
+                if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
+                    return FORMAT_B8G8R8X8_UNORM;
+                if (HasMasks(pf, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+                    return FORMAT_R10G10B10A2_UNORM;
+                if (HasMasks(pf, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+                    return FORMAT_R16G16_UNORM;
+                if (HasMasks(pf, 0xffffffff, 0x00000000, 0x00000000, 0x00000000))
+                    return FORMAT_R32_FLOAT;
+                break;
+
+            case 16:
+                if (HasMasks(pf, 0x7c00, 0x03e0, 0x001f, 0x8000))
+                    return FORMAT_B5G5R5A1_UNORM;
+                if (HasMasks(pf, 0xf800, 0x07e0, 0x001f, 0x0000))
+                    return FORMAT_B5G6R5_UNORM;
+                if (HasMasks(pf, 0x0f00, 0x00f0, 0x000f, 0xf000))
+                    return FORMAT_B4G4R4A4_UNORM;
+                break;
+            }
+        }
+        else if (pf.flags & DDPF_LUMINANCE)
+        {
+            if (pf.RGBBitCount == 8 && HasMasks(pf, 0x000000ff, 0x00000000, 0x00000000, 0x00000000))
+                return FORMAT_R8_UNORM;
+            if (pf.RGBBitCount == 16 && HasMasks(pf, 0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
+                return FORMAT_R16_UNORM;
+            if (pf.RGBBitCount == 16 && HasMasks(pf, 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
+                return FORMAT_R8G8_UNORM;
+        }
+        else if (pf.flags & DDPF_ALPHA)
+        {
+            if (pf.RGBBitCount == 8)
+                return FORMAT_A8_UNORM;
+        }
+        else if (pf.flags & DDPF_FOURCC)
+        {
+            if (pf.fourCC == MakeFourCC('D', 'X', 'T', '1'))
+                return FORMAT_BC1_UNORM;
+            if (pf.fourCC == MakeFourCC('D', 'X', 'T', '2') || pf.fourCC == MakeFourCC('D', 'X', 'T', '3'))
+                return FORMAT_BC2_UNORM;
+            if (pf.fourCC == MakeFourCC('D', 'X', 'T', '4') || pf.fourCC == MakeFourCC('D', 'X', 'T', '5'))
+                return FORMAT_BC3_UNORM;
+            if (pf.fourCC == MakeFourCC('A', 'T', 'I', '1') || pf.fourCC == MakeFourCC('B', 'C', '4', 'U'))
+                return FORMAT_BC4_UNORM;
+            if (pf.fourCC == MakeFourCC('B', 'C', '4', 'S'))
+                return FORMAT_BC4_SNORM;
+            if (pf.fourCC == MakeFourCC('A', 'T', 'I', '2') || pf.fourCC == MakeFourCC('B', 'C', '5', 'U'))
+                return FORMAT_BC5_UNORM;
+            if (pf.fourCC == MakeFourCC('B', 'C', '5', 'S'))
+                return FORMAT_BC5_SNORM;
+            if (pf.fourCC == MakeFourCC('R', 'G', 'B', 'G'))
+                return FORMAT_R8G8_B8G8_UNORM;
+            if (pf.fourCC == MakeFourCC('G', 'R', 'G', 'B'))
+                return FORMAT_G8R8_G8B8_UNORM;
+
+            // D3DFMT values stored directly in the fourCC field
+            switch (pf.fourCC)
+            {
+            case 36:  return FORMAT_R16G16B16A16_UNORM;
+            case 110: return FORMAT_R16G16B16A16_SNORM;
+            case 111: return FORMAT_R16_FLOAT;
+            case 112: return FORMAT_R16G16_FLOAT;
+            case 113: return FORMAT_R16G16B16A16_FLOAT;
+            case 114: return FORMAT_R32_FLOAT;
+            case 115: return FORMAT_R32G32_FLOAT;
+            case 116: return FORMAT_R32G32B32A32_FLOAT;
+            }
+        }
+
+        return FORMAT_UNKNOWN;
+    }
+}
+
+DDSResult DDSFile::Parse(const uint8_t* data, size_t size, DDSInfo* info)
+{
+    if (size < sizeof(uint32_t) + sizeof(DDSHeader))
+        return DDSResult_TooSmall;
+
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    if (magic != Magic)
+        return DDSResult_BadMagic;
+
+    DDSHeader header;
+    memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+    if (header.size != sizeof(DDSHeader) || header.ddspf.size != sizeof(DDSPixelFormat))
+        return DDSResult_BadHeader;
+
+    DDSInfo result;
+    memset(&result, 0, sizeof(result));
+    result.Width = header.width;
+    result.Height = header.height;
+    result.Depth = 1;
+    result.MipCount = header.mipMapCount == 0 ? 1 : header.mipMapCount;
+    result.ArraySize = 1;
+    result.DataOffset = sizeof(uint32_t) + sizeof(DDSHeader);
+
+    if ((header.ddspf.flags & DDPF_FOURCC) && header.ddspf.fourCC == MakeFourCC('D', 'X', '1', '0'))
+    {
+        if (size < result.DataOffset + sizeof(DDSHeaderDXT10))
+            return DDSResult_TooSmall;
+
+        DDSHeaderDXT10 dx10;
+        memcpy(&dx10, data + result.DataOffset, sizeof(dx10));
+        result.DataOffset += sizeof(DDSHeaderDXT10);
+
+        result.Format = dx10.dxgiFormat;
+        result.ArraySize = dx10.arraySize;
+        if (result.ArraySize == 0 || result.ArraySize > MaxDimension)
+            return DDSResult_BadHeader;
+
+        switch (dx10.resourceDimension)
+        {
+        case DIMENSION_TEXTURE1D:
+            result.Height = 1;
+            break;
+
+        case DIMENSION_TEXTURE2D:
+            if (dx10.miscFlag & MISC_TEXTURECUBE)
+            {
+                // checked before multiplying so the face count can't wrap around
+                if (result.ArraySize > MaxDimension / 6)
+                    return DDSResult_BadHeader;
+                result.IsCubeMap = true;
+                result.ArraySize *= 6;
+            }
+            break;
+
+        case DIMENSION_TEXTURE3D:
+            if (!(header.flags & DDSD_DEPTH) || result.ArraySize != 1)
+                return DDSResult_BadHeader;
+            result.IsVolume = true;
+            result.Depth = header.depth;
+            break;
+
+        default:
+            return DDSResult_BadHeader;
+        }
+    }
+    else
+    {
+        result.Format = GetLegacyFormat(header.ddspf);
+
+        if (header.flags & DDSD_DEPTH)
+        {
+            result.IsVolume = true;
+            result.Depth = header.depth;
+        }
+        else if (header.caps2 & DDSCAPS2_CUBEMAP)
+        {
+            // D3D11 has no partial cube maps
+            if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+                return DDSResult_UnsupportedFormat;
+            result.IsCubeMap = true;
+            result.ArraySize = 6;
+        }
+    }
+
+    if (BitsPerPixel(result.Format) == 0)
+        return DDSResult_UnsupportedFormat;
+
+    if (result.Width == 0 || result.Height == 0 || result.Depth == 0 ||
+        result.Width > MaxDimension || result.Height > MaxDimension || result.Depth > MaxDimension ||
+        result.MipCount > MaxMipCount || result.ArraySize > MaxDimension)
+        return DDSResult_BadHeader;
+
+    // add up every slice's mip chain; 64 bit so a hostile header can't wrap around on 32 bit devices
+    uint64_t dataSize = 0;
+    for (uint32_t slice = 0; slice < result.ArraySize; slice++)
+    {
+        uint32_t width = result.Width;
+        uint32_t height = result.Height;
+        uint32_t depth = result.Depth;
+
+        for (uint32_t mip = 0; mip < result.MipCount; mip++)
+        {
+            size_t rowBytes, numRows, numBytes;
+            if (!GetSurfaceInfo(width, height, result.Format, &rowBytes, &numRows, &numBytes))
+                return DDSResult_UnsupportedFormat;
+
+            dataSize += (uint64_t)numBytes * depth;
+
+            width = width > 1 ? width >> 1 : 1;
+            height = height > 1 ? height >> 1 : 1;
+            depth = depth > 1 ? depth >> 1 : 1;
+        }
+    }
+
+    if (dataSize > (uint64_t)(size - result.DataOffset))
+        return DDSResult_Truncated;
+
+    result.DataSize = (size_t)dataSize;
+    *info = result;
+    return DDSResult_Ok;
+}
+
+bool DDSFile::GetSurfaceInfo(uint32_t width, uint32_t height, uint32_t format, size_t* rowBytes, size_t* numRows, size_t* numBytes)
+{
+    size_t bpp = BitsPerPixel(format);
+    if (bpp == 0)
+        return false;
+
+    bool blockCompressed = (format >= 70 && format <= 84) || (format >= 94 && format <= 99);
+    bool packed = format == FORMAT_R8G8_B8G8_UNORM || format == FORMAT_G8R8_G8B8_UNORM;
+
+    if (blockCompressed)
+    {
+        // 4x4 blocks of 8 bytes (BC1, BC4) or 16 bytes (everything else)
+        size_t blockBytes = bpp == 4 ? 8 : 16;
+        size_t blocksWide = width > 0 ? (width + 3) / 4 : 0;
+        size_t blocksHigh = height > 0 ? (height + 3) / 4 : 0;
+        *rowBytes = (blocksWide > 0 ? blocksWide : 1) * blockBytes;
+        *numRows = blocksHigh > 0 ? blocksHigh : 1;
+    }
+    else if (packed)
+    {
+        *rowBytes = ((width + 1) >> 1) * 4;
+        *numRows = height;
+    }
+    else
+    {
+        *rowBytes = (width * bpp + 7) / 8;
+        *numRows = height;
+    }
+
+    *numBytes = *rowBytes * *numRows;
+    return true;
+}
+
+size_t DDSFile::BitsPerPixel(uint32_t format)
+{
+    if (format >= 1 && format <= 4)
+        return 128;
+    if (format >= 5 && format <= 8)
+        return 96;
+    if (format >= 9 && format <= 22)
+        return 64;
+    if ((format >= 23 && format <= 47) || format == 67 || (format >= 87 && format <= 93))
+        return 32;
+    if ((format >= 48 && format <= 59) || format == 68 || format == 69 || format == 85 || format == 86 || format == 115)
+        return 16;
+    if (format >= 60 && format <= 65)
+        return 8;
+    if ((format >= 70 && format <= 72) || (format >= 79 && format <= 81))
+        return 4;
+    if ((format >= 73 && format <= 78) || (format >= 82 && format <= 84) || (format >= 94 && format <= 99))
+        return 8;
+
+    // R1_UNORM, video and anything newer are not used for sprites
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Describes a DDS file held in memory. Parsing only looks at the bytes it is given and never
+// touches the graphics API, so it can be checked against sample files on any platform.
+// Formats are reported as DXGI_FORMAT values.
+struct DDSInfo
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Depth;
+    uint32_t MipCount;
+    uint32_t ArraySize;         // number of textures, 6 per cube for cube maps
+    uint32_t Format;
+    bool IsCubeMap;
+    bool IsVolume;
+    size_t DataOffset;          // start of the first subresource in the file
+    size_t DataSize;            // bytes taken by every subresource together
+};
+
+enum DDSResult
+{
+    DDSResult_Ok,
+    DDSResult_OpenFailed,
+    DDSResult_TooSmall,
+    DDSResult_BadMagic,
+    DDSResult_BadHeader,
+    DDSResult_UnsupportedFormat,
+    DDSResult_Truncated,
+};
+
+class DDSFile
+{
+public:
+    static DDSResult Parse(const uint8_t* data, size_t size, DDSInfo* info);
+
+    // size of one mip level of one slice. Returns false for formats we can't size
+    static bool GetSurfaceInfo(uint32_t width, uint32_t height, uint32_t format, size_t* rowBytes, size_t* numRows, size_t* numBytes);
+
+    static size_t BitsPerPixel(uint32_t format);
+
+protected:
+    static const uint32_t Magic = 0x20534444;          // "DDS "
+    static const uint32_t MaxDimension = 16384;        // D3D11 texture limit, also stops size overflow
+    static const uint32_t MaxMipCount = 15;
+};
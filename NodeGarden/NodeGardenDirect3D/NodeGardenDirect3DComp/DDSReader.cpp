@@ -0,0 +1,246 @@
+#include "DDSReader.h"
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+DDSReader::DDSReader(void)
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    memset(&m_info, 0, sizeof(m_info));
+#if defined(_WIN32)
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = nullptr;
+#endif
+}
+
+DDSReader::~DDSReader(void)
+{
+    Close();
+}
+
+#if defined(_WIN32)
+DDSResult DDSReader::Open(const wchar_t* fileName)
+{
+    Close();
+
+    HANDLE file = CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return DDSResult_OpenFailed;
+    m_file = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.HighPart != 0)
+    {
+        Close();
+        return DDSResult_OpenFailed;
+    }
+    m_size = fileSize.LowPart;
+
+    HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+    void* view = mapping != nullptr ? MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0) : nullptr;
+
+    if (view != nullptr)
+    {
+        m_mapping = mapping;
+        m_data = static_cast<const uint8_t*>(view);
+        m_mapped = true;
+    }
+    else
+    {
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+
+        // fall back to reading the whole file
+        m_buffer.resize(m_size);
+        DWORD bytesRead = 0;
+        if (m_size > 0 && (!ReadFile(file, &m_buffer[0], (DWORD)m_size, &bytesRead, nullptr) || bytesRead != m_size))
+        {
+            Close();
+            return DDSResult_OpenFailed;
+        }
+        m_data = m_size > 0 ? &m_buffer[0] : nullptr;
+    }
+
+    DDSResult result = Index();
+    if (result != DDSResult_Ok)
+        Close();
+    return result;
+}
+#else
+DDSResult DDSReader::Open(const char* fileName)
+{
+    Close();
+
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+        return DDSResult_OpenFailed;
+
+    struct stat fileInfo;
+    if (fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0)
+    {
+        close(file);
+        return DDSResult_TooSmall;
+    }
+    m_size = (size_t)fileInfo.st_size;
+
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view != MAP_FAILED)
+    {
+        m_data = static_cast<const uint8_t*>(view);
+        m_mapped = true;
+    }
+    else
+    {
+        // fall back to reading the whole file
+        m_buffer.resize(m_size);
+        size_t offset = 0;
+        while (offset < m_size)
+        {
+            ssize_t bytesRead = read(file, &m_buffer[offset], m_size - offset);
+            if (bytesRead <= 0)
+                break;
+            offset += (size_t)bytesRead;
+        }
+
+        if (offset != m_size)
+        {
+            close(file);
+            Close();
+            return DDSResult_OpenFailed;
+        }
+        m_data = &m_buffer[0];
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    close(file);
+
+    DDSResult result = Index();
+    if (result != DDSResult_Ok)
+        Close();
+    return result;
+}
+#endif
+
+DDSResult DDSReader::Attach(const uint8_t* data, size_t size)
+{
+    Close();
+
+    m_data = data;
+    m_size = size;
+
+    DDSResult result = Index();
+    if (result != DDSResult_Ok)
+        Close();
+    return result;
+}
+
+void DDSReader::Close()
+{
+    if (m_mapped)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+#if defined(_WIN32)
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    std::vector<uint8_t>().swap(m_buffer);
+    memset(&m_info, 0, sizeof(m_info));
+    m_subresources.clear();
+}
+
+const DDSInfo& DDSReader::GetInfo() const
+{
+    return m_info;
+}
+
+const uint8_t* DDSReader::GetData() const
+{
+    return m_data;
+}
+
+size_t DDSReader::GetSize() const
+{
+    return m_size;
+}
+
+size_t DDSReader::GetSubresourceCount() const
+{
+    return m_subresources.size();
+}
+
+const DDSSubresource& DDSReader::GetSubresource(uint32_t mip, uint32_t slice) const
+{
+    return m_subresources[mip + slice * m_info.MipCount];
+}
+
+const DDSSubresource* DDSReader::GetSubresources() const
+{
+    return m_subresources.empty() ? nullptr : &m_subresources[0];
+}
+
+DDSResult DDSReader::Index()
+{
+    if (m_data == nullptr)
+        return DDSResult_TooSmall;
+
+    // Parse has already checked that every subresource fits inside the file
+    DDSResult result = DDSFile::Parse(m_data, m_size, &m_info);
+    if (result != DDSResult_Ok)
+        return result;
+
+    m_subresources.resize((size_t)m_info.ArraySize * m_info.MipCount);
+
+    const uint8_t* cursor = m_data + m_info.DataOffset;
+    for (uint32_t slice = 0; slice < m_info.ArraySize; slice++)
+    {
+        uint32_t width = m_info.Width;
+        uint32_t height = m_info.Height;
+        uint32_t depth = m_info.Depth;
+
+        for (uint32_t mip = 0; mip < m_info.MipCount; mip++)
+        {
+            size_t rowBytes, numRows, numBytes;
+            DDSFile::GetSurfaceInfo(width, height, m_info.Format, &rowBytes, &numRows, &numBytes);
+
+            DDSSubresource& subresource = m_subresources[mip + slice * m_info.MipCount];
+            subresource.Data = cursor;
+            subresource.RowPitch = rowBytes;
+            subresource.SlicePitch = numBytes;
+            subresource.Width = width;
+            subresource.Height = height;
+            subresource.Depth = depth;
+
+            cursor += numBytes * depth;
+
+            width = width > 1 ? width >> 1 : 1;
+            height = height > 1 ? height >> 1 : 1;
+            depth = depth > 1 ? depth >> 1 : 1;
+        }
+    }
+
+    return DDSResult_Ok;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "DDSFile.h"
+#include <vector>
+
+// One mip level of one array slice, pointing straight into the file's bytes
+struct DDSSubresource
+{
+    const uint8_t* Data;
+    size_t RowPitch;
+    size_t SlicePitch;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Depth;
+};
+
+// Reads a DDS file by memory mapping it rather than copying it into a heap buffer. Every
+// subresource is exposed as a view into the mapping, so textures can be created (or mips
+// uploaded smallest first) straight from the file. The mapping lives as long as the reader.
+class DDSReader
+{
+public:
+    DDSReader(void);
+    ~DDSReader(void);
+
+#if defined(_WIN32)
+    DDSResult Open(const wchar_t* fileName);
+#else
+    DDSResult Open(const char* fileName);
+#endif
+
+    // Use bytes that are already in memory; the caller keeps them alive.
+    DDSResult Attach(const uint8_t* data, size_t size);
+    void Close();
+
+    const DDSInfo& GetInfo() const;
+    const uint8_t* GetData() const;
+    size_t GetSize() const;
+
+    // Subresources are ordered like D3D11CalcSubresource: mip + slice * MipCount
+    size_t GetSubresourceCount() const;
+    const DDSSubresource& GetSubresource(uint32_t mip, uint32_t slice) const;
+    const DDSSubresource* GetSubresources() const;
+
+private:
+    DDSReader(const DDSReader&);
+    DDSReader& operator=(const DDSReader&);
+
+    DDSResult Index();
+
+    const uint8_t* m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::vector<uint8_t> m_buffer;     // only used when the platform refuses to map the file
+    DDSInfo m_info;
+    std::vector<DDSSubresource> m_subresources;
+
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#endif
+};
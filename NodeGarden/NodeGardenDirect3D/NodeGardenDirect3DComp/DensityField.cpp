@@ -0,0 +1,176 @@
+#include "DensityField.h"
+#include "Garden.h"
+#include <float.h>
+#include <math.h>
+
+DensityField::DensityField(void)
+{
+    m_resolution = DefaultResolution;
+    m_radius = 0;
+    m_cellSize = 0;
+    m_columns = 0;
+    m_rows = 0;
+}
+
+void DensityField::SetResolution(int cellsPerRadius)
+{
+    m_resolution = cellsPerRadius > 1 ? cellsPerRadius : 1;
+}
+
+int DensityField::GetResolution() const
+{
+    return m_resolution;
+}
+
+void DensityField::Estimate(const std::vector<GardenNode>& nodes, float radius, std::vector<float>* sums)
+{
+    int count = (int)nodes.size();
+    sums->assign(count, 0.0f);
+    if (count == 0 || !(radius > 0))
+        return;
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        const GardenNode& node = nodes[i];
+        if (node.X < minX) minX = node.X;
+        if (node.Y < minY) minY = node.Y;
+        if (node.X > maxX) maxX = node.X;
+        if (node.Y > maxY) maxY = node.Y;
+    }
+
+    // a node far out on its own would otherwise make the grid huge
+    float cellSize = radius / m_resolution;
+    double cells = ((maxX - minX) / cellSize + 1) * (double)((maxY - minY) / cellSize + 1);
+    if (cells > MaxCells)
+        cellSize *= (float)sqrt(cells / MaxCells);
+
+    // room around the nodes for the whole cone, so nothing has to be clipped
+    int pad = (int)ceilf(radius / cellSize) + 1;
+    int columns = (int)((maxX - minX) / cellSize) + 2 + pad * 2;
+    int rows = (int)((maxY - minY) / cellSize) + 2 + pad * 2;
+    float originX = minX - pad * cellSize;
+    float originY = minY - pad * cellSize;
+
+    // both grids are left zeroed after each estimate, so only a change of shape clears them
+    bool reshaped = columns != m_columns || rows != m_rows;
+    if (reshaped)
+    {
+        m_columns = columns;
+        m_rows = rows;
+        m_mass.assign((size_t)columns * rows, 0.0f);
+        m_field.assign((size_t)columns * rows, 0.0f);
+    }
+    if (reshaped || radius != m_radius || cellSize != m_cellSize)
+    {
+        m_radius = radius;
+        m_cellSize = cellSize;
+        BuildKernel(radius);
+    }
+
+    // spread each node over the corners of its cell
+    m_occupied.clear();
+    for (int i = 0; i < count; i++)
+    {
+        float x = (nodes[i].X - originX) / cellSize;
+        float y = (nodes[i].Y - originY) / cellSize;
+        int column = (int)x;
+        int row = (int)y;
+        float fx = x - column;
+        float fy = y - row;
+
+        int cell = row * columns + column;
+        int corners[4] = { cell, cell + 1, cell + columns, cell + columns + 1 };
+        float weights[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+        for (int corner = 0; corner < 4; corner++)
+        {
+            if (m_mass[corners[corner]] == 0 && weights[corner] > 0)
+                m_occupied.push_back(corners[corner]);
+            m_mass[corners[corner]] += weights[corner];
+        }
+    }
+
+    for (size_t i = 0; i < m_occupied.size(); i++)
+    {
+        int cell = m_occupied[i];
+        float mass = m_mass[cell];
+        for (size_t t = 0; t < m_taps.size(); t++)
+        {
+            m_field[cell + m_taps[t].Offset] += mass * m_taps[t].Weight;
+        }
+    }
+
+    // what a node adds to its own corners, read back through the same weights
+    float side = Kernel(cellSize);
+    float diagonal = Kernel(cellSize * 1.41421356f);
+
+    for (int i = 0; i < count; i++)
+    {
+        float x = (nodes[i].X - originX) / cellSize;
+        float y = (nodes[i].Y - originY) / cellSize;
+        int column = (int)x;
+        int row = (int)y;
+        float fx = x - column;
+        float fy = y - row;
+
+        int cell = row * columns + column;
+        float w00 = (1 - fx) * (1 - fy), w10 = fx * (1 - fy), w01 = (1 - fx) * fy, w11 = fx * fy;
+        float value = w00 * m_field[cell] + w10 * m_field[cell + 1] + w01 * m_field[cell + columns] + w11 * m_field[cell + columns + 1];
+        float self = w00 * w00 + w10 * w10 + w01 * w01 + w11 * w11 +
+            2 * side * (w00 * w10 + w00 * w01 + w10 * w11 + w01 * w11) +
+            2 * diagonal * (w00 * w11 + w10 * w01);
+
+        float sum = value - self;
+        (*sums)[i] = sum > 0 ? sum : 0;
+    }
+
+    for (size_t i = 0; i < m_occupied.size(); i++)
+    {
+        int cell = m_occupied[i];
+        m_mass[cell] = 0;
+        for (size_t t = 0; t < m_taps.size(); t++)
+        {
+            m_field[cell + m_taps[t].Offset] = 0;
+        }
+    }
+}
+
+int DensityField::GetColumns() const
+{
+    return m_columns;
+}
+
+int DensityField::GetRows() const
+{
+    return m_rows;
+}
+
+float DensityField::GetCellSize() const
+{
+    return m_cellSize;
+}
+
+void DensityField::BuildKernel(float radius)
+{
+    m_taps.clear();
+
+    // every cell the cone reaches, as offsets in a grid m_columns wide
+    int reach = (int)ceilf(radius / m_cellSize) - 1;
+    for (int dy = -reach; dy <= reach; dy++)
+    {
+        for (int dx = -reach; dx <= reach; dx++)
+        {
+            float weight = Kernel(m_cellSize * sqrtf((float)(dx * dx + dy * dy)));
+            if (weight <= 0)
+                continue;
+
+            Tap tap = { dy * m_columns + dx, weight };
+            m_taps.push_back(tap);
+        }
+    }
+}
+
+float DensityField::Kernel(float distance) const
+{
+    return distance < m_radius ? 1 - distance / m_radius : 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+struct GardenNode;
+
+// Estimates the connection pass's sums without looking at pairs.
+//
+// A node's connectedness is the sum of 1 - distance / radius over every other node in range:
+// a kernel density estimate with a cone for its kernel. Estimate spreads each node over the
+// four corners of the grid cell it sits in, adds the cone around every corner that got any
+// weight, and reads each node's value back from its four corners the same way, less what
+// the node contributed to itself. The cost is the nodes plus the occupied cells times the
+// cone's footprint, however crowded the garden.
+//
+// Spreading and reading back each blur the cone by a cell, so values come out a little low
+// near a node and a little beyond the radius; more cells per radius trades speed for accuracy.
+class DensityField
+{
+public:
+    static const int DefaultResolution = 4;
+    static const size_t MaxCells = 1 << 22;     // past this the cells get bigger instead
+
+    DensityField(void);
+    ~DensityField(void) {};
+
+    // grid cells per radius
+    void SetResolution(int cellsPerRadius);
+    int GetResolution() const;
+
+    // sums[i] is node i's estimated connectedness
+    void Estimate(const std::vector<GardenNode>& nodes, float radius, std::vector<float>* sums);
+
+    int GetColumns() const;
+    int GetRows() const;
+    float GetCellSize() const;
+
+private:
+    struct Tap
+    {
+        int Offset;                 // in to the grid, from the cell the weight is in
+        float Weight;
+    };
+
+    void BuildKernel(float radius);
+    float Kernel(float distance) const;
+
+    int m_resolution;
+    float m_radius;
+    float m_cellSize;
+    int m_columns;
+    int m_rows;
+
+    std::vector<Tap> m_taps;
+    std::vector<float> m_mass;
+    std::vector<float> m_field;
+    std::vector<int> m_occupied;            // cells with any mass, in the order first reached
+};
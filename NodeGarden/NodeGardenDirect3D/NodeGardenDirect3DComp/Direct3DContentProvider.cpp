@@ -63,6 +63,7 @@ HRESULT Direct3DContentProvider::GetTexture(_In_ const DrawingSurfaceSizeF* size
 	// Draw to the texture.
 	if (SUCCEEDED(hr))
 	{
+		PROFILE_SCOPE("Frame");
 		hr = m_synchronizedTexture->BeginDraw();
 		
 		if (SUCCEEDED(hr))
@@ -70,8 +71,11 @@ HRESULT Direct3DContentProvider::GetTexture(_In_ const DrawingSurfaceSizeF* size
 			hr = m_controller->GetTexture(size, synchronizedTexture, textureSubRectangle);
 		}
 
+		PROFILE_SCOPE("Present");
 		m_synchronizedTexture->EndDraw();
 	}
 
+	m_controller->EndFrame();
+
 	return hr;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Direct3DInterop.h"
 #include "Direct3DContentProvider.h"
 
+using namespace Concurrency;
 using namespace Windows::Foundation;
 using namespace Windows::UI::Core;
 using namespace Microsoft::WRL;
@@ -11,8 +12,28 @@ using namespace Windows::Phone::Input::Interop;
 namespace NodeGardenDirect3DComp
 {
 
+// the encoders and profiler take narrow paths, which is fine for the app's local folder
+static std::string ToUtf8(Platform::String^ text)
+{
+	int length = WideCharToMultiByte(CP_UTF8, 0, text->Data(), -1, nullptr, 0, nullptr, nullptr);
+	std::string utf8(length > 0 ? length - 1 : 0, '\0');
+	if (length > 1)
+	{
+		WideCharToMultiByte(CP_UTF8, 0, text->Data(), -1, &utf8[0], length, nullptr, nullptr);
+	}
+
+	return utf8;
+}
+
 Direct3DInterop::Direct3DInterop() :
-	m_timer(ref new BasicTimer())
+	m_timer(ref new BasicTimer()),
+	m_frameWorkTimer(ref new BasicTimer()),
+	m_dynamicResolutionRequested(false),
+	m_requestedMinScale(1.0f),
+	m_requestedMaxScale(1.0f),
+	m_dynamicResolutionChanged(false),
+	m_dynamicResolutionEnabled(false),
+	m_renderTargetSizeDirty(false)
 {
 }
 
@@ -42,14 +63,264 @@ void Direct3DInterop::RenderResolution::set(Windows::Foundation::Size renderReso
 	{
 		m_renderResolution = renderResolution;
 
+		// the render target itself is resized by PrepareResources, on the compositor thread
 		if (m_renderer)
 		{
-			m_renderer->UpdateForRenderResolutionChange(m_renderResolution.Width, m_renderResolution.Height);
-			RecreateSynchronizedTexture();
+			m_renderer->SetGardenSize(m_renderResolution.Width, m_renderResolution.Height);
+			m_renderTargetSizeDirty = true;
 		}
 	}
 }
 
+void Direct3DInterop::EnableDynamicResolution(float minScale, float maxScale)
+{
+	std::lock_guard<std::mutex> lock(m_dynamicResolutionLock);
+	m_dynamicResolutionRequested = true;
+	m_requestedMinScale = minScale;
+	m_requestedMaxScale = maxScale;
+	m_dynamicResolutionChanged = true;
+}
+
+void Direct3DInterop::DisableDynamicResolution()
+{
+	std::lock_guard<std::mutex> lock(m_dynamicResolutionLock);
+	m_dynamicResolutionRequested = false;
+	m_dynamicResolutionChanged = true;
+}
+
+void Direct3DInterop::EnableApproximateConnectedness(int32 aboveNodeCount, int32 cellsPerRadius)
+{
+	if (m_renderer)
+	{
+		m_renderer->SetDensityField(aboveNodeCount, cellsPerRadius);
+	}
+}
+
+void Direct3DInterop::DisableApproximateConnectedness()
+{
+	if (m_renderer)
+	{
+		m_renderer->SetDensityField(0, DensityField::DefaultResolution);
+	}
+}
+
+void Direct3DInterop::EnableHeatmap(bool fromConnectedness, float cellSize, int32 blurRadius)
+{
+	if (m_renderer)
+	{
+		m_renderer->EnableHeatmap(fromConnectedness ? HeatmapSource_Connectedness : HeatmapSource_Edges, cellSize, blurRadius);
+	}
+}
+
+void Direct3DInterop::DisableHeatmap()
+{
+	if (m_renderer)
+	{
+		m_renderer->DisableHeatmap();
+	}
+}
+
+void Direct3DInterop::EnableLevelOfDetail(float detailRadius, float angle)
+{
+	if (m_renderer)
+	{
+		m_renderer->EnableLevelOfDetail(detailRadius, angle);
+	}
+}
+
+void Direct3DInterop::DisableLevelOfDetail()
+{
+	if (m_renderer)
+	{
+		m_renderer->DisableLevelOfDetail();
+	}
+}
+
+void Direct3DInterop::EnableNodeExpiry(float silentSeconds)
+{
+	if (m_renderer)
+	{
+		m_renderer->SetNodeExpiry(silentSeconds);
+	}
+}
+
+void Direct3DInterop::DisableNodeExpiry()
+{
+	if (m_renderer)
+	{
+		m_renderer->SetNodeExpiry(0);
+	}
+}
+
+void Direct3DInterop::UpdateRenderTargetSize()
+{
+	float scale = m_dynamicResolutionEnabled ? m_dynamicResolution.GetScale() : 1.0f;
+
+	m_renderTargetSize.Width = floorf(m_renderResolution.Width * scale);
+	m_renderTargetSize.Height = floorf(m_renderResolution.Height * scale);
+
+	m_renderer->UpdateForRenderResolutionChange(m_renderTargetSize.Width, m_renderTargetSize.Height);
+}
+
+void Direct3DInterop::StartCapture(Platform::String^ outputFolder, bool rawYuv)
+{
+	if (m_renderer)
+	{
+		m_renderer->StartCapture(rawYuv ? CaptureFormat_Yuv : CaptureFormat_Png, ToUtf8(outputFolder));
+	}
+}
+
+void Direct3DInterop::StopCapture()
+{
+	if (m_renderer)
+	{
+		m_renderer->StopCapture();
+	}
+}
+
+uint32 Direct3DInterop::CapturedFrames::get()
+{
+	return m_renderer ? m_renderer->GetCaptureQueue().GetEncodedFrames() : 0;
+}
+
+uint32 Direct3DInterop::DroppedCaptureFrames::get()
+{
+	return m_renderer ? m_renderer->GetCaptureQueue().GetDroppedFrames() : 0;
+}
+
+bool Direct3DInterop::ShowPerformanceHud::get()
+{
+	return m_renderer ? m_renderer->IsHudVisible() : false;
+}
+
+void Direct3DInterop::ShowPerformanceHud::set(bool visible)
+{
+	if (m_renderer)
+	{
+		m_renderer->SetHudVisible(visible);
+	}
+}
+
+bool Direct3DInterop::PipelinedFrames::get()
+{
+	return m_renderer ? m_renderer->IsPipelined() : false;
+}
+
+void Direct3DInterop::PipelinedFrames::set(bool pipelined)
+{
+	if (m_renderer)
+	{
+		m_renderer->SetPipelined(pipelined);
+	}
+}
+
+Platform::String^ Direct3DInterop::FrameStageTimes::get()
+{
+	if (!m_renderer)
+	{
+		return ref new Platform::String();
+	}
+
+	// stage names are plain ASCII
+	std::string times = m_renderer->GetStageTimes();
+	std::wstring wide(times.begin(), times.end());
+	return ref new Platform::String(wide.c_str(), (unsigned int)wide.size());
+}
+
+int32 Direct3DInterop::MaxConnectionsPerNode::get()
+{
+	return m_renderer ? m_renderer->GetMaxDegree() : 0;
+}
+
+void Direct3DInterop::MaxConnectionsPerNode::set(int32 degree)
+{
+	if (m_renderer)
+	{
+		m_renderer->SetMaxDegree(degree);
+	}
+}
+
+void Direct3DInterop::StartProfileCapture(uint32 frameCount, Platform::String^ outputFolder)
+{
+	m_profileFolder = ToUtf8(outputFolder);
+	Profiler::StartCapture((int)frameCount);
+}
+
+void Direct3DInterop::EndFrame()
+{
+	if (Profiler::EndFrame())
+	{
+		// writing the trace takes a while, keep it off the render thread
+		std::string folder = m_profileFolder;
+		create_task([folder] ()
+		{
+			Profiler::WriteChromeTrace(folder + "\\profile_trace.json");
+			Profiler::WriteHistograms(folder + "\\profile_histograms.txt");
+		});
+	}
+}
+
+bool Direct3DInterop::StartRecording(Platform::String^ outputFile)
+{
+	return m_renderer ? m_renderer->StartRecording(ToUtf8(outputFile)) : false;
+}
+
+void Direct3DInterop::StopRecording()
+{
+	if (m_renderer)
+	{
+		m_renderer->StopRecording();
+	}
+}
+
+uint32 Direct3DInterop::RecordedFrames::get()
+{
+	return m_renderer ? m_renderer->GetRecordedFrames() : 0;
+}
+
+bool Direct3DInterop::StartStateExport(Platform::String^ name, uint32 nodeCapacity, uint32 edgeCapacity)
+{
+	return m_renderer ? m_renderer->StartStateExport(ToUtf8(name), nodeCapacity, edgeCapacity) : false;
+}
+
+void Direct3DInterop::StopStateExport()
+{
+	if (m_renderer)
+	{
+		m_renderer->StopStateExport();
+	}
+}
+
+uint16 Direct3DInterop::StartMetricsServer(uint16 port)
+{
+	if (!m_renderer || !m_renderer->StartMetricsServer(port))
+		return 0;
+
+	return m_renderer->GetMetricsPort();
+}
+
+void Direct3DInterop::StopMetricsServer()
+{
+	if (m_renderer)
+	{
+		m_renderer->StopMetricsServer();
+	}
+}
+
+void Direct3DInterop::SetAllocationSampling(uint32 sampleEvery)
+{
+	AllocationTracker::SetStackSampling(sampleEvery);
+}
+
+void Direct3DInterop::WriteAllocationReport(Platform::String^ outputFile)
+{
+	std::string path = ToUtf8(outputFile);
+	create_task([path] ()
+	{
+		AllocationTracker::WriteReport(path);
+	});
+}
+
 // Event Handlers
 void Direct3DInterop::OnPointerPressed(DrawingSurfaceManipulationHost^ sender, PointerEventArgs^ args)
 {
@@ -69,10 +340,13 @@ void Direct3DInterop::OnPointerReleased(DrawingSurfaceManipulationHost^ sender,
 // Interface With Direct3DContentProvider
 HRESULT Direct3DInterop::Connect(_In_ IDrawingSurfaceRuntimeHostNative* host)
 {
+	Profiler::SetThreadName("Render");
+
 	m_renderer = ref new XTKRenderer();
 	m_renderer->Initialize();
 	m_renderer->UpdateForWindowSizeChange(WindowBounds.Width, WindowBounds.Height);
-	m_renderer->UpdateForRenderResolutionChange(m_renderResolution.Width, m_renderResolution.Height);
+	m_renderer->SetGardenSize(m_renderResolution.Width, m_renderResolution.Height);
+	UpdateRenderTargetSize();
 
 	// Restart timer after renderer has finished initializing.
 	m_timer->Reset();
@@ -89,6 +363,25 @@ HRESULT Direct3DInterop::PrepareResources(_In_ const LARGE_INTEGER* presentTarge
 {
 	*contentDirty = true;
 
+	if (m_dynamicResolutionChanged.exchange(false))
+	{
+		std::lock_guard<std::mutex> lock(m_dynamicResolutionLock);
+		if (m_dynamicResolutionRequested)
+		{
+			m_dynamicResolution.SetBounds(m_requestedMinScale, m_requestedMaxScale);
+		}
+		m_dynamicResolutionEnabled = m_dynamicResolutionRequested;
+		m_renderTargetSizeDirty = true;
+	}
+
+	// Resize here rather than in GetTexture, where the synchronized texture is mid-draw. Cleared
+	// before resizing, so a request that arrives meanwhile is kept for the next frame.
+	if (m_renderTargetSizeDirty.exchange(false))
+	{
+		UpdateRenderTargetSize();
+		RecreateSynchronizedTexture();
+	}
+
 	return S_OK;
 }
 
@@ -98,10 +391,22 @@ HRESULT Direct3DInterop::GetTexture(_In_ const DrawingSurfaceSizeF* size, _Out_
 
     if(m_renderer->IsLoaded())
     {
-	    m_renderer->Update(m_timer->Total, m_timer->Delta);
+	    m_frameWorkTimer->Reset();
+	    m_renderer->BeginUpdate(m_timer->Total, m_timer->Delta);
 	    m_renderer->Render();
+	    m_renderer->EndUpdate();
+	    m_frameWorkTimer->Update();
+
+	    if (m_dynamicResolutionEnabled && m_dynamicResolution.AddFrame(m_timer->Delta, m_frameWorkTimer->Total))
+	    {
+		    m_renderTargetSizeDirty = true;
+	    }
     }
 
+	// Only the rendered part of the texture is shown, stretched to the surface.
+	textureSubRectangle->right = m_renderTargetSize.Width;
+	textureSubRectangle->bottom = m_renderTargetSize.Height;
+
 	RequestAdditionalFrame();
 
 	return S_OK;
@@ -3,7 +3,11 @@
 #include "pch.h"
 #include "BasicTimer.h"
 #include "XTKRenderer.h"
+#include "DynamicResolution.h"
+#include "Profiler.h"
 #include <DrawingSurfaceNative.h>
+#include <atomic>
+#include <mutex>
 #include <string>
 
 namespace NodeGardenDirect3DComp
@@ -41,6 +45,98 @@ public:
     void CreateNodes(int nodeNum);
     void UpdateNodePosition(int nodeId, float nodeX, float nodeY);
 
+    // Let the render target shrink/grow between minScale and maxScale of RenderResolution
+    // depending on recent frame costs. The garden keeps RenderResolution as its coordinate space.
+    void EnableDynamicResolution(float minScale, float maxScale);
+    void DisableDynamicResolution();
+
+    // Past aboveNodeCount nodes, size nodes from an estimate of how crowded their surroundings
+    // are instead of testing every pair, with cellsPerRadius grid cells to each connection
+    // distance. Much cheaper for big crowds, within a few percent, but no lines are drawn.
+    void EnableApproximateConnectedness(int32 aboveNodeCount, int32 cellsPerRadius);
+    void DisableApproximateConnectedness();
+
+    // Draw the connections as a heatmap: their density over cells of cellSize garden units,
+    // blurred blurRadius cells either way and coloured in one pass, in place of a line each.
+    // With fromConnectedness it shows the nodes' connectedness instead, which still works when
+    // approximate connectedness leaves no connections to draw.
+    void EnableHeatmap(bool fromConnectedness, float cellSize, int32 blurRadius);
+    void DisableHeatmap();
+
+    // Draw the parts of the garden further than detailRadius from the local node as
+    // super-nodes, merging more of it the further away it is: a region is merged once it's
+    // narrower than angle times its distance. For gardens of tens of thousands of nodes.
+    void EnableLevelOfDetail(float detailRadius, float angle);
+    void DisableLevelOfDetail();
+
+    // Fade out and drop a remote node once it has gone silentSeconds without moving, for peers
+    // that vanish without a leave. Off by default: a peer standing still sends nothing either,
+    // so silentSeconds has to be longer than the app's peers ever go between updates.
+    void EnableNodeExpiry(float silentSeconds);
+    void DisableNodeExpiry();
+
+    // Record rendered frames into outputFolder as PNGs, or raw I420 when rawYuv is set.
+    // Encoding happens on a worker thread; frames it can't keep up with are dropped. Both take
+    // effect at the next frame rendered.
+    void StartCapture(Platform::String^ outputFolder, bool rawYuv);
+    void StopCapture();
+    property uint32 CapturedFrames { uint32 get(); }
+    property uint32 DroppedCaptureFrames { uint32 get(); }
+
+    // Frame time graph and counters drawn over the garden
+    property bool ShowPerformanceHud
+    {
+        bool get();
+        void set(bool visible);
+    }
+
+    // Most connections a node keeps, its nearest first; 0, the default, for no limit. Thins
+    // out the lines in a dense crowd.
+    property int32 MaxConnectionsPerNode
+    {
+        int32 get();
+        void set(int32 degree);
+    }
+
+    // Simulate the next frame on a worker thread while this one is drawn, from a copy of
+    // the garden taken when its update finished. Frames are shown one behind the simulation.
+    property bool PipelinedFrames
+    {
+        bool get();
+        void set(bool pipelined);
+    }
+
+    // How long each stage of the last frame took, a "name ms" line each: the update's stages,
+    // then the drawing's. Stages with nothing between them run on a thread pool side by side.
+    property Platform::String^ FrameStageTimes { Platform::String^ get(); }
+
+    // Time the hot scopes of the next frameCount frames, then write profile_trace.json
+    // (Chrome trace events) and profile_histograms.txt into outputFolder. Scopes are only
+    // compiled in to debug builds and release builds with NODEGARDEN_PROFILE defined.
+    void StartProfileCapture(uint32 frameCount, Platform::String^ outputFolder);
+
+    // Log input, node changes and frame timings to outputFile from now on. The log starts
+    // with the garden as it is, and GardenReplay re-runs it headlessly frame for frame.
+    bool StartRecording(Platform::String^ outputFile);
+    void StopRecording();
+    property uint32 RecordedFrames { uint32 get(); }
+
+    // Allocations per phase since startup, and the stacks of every sampleEvery'th one from now
+    // on (0 for none), written to outputFile. Needs a build with NODEGARDEN_TRACK_ALLOCATIONS.
+    void SetAllocationSampling(uint32 sampleEvery);
+    void WriteAllocationReport(Platform::String^ outputFile);
+
+    // Publish node positions, sizes and edges every frame to the named shared memory region,
+    // sized for nodeCapacity nodes and edgeCapacity edges. GardenExport describes the layout.
+    bool StartStateExport(Platform::String^ name, uint32 nodeCapacity, uint32 edgeCapacity);
+    void StopStateExport();
+
+    // Serve frame times, node and connection counts and network rates in the Prometheus text
+    // format at http://127.0.0.1:port/metrics. Port 0 picks a free one. Returns the port
+    // bound, or 0 if the server couldn't start.
+    uint16 StartMetricsServer(uint16 port);
+    void StopMetricsServer();
+
 protected:
 	// Event Handlers
 	void OnPointerPressed(Windows::Phone::Input::Interop::DrawingSurfaceManipulationHost^ sender, Windows::UI::Core::PointerEventArgs^ args);
@@ -53,11 +149,30 @@ internal:
 	HRESULT STDMETHODCALLTYPE PrepareResources(_In_ const LARGE_INTEGER* presentTargetTime, _Out_ BOOL* contentDirty);
 	HRESULT STDMETHODCALLTYPE GetTexture(_In_ const DrawingSurfaceSizeF* size, _Out_ IDrawingSurfaceSynchronizedTextureNative** synchronizedTexture, _Out_ DrawingSurfaceRectF* textureSubRectangle);
 	ID3D11Texture2D* GetTexture();
+	void EndFrame();
 
 private:
+	void UpdateRenderTargetSize();
+
 	XTKRenderer^ m_renderer;
 	BasicTimer^ m_timer;
+	BasicTimer^ m_frameWorkTimer;
 	Windows::Foundation::Size m_renderResolution;
+	Windows::Foundation::Size m_renderTargetSize;
+
+	// Enable/DisableDynamicResolution come from the UI thread while the compositor thread feeds
+	// the controller, so they only leave a request here for PrepareResources to apply
+	std::mutex m_dynamicResolutionLock;
+	bool m_dynamicResolutionRequested;
+	float m_requestedMinScale;
+	float m_requestedMaxScale;
+	std::atomic<bool> m_dynamicResolutionChanged;
+
+	DynamicResolution m_dynamicResolution;      // the compositor thread's only
+	bool m_dynamicResolutionEnabled;
+	std::atomic<bool> m_renderTargetSizeDirty;
+
+	std::string m_profileFolder;
 };
 
 }
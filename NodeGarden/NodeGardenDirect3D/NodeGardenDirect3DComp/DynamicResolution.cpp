@@ -0,0 +1,140 @@
+#include "DynamicResolution.h"
+#include <math.h>
+
+const float DynamicResolution::ScaleDownStep = 0.1f;
+const float DynamicResolution::ScaleUpStep = 0.05f;
+const float DynamicResolution::OverloadRatio = 1.15f;
+const float DynamicResolution::HeadroomRatio = 0.6f;
+
+DynamicResolution::DynamicResolution(void)
+{
+    m_minScale = 0.5f;
+    m_maxScale = 1.0f;
+    m_targetFrameTime = 1.0f / 60.0f;
+    Reset(1.0f);
+}
+
+void DynamicResolution::SetBounds(float minScale, float maxScale)
+{
+    if (minScale > maxScale)
+    {
+        float swap = minScale;
+        minScale = maxScale;
+        maxScale = swap;
+    }
+
+    m_minScale = minScale;
+    m_maxScale = maxScale;
+    Reset(m_scale);
+}
+
+void DynamicResolution::SetTargetFrameTime(float targetFrameTime)
+{
+    m_targetFrameTime = targetFrameTime;
+    ClearSamples();
+}
+
+void DynamicResolution::Reset(float scale)
+{
+    m_scale = scale < m_minScale ? m_minScale : (scale > m_maxScale ? m_maxScale : scale);
+    m_cooldown = 0;
+    ClearSamples();
+}
+
+bool DynamicResolution::AddFrame(float frameTime, float busyTime)
+{
+    if (m_cooldown > 0)
+    {
+        m_cooldown--;
+        return false;
+    }
+
+    // keep a running window so the average costs O(1) per frame
+    if (m_sampleCount == SampleCount)
+    {
+        m_frameTimeSum -= m_frameTimes[m_sampleIndex];
+        m_busyTimeSum -= m_busyTimes[m_sampleIndex];
+    }
+    else
+    {
+        m_sampleCount++;
+    }
+
+    m_frameTimes[m_sampleIndex] = frameTime;
+    m_busyTimes[m_sampleIndex] = busyTime;
+    m_frameTimeSum += frameTime;
+    m_busyTimeSum += busyTime;
+    m_sampleIndex = (m_sampleIndex + 1) % SampleCount;
+
+    if (m_sampleCount < SampleCount)
+        return false;
+
+    float averageFrameTime = m_frameTimeSum / SampleCount;
+    float averageBusyTime = m_busyTimeSum / SampleCount;
+
+    if (averageFrameTime > m_targetFrameTime * OverloadRatio)
+    {
+        m_cheapFrames = 0;
+        return ChangeScale(m_scale - ScaleDownStep);
+    }
+
+    // only grow after a sustained run of frames with plenty of headroom, so a
+    // size that is just barely affordable doesn't flip back and forth
+    if (averageBusyTime < m_targetFrameTime * HeadroomRatio && averageFrameTime <= m_targetFrameTime * OverloadRatio)
+    {
+        if (++m_cheapFrames >= ScaleUpSampleCount)
+        {
+            m_cheapFrames = 0;
+            return ChangeScale(m_scale + ScaleUpStep);
+        }
+    }
+    else
+    {
+        m_cheapFrames = 0;
+    }
+
+    return false;
+}
+
+float DynamicResolution::GetScale() const
+{
+    return m_scale;
+}
+
+float DynamicResolution::GetMinScale() const
+{
+    return m_minScale;
+}
+
+float DynamicResolution::GetMaxScale() const
+{
+    return m_maxScale;
+}
+
+void DynamicResolution::ClearSamples()
+{
+    m_frameTimeSum = 0;
+    m_busyTimeSum = 0;
+    m_sampleIndex = 0;
+    m_sampleCount = 0;
+    m_cheapFrames = 0;
+}
+
+bool DynamicResolution::ChangeScale(float scale)
+{
+    // snap to the step grid so repeated changes don't drift and produce odd target sizes
+    scale = floorf(scale / ScaleUpStep + 0.5f) * ScaleUpStep;
+
+    if (scale < m_minScale)
+        scale = m_minScale;
+    if (scale > m_maxScale)
+        scale = m_maxScale;
+
+    if (scale == m_scale)
+        return false;
+
+    m_scale = scale;
+    m_cooldown = CooldownFrames;
+    ClearSamples();
+    return true;
+}
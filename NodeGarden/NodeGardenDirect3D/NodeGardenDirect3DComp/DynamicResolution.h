@@ -0,0 +1,49 @@
+#pragma once
+
+// Chooses a render target scale between configured bounds from recent frame costs.
+// Kept free of DirectX/WinRT types so it can be driven from plain C++.
+class DynamicResolution
+{
+public:
+    DynamicResolution(void);
+    ~DynamicResolution(void) {};
+
+    void SetBounds(float minScale, float maxScale);
+    void SetTargetFrameTime(float targetFrameTime);
+    void Reset(float scale);
+
+    // Feed the timings (in seconds) of one frame. frameTime is the delta between frames and
+    // includes any GPU back pressure; busyTime is the CPU time spent updating and rendering.
+    // Returns true when the scale changed and the render target needs rebuilding.
+    bool AddFrame(float frameTime, float busyTime);
+
+    float GetScale() const;
+    float GetMinScale() const;
+    float GetMaxScale() const;
+
+private:
+    static const int SampleCount = 30;          // frames averaged before any decision is made
+    static const int ScaleUpSampleCount = 90;   // growing needs a longer run of cheap frames than shrinking
+    static const int CooldownFrames = 30;       // frames ignored after a change while the new size settles
+    static const float ScaleDownStep;
+    static const float ScaleUpStep;
+    static const float OverloadRatio;           // average frame time above target*ratio shrinks the target
+    static const float HeadroomRatio;           // average busy time below target*ratio grows the target
+
+    void ClearSamples();
+    bool ChangeScale(float scale);
+
+    float m_minScale;
+    float m_maxScale;
+    float m_targetFrameTime;
+    float m_scale;
+
+    float m_frameTimes[SampleCount];
+    float m_busyTimes[SampleCount];
+    float m_frameTimeSum;
+    float m_busyTimeSum;
+    int m_sampleIndex;
+    int m_sampleCount;
+    int m_cheapFrames;
+    int m_cooldown;
+};
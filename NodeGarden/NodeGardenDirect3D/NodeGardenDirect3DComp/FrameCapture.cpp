@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "FrameCapture.h"
+
+using namespace Microsoft::WRL;
+
+FrameCapture::FrameCapture(void)
+{
+    m_nextStaging = 0;
+    for (int i = 0; i < StagingCount; i++)
+    {
+        m_staging[i].width = 0;
+        m_staging[i].height = 0;
+        m_staging[i].pending = false;
+    }
+}
+
+void FrameCapture::Start(CaptureFormat format, const std::string& outputFolder)
+{
+    m_queue.Start(format, outputFolder, QueueSlots);
+    m_nextStaging = 0;
+}
+
+void FrameCapture::Stop(ID3D11DeviceContext* context)
+{
+    if (!m_queue.IsRunning())
+        return;
+
+    // hand over everything still in flight, oldest first, waiting on the GPU this once
+    for (int i = 0; i < StagingCount; i++)
+    {
+        ReadBack(context, m_staging[(m_nextStaging + i) % StagingCount], true);
+    }
+
+    m_queue.Stop();
+}
+
+bool FrameCapture::IsCapturing() const
+{
+    return m_queue.IsRunning();
+}
+
+void FrameCapture::CaptureFrame(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* renderTarget)
+{
+    StagingFrame& frame = m_staging[m_nextStaging];
+    m_nextStaging = (m_nextStaging + 1) % StagingCount;
+
+    // this slot was copied StagingCount frames ago and should be ready by now
+    ReadBack(context, frame, false);
+
+    D3D11_TEXTURE2D_DESC desc;
+    renderTarget->GetDesc(&desc);
+
+    // dynamic resolution can change the target size while capturing
+    if (!frame.texture || frame.width != desc.Width || frame.height != desc.Height)
+    {
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        desc.MiscFlags = 0;
+
+        frame.texture = nullptr;
+        DX::ThrowIfFailed(
+            device->CreateTexture2D(&desc, nullptr, &frame.texture)
+            );
+        frame.width = desc.Width;
+        frame.height = desc.Height;
+    }
+
+    context->CopyResource(frame.texture.Get(), renderTarget);
+    frame.pending = true;
+}
+
+const FrameCaptureQueue& FrameCapture::GetQueue() const
+{
+    return m_queue;
+}
+
+void FrameCapture::ReadBack(ID3D11DeviceContext* context, StagingFrame& frame, bool wait)
+{
+    if (!frame.pending)
+        return;
+    frame.pending = false;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = context->Map(frame.texture.Get(), 0, D3D11_MAP_READ, wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (FAILED(hr))
+    {
+        // the GPU is too far behind to read this one without stalling
+        m_queue.DropFrame();
+        return;
+    }
+
+    uint8_t* pixels = m_queue.BeginFrame(frame.width, frame.height);
+    if (pixels != nullptr)
+    {
+        const uint8_t* source = static_cast<const uint8_t*>(mapped.pData);
+        size_t rowBytes = frame.width * 4;
+        for (UINT y = 0; y < frame.height; y++)
+        {
+            memcpy(pixels + y * rowBytes, source + y * mapped.RowPitch, rowBytes);
+        }
+        m_queue.EndFrame();
+    }
+
+    context->Unmap(frame.texture.Get(), 0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "DirectXHelper.h"
+#include "FrameCaptureQueue.h"
+
+// Records rendered frames without stalling the render loop. ScreenGrab copies the target to
+// a staging texture and maps it straight away, which waits for the GPU; here each frame is
+// copied into a ring of staging textures and only mapped a few frames later, when the GPU
+// is done with it, then handed to FrameCaptureQueue's worker for encoding.
+class FrameCapture
+{
+public:
+    FrameCapture(void);
+    ~FrameCapture(void) {};
+
+    void Start(CaptureFormat format, const std::string& outputFolder);
+    void Stop(ID3D11DeviceContext* context);
+    bool IsCapturing() const;
+
+    // Call once the frame has been rendered into renderTarget.
+    void CaptureFrame(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* renderTarget);
+
+    const FrameCaptureQueue& GetQueue() const;
+
+private:
+    static const int StagingCount = 3;      // frames a readback is given before it is mapped
+    static const int QueueSlots = 8;        // frames that may wait for the encoder
+
+    struct StagingFrame
+    {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+        UINT width;
+        UINT height;
+        bool pending;
+    };
+
+    void ReadBack(ID3D11DeviceContext* context, StagingFrame& frame, bool wait);
+
+    StagingFrame m_staging[StagingCount];
+    int m_nextStaging;
+    FrameCaptureQueue m_queue;
+};
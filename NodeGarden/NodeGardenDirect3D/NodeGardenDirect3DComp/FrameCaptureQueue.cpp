@@ -0,0 +1,155 @@
+#include "FrameCaptureQueue.h"
+
+FrameCaptureQueue::FrameCaptureQueue(void)
+{
+    m_readIndex = 0;
+    m_queued = 0;
+    m_writing = false;
+    m_stopping = false;
+    m_nextFrameIndex = 0;
+    m_submitted = 0;
+    m_encoded = 0;
+    m_dropped = 0;
+    m_failed = 0;
+}
+
+FrameCaptureQueue::~FrameCaptureQueue(void)
+{
+    Stop();
+}
+
+bool FrameCaptureQueue::Start(CaptureFormat format, const std::string& outputFolder, int slotCount)
+{
+    Stop();
+
+    if (slotCount < 2)
+        slotCount = 2;
+
+    m_encoder.reset(FrameEncoder::Create(format, outputFolder));
+    m_slots.resize(slotCount);
+    m_readIndex = 0;
+    m_queued = 0;
+    m_writing = false;
+    m_stopping = false;
+    m_nextFrameIndex = 0;
+    m_submitted = 0;
+    m_encoded = 0;
+    m_dropped = 0;
+    m_failed = 0;
+
+    m_worker = std::thread(&FrameCaptureQueue::EncodeLoop, this);
+    return true;
+}
+
+void FrameCaptureQueue::Stop()
+{
+    if (!m_worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stopping = true;
+    }
+    m_frameQueued.notify_one();
+    m_worker.join();
+
+    m_encoder.reset();
+}
+
+bool FrameCaptureQueue::IsRunning() const
+{
+    return m_worker.joinable();
+}
+
+uint8_t* FrameCaptureQueue::BeginFrame(uint32_t width, uint32_t height)
+{
+    if (!m_worker.joinable())
+        return nullptr;
+
+    size_t writeIndex;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_queued == m_slots.size())
+        {
+            m_dropped++;
+            return nullptr;
+        }
+        writeIndex = (m_readIndex + m_queued) % m_slots.size();
+        m_writing = true;
+    }
+
+    // the slot is ours until EndFrame, so sizing and copying happen outside the lock
+    Slot& slot = m_slots[writeIndex];
+    slot.width = width;
+    slot.height = height;
+    slot.frameIndex = m_nextFrameIndex++;
+    slot.pixels.resize((size_t)width * height * 4);
+    return &slot.pixels[0];
+}
+
+void FrameCaptureQueue::EndFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_writing)
+            return;
+        m_writing = false;
+        m_queued++;
+    }
+    m_submitted++;
+    m_frameQueued.notify_one();
+}
+
+void FrameCaptureQueue::DropFrame()
+{
+    m_dropped++;
+}
+
+uint32_t FrameCaptureQueue::GetSubmittedFrames() const
+{
+    return m_submitted;
+}
+
+uint32_t FrameCaptureQueue::GetEncodedFrames() const
+{
+    return m_encoded;
+}
+
+uint32_t FrameCaptureQueue::GetDroppedFrames() const
+{
+    return m_dropped;
+}
+
+uint32_t FrameCaptureQueue::GetFailedFrames() const
+{
+    return m_failed;
+}
+
+void FrameCaptureQueue::EncodeLoop()
+{
+    for (;;)
+    {
+        size_t readIndex;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            while (m_queued == 0 && !m_stopping)
+                m_frameQueued.wait(lock);
+
+            if (m_queued == 0)
+                return;
+            readIndex = m_readIndex;
+        }
+
+        Slot& slot = m_slots[readIndex];
+        if (m_encoder->WriteFrame(&slot.pixels[0], slot.width, slot.height, (size_t)slot.width * 4, slot.frameIndex))
+            m_encoded++;
+        else
+            m_failed++;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_readIndex = (m_readIndex + 1) % m_slots.size();
+            m_queued--;
+        }
+    }
+}
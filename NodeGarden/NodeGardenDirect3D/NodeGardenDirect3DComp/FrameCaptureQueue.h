@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FrameEncoder.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// A ring of CPU frame buffers between the render thread and an encoding worker. The render
+// thread never waits on the encoder: when every slot is still queued the frame is dropped
+// and counted instead.
+class FrameCaptureQueue
+{
+public:
+    FrameCaptureQueue(void);
+    ~FrameCaptureQueue(void);
+
+    bool Start(CaptureFormat format, const std::string& outputFolder, int slotCount);
+
+    // Encodes whatever is already queued, then stops the worker.
+    void Stop();
+    bool IsRunning() const;
+
+    // Render thread: a buffer to copy a width x height BGRA frame into (rows of width*4
+    // bytes), or nullptr if the encoder has fallen behind and this frame is dropped.
+    uint8_t* BeginFrame(uint32_t width, uint32_t height);
+    void EndFrame();
+
+    // Count a frame the producer had to give up on before it reached the queue.
+    void DropFrame();
+
+    uint32_t GetSubmittedFrames() const;
+    uint32_t GetEncodedFrames() const;
+    uint32_t GetDroppedFrames() const;
+    uint32_t GetFailedFrames() const;
+
+private:
+    FrameCaptureQueue(const FrameCaptureQueue&);
+    FrameCaptureQueue& operator=(const FrameCaptureQueue&);
+
+    struct Slot
+    {
+        std::vector<uint8_t> pixels;
+        uint32_t width;
+        uint32_t height;
+        uint64_t frameIndex;
+    };
+
+    void EncodeLoop();
+
+    std::unique_ptr<FrameEncoder> m_encoder;
+    std::vector<Slot> m_slots;
+
+    // slots [m_readIndex, m_readIndex + m_queued) are waiting for the encoder. The lock only
+    // covers these indices, never a copy or an encode
+    std::mutex m_lock;
+    std::condition_variable m_frameQueued;
+    size_t m_readIndex;
+    size_t m_queued;
+    bool m_writing;
+    bool m_stopping;
+    std::thread m_worker;
+
+    uint64_t m_nextFrameIndex;
+    std::atomic<uint32_t> m_submitted;
+    std::atomic<uint32_t> m_encoded;
+    std::atomic<uint32_t> m_dropped;
+    std::atomic<uint32_t> m_failed;
+};
@@ -0,0 +1,282 @@
+#include "FrameEncoder.h"
+#include <string.h>
+
+namespace
+{
+    uint32_t s_crcTable[256];
+    bool s_crcTableReady = false;
+
+    void BuildCrcTable()
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            s_crcTable[n] = c;
+        }
+        s_crcTableReady = true;
+    }
+
+    uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            crc = s_crcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return crc;
+    }
+
+    uint32_t UpdateAdler(uint32_t adler, const uint8_t* data, size_t size)
+    {
+        uint32_t a = adler & 0xffff;
+        uint32_t b = adler >> 16;
+
+        while (size > 0)
+        {
+            // 5552 is the most bytes that can be summed before b must be reduced
+            size_t run = size < 5552 ? size : 5552;
+            size -= run;
+            while (run-- > 0)
+            {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+
+        return (b << 16) | a;
+    }
+
+    void PutBigEndian(uint8_t* out, uint32_t value)
+    {
+        out[0] = (uint8_t)(value >> 24);
+        out[1] = (uint8_t)(value >> 16);
+        out[2] = (uint8_t)(value >> 8);
+        out[3] = (uint8_t)value;
+    }
+
+    // writes chunk data while keeping the chunk's running CRC
+    struct PngChunkWriter
+    {
+        FILE* file;
+        uint32_t crc;
+        bool ok;
+
+        void Begin(const char* type, uint32_t length)
+        {
+            uint8_t header[8];
+            PutBigEndian(header, length);
+            memcpy(header + 4, type, 4);
+            ok = fwrite(header, 1, 8, file) == 8;
+            crc = UpdateCrc(0xffffffffu, header + 4, 4);
+        }
+
+        void Write(const uint8_t* data, size_t size)
+        {
+            ok = ok && fwrite(data, 1, size, file) == size;
+            crc = UpdateCrc(crc, data, size);
+        }
+
+        void End()
+        {
+            uint8_t footer[4];
+            PutBigEndian(footer, crc ^ 0xffffffffu);
+            ok = ok && fwrite(footer, 1, 4, file) == 4;
+        }
+    };
+
+    uint8_t ToY(int r, int g, int b)
+    {
+        return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+
+    uint8_t ToU(int r, int g, int b)
+    {
+        return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    }
+
+    uint8_t ToV(int r, int g, int b)
+    {
+        return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+FrameEncoder::FrameEncoder(const std::string& outputFolder) :
+    m_outputFolder(outputFolder)
+{
+    if (!s_crcTableReady)
+        BuildCrcTable();
+}
+
+FrameEncoder* FrameEncoder::Create(CaptureFormat format, const std::string& outputFolder)
+{
+    switch (format)
+    {
+    case CaptureFormat_Yuv:
+        return new YuvFrameEncoder(outputFolder);
+    default:
+        return new PngFrameEncoder(outputFolder);
+    }
+}
+
+PngFrameEncoder::PngFrameEncoder(const std::string& outputFolder) : FrameEncoder(outputFolder)
+{
+}
+
+bool PngFrameEncoder::WriteFrame(const uint8_t* bgra, uint32_t width, uint32_t height, size_t rowPitch, uint64_t frameIndex)
+{
+    char fileName[32];
+    sprintf(fileName, "/frame_%06u.png", (unsigned)frameIndex);
+    FILE* file = fopen((m_outputFolder + fileName).c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    bool ok = fwrite(signature, 1, 8, file) == 8;
+
+    PngChunkWriter chunk = { file, 0, ok };
+
+    // 8 bit RGB, no interlacing; the render target's alpha isn't meaningful
+    uint8_t ihdr[13];
+    PutBigEndian(ihdr, width);
+    PutBigEndian(ihdr + 4, height);
+    ihdr[8] = 8;
+    ihdr[9] = 2;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    chunk.Begin("IHDR", 13);
+    chunk.Write(ihdr, 13);
+    chunk.End();
+
+    // each scanline is a filter byte followed by RGB, stored in 64K deflate blocks
+    size_t rowBytes = 1 + (size_t)width * 3;
+    size_t rawSize = rowBytes * height;
+    size_t blockCount = (rawSize + 65534) / 65535;
+    chunk.Begin("IDAT", (uint32_t)(2 + rawSize + blockCount * 5 + 4));
+
+    static const uint8_t zlibHeader[2] = { 0x78, 0x01 };
+    chunk.Write(zlibHeader, 2);
+
+    m_row.resize(rowBytes);
+    uint32_t adler = 1;
+    size_t blockLeft = 0;
+    size_t remaining = rawSize;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* source = bgra + y * rowPitch;
+        m_row[0] = 0;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            m_row[1 + x * 3] = source[x * 4 + 2];
+            m_row[2 + x * 3] = source[x * 4 + 1];
+            m_row[3 + x * 3] = source[x * 4];
+        }
+        adler = UpdateAdler(adler, &m_row[0], rowBytes);
+
+        size_t offset = 0;
+        while (offset < rowBytes)
+        {
+            if (blockLeft == 0)
+            {
+                blockLeft = remaining < 65535 ? remaining : 65535;
+                uint8_t blockHeader[5];
+                blockHeader[0] = remaining == blockLeft ? 1 : 0;
+                blockHeader[1] = (uint8_t)blockLeft;
+                blockHeader[2] = (uint8_t)(blockLeft >> 8);
+                blockHeader[3] = (uint8_t)~blockLeft;
+                blockHeader[4] = (uint8_t)(~blockLeft >> 8);
+                chunk.Write(blockHeader, 5);
+            }
+
+            size_t run = rowBytes - offset < blockLeft ? rowBytes - offset : blockLeft;
+            chunk.Write(&m_row[offset], run);
+            offset += run;
+            blockLeft -= run;
+            remaining -= run;
+        }
+    }
+
+    uint8_t adlerBytes[4];
+    PutBigEndian(adlerBytes, adler);
+    chunk.Write(adlerBytes, 4);
+    chunk.End();
+
+    chunk.Begin("IEND", 0);
+    chunk.End();
+
+    ok = chunk.ok;
+    return fclose(file) == 0 && ok;
+}
+
+YuvFrameEncoder::YuvFrameEncoder(const std::string& outputFolder) : FrameEncoder(outputFolder)
+{
+    m_file = nullptr;
+    m_width = 0;
+    m_height = 0;
+}
+
+YuvFrameEncoder::~YuvFrameEncoder(void)
+{
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+bool YuvFrameEncoder::WriteFrame(const uint8_t* bgra, uint32_t width, uint32_t height, size_t rowPitch, uint64_t)
+{
+    // raw streams carry no header, so a size change (dynamic resolution) starts a new file
+    if (m_file == nullptr || width != m_width || height != m_height)
+    {
+        if (m_file != nullptr)
+            fclose(m_file);
+
+        char fileName[48];
+        sprintf(fileName, "/capture_%ux%u.yuv", width, height);
+        m_file = fopen((m_outputFolder + fileName).c_str(), "ab");
+        if (m_file == nullptr)
+            return false;
+
+        m_width = width;
+        m_height = height;
+    }
+
+    uint32_t chromaWidth = (width + 1) / 2;
+    uint32_t chromaHeight = (height + 1) / 2;
+    size_t lumaSize = (size_t)width * height;
+    size_t chromaSize = (size_t)chromaWidth * chromaHeight;
+    m_planes.resize(lumaSize + chromaSize * 2);
+
+    uint8_t* yPlane = &m_planes[0];
+    uint8_t* uPlane = yPlane + lumaSize;
+    uint8_t* vPlane = uPlane + chromaSize;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* source = bgra + y * rowPitch;
+        for (uint32_t x = 0; x < width; x++)
+            yPlane[y * width + x] = ToY(source[x * 4 + 2], source[x * 4 + 1], source[x * 4]);
+    }
+
+    // chroma from the average of each 2x2 block, clamped at odd edges
+    for (uint32_t cy = 0; cy < chromaHeight; cy++)
+    {
+        const uint8_t* row0 = bgra + (cy * 2) * rowPitch;
+        const uint8_t* row1 = bgra + (cy * 2 + 1 < height ? cy * 2 + 1 : cy * 2) * rowPitch;
+
+        for (uint32_t cx = 0; cx < chromaWidth; cx++)
+        {
+            uint32_t x0 = cx * 2 * 4;
+            uint32_t x1 = (cx * 2 + 1 < width ? cx * 2 + 1 : cx * 2) * 4;
+
+            int b = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) / 4;
+            int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) / 4;
+            int r = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) / 4;
+
+            uPlane[cy * chromaWidth + cx] = ToU(r, g, b);
+            vPlane[cy * chromaWidth + cx] = ToV(r, g, b);
+        }
+    }
+
+    return fwrite(&m_planes[0], 1, m_planes.size(), m_file) == m_planes.size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+enum CaptureFormat
+{
+    CaptureFormat_Png,          // one PNG per frame, frame_000000.png onwards
+    CaptureFormat_Yuv,          // one raw I420 stream per frame size, capture_WxH.yuv
+};
+
+// Turns captured BGRA frames into files. Runs on the capture worker thread and has no
+// graphics dependencies, so it can be fed from a CPU framebuffer.
+class FrameEncoder
+{
+public:
+    FrameEncoder(const std::string& outputFolder);
+    virtual ~FrameEncoder(void) {};
+
+    virtual bool WriteFrame(const uint8_t* bgra, uint32_t width, uint32_t height, size_t rowPitch, uint64_t frameIndex) = 0;
+
+    static FrameEncoder* Create(CaptureFormat format, const std::string& outputFolder);
+
+protected:
+    std::string m_outputFolder;
+};
+
+// Uncompressed (stored deflate) PNGs. Encoding speed matters more than size here; the
+// sequences are recompressed when the highlight reel is cut.
+class PngFrameEncoder : public FrameEncoder
+{
+public:
+    PngFrameEncoder(const std::string& outputFolder);
+    virtual ~PngFrameEncoder(void) {};
+
+    virtual bool WriteFrame(const uint8_t* bgra, uint32_t width, uint32_t height, size_t rowPitch, uint64_t frameIndex) override;
+
+private:
+    std::vector<uint8_t> m_row;
+};
+
+// BT.601 I420 appended to one file per frame size
+class YuvFrameEncoder : public FrameEncoder
+{
+public:
+    YuvFrameEncoder(const std::string& outputFolder);
+    virtual ~YuvFrameEncoder(void);
+
+    virtual bool WriteFrame(const uint8_t* bgra, uint32_t width, uint32_t height, size_t rowPitch, uint64_t frameIndex) override;
+
+private:
+    FILE* m_file;
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<uint8_t> m_planes;
+};
@@ -0,0 +1,122 @@
+#include "FrameGraph.h"
+#include "Profiler.h"
+
+FrameGraph::FrameGraph(void)
+{
+    m_stagesLeft = 0;
+    m_runStart = 0;
+    m_runEnd = 0;
+    for (int i = 0; i < MaxStages; i++)
+    {
+        m_waiting[i] = 0;
+    }
+}
+
+int FrameGraph::AddStage(const char* name, const std::function<void()>& work)
+{
+    if ((int)m_stages.size() >= MaxStages)
+        return -1;
+
+    Stage stage;
+    stage.Name = name;
+    stage.Work = work;
+    stage.DependencyCount = 0;
+    stage.Start = 0;
+    stage.End = 0;
+    m_stages.push_back(stage);
+    return (int)m_stages.size() - 1;
+}
+
+void FrameGraph::AddDependency(int stage, int before)
+{
+    if (stage < 0 || stage >= (int)m_stages.size() || before < 0 || before >= stage)
+        return;
+
+    m_stages[before].Dependents.push_back(stage);
+    m_stages[stage].DependencyCount++;
+}
+
+void FrameGraph::Run(TaskPool& pool)
+{
+    int count = (int)m_stages.size();
+    m_runStart = Profiler::Now();
+    m_stagesLeft = count;
+    for (int i = 0; i < count; i++)
+    {
+        m_waiting[i] = m_stages[i].DependencyCount;
+    }
+
+    // the first stage with nothing to wait on runs here rather than going through the queue
+    int first = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (m_stages[i].DependencyCount != 0)
+            continue;
+
+        if (first < 0)
+            first = i;
+        else
+            pool.Submit([this, &pool, i]() { RunStage(pool, i); }, this);
+    }
+    if (first >= 0)
+        RunStage(pool, first);
+
+    pool.WaitUntil([this]() { return m_stagesLeft == 0; }, this);
+    m_runEnd = Profiler::Now();
+}
+
+void FrameGraph::RunStage(TaskPool& pool, int index)
+{
+    Stage& stage = m_stages[index];
+    stage.Start = Profiler::Now();
+    {
+        PROFILE_SCOPE(stage.Name);
+        stage.Work();
+    }
+    stage.End = Profiler::Now();
+
+    // the last dependency to finish starts each dependent; one of them carries on on this
+    // thread, the rest are queued
+    int next = -1;
+    for (size_t i = 0; i < stage.Dependents.size(); i++)
+    {
+        int dependent = stage.Dependents[i];
+        if (--m_waiting[dependent] != 0)
+            continue;
+
+        if (next < 0)
+            next = dependent;
+        else
+            pool.Submit([this, &pool, dependent]() { RunStage(pool, dependent); }, this);
+    }
+
+    // counted down after the dependents are queued, so Run can't return with one still to start
+    m_stagesLeft--;
+    if (next >= 0)
+        RunStage(pool, next);
+}
+
+int FrameGraph::GetStageCount() const
+{
+    return (int)m_stages.size();
+}
+
+const char* FrameGraph::GetStageName(int stage) const
+{
+    return m_stages[stage].Name;
+}
+
+double FrameGraph::GetStageStart(int stage) const
+{
+    return Profiler::TicksToNs(m_stages[stage].Start - m_runStart) / 1e6;
+}
+
+double FrameGraph::GetStageTime(int stage) const
+{
+    return Profiler::TicksToNs(m_stages[stage].End - m_stages[stage].Start) / 1e6;
+}
+
+double FrameGraph::GetRunTime() const
+{
+    return Profiler::TicksToNs(m_runEnd - m_runStart) / 1e6;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "TaskPool.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+// A frame's work as named stages with dependencies between them, run on a TaskPool. A stage
+// starts as soon as every stage it depends on has finished, so stages with nothing between
+// them run side by side.
+//
+// The graph is built once and run every frame. A stage can only depend on stages added
+// before it, which rules out cycles. Each run records when every stage started and how long
+// it took, for Direct3DInterop::FrameStageTimes and GardenFrameGraphCheck; with profiling
+// compiled in each stage is also a scope under its own name.
+class FrameGraph
+{
+public:
+    static const int MaxStages = 16;
+
+    FrameGraph(void);
+    ~FrameGraph(void) {};
+
+    // returns the stage's index, or -1 past MaxStages. name must outlive the graph
+    int AddStage(const char* name, const std::function<void()>& work);
+
+    // before must have been added before stage
+    void AddDependency(int stage, int before);
+
+    // every stage once, returning when they have all finished
+    void Run(TaskPool& pool);
+
+    int GetStageCount() const;
+    const char* GetStageName(int stage) const;
+
+    // from the last run, in ms; start is from when Run was called
+    double GetStageStart(int stage) const;
+    double GetStageTime(int stage) const;
+    double GetRunTime() const;
+
+private:
+    struct Stage
+    {
+        const char* Name;
+        std::function<void()> Work;
+        std::vector<int> Dependents;        // stages waiting on this one
+        int DependencyCount;
+        uint64_t Start;
+        uint64_t End;
+    };
+
+    void RunStage(TaskPool& pool, int stage);
+
+    std::vector<Stage> m_stages;
+    std::atomic<int> m_waiting[MaxStages];      // dependencies unfinished this run, by stage
+    std::atomic<int> m_stagesLeft;
+    uint64_t m_runStart;
+    uint64_t m_runEnd;
+};
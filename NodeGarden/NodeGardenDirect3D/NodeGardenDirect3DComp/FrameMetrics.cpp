@@ -0,0 +1,103 @@
+#include "FrameMetrics.h"
+#include <algorithm>
+#include <string.h>
+
+FrameMetrics::FrameMetrics(void)
+{
+    memset(m_samples, 0, sizeof(m_samples));
+    m_frameCount = 0;
+    m_networkUpdates = 0;
+    m_totalFrameTime = 0;
+    m_rateTime = 0;
+    m_rateUpdates = 0;
+    m_networkUpdatesPerSecond = 0;
+}
+
+void FrameMetrics::AddFrame(const FrameSample& sample)
+{
+    uint32_t frame = m_frameCount.load(std::memory_order_relaxed);
+    m_samples[frame % HistoryLength] = sample;
+    m_frameCount.store(frame + 1, std::memory_order_release);
+
+    m_rateTime += sample.FrameTime;
+    m_totalFrameTime += sample.FrameTime;
+}
+
+void FrameMetrics::AddNetworkUpdate()
+{
+    m_networkUpdates.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameMetrics::Summarise(FrameSummary* summary)
+{
+    memset(summary, 0, sizeof(FrameSummary));
+
+    int count = GetSampleCount();
+    if (count == 0)
+        return;
+
+    float frameTimes[HistoryLength];
+    for (int i = 0; i < count; i++)
+    {
+        const FrameSample& sample = GetSample(i);
+        frameTimes[i] = sample.FrameTime;
+        summary->AverageFrameTime += sample.FrameTime;
+        summary->AverageSimTime += sample.SimTime;
+        summary->AverageRenderTime += sample.RenderTime;
+    }
+
+    summary->AverageFrameTime /= count;
+    summary->AverageSimTime /= count;
+    summary->AverageRenderTime /= count;
+
+    // nearest-rank percentiles, highest first so each nth_element only partitions what's left
+    int rank = (count * 99 + 99) / 100 - 1;
+    std::nth_element(frameTimes, frameTimes + rank, frameTimes + count);
+    summary->P99FrameTime = frameTimes[rank];
+
+    int p90Rank = (count * 90 + 99) / 100 - 1;
+    std::nth_element(frameTimes, frameTimes + p90Rank, frameTimes + rank);
+    summary->P90FrameTime = frameTimes[p90Rank];
+
+    int medianRank = (count * 50 + 99) / 100 - 1;
+    std::nth_element(frameTimes, frameTimes + medianRank, frameTimes + p90Rank);
+    summary->MedianFrameTime = frameTimes[medianRank];
+
+    if (m_rateTime >= 1.0f)
+    {
+        uint32_t updates = m_networkUpdates.load(std::memory_order_relaxed);
+        m_networkUpdatesPerSecond = (updates - m_rateUpdates) / m_rateTime;
+        m_rateUpdates = updates;
+        m_rateTime = 0;
+    }
+
+    summary->NetworkUpdatesPerSecond = m_networkUpdatesPerSecond;
+    summary->Last = GetSample(0);
+}
+
+int FrameMetrics::GetSampleCount() const
+{
+    uint32_t frames = m_frameCount.load(std::memory_order_acquire);
+    return frames < (uint32_t)HistoryLength ? (int)frames : HistoryLength;
+}
+
+uint32_t FrameMetrics::GetFrameCount() const
+{
+    return m_frameCount.load(std::memory_order_acquire);
+}
+
+uint32_t FrameMetrics::GetNetworkUpdates() const
+{
+    return m_networkUpdates.load(std::memory_order_relaxed);
+}
+
+double FrameMetrics::GetTotalFrameTime() const
+{
+    return m_totalFrameTime;
+}
+
+const FrameSample& FrameMetrics::GetSample(int age) const
+{
+    uint32_t frames = m_frameCount.load(std::memory_order_acquire);
+    return m_samples[(frames - 1 - age) % HistoryLength];
+}
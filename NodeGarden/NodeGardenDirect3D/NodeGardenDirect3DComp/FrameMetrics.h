@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// What one frame cost and produced
+struct FrameSample
+{
+    float FrameTime;            // seconds between frames
+    float SimTime;              // seconds in Update
+    float RenderTime;           // seconds in Render
+    uint32_t Nodes;
+    uint64_t PairsTested;       // n^2 / 2 for brute force, past 32 bits in big gardens
+    uint32_t Connections;
+    uint32_t SpritesSubmitted;
+};
+
+struct FrameSummary
+{
+    float AverageFrameTime;
+    float MedianFrameTime;
+    float P90FrameTime;
+    float P99FrameTime;
+    float AverageSimTime;
+    float AverageRenderTime;
+    float NetworkUpdatesPerSecond;
+    FrameSample Last;
+};
+
+// Recent frame history for the performance HUD. Recording a frame is a struct copy into a
+// ring plus one atomic store, and network updates are a relaxed atomic increment from any
+// thread; the sorting and averaging only happen in Summarise, when something is watching.
+class FrameMetrics
+{
+public:
+    static const int HistoryLength = 120;
+
+    FrameMetrics(void);
+    ~FrameMetrics(void) {};
+
+    // render thread
+    void AddFrame(const FrameSample& sample);
+
+    // any thread
+    void AddNetworkUpdate();
+
+    // render thread; the network rate is refreshed about once a second
+    void Summarise(FrameSummary* summary);
+
+    int GetSampleCount() const;
+
+    // since startup
+    uint32_t GetFrameCount() const;
+    uint32_t GetNetworkUpdates() const;
+    double GetTotalFrameTime() const;       // render thread
+
+    // age 0 is the most recent frame
+    const FrameSample& GetSample(int age) const;
+
+private:
+    FrameSample m_samples[HistoryLength];
+    std::atomic<uint32_t> m_frameCount;
+    std::atomic<uint32_t> m_networkUpdates;
+
+    double m_totalFrameTime;
+    float m_rateTime;
+    uint32_t m_rateUpdates;
+    float m_networkUpdatesPerSecond;
+};
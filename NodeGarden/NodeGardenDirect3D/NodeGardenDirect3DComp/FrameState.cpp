@@ -0,0 +1,105 @@
+#include "FrameState.h"
+#include "Profiler.h"
+
+FrameState::FrameState(void)
+{
+    Frame = 0;
+    HasMyNode = false;
+    FrameTime = 0;
+    SimTime = 0;
+    PairsTested = 0;
+}
+
+void FrameState::Capture(const Garden& garden, uint64_t frame)
+{
+    // assign reuses the vectors' storage, so after the first few frames this is two copies
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+    Nodes.assign(nodes.begin(), nodes.end());
+    Edges.assign(edges.begin(), edges.end());
+    HasMyNode = garden.HasMyNode();
+    PairsTested = garden.GetPairsTested();
+    Frame = frame;
+}
+
+FrameStateBuffer::FrameStateBuffer(void)
+{
+    m_front = 0;
+}
+
+const FrameState& FrameStateBuffer::Front() const
+{
+    return m_states[m_front];
+}
+
+FrameState& FrameStateBuffer::Back()
+{
+    return m_states[1 - m_front];
+}
+
+void FrameStateBuffer::Swap()
+{
+    m_front = 1 - m_front;
+}
+
+FrameWorker::FrameWorker(void)
+{
+    m_busy = false;
+    m_quit = false;
+    m_thread = std::thread(&FrameWorker::Run, this);
+}
+
+FrameWorker::~FrameWorker(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void FrameWorker::Start(const std::function<void()>& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_job = job;
+        m_busy = true;
+    }
+    m_wake.notify_one();
+}
+
+void FrameWorker::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (m_busy)
+        m_done.wait(lock);
+}
+
+bool FrameWorker::IsBusy()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_busy;
+}
+
+void FrameWorker::Run()
+{
+    Profiler::SetThreadName("Simulation");
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;)
+    {
+        while (!m_busy && !m_quit)
+            m_wake.wait(lock);
+        if (m_quit)
+            return;
+
+        std::function<void()> job = m_job;
+        lock.unlock();
+        job();
+        lock.lock();
+
+        m_busy = false;
+        m_done.notify_all();
+    }
+}
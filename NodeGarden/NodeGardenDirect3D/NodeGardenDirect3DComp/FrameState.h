@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Garden.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// Everything drawing a frame needs from the simulation, copied out once the frame's update
+// has finished so the drawing never looks at the live garden.
+struct FrameState
+{
+    uint64_t Frame;                 // counts up from 1 with every capture
+    std::vector<GardenNode> Nodes;
+    std::vector<GardenEdge> Edges;
+    bool HasMyNode;
+
+    // what the update cost and found, for the frame metrics of the frame it's drawn in
+    float FrameTime;
+    float SimTime;
+    uint64_t PairsTested;
+
+    FrameState(void);
+
+    void Capture(const Garden& garden, uint64_t frame);
+};
+
+// Two FrameStates: the front one is drawn while the back one is filled with the next frame.
+//
+// Neither side locks anything. The owner makes sure the back is only written while the front
+// is being read, and Swap is only called once both are done with, so the front never changes
+// under the renderer and every state it sees is one whole frame.
+class FrameStateBuffer
+{
+public:
+    FrameStateBuffer(void);
+    ~FrameStateBuffer(void) {};
+
+    const FrameState& Front() const;
+    FrameState& Back();
+
+    // the back becomes the front
+    void Swap();
+
+private:
+    FrameState m_states[2];
+    int m_front;
+};
+
+// One thread that runs a single job at a time alongside its caller: Start hands it the job,
+// Wait returns once it has finished. The thread lives as long as the worker, so a frame
+// costs two wakeups rather than a thread.
+class FrameWorker
+{
+public:
+    FrameWorker(void);
+    ~FrameWorker(void);
+
+    // the previous job must have been waited for
+    void Start(const std::function<void()>& job);
+    void Wait();
+    bool IsBusy();
+
+private:
+    FrameWorker(const FrameWorker&);
+    FrameWorker& operator=(const FrameWorker&);
+
+    void Run();
+
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::function<void()> m_job;
+    bool m_busy;
+    bool m_quit;
+};
@@ -0,0 +1,1213 @@
+#include "Garden.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <string.h>
+
+const float Garden::MinDist = 250.0f;
+const float Garden::Speed = 0.6f;
+const float Garden::WanderInterval = 1000.0f / 60.0f;
+const float Garden::NodeFadeTime = 1.0f;
+
+Garden::Garden(void)
+{
+    m_width = 0;
+    m_height = 0;
+    m_nextId = 1;
+    m_threadCount = 1;
+    m_pairsTested = 0;
+    m_maxConnectedness = 0.1f;
+    m_reorderInterval = 0;
+    m_framesSinceReorder = 0;
+    m_search = ConnectionSearch_Adaptive;
+    m_lastSearch = ConnectionSearch_BruteForce;
+    m_maxDegree = 0;
+    m_degree = 0;
+    m_densityFieldAbove = 0;
+    m_hasMyNode = false;
+    m_isBeingDragged = false;
+    m_clock = 0;
+    m_nodeExpiry = 0;
+    SetSeed(1);
+}
+
+void Garden::SetSize(float width, float height)
+{
+    m_width = width;
+    m_height = height;
+}
+
+float Garden::GetWidth() const
+{
+    return m_width;
+}
+
+float Garden::GetHeight() const
+{
+    return m_height;
+}
+
+void Garden::SetSeed(uint32_t seed)
+{
+    // xorshift gets stuck at zero
+    m_randomState = seed != 0 ? seed : 0x9E3779B9;
+}
+
+void Garden::SetThreadCount(int count)
+{
+    m_threadCount = count > 1 ? count : 1;
+
+    // the calling thread takes a slice too
+    if (m_threadCount == 1)
+        m_pool.reset();
+    else if (!m_pool || m_pool->GetWorkerCount() != m_threadCount - 1)
+        m_pool = std::unique_ptr<TaskPool>(new TaskPool(m_threadCount - 1));
+}
+
+int Garden::GetThreadCount() const
+{
+    return m_threadCount;
+}
+
+void Garden::SetReorderInterval(int frames)
+{
+    m_reorderInterval = frames > 0 ? frames : 0;
+    m_framesSinceReorder = 0;
+}
+
+int Garden::GetReorderInterval() const
+{
+    return m_reorderInterval;
+}
+
+void Garden::SetConnectionSearch(ConnectionSearch search)
+{
+    m_search = search;
+}
+
+ConnectionSearch Garden::GetConnectionSearch() const
+{
+    return m_search;
+}
+
+ConnectionSearch Garden::GetLastSearch() const
+{
+    return m_lastSearch;
+}
+
+const Quadtree& Garden::GetQuadtree() const
+{
+    return m_quadtree;
+}
+
+void Garden::SetMaxDegree(int degree)
+{
+    m_maxDegree = degree > 0 ? degree : 0;
+}
+
+int Garden::GetMaxDegree() const
+{
+    return m_maxDegree;
+}
+
+void Garden::SetDensityFieldAbove(int count)
+{
+    m_densityFieldAbove = count > 0 ? count : 0;
+}
+
+int Garden::GetDensityFieldAbove() const
+{
+    return m_densityFieldAbove;
+}
+
+void Garden::SetDensityFieldResolution(int cells)
+{
+    m_densityField.SetResolution(cells);
+}
+
+int Garden::GetDensityFieldResolution() const
+{
+    return m_densityField.GetResolution();
+}
+
+void Garden::SetNodeExpiry(float seconds)
+{
+    m_nodeExpiry = seconds > 0 ? seconds : 0;
+
+    m_expiryWheel.Reset(GetTick());
+    for (size_t i = 0; i < m_fading.size(); i++)
+    {
+        int index = m_fading[i];
+        m_schedules[index].FadeStart = -1;
+        m_schedules[index].FadeSlot = -1;
+        m_nodes[index].Opacity = 1;
+    }
+    m_fading.clear();
+
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        m_schedules[i].Expiry = -1;
+        if (m_nodeExpiry > 0 && IsRemote((int)i))
+            ScheduleExpiry((int)i, m_schedules[i].LastSeen + m_nodeExpiry);
+    }
+}
+
+float Garden::GetNodeExpiry() const
+{
+    return m_nodeExpiry;
+}
+
+void Garden::SaveState(GardenState* state) const
+{
+    state->Nodes = m_nodes;
+    state->Width = m_width;
+    state->Height = m_height;
+    state->MaxConnectedness = m_maxConnectedness;
+    state->RandomState = m_randomState;
+    state->NextId = m_nextId;
+    state->ReorderInterval = m_reorderInterval;
+    state->FramesSinceReorder = m_framesSinceReorder;
+    state->MaxDegree = m_maxDegree;
+    state->DensityFieldAbove = m_densityFieldAbove;
+    state->DensityFieldResolution = m_densityField.GetResolution();
+    state->NodeExpiry = m_nodeExpiry;
+    state->Clock = m_clock;
+    state->WanderDue.resize(m_nodes.size());
+    state->ExpiryDue.resize(m_nodes.size());
+    state->LastSeen.resize(m_nodes.size());
+    state->FadeStart.resize(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        const NodeSchedule& schedule = m_schedules[i];
+        state->WanderDue[i] = schedule.Wander >= 0 ? m_wanderWheel.GetDue(schedule.Wander) : 0;
+        state->ExpiryDue[i] = schedule.Expiry >= 0 ? m_expiryWheel.GetDue(schedule.Expiry) : 0;
+        state->LastSeen[i] = schedule.LastSeen;
+        state->FadeStart[i] = schedule.FadeStart;
+    }
+    state->HasMyNode = m_hasMyNode;
+    state->IsBeingDragged = m_isBeingDragged;
+}
+
+void Garden::LoadState(const GardenState& state)
+{
+    m_nodes = state.Nodes;
+    m_edges.clear();
+    m_width = state.Width;
+    m_height = state.Height;
+    m_maxConnectedness = state.MaxConnectedness;
+    m_randomState = state.RandomState;
+    m_nextId = state.NextId;
+    m_reorderInterval = state.ReorderInterval;
+    m_framesSinceReorder = state.FramesSinceReorder;
+    m_maxDegree = state.MaxDegree;
+    m_densityFieldAbove = state.DensityFieldAbove;
+    m_densityField.SetResolution(state.DensityFieldResolution);
+
+    m_nodeExpiry = state.NodeExpiry;
+    m_clock = state.Clock;
+    m_wanderWheel.Reset(GetTick());
+    m_expiryWheel.Reset(GetTick());
+    m_schedules.assign(m_nodes.size(), NewSchedule());
+    m_fading.clear();
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        NodeSchedule& schedule = m_schedules[i];
+        if (i < state.WanderDue.size() && state.WanderDue[i] != 0)
+            schedule.Wander = m_wanderWheel.Schedule(state.WanderDue[i], (int)i);
+        if (i < state.ExpiryDue.size() && state.ExpiryDue[i] != 0)
+            schedule.Expiry = m_expiryWheel.Schedule(state.ExpiryDue[i], (int)i);
+        if (i < state.LastSeen.size())
+            schedule.LastSeen = state.LastSeen[i];
+        if (i < state.FadeStart.size() && state.FadeStart[i] >= 0)
+        {
+            schedule.FadeStart = state.FadeStart[i];
+            schedule.FadeSlot = (int)m_fading.size();
+            m_fading.push_back((int)i);
+        }
+    }
+    ReserveSchedules();
+
+    m_hasMyNode = state.HasMyNode;
+    m_isBeingDragged = state.IsBeingDragged;
+    m_motion.Invalidate();
+}
+
+uint32_t Garden::Checksum() const
+{
+    // FNV-1a over the raw bits, so any difference at all shows up
+    uint32_t hash = 2166136261u;
+    const uint8_t* bytes = m_nodes.empty() ? nullptr : (const uint8_t*)&m_nodes[0];
+    size_t size = m_nodes.size() * sizeof(GardenNode);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    uint32_t extra[3] = { (uint32_t)m_edges.size(), m_randomState, 0 };
+    memcpy(&extra[2], &m_maxConnectedness, sizeof(float));
+    bytes = (const uint8_t*)extra;
+    for (size_t i = 0; i < sizeof(extra); i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+float Garden::Random(float max)
+{
+    m_randomState ^= m_randomState << 13;
+    m_randomState ^= m_randomState >> 17;
+    m_randomState ^= m_randomState << 5;
+
+    return (float)((double)m_randomState / 4294967295.0 * max);
+}
+
+void Garden::Clear()
+{
+    m_nodes.clear();
+    m_edges.clear();
+    m_wanderWheel.Reset(GetTick());
+    m_expiryWheel.Reset(GetTick());
+    m_schedules.clear();
+    m_fading.clear();
+    m_motion.Invalidate();
+    m_hasMyNode = false;
+    m_isBeingDragged = false;
+}
+
+int Garden::AddMyNode()
+{
+    Clear();
+
+    GardenNode node = NewNode();
+    node.Id = NextUniqueId();
+    m_nodes.push_back(node);
+    m_schedules.push_back(NewSchedule());
+    m_hasMyNode = true;
+
+    return node.Id;
+}
+
+void Garden::SetNodeCount(int count)
+{
+    int first = m_hasMyNode ? 1 : 0;
+    if (count < first)
+        count = first;
+
+    m_nodes.resize(count);
+    m_wanderWheel.Reset(GetTick());
+    m_expiryWheel.Reset(GetTick());
+    m_schedules.assign(count, NewSchedule());
+    m_fading.clear();
+    ReserveSchedules();
+    for (int i = first; i < count; i++)
+    {
+        m_nodes[i] = NewNode();
+        ScheduleWander(i);
+    }
+
+    m_edges.clear();
+    m_motion.Invalidate();
+}
+
+int Garden::AddNode(float x, float y)
+{
+    GardenNode node = NewNode();
+    node.X = x;
+    node.Y = y;
+    node.Id = NextUniqueId();
+    m_nodes.push_back(node);
+    m_schedules.push_back(NewSchedule());
+    ReserveSchedules();
+
+    int index = (int)m_nodes.size() - 1;
+    m_motion.Wake(m_nodes, index);
+    SeeNode(index);
+
+    return node.Id;
+}
+
+bool Garden::RemoveNode(int id)
+{
+    for (size_t i = m_hasMyNode ? 1 : 0; i < m_nodes.size(); i++)
+    {
+        if (m_nodes[i].Id == id)
+        {
+            RemoveNodeAt((int)i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Garden::UpdateNodePosition(int id, float x, float y)
+{
+    size_t first = m_hasMyNode ? 1 : 0;
+
+    for (size_t i = first; i < m_nodes.size(); i++)
+    {
+        if (m_nodes[i].Id == id)
+        {
+            SetNodeTarget((int)i, x, y);
+            SeeNode((int)i);
+            return;
+        }
+    }
+
+    // adopt a node nobody owns yet before growing the garden
+    for (size_t i = first; i < m_nodes.size(); i++)
+    {
+        if (m_nodes[i].Id == -1)
+        {
+            m_nodes[i].Id = id;
+            m_wanderWheel.Cancel(m_schedules[i].Wander);
+            m_schedules[i].Wander = -1;
+            SetNodeTarget((int)i, x, y);
+            SeeNode((int)i);
+            return;
+        }
+    }
+
+    AddNode(x, y);
+    m_nodes.back().Id = id;
+}
+
+void Garden::SetNodeTarget(int index, float x, float y)
+{
+    m_nodes[index].TargetX = x;
+    m_nodes[index].TargetY = y;
+    m_motion.Wake(m_nodes, index);
+}
+
+int Garden::ReorderNodes()
+{
+    PROFILE_SCOPE("ReorderNodes");
+    ALLOCATION_PHASE("ReorderNodes");
+
+    int first = m_hasMyNode ? 1 : 0;
+    int count = (int)m_nodes.size();
+    if (count - first < 2)
+        return 0;
+
+    // the old index in the low bits breaks ties, so the order never depends on the sort
+    m_reorderKeys.resize(count - first);
+    for (int i = first; i < count; i++)
+    {
+        m_reorderKeys[i - first] = (uint64_t)MortonKey(m_nodes[i].X, m_nodes[i].Y) << 32 | (uint32_t)i;
+    }
+
+    // mostly still in order from last time, which std::sort handles well
+    std::sort(m_reorderKeys.begin(), m_reorderKeys.end());
+
+    m_reorderNodes.resize(count);
+    m_reorderSlots.resize(count);
+    int moved = 0;
+    for (int i = 0; i < first; i++)
+    {
+        m_reorderNodes[i] = m_nodes[i];
+        m_reorderSlots[i] = i;
+    }
+
+    for (int i = first; i < count; i++)
+    {
+        int old = (int)(uint32_t)m_reorderKeys[i - first];
+        m_reorderNodes[i] = m_nodes[old];
+        m_reorderSlots[old] = i;
+        if (old != i)
+            moved++;
+    }
+
+    if (moved == 0)
+        return 0;
+
+    m_nodes.swap(m_reorderNodes);
+
+    m_reorderSchedules.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        const NodeSchedule& schedule = m_schedules[i];
+        int slot = m_reorderSlots[i];
+        m_reorderSchedules[slot] = schedule;
+        if (schedule.Wander >= 0)
+            m_wanderWheel.SetItem(schedule.Wander, slot);
+        if (schedule.Expiry >= 0)
+            m_expiryWheel.SetItem(schedule.Expiry, slot);
+        if (schedule.FadeSlot >= 0)
+            m_fading[schedule.FadeSlot] = slot;
+    }
+    m_schedules.swap(m_reorderSchedules);
+    m_motion.Invalidate();
+
+    // the renderer draws the edges after Update, so any still around have to follow their nodes
+    for (size_t i = 0; i < m_edges.size(); i++)
+    {
+        GardenEdge& edge = m_edges[i];
+        int a = m_reorderSlots[edge.First];
+        int b = m_reorderSlots[edge.Second];
+        edge.First = a < b ? a : b;
+        edge.Second = a < b ? b : a;
+    }
+
+    return moved;
+}
+
+void Garden::BeginDrag(float x, float y)
+{
+    if (!m_hasMyNode)
+        return;
+
+    float dx = m_nodes[0].X - x;
+    float dy = m_nodes[0].Y - y;
+    if (sqrtf(dx * dx + dy * dy) < TouchAreaSize)
+    {
+        m_isBeingDragged = true;
+    }
+}
+
+void Garden::Drag(float x, float y)
+{
+    if (m_isBeingDragged)
+    {
+        m_nodes[0].X = x;
+        m_nodes[0].Y = y;
+    }
+}
+
+void Garden::EndDrag()
+{
+    m_isBeingDragged = false;
+}
+
+void Garden::Update(float /*timeTotal*/, float timeDelta)
+{
+    UpdateOrder();
+    UpdateNodes(timeDelta);
+    FindConnections();
+    FinishConnections();
+}
+
+void Garden::UpdateOrder()
+{
+    if (m_reorderInterval == 0 || ++m_framesSinceReorder < m_reorderInterval)
+        return;
+
+    m_framesSinceReorder = 0;
+    ReorderNodes();
+}
+
+void Garden::UpdateNodes(float timeDelta)
+{
+    PROFILE_SCOPE("UpdateNodes");
+    ALLOCATION_PHASE("UpdateNodes");
+
+    // only the wandering nodes whose wait is up do anything but move
+    m_clock += timeDelta;
+    m_wanderFired.clear();
+    m_wanderWheel.Advance(GetTick(), &m_wanderFired);
+
+    // in node order, not the order they happen to sit in their slots, so a loaded garden
+    // draws the same targets as the one it was saved from
+    std::sort(m_wanderFired.begin(), m_wanderFired.end());
+    for (size_t f = 0; f < m_wanderFired.size(); f++)
+    {
+        int index = m_wanderFired[f];
+        m_schedules[index].Wander = -1;
+        if (m_nodes[index].Id == -1)
+        {
+            RandomPosition(&m_nodes[index].TargetX, &m_nodes[index].TargetY);
+            m_motion.Wake(m_nodes, index);
+            ScheduleWander(index);
+        }
+    }
+
+    ExpireNodes();
+    m_motion.Step(m_nodes, m_hasMyNode ? 1 : 0, Speed, timeDelta);
+}
+
+void Garden::FindConnections()
+{
+    PROFILE_SCOPE("FindConnections");
+    ALLOCATION_PHASE("FindConnections");
+
+    if (m_search == ConnectionSearch_DensityField || (m_densityFieldAbove > 0 && (int)m_nodes.size() > m_densityFieldAbove))
+    {
+        m_lastSearch = ConnectionSearch_DensityField;
+        FindConnectionsEstimated();
+        return;
+    }
+
+    // a cap no node can reach keeps every pair, so the plain pass does the same for less
+    m_degree = m_maxDegree > 0 && m_maxDegree < (int)m_nodes.size() - 1 ? m_maxDegree : 0;
+    if (m_degree > 0)
+    {
+        // the neighbours are all offered before any pair is kept
+        size_t slots = m_nodes.size() * m_degree;
+        if (m_nearest.size() < slots)
+            m_nearest.resize(slots);
+        m_nearestCounts.assign(m_nodes.size(), 0);
+    }
+
+    if (m_threadCount > 1 && m_degree == 0)
+    {
+        m_lastSearch = ConnectionSearch_BruteForce;
+        FindConnectionsThreaded();
+        return;
+    }
+
+    if (m_search == ConnectionSearch_Quadtree || (m_search == ConnectionSearch_Adaptive && IsQuadtreeCheaper()))
+    {
+        m_lastSearch = ConnectionSearch_Quadtree;
+        FindConnectionsIndexed();
+        if (m_degree > 0)
+            ConnectNearest();
+        return;
+    }
+
+    m_lastSearch = ConnectionSearch_BruteForce;
+
+    const float minDistSquared = MinDist * MinDist;
+    int count = (int)m_nodes.size();
+
+    m_edges.clear();
+    m_pairsTested = (uint64_t)count * (count > 0 ? count - 1 : 0) / 2;
+
+    for (int i = 0; i < count; i++)
+    {
+        GardenNode& node1 = m_nodes[i];
+
+        for (int j = i + 1; j < count; j++)
+        {
+            GardenNode& node2 = m_nodes[j];
+
+            // calculate the distance between each 2 nodes. Most pairs are far apart, so
+            // reject on the squared distance before paying for the square root
+            float dx = node1.X - node2.X;
+            float dy = node1.Y - node2.Y;
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared >= minDistSquared)
+                continue;
+
+            float distance = sqrtf(distanceSquared);
+            if (distance >= MinDist)
+                continue;
+
+            if (m_degree > 0)
+            {
+                OfferNeighbours(i, j, distanceSquared);
+                continue;
+            }
+
+            // add a mapped value between 1-0 to each node's connectedness value
+            float connectedness = Map(distance, 0, MinDist, 1, 0);
+            ApplyConnection(node1, connectedness);
+            ApplyConnection(node2, connectedness);
+
+            GardenEdge edge = { i, j, distance };
+            m_edges.push_back(edge);
+        }
+    }
+
+    if (m_degree > 0)
+        ConnectNearest();
+}
+
+void Garden::FindConnectionsIndexed()
+{
+    const float minDistSquared = MinDist * MinDist;
+    int count = (int)m_nodes.size();
+
+    if (m_quadtree.NeedsRebuild(m_nodes))
+        m_quadtree.Build(m_nodes);
+    else
+        m_quadtree.Refit(m_nodes);
+
+    m_edges.clear();
+    m_pairsTested = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        GardenNode& node1 = m_nodes[i];
+
+        m_hits.clear();
+        m_pairsTested += m_quadtree.Query(node1.X, node1.Y, minDistSquared, i, &m_hits);
+
+        // in the order the brute force pass reaches them, so the running maximum, and with it
+        // every node's normalised value, comes out the same. Capped, the heaps keep the same
+        // nearest whatever order they're offered in, and ConnectNearest puts them in order
+        if (m_degree == 0)
+            std::sort(m_hits.begin(), m_hits.end(), [](const QuadtreeHit& a, const QuadtreeHit& b) { return a.Index < b.Index; });
+
+        for (size_t h = 0; h < m_hits.size(); h++)
+        {
+            int j = m_hits[h].Index;
+            GardenNode& node2 = m_nodes[j];
+
+            float distance = sqrtf(m_hits[h].DistanceSquared);
+            if (distance >= MinDist)
+                continue;
+
+            if (m_degree > 0)
+            {
+                OfferNeighbours(i, j, m_hits[h].DistanceSquared);
+                continue;
+            }
+
+            float connectedness = Map(distance, 0, MinDist, 1, 0);
+            ApplyConnection(node1, connectedness);
+            ApplyConnection(node2, connectedness);
+
+            GardenEdge edge = { i, j, distance };
+            m_edges.push_back(edge);
+        }
+    }
+}
+
+bool Garden::IsQuadtreeCheaper()
+{
+    // below this the whole brute force pass is a few microseconds
+    const int MinimumNodes = 128;
+    const int MaxCellsPerAxis = 128;
+
+    int count = (int)m_nodes.size();
+    if (count < MinimumNodes)
+        return false;
+
+    float minX = m_nodes[0].X, minY = m_nodes[0].Y, maxX = minX, maxY = minY;
+    for (int i = 1; i < count; i++)
+    {
+        const GardenNode& node = m_nodes[i];
+        if (node.X < minX) minX = node.X;
+        if (node.Y < minY) minY = node.Y;
+        if (node.X > maxX) maxX = node.X;
+        if (node.Y > maxY) maxY = node.Y;
+    }
+
+    // MinDist cells, made bigger when the garden is too wide for the grid to stay small
+    float cellSize = MinDist;
+    float extent = maxX - minX > maxY - minY ? maxX - minX : maxY - minY;
+    if (extent / cellSize > MaxCellsPerAxis - 1)
+        cellSize = extent / (MaxCellsPerAxis - 1);
+    if (!(cellSize > 0) || !(extent >= 0))
+        return false;
+
+    int columns = (int)((maxX - minX) / cellSize) + 1;
+    int rows = (int)((maxY - minY) / cellSize) + 1;
+    m_densityCells.assign(columns * rows, 0);
+    for (int i = 0; i < count; i++)
+    {
+        int column = (int)((m_nodes[i].X - minX) / cellSize);
+        int row = (int)((m_nodes[i].Y - minY) / cellSize);
+        m_densityCells[(row < rows ? row : rows - 1) * columns + (column < columns ? column : columns - 1)]++;
+    }
+
+    // every node in a cell against every node in the block around it: about what the tree
+    // tests, counting each pair from both ends as its queries do
+    double estimate = 0;
+    for (int row = 0; row < rows; row++)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            int cell = m_densityCells[row * columns + column];
+            if (cell == 0)
+                continue;
+
+            int block = 0;
+            for (int y = row > 0 ? row - 1 : 0; y <= row + 1 && y < rows; y++)
+            {
+                for (int x = column > 0 ? column - 1 : 0; x <= column + 1 && x < columns; x++)
+                {
+                    block += m_densityCells[y * columns + x];
+                }
+            }
+
+            estimate += (double)cell * block;
+        }
+    }
+
+    // Walking the tree, testing each pair from both ends and sorting the hits costs enough
+    // that the quadtree only wins once this is under about a tenth of the N^2/2 pairs brute
+    // force tests. That held within 20% for uniform, clustered and ring layouts from 200
+    // to 10000 nodes in GardenBench.
+    return estimate < (double)count * count / 20;
+}
+
+void Garden::FindConnectionsThreaded()
+{
+    int count = (int)m_nodes.size();
+    int threadCount = m_threadCount < count ? m_threadCount : (count > 0 ? count : 1);
+
+    m_edges.clear();
+    m_pairsTested = (uint64_t)count * (count > 0 ? count - 1 : 0);
+    m_threadEdges.resize(threadCount);
+
+    // rows are all the same length, so equal slices are equal work
+    m_pool->ForEach(threadCount, [this, count, threadCount](int t)
+    {
+        ConnectRows(count * t / threadCount, count * (t + 1) / threadCount, &m_threadEdges[t]);
+    });
+
+    for (int t = 0; t < threadCount; t++)
+    {
+        m_edges.insert(m_edges.end(), m_threadEdges[t].begin(), m_threadEdges[t].end());
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        GardenNode& node = m_nodes[i];
+
+        // nodes with nothing in range keep last frame's value, as they do single threaded
+        if (node.Connectedness > 0)
+        {
+            if (node.Connectedness > m_maxConnectedness)
+                m_maxConnectedness = node.Connectedness;
+
+            node.NormalisedConnectedness = Map(node.Connectedness, 0, m_maxConnectedness, 0, 1);
+        }
+    }
+}
+
+void Garden::FindConnectionsEstimated()
+{
+    int count = (int)m_nodes.size();
+
+    m_edges.clear();
+    m_pairsTested = 0;
+    m_densityField.Estimate(m_nodes, MinDist, &m_densitySums);
+
+    // normalised in node order, as the threaded pass does
+    for (int i = 0; i < count; i++)
+    {
+        GardenNode& node = m_nodes[i];
+        node.Connectedness += m_densitySums[i];
+
+        if (node.Connectedness > 0)
+        {
+            if (node.Connectedness > m_maxConnectedness)
+                m_maxConnectedness = node.Connectedness;
+
+            node.NormalisedConnectedness = Map(node.Connectedness, 0, m_maxConnectedness, 0, 1);
+        }
+    }
+}
+
+void Garden::ConnectRows(int first, int last, std::vector<GardenEdge>* edges)
+{
+    const float minDistSquared = MinDist * MinDist;
+    int count = (int)m_nodes.size();
+
+    edges->clear();
+
+    for (int i = first; i < last; i++)
+    {
+        GardenNode& node1 = m_nodes[i];
+        float connectedness = 0;
+
+        // the whole row, lowest index first, adds up in the same order the single threaded
+        // pass reaches this node in
+        for (int j = 0; j < count; j++)
+        {
+            if (j == i)
+                continue;
+
+            const GardenNode& node2 = m_nodes[j];
+            float dx = node1.X - node2.X;
+            float dy = node1.Y - node2.Y;
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared >= minDistSquared)
+                continue;
+
+            float distance = sqrtf(distanceSquared);
+            if (distance >= MinDist)
+                continue;
+
+            connectedness += Map(distance, 0, MinDist, 1, 0);
+
+            if (j > i)
+            {
+                GardenEdge edge = { i, j, distance };
+                edges->push_back(edge);
+            }
+        }
+
+        node1.Connectedness = connectedness;
+    }
+}
+
+// A neighbour's squared distance above its index: distances are never negative, so their bits
+// order the same way the floats do, and the lower index wins a tie
+static uint64_t NeighbourKey(float distanceSquared, int index)
+{
+    uint32_t bits;
+    memcpy(&bits, &distanceSquared, sizeof(bits));
+    return (uint64_t)bits << 32 | (uint32_t)index;
+}
+
+void Garden::OfferNeighbours(int first, int second, float distanceSquared)
+{
+    int ends[2] = { first, second };
+    uint64_t keys[2] = { NeighbourKey(distanceSquared, second), NeighbourKey(distanceSquared, first) };
+
+    for (int end = 0; end < 2; end++)
+    {
+        // the farthest of the nearest so far sits on top, and is the one a closer node replaces
+        uint64_t key = keys[end];
+        uint64_t* heap = &m_nearest[(size_t)ends[end] * m_degree];
+        int& size = m_nearestCounts[ends[end]];
+        if (size < m_degree)
+        {
+            heap[size++] = key;
+            std::push_heap(heap, heap + size);
+            continue;
+        }
+        if (key >= heap[0])
+            continue;
+
+        // sift the new key down from the top in one pass, rather than a pop and a push
+        int at = 0;
+        for (;;)
+        {
+            int child = at * 2 + 1;
+            if (child >= size)
+                break;
+            if (child + 1 < size && heap[child + 1] > heap[child])
+                child++;
+            if (heap[child] <= key)
+                break;
+
+            heap[at] = heap[child];
+            at = child;
+        }
+        heap[at] = key;
+    }
+}
+
+void Garden::ConnectNearest()
+{
+    int count = (int)m_nodes.size();
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint64_t* heap = &m_nearest[(size_t)i * m_degree];
+
+        // each pair once, from its lower end, and only if i made the other node's cut too. A
+        // heap holds the smallest keys it was offered, so i is in j's when j's isn't full or
+        // i's key is no bigger than j's largest
+        m_nearestEdges.clear();
+        for (int n = 0; n < m_nearestCounts[i]; n++)
+        {
+            int j = (int)(uint32_t)heap[n];
+            if (j < i)
+                continue;
+
+            uint64_t reverse = (heap[n] & 0xFFFFFFFF00000000ull) | (uint32_t)i;
+            if (m_nearestCounts[j] < m_degree || reverse <= m_nearest[(size_t)j * m_degree])
+                m_nearestEdges.push_back((uint64_t)j << 32 | (heap[n] >> 32));
+        }
+
+        // in the order the uncapped pass reaches them
+        std::sort(m_nearestEdges.begin(), m_nearestEdges.end());
+
+        for (size_t e = 0; e < m_nearestEdges.size(); e++)
+        {
+            int j = (int)(m_nearestEdges[e] >> 32);
+            uint32_t bits = (uint32_t)m_nearestEdges[e];
+            float distanceSquared;
+            memcpy(&distanceSquared, &bits, sizeof(distanceSquared));
+
+            float distance = sqrtf(distanceSquared);
+            float connectedness = Map(distance, 0, MinDist, 1, 0);
+            ApplyConnection(m_nodes[i], connectedness);
+            ApplyConnection(m_nodes[j], connectedness);
+
+            GardenEdge edge = { i, j, distance };
+            m_edges.push_back(edge);
+        }
+    }
+}
+
+void Garden::ApplyConnection(GardenNode& node, float connectedness)
+{
+    // increase the connectedness
+    node.Connectedness += connectedness;
+
+    // this allows us to get a reliable value for MaxConnectedness. Used for Mapping the Connectedness value
+    if (node.Connectedness > m_maxConnectedness)
+        m_maxConnectedness = node.Connectedness;
+
+    // create a normalised version of the Connectedness variable
+    node.NormalisedConnectedness = Map(node.Connectedness, 0, m_maxConnectedness, 0, 1);
+}
+
+void Garden::FinishConnections()
+{
+    PROFILE_SCOPE("FinishConnections");
+    ALLOCATION_PHASE("FinishConnections");
+
+    size_t count = m_nodes.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        GardenNode& node = m_nodes[i];
+
+        // the outline grows from last frame's size
+        node.OutlineSize = node.Size + Map(node.NormalisedConnectedness, 0, 1, (float)EllipseOutlineMin, (float)EllipseOutlineMax);
+        node.Shadow1Size = node.NormalisedConnectedness * Shadow1Multiplier;
+        node.Shadow2Size = node.NormalisedConnectedness * Shadow2Multiplier;
+
+        // calculate the node size from NormalisedConnectedness
+        node.Size = Map(node.NormalisedConnectedness, 0, 1, (float)NodeSizeMin, (float)NodeSizeMax);
+        node.Connectedness = 0;
+
+        // decay once per node per frame so a burst of connections doesn't pin the scale forever
+        m_maxConnectedness -= 0.00001f;
+    }
+}
+
+bool Garden::HasMyNode() const
+{
+    return m_hasMyNode;
+}
+
+int Garden::GetNodeCount() const
+{
+    return (int)m_nodes.size();
+}
+
+const std::vector<GardenNode>& Garden::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<GardenEdge>& Garden::GetEdges() const
+{
+    return m_edges;
+}
+
+uint64_t Garden::GetPairsTested() const
+{
+    return m_pairsTested;
+}
+
+float Garden::Map(float value, float start1, float end1, float start2, float end2)
+{
+    return (start2 + ((value - start1) / (end1 - start1) * (end2 - start2)));
+}
+
+float Garden::GetDrawRadius(const GardenNode& node)
+{
+    float largest = node.Shadow2Size;
+    if (node.Size > largest)
+        largest = node.Size;
+    if (node.OutlineSize > largest)
+        largest = node.OutlineSize;
+
+    return largest / 2;
+}
+
+GardenNode Garden::NewNode()
+{
+    GardenNode node;
+    RandomPosition(&node.X, &node.Y);
+    RandomPosition(&node.TargetX, &node.TargetY);
+    node.Size = (float)NodeSizeMax;
+    node.OutlineSize = 0;
+    node.Shadow1Size = 0;
+    node.Shadow2Size = 0;
+    node.Connectedness = 0;
+    node.NormalisedConnectedness = 0;
+    node.Opacity = 1;
+    node.Id = -1;
+
+    return node;
+}
+
+Garden::NodeSchedule Garden::NewSchedule() const
+{
+    NodeSchedule schedule;
+    schedule.Wander = -1;
+    schedule.Expiry = -1;
+    schedule.LastSeen = m_clock;
+    schedule.FadeStart = -1;
+    schedule.FadeSlot = -1;
+
+    return schedule;
+}
+
+// a node has at most one timer on each wheel and one place in m_fading, so room for as many
+// nodes as m_nodes has keeps UpdateNodes from allocating as timers fire and are rescheduled
+void Garden::ReserveSchedules()
+{
+    int nodes = (int)m_nodes.capacity();
+    m_wanderWheel.Reserve(nodes);
+    m_wanderFired.reserve(nodes);
+    m_expiryWheel.Reserve(nodes);
+    m_expiryFired.reserve(nodes);
+    m_fading.reserve(nodes);
+}
+
+void Garden::ScheduleWander(int index)
+{
+    // inverse transform of a uniform draw; the clamp keeps the log finite, at some 16 intervals
+    float uniform = Random(1);
+    double wait = -log(1.0 - uniform * 0.9999999) * WanderInterval;
+    uint64_t ticks = (uint64_t)(wait * TicksPerSecond + 0.5);
+    m_schedules[index].Wander = m_wanderWheel.Schedule(GetTick() + ticks, index);
+}
+
+bool Garden::IsRemote(int index) const
+{
+    return m_nodes[index].Id != -1 && !(m_hasMyNode && index == 0);
+}
+
+void Garden::ScheduleExpiry(int index, double at)
+{
+    // rounded up, so a timer never fires before the time it stands for
+    uint64_t due = (uint64_t)ceil(at * TicksPerSecond);
+    m_schedules[index].Expiry = m_expiryWheel.Schedule(due, index);
+}
+
+void Garden::SeeNode(int index)
+{
+    NodeSchedule& schedule = m_schedules[index];
+    schedule.LastSeen = m_clock;
+    if (m_nodeExpiry == 0)
+        return;
+
+    // a timer already waiting moves itself out when it comes due
+    if (schedule.FadeSlot >= 0)
+    {
+        StopFading(index);
+        m_expiryWheel.Cancel(schedule.Expiry);
+        schedule.Expiry = -1;
+    }
+    if (schedule.Expiry < 0)
+        ScheduleExpiry(index, m_clock + m_nodeExpiry);
+}
+
+void Garden::ExpireNodes()
+{
+    m_expiryFired.clear();
+    m_expiryWheel.Advance(GetTick(), &m_expiryFired);
+
+    // highest index first, so moving the last node in to a removed one's place never moves
+    // one still to be looked at
+    std::sort(m_expiryFired.begin(), m_expiryFired.end(), std::greater<int>());
+    for (size_t f = 0; f < m_expiryFired.size(); f++)
+    {
+        int index = m_expiryFired[f];
+        NodeSchedule& schedule = m_schedules[index];
+        schedule.Expiry = -1;
+
+        if (schedule.FadeSlot >= 0)
+            RemoveNodeAt(index);
+        else if (m_clock - schedule.LastSeen >= m_nodeExpiry)
+        {
+            StartFading(index);
+            ScheduleExpiry(index, m_clock + NodeFadeTime);
+        }
+        else
+            ScheduleExpiry(index, schedule.LastSeen + m_nodeExpiry);
+    }
+
+    for (size_t i = 0; i < m_fading.size(); i++)
+    {
+        int index = m_fading[i];
+        float faded = (float)((m_clock - m_schedules[index].FadeStart) / NodeFadeTime);
+        m_nodes[index].Opacity = faded < 1 ? 1 - faded : 0;
+    }
+}
+
+void Garden::StartFading(int index)
+{
+    NodeSchedule& schedule = m_schedules[index];
+    schedule.FadeStart = m_clock;
+    schedule.FadeSlot = (int)m_fading.size();
+    m_fading.push_back(index);
+}
+
+void Garden::StopFading(int index)
+{
+    NodeSchedule& schedule = m_schedules[index];
+    if (schedule.FadeSlot < 0)
+        return;
+
+    int moved = m_fading.back();
+    m_fading[schedule.FadeSlot] = moved;
+    m_schedules[moved].FadeSlot = schedule.FadeSlot;
+    m_fading.pop_back();
+
+    schedule.FadeStart = -1;
+    schedule.FadeSlot = -1;
+    m_nodes[index].Opacity = 1;
+}
+
+void Garden::RemoveNodeAt(int index)
+{
+    int last = (int)m_nodes.size() - 1;
+    StopFading(index);
+    m_wanderWheel.Cancel(m_schedules[index].Wander);
+    m_expiryWheel.Cancel(m_schedules[index].Expiry);
+
+    // the last node takes its place, and its timers are told where it went
+    if (index != last)
+    {
+        m_nodes[index] = m_nodes[last];
+        NodeSchedule& schedule = m_schedules[index];
+        schedule = m_schedules[last];
+        if (schedule.Wander >= 0)
+            m_wanderWheel.SetItem(schedule.Wander, index);
+        if (schedule.Expiry >= 0)
+            m_expiryWheel.SetItem(schedule.Expiry, index);
+        if (schedule.FadeSlot >= 0)
+            m_fading[schedule.FadeSlot] = index;
+    }
+
+    m_nodes.pop_back();
+    m_schedules.pop_back();
+    m_motion.Remove(index, last);
+
+    // edges index the old layout; the next connection pass rebuilds them
+    m_edges.clear();
+}
+
+uint64_t Garden::GetTick() const
+{
+    return (uint64_t)(m_clock * TicksPerSecond);
+}
+
+void Garden::RandomPosition(float* x, float* y)
+{
+    *x = NodeSizeMax + Random(m_width - 2 * NodeSizeMax);
+    *y = NodeSizeMax + Random(m_height - 2 * NodeSizeMax);
+}
+
+int Garden::NextUniqueId()
+{
+    return m_nextId++;
+}
+
+uint32_t Garden::MortonKey(float x, float y) const
+{
+    // 16 bits an axis across the garden; anything outside it is clamped to the border
+    uint32_t cell[2];
+    float position[2] = { m_width > 0 ? x / m_width : 0, m_height > 0 ? y / m_height : 0 };
+    for (int axis = 0; axis < 2; axis++)
+    {
+        float scaled = position[axis] * 65535.0f;
+        cell[axis] = scaled > 0 ? (scaled < 65535.0f ? (uint32_t)scaled : 65535u) : 0;
+
+        // spread the 16 bits to the even bits
+        uint32_t v = cell[axis];
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        cell[axis] = v;
+    }
+
+    return cell[0] | (cell[1] << 1);
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "Quadtree.h"
+#include "DensityField.h"
+#include "TaskPool.h"
+#include "TimerWheel.h"
+#include "MotionIntegrator.h"
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+// One node of the garden. Plain data so the simulation can be stepped, and measured,
+// without a device; XTKRenderer draws from these after each Update.
+struct GardenNode
+{
+    float X;                        // current position
+    float Y;
+    float TargetX;                  // where the node is easing towards
+    float TargetY;
+    float Size;
+    float OutlineSize;
+    float Shadow1Size;
+    float Shadow2Size;
+    float Connectedness;            // summed during the connection pass, cleared when finished
+    float NormalisedConnectedness;
+    float Opacity;                  // 1, falling to 0 while a silent remote node fades out
+    int Id;                         // -1 until someone owns the node; unowned nodes wander
+};
+
+// Two nodes close enough to be joined this frame, as indices into the node list
+struct GardenEdge
+{
+    int First;
+    int Second;
+    float Distance;
+};
+
+// How the connection pass finds the pairs within MinDist. The first three give the same edges
+// and sums, bit for bit; they only differ in how many pairs they test to find them.
+enum ConnectionSearch
+{
+    ConnectionSearch_BruteForce,    // every pair
+    ConnectionSearch_Quadtree,      // each node's neighbours from a Quadtree
+    ConnectionSearch_Adaptive,      // whichever of the two the node density says is cheaper
+    ConnectionSearch_DensityField,  // no pairs at all: sums estimated by a DensityField, and no edges
+};
+
+// Everything a frame of the simulation depends on, so a recording can start mid-session
+struct GardenState
+{
+    std::vector<GardenNode> Nodes;
+    float Width;
+    float Height;
+    float MaxConnectedness;
+    uint32_t RandomState;
+    int NextId;
+    int ReorderInterval;
+    int FramesSinceReorder;
+    int MaxDegree;
+    int DensityFieldAbove;
+    int DensityFieldResolution;
+    float NodeExpiry;
+    double Clock;
+    std::vector<uint64_t> WanderDue;        // by node, the tick its next retarget is due, 0 for none
+    std::vector<uint64_t> ExpiryDue;        // by node, the tick its expiry timer is due, 0 for none
+    std::vector<double> LastSeen;           // by node, the clock when it was last added or moved
+    std::vector<double> FadeStart;          // by node, the clock when it began fading, -1 if it isn't
+    bool HasMyNode;
+    bool IsBeingDragged;
+};
+
+// The node garden simulation. Each frame runs three steps: UpdateNodes moves every node, and
+// fades out remote nodes gone silent if SetNodeExpiry asks it to, FindConnections tests the
+// pairs and accumulates connectedness, and FinishConnections turns that in to sizes. When
+// there is a local node it is always node 0; it only moves when dragged. Nodes are otherwise
+// in no particular order, and may be reordered; ids, not indices, name a node from one frame
+// to the next.
+class Garden
+{
+public:
+    Garden(void);
+    ~Garden(void) {};
+
+    void SetSize(float width, float height);
+    float GetWidth() const;
+    float GetHeight() const;
+
+    // same seed, same calls, same garden
+    void SetSeed(uint32_t seed);
+
+    // Threads for the connection pass, 1 by default. With more than one each thread walks whole
+    // rows, so every pair is tested twice but no two threads write the same node. Sums and edges
+    // come out the same as the single thread pass; the normalisation uses the running maximum
+    // in node order instead of pair order, so a run is repeatable for any count above 1 but
+    // doesn't match a single threaded run bit for bit. The extra threads are a TaskPool started
+    // here, not threads started every frame.
+    void SetThreadCount(int count);
+    int GetThreadCount() const;
+
+    // Sort the nodes along a Morton curve every this many frames, 0 (the default) for never.
+    // Nodes added, removed and wandering leave the list in no spatial order, so nodes close in
+    // the garden are far apart in memory; sorting puts each node's neighbours, and the two
+    // ends of most edges, on nearby cache lines.
+    void SetReorderInterval(int frames);
+    int GetReorderInterval() const;
+
+    // Adaptive by default. Each frame the adaptive search bins the nodes in to MinDist sized
+    // cells and estimates the pairs a quadtree would test from the counts in each 3x3 block;
+    // when that comes close to testing everything, as with everyone in one spot, the plain
+    // pass is cheaper. The threaded pass is always brute force.
+    void SetConnectionSearch(ConnectionSearch search);
+    ConnectionSearch GetConnectionSearch() const;
+    ConnectionSearch GetLastSearch() const;     // what the last connection pass used
+    const Quadtree& GetQuadtree() const;
+
+    // Keep at most this many connections per node, 0 (the default) for no limit. A pair is only
+    // joined while each node is among the other's degree nearest, so both ends agree on every
+    // edge, no node goes over, and crowds thin out to their closest neighbours instead of
+    // every node joining every other. Ties in distance go to the lower index. Capping runs the
+    // single threaded pass, whatever the thread count.
+    void SetMaxDegree(int degree);
+    int GetMaxDegree() const;
+
+    // Estimate connectedness from a DensityField instead of testing pairs once there are more
+    // than this many nodes, 0 (the default) for never. Sizes come out close to the exact pass
+    // for a fraction of the cost in a crowd, but nothing is joined, so there are no edges to
+    // draw, and a degree cap has nothing to apply to. Setting the search to DensityField
+    // estimates at any count.
+    void SetDensityFieldAbove(int count);
+    int GetDensityFieldAbove() const;
+    // grid cells per MinDist, DensityField::DefaultResolution by default; see DensityField
+    void SetDensityFieldResolution(int cells);
+    int GetDensityFieldResolution() const;
+
+    // Fade out and remove a remote node once it hasn't been added or moved for this many
+    // seconds, 0 (the default) for never. A peer that leaves without saying so would otherwise
+    // stay forever, drawn and tested against every frame. Each remote node keeps the clock it
+    // was last seen at and one timer in a TimerWheel; seeing it again only updates the clock,
+    // and the timer moves out to the new deadline when it comes due. A node that goes silent
+    // for the whole time fades over NodeFadeTime, unless it's seen again first, and is then
+    // removed by moving the last node in to its place. Setting this restarts every deadline
+    // from each node's last seen, and brings back any node fading out.
+    void SetNodeExpiry(float seconds);
+    float GetNodeExpiry() const;
+
+    void SaveState(GardenState* state) const;
+    void LoadState(const GardenState& state);
+
+    // hash of the node state and edge count, to spot the first frame two runs diverge
+    uint32_t Checksum() const;
+
+    void Clear();
+    int AddMyNode();
+
+    // keeps the local node and replaces everything else with count-1 wandering nodes
+    void SetNodeCount(int count);
+
+    // a remote node at a position. Returns the id it was given
+    int AddNode(float x, float y);
+    // false if no remote node has that id. The last node moves in to its place
+    bool RemoveNode(int id);
+    void UpdateNodePosition(int id, float x, float y);
+    void SetNodeTarget(int index, float x, float y);
+
+    // sorts every node but the local one by its Morton key now, remapping the edges to match.
+    // Returns how many nodes moved
+    int ReorderNodes();
+
+    void BeginDrag(float x, float y);
+    void Drag(float x, float y);
+    void EndDrag();
+
+    void Update(float timeTotal, float timeDelta);
+    void UpdateOrder();                     // reorders when the interval is up
+    void UpdateNodes(float timeDelta);
+    void FindConnections();
+    void FinishConnections();
+
+    bool HasMyNode() const;
+    int GetNodeCount() const;
+    const std::vector<GardenNode>& GetNodes() const;
+    const std::vector<GardenEdge>& GetEdges() const;
+    uint64_t GetPairsTested() const;
+
+    // uniform in [0, max]
+    float Random(float max);
+
+    static float Map(float value, float start1, float end1, float start2, float end2);
+
+    // half the size of the largest ellipse drawn for a node
+    static float GetDrawRadius(const GardenNode& node);
+
+    static const float MinDist;                 // minimum distance between 2 nodes for a connection
+    static const float Speed;
+    static const int NodeSizeMin = 20;          // the Connectedness value determins the node size. This number is between nodeSizeMin and nodeSizeMax
+    static const int NodeSizeMax = 50;
+    static const int Shadow1Multiplier = 85;    // shadow 1 size
+    static const int Shadow2Multiplier = 110;   // shadow 2 size
+    static const int EllipseOutlineMin = 4;     // minimum thickness for the ellipse outline. Mapped using Connectedness
+    static const int EllipseOutlineMax = 12;
+    static const int TouchAreaSize = 60;
+
+    // Wandering nodes pick a new target at random moments, on average this many seconds apart:
+    // the rate the old one in a thousand chance every frame gave at 60Hz, now whatever the
+    // frame rate. The waits are exponential and kept in a TimerWheel counting TicksPerSecond,
+    // so a frame only touches the nodes whose wait is up.
+    static const float WanderInterval;
+    static const float NodeFadeTime;            // seconds an expiring node takes to fade out
+    static const int TicksPerSecond = 60;       // of the garden clock, for both timer wheels
+
+private:
+    // what the garden keeps about each node beside the node itself
+    struct NodeSchedule
+    {
+        int Wander;                             // its retarget timer, -1 for none
+        int Expiry;                             // its expiry timer, -1 for none
+        double LastSeen;
+        double FadeStart;                       // -1 unless fading
+        int FadeSlot;                           // where it is in m_fading, -1 unless fading
+    };
+
+    GardenNode NewNode();
+    NodeSchedule NewSchedule() const;
+    void ReserveSchedules();
+    void ScheduleWander(int index);
+    bool IsRemote(int index) const;
+    void ScheduleExpiry(int index, double at);
+    void SeeNode(int index);
+    void ExpireNodes();
+    void StartFading(int index);
+    void StopFading(int index);
+    void RemoveNodeAt(int index);
+    uint64_t GetTick() const;
+    void RandomPosition(float* x, float* y);
+    void ApplyConnection(GardenNode& node, float connectedness);
+    void FindConnectionsThreaded();
+    void FindConnectionsIndexed();
+    void FindConnectionsEstimated();
+    bool IsQuadtreeCheaper();
+    void ConnectRows(int first, int last, std::vector<GardenEdge>* edges);
+    void OfferNeighbours(int first, int second, float distanceSquared);
+    void ConnectNearest();
+    int NextUniqueId();
+    uint32_t MortonKey(float x, float y) const;
+
+    float m_width;
+    float m_height;
+    uint32_t m_randomState;
+    int m_nextId;
+
+    std::vector<GardenNode> m_nodes;
+    std::vector<GardenEdge> m_edges;
+    std::vector<std::vector<GardenEdge> > m_threadEdges;
+    int m_threadCount;
+    std::unique_ptr<TaskPool> m_pool;           // the other threadCount - 1 threads, kept between frames
+    uint64_t m_pairsTested;
+    float m_maxConnectedness;
+
+    int m_reorderInterval;
+    int m_framesSinceReorder;
+    std::vector<uint64_t> m_reorderKeys;        // Morton key above the old index, reused
+    std::vector<GardenNode> m_reorderNodes;
+    std::vector<int> m_reorderSlots;            // new index by old
+    std::vector<NodeSchedule> m_reorderSchedules;
+
+    double m_clock;                             // seconds the garden has been updated for
+    std::vector<NodeSchedule> m_schedules;      // by node
+    TimerWheel m_wanderWheel;                   // retargets, by node index
+    std::vector<int> m_wanderFired;
+
+    float m_nodeExpiry;
+    TimerWheel m_expiryWheel;                   // deadlines and ends of fades, by node index
+    std::vector<int> m_expiryFired;
+    std::vector<int> m_fading;                  // the nodes fading out, in no particular order
+
+    MotionIntegrator m_motion;                  // told whenever a node's position or target moves
+
+    ConnectionSearch m_search;
+    ConnectionSearch m_lastSearch;
+    Quadtree m_quadtree;
+    std::vector<QuadtreeHit> m_hits;
+    std::vector<int> m_densityCells;
+
+    int m_maxDegree;
+    int m_degree;                               // what this pass caps at, 0 when the cap can't bind
+    std::vector<uint64_t> m_nearest;            // per node, a max heap of up to m_maxDegree neighbour keys
+    std::vector<int> m_nearestCounts;
+    std::vector<uint64_t> m_nearestEdges;       // one node's kept neighbours, reused
+
+    int m_densityFieldAbove;
+    DensityField m_densityField;
+    std::vector<float> m_densitySums;
+
+    bool m_hasMyNode;
+    bool m_isBeingDragged;
+};
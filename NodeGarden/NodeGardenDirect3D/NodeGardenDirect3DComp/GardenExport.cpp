@@ -0,0 +1,357 @@
+#include "GardenExport.h"
+#include <atomic>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    const uint32_t NoSlot = 0xffffffff;
+
+    // Both headers are a cache line so the sequence a reader spins on doesn't share one with
+    // the data being written
+    struct RegionHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t NodeCapacity;
+        uint32_t EdgeCapacity;
+        uint32_t SlotSize;
+        std::atomic<uint32_t> Latest;
+        uint8_t Reserved[40];
+    };
+
+    struct SlotHeader
+    {
+        std::atomic<uint32_t> Sequence;     // odd while the writer is in the slot
+        uint32_t NodeCount;
+        uint32_t EdgeCount;
+        uint32_t TotalNodes;
+        uint32_t TotalEdges;
+        float Width;
+        float Height;
+        uint32_t Reserved0;
+        uint64_t Frame;
+        uint8_t Reserved[24];
+    };
+
+    size_t RoundUp(size_t size)
+    {
+        return (size + 63) & ~(size_t)63;
+    }
+
+    RegionHeader* Header(uint8_t* region)
+    {
+        return (RegionHeader*)region;
+    }
+
+    SlotHeader* Slot(uint8_t* region, size_t slotSize, uint32_t index)
+    {
+        return (SlotHeader*)(region + sizeof(RegionHeader) + slotSize * index);
+    }
+}
+
+GardenExport::GardenExport(void)
+{
+    m_region = nullptr;
+    m_size = 0;
+    m_slotSize = 0;
+    m_writing = 0;
+    m_frame = 0;
+    m_owner = false;
+    m_handle = nullptr;
+}
+
+GardenExport::~GardenExport(void)
+{
+    Close();
+}
+
+bool GardenExport::Create(const std::string& name, uint32_t nodeCapacity, uint32_t edgeCapacity)
+{
+    Close();
+
+    size_t slotSize = RoundUp(sizeof(SlotHeader) + nodeCapacity * sizeof(GardenExportNode) + edgeCapacity * sizeof(GardenExportEdge));
+    if (!Map(name, sizeof(RegionHeader) + slotSize * 2, true))
+        return false;
+
+    m_owner = true;
+    m_slotSize = slotSize;
+    m_frame = 0;
+
+    RegionHeader* header = Header(m_region);
+    header->Version = Version;
+    header->NodeCapacity = nodeCapacity;
+    header->EdgeCapacity = edgeCapacity;
+    header->SlotSize = (uint32_t)slotSize;
+    header->Latest.store(NoSlot, std::memory_order_relaxed);
+    Slot(m_region, slotSize, 0)->Sequence.store(0, std::memory_order_relaxed);
+    Slot(m_region, slotSize, 1)->Sequence.store(0, std::memory_order_relaxed);
+
+    // readers check the magic before trusting anything else
+    std::atomic_thread_fence(std::memory_order_release);
+    header->Magic = Magic;
+
+    return true;
+}
+
+bool GardenExport::Open(const std::string& name)
+{
+    Close();
+
+    if (!Map(name, 0, false))
+        return false;
+
+    RegionHeader* header = Header(m_region);
+    bool valid = m_size >= sizeof(RegionHeader) && header->Magic == Magic && header->Version == Version;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    size_t slotSize = valid ? header->SlotSize : 0;
+    if (!valid || slotSize < sizeof(SlotHeader) ||
+        RoundUp(sizeof(SlotHeader) + header->NodeCapacity * sizeof(GardenExportNode) + header->EdgeCapacity * sizeof(GardenExportEdge)) != slotSize ||
+        m_size < sizeof(RegionHeader) + slotSize * 2)
+    {
+        Close();
+        return false;
+    }
+
+    m_slotSize = slotSize;
+    return true;
+}
+
+void GardenExport::Close()
+{
+    if (m_region == nullptr)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_region);
+    CloseHandle((HANDLE)m_handle);
+#else
+    munmap(m_region, m_size);
+    if (m_owner)
+        shm_unlink(m_name.c_str());
+#endif
+
+    m_region = nullptr;
+    m_handle = nullptr;
+    m_size = 0;
+    m_owner = false;
+}
+
+bool GardenExport::IsOpen() const
+{
+    return m_region != nullptr;
+}
+
+void GardenExport::BeginFrame(GardenExportSlot* slot)
+{
+    RegionHeader* header = Header(m_region);
+    uint32_t latest = header->Latest.load(std::memory_order_relaxed);
+    m_writing = latest == 0 ? 1 : 0;
+
+    SlotHeader* target = Slot(m_region, m_slotSize, m_writing);
+    uint32_t sequence = target->Sequence.load(std::memory_order_relaxed);
+    target->Sequence.store(sequence + 1, std::memory_order_relaxed);
+
+    // the odd sequence has to be visible before any of the writes it guards
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* data = (uint8_t*)target + sizeof(SlotHeader);
+    slot->Nodes = (GardenExportNode*)data;
+    slot->Edges = (GardenExportEdge*)(data + header->NodeCapacity * sizeof(GardenExportNode));
+    slot->NodeCapacity = header->NodeCapacity;
+    slot->EdgeCapacity = header->EdgeCapacity;
+}
+
+uint64_t GardenExport::EndFrame(float width, float height, uint32_t nodeCount, uint32_t edgeCount, uint32_t totalNodes, uint32_t totalEdges)
+{
+    RegionHeader* header = Header(m_region);
+    SlotHeader* target = Slot(m_region, m_slotSize, m_writing);
+
+    target->NodeCount = nodeCount;
+    target->EdgeCount = edgeCount;
+    target->TotalNodes = totalNodes;
+    target->TotalEdges = totalEdges;
+    target->Width = width;
+    target->Height = height;
+    target->Frame = ++m_frame;
+
+    target->Sequence.store(target->Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    header->Latest.store(m_writing, std::memory_order_release);
+
+    return m_frame;
+}
+
+uint64_t GardenExport::Publish(const Garden& garden)
+{
+    GardenExportSlot slot;
+    BeginFrame(&slot);
+
+    const std::vector<GardenNode>& nodes = garden.GetNodes();
+    uint32_t nodeCount = nodes.size() < slot.NodeCapacity ? (uint32_t)nodes.size() : slot.NodeCapacity;
+    for (uint32_t i = 0; i < nodeCount; i++)
+    {
+        slot.Nodes[i].X = nodes[i].X;
+        slot.Nodes[i].Y = nodes[i].Y;
+        slot.Nodes[i].Size = nodes[i].Size;
+        slot.Nodes[i].Id = nodes[i].Id;
+    }
+
+    // an edge to a node that didn't fit would point past the list, so those are left out too
+    const std::vector<GardenEdge>& edges = garden.GetEdges();
+    uint32_t edgeCount = 0;
+    for (size_t i = 0; i < edges.size() && edgeCount < slot.EdgeCapacity; i++)
+    {
+        if ((uint32_t)edges[i].Second >= nodeCount)
+            continue;
+
+        slot.Edges[edgeCount].First = (uint32_t)edges[i].First;
+        slot.Edges[edgeCount].Second = (uint32_t)edges[i].Second;
+        edgeCount++;
+    }
+
+    return EndFrame(garden.GetWidth(), garden.GetHeight(), nodeCount, edgeCount, (uint32_t)nodes.size(), (uint32_t)edges.size());
+}
+
+bool GardenExport::Read(GardenExportFrame* frame, int attempts) const
+{
+    RegionHeader* header = Header(m_region);
+    uint32_t nodeCapacity = header->NodeCapacity;
+    uint32_t edgeCapacity = header->EdgeCapacity;
+
+    for (int attempt = 0; attempt < attempts; attempt++)
+    {
+        uint32_t latest = header->Latest.load(std::memory_order_acquire);
+        if (latest > 1)
+            return false;
+
+        SlotHeader* source = Slot(m_region, m_slotSize, latest);
+        uint32_t before = source->Sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+            continue;
+
+        // everything read here may be torn; the counts are clamped so a torn copy is only
+        // wrong, never out of bounds, and the sequence check below throws it away
+        SlotHeader copy;
+        memcpy((uint8_t*)&copy + sizeof(copy.Sequence), (uint8_t*)source + sizeof(copy.Sequence), sizeof(SlotHeader) - sizeof(copy.Sequence));
+        uint32_t nodeCount = copy.NodeCount < nodeCapacity ? copy.NodeCount : nodeCapacity;
+        uint32_t edgeCount = copy.EdgeCount < edgeCapacity ? copy.EdgeCount : edgeCapacity;
+
+        const uint8_t* data = (const uint8_t*)source + sizeof(SlotHeader);
+        frame->Nodes.resize(nodeCount);
+        frame->Edges.resize(edgeCount);
+        if (nodeCount > 0)
+            memcpy(&frame->Nodes[0], data, nodeCount * sizeof(GardenExportNode));
+        if (edgeCount > 0)
+            memcpy(&frame->Edges[0], data + nodeCapacity * sizeof(GardenExportNode), edgeCount * sizeof(GardenExportEdge));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source->Sequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        frame->Frame = copy.Frame;
+        frame->Width = copy.Width;
+        frame->Height = copy.Height;
+        frame->TotalNodes = copy.TotalNodes;
+        frame->TotalEdges = copy.TotalEdges;
+        return true;
+    }
+
+    return false;
+}
+
+bool GardenExport::Map(const std::string& name, size_t size, bool create)
+{
+    m_name = name;
+
+#if defined(_WIN32)
+    std::wstring wideName(name.begin(), name.end());
+    HANDLE mapping;
+    void* view;
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    if (create)
+        mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, wideName.c_str());
+    else
+        mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, wideName.c_str());
+    if (mapping == nullptr)
+        return false;
+
+    view = MapViewOfFile(mapping, create ? FILE_MAP_READ | FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+#else
+    // the phone only lets an app create mappings, in its own namespace; monitors read them
+    // from the desktop side when the app runs in the emulator
+    if (!create)
+        return false;
+
+    mapping = CreateFileMappingFromApp(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, size, wideName.c_str());
+    if (mapping == nullptr)
+        return false;
+
+    view = MapViewOfFileFromApp(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0);
+#endif
+
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    if (!create)
+    {
+        MEMORY_BASIC_INFORMATION info;
+        size = VirtualQuery(view, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+    }
+
+    m_handle = mapping;
+    m_region = (uint8_t*)view;
+    m_size = size;
+    return true;
+#else
+    int fd = create ? shm_open(name.c_str(), O_CREAT | O_RDWR, 0644) : shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    if (create)
+    {
+        // a region left by a writer that crashed is reset rather than reused
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+    }
+    else
+    {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+    }
+
+    void* view = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        if (create)
+            shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_region = (uint8_t*)view;
+    m_size = size;
+    return true;
+#endif
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Garden.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+struct GardenExportNode
+{
+    float X;
+    float Y;
+    float Size;
+    int Id;
+};
+
+struct GardenExportEdge
+{
+    uint32_t First;             // indices in to the frame's nodes
+    uint32_t Second;
+};
+
+// One complete frame as a reader copied it out
+struct GardenExportFrame
+{
+    uint64_t Frame;             // counts up from 1 with every publish
+    float Width;
+    float Height;
+    uint32_t TotalNodes;        // before the region's capacity cut the lists short
+    uint32_t TotalEdges;
+    std::vector<GardenExportNode> Nodes;
+    std::vector<GardenExportEdge> Edges;
+};
+
+// Where a writer fills in the next frame, straight in to the shared region
+struct GardenExportSlot
+{
+    GardenExportNode* Nodes;
+    GardenExportEdge* Edges;
+    uint32_t NodeCapacity;
+    uint32_t EdgeCapacity;
+};
+
+// A named shared memory region holding the latest garden frame for other processes.
+//
+// There are two slots, each with its own sequence number. The writer always fills the slot
+// readers weren't pointed at, making its sequence odd while it writes and even when done, then
+// points readers at it. A reader copies the latest slot and keeps the copy only if the sequence
+// was even and unchanged around it. Publishing never waits on a reader; a reader only retries
+// when the writer has lapped it, which takes two whole frames.
+//
+// The region is sized for fixed capacities when created. Frames with more nodes or edges than
+// that are cut short, and TotalNodes and TotalEdges say by how much.
+class GardenExport
+{
+public:
+    static const uint32_t Magic = 0x58454e47;      // "GNEX"
+    static const uint32_t Version = 1;
+
+    GardenExport(void);
+    ~GardenExport(void);
+
+    // writer. On Linux the name is an shm_open name, "/nodegarden" for example
+    bool Create(const std::string& name, uint32_t nodeCapacity, uint32_t edgeCapacity);
+
+    // reader; maps the region read only
+    bool Open(const std::string& name);
+
+    void Close();
+    bool IsOpen() const;
+
+    // writer: BeginFrame, fill the slot, then EndFrame with how many of each were written.
+    // Returns the frame number readers will see
+    void BeginFrame(GardenExportSlot* slot);
+    uint64_t EndFrame(float width, float height, uint32_t nodeCount, uint32_t edgeCount, uint32_t totalNodes, uint32_t totalEdges);
+
+    // writer: the garden as it is after Update
+    uint64_t Publish(const Garden& garden);
+
+    // reader: false if nothing has been published yet or the writer kept lapping the copy
+    bool Read(GardenExportFrame* frame, int attempts = 16) const;
+
+private:
+    GardenExport(const GardenExport&);
+    GardenExport& operator=(const GardenExport&);
+
+    bool Map(const std::string& name, size_t size, bool create);
+
+    uint8_t* m_region;
+    size_t m_size;
+    size_t m_slotSize;
+    uint32_t m_writing;         // slot BeginFrame handed out
+    uint64_t m_frame;
+    std::string m_name;
+    bool m_owner;
+    void* m_handle;
+};
@@ -0,0 +1,312 @@
+#include "GardenLod.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+// about what a phone screen of nodes spans at the default density
+const float GardenLod::DefaultDetailRadius = 2 * Garden::MinDist;
+const float GardenLod::DefaultAngle = 0.5f;
+
+GardenLod::GardenLod(void)
+{
+    m_detailRadius = DefaultDetailRadius;
+    m_angle = DefaultAngle;
+    m_clusterCount = 0;
+    m_myNode = -1;
+    m_pairCount = 0;
+}
+
+void GardenLod::SetDetailRadius(float radius)
+{
+    m_detailRadius = radius > 0 ? radius : 0;
+}
+
+float GardenLod::GetDetailRadius() const
+{
+    return m_detailRadius;
+}
+
+void GardenLod::SetAngle(float angle)
+{
+    m_angle = angle > 0 ? angle : 0;
+}
+
+float GardenLod::GetAngle() const
+{
+    return m_angle;
+}
+
+void GardenLod::Build(const Garden& garden, float focusX, float focusY)
+{
+    Build(garden.GetNodes(), garden.GetEdges(), garden.HasMyNode(), focusX, focusY);
+}
+
+void GardenLod::Build(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges, bool hasMyNode, float focusX, float focusY)
+{
+    int count = (int)nodes.size();
+
+    m_nodes.clear();
+    m_edges.clear();
+    m_memberCounts.clear();
+    m_cells.clear();
+    m_clusterCount = 0;
+    m_myNode = -1;
+
+    m_items.resize(count);
+    m_scratch.resize(count);
+    m_owner.resize(count);
+    if (count == 0)
+        return;
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        m_items[i] = i;
+
+        const GardenNode& node = nodes[i];
+        if (node.X < minX) minX = node.X;
+        if (node.Y < minY) minY = node.Y;
+        if (node.X > maxX) maxX = node.X;
+        if (node.Y > maxY) maxY = node.Y;
+    }
+
+    Cell root = { minX, minY, maxX - minX > maxY - minY ? maxX - minX : maxY - minY, 0, count, 0 };
+    m_cells.push_back(root);
+
+    // cells are added after their parent and handled in order, so what's drawn comes out
+    // nearest the root first and the same for the same garden
+    for (size_t c = 0; c < m_cells.size(); c++)
+    {
+        Cell cell = m_cells[c];
+        if (cell.Count == 1)
+        {
+            AddNode(nodes[m_items[cell.First]], m_items[cell.First]);
+            continue;
+        }
+
+        // nearest point of the cell to the focus
+        float dx = focusX < cell.X ? cell.X - focusX : (focusX > cell.X + cell.Size ? focusX - cell.X - cell.Size : 0);
+        float dy = focusY < cell.Y ? cell.Y - focusY : (focusY > cell.Y + cell.Size ? focusY - cell.Y - cell.Size : 0);
+        float distance = sqrtf(dx * dx + dy * dy);
+
+        bool open = distance < m_detailRadius || cell.Size > m_angle * distance;
+        if (!open || cell.Depth >= MaxDepth || !(cell.Size > 0))
+        {
+            AddCluster(nodes, cell);
+            continue;
+        }
+
+        // counting sort of the cell's items in to its quarters, as Quadtree::Build does
+        int first = cell.First;
+        int last = first + cell.Count;
+        float half = cell.Size / 2;
+        float midX = cell.X + half;
+        float midY = cell.Y + half;
+        int counts[4] = { 0, 0, 0, 0 };
+        for (int i = first; i < last; i++)
+        {
+            const GardenNode& node = nodes[m_items[i]];
+            counts[(node.X >= midX ? 1 : 0) + (node.Y >= midY ? 2 : 0)]++;
+        }
+
+        int next[4] = { first, first + counts[0], first + counts[0] + counts[1], first + counts[0] + counts[1] + counts[2] };
+        for (int quarter = 0; quarter < 4; quarter++)
+        {
+            if (counts[quarter] == 0)
+                continue;
+
+            Cell child = { quarter & 1 ? midX : cell.X, quarter & 2 ? midY : cell.Y, half, next[quarter], counts[quarter], cell.Depth + 1 };
+            m_cells.push_back(child);
+        }
+        for (int i = first; i < last; i++)
+        {
+            const GardenNode& node = nodes[m_items[i]];
+            m_scratch[next[(node.X >= midX ? 1 : 0) + (node.Y >= midY ? 2 : 0)]++] = m_items[i];
+        }
+        for (int i = first; i < last; i++)
+        {
+            m_items[i] = m_scratch[i];
+        }
+    }
+
+    if (hasMyNode && m_memberCounts[m_owner[0]] == 1)
+        m_myNode = m_owner[0];
+
+    MergeEdges(edges);
+}
+
+const std::vector<GardenNode>& GardenLod::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<GardenEdge>& GardenLod::GetEdges() const
+{
+    return m_edges;
+}
+
+const std::vector<int>& GardenLod::GetMemberCounts() const
+{
+    return m_memberCounts;
+}
+
+int GardenLod::GetClusterCount() const
+{
+    return m_clusterCount;
+}
+
+int GardenLod::GetMyNodeIndex() const
+{
+    return m_myNode;
+}
+
+void GardenLod::AddNode(const GardenNode& node, int item)
+{
+    m_owner[item] = (int)m_nodes.size();
+    m_nodes.push_back(node);
+    m_memberCounts.push_back(1);
+}
+
+void GardenLod::AddCluster(const std::vector<GardenNode>& nodes, const Cell& cell)
+{
+    int index = (int)m_nodes.size();
+    double sumX = 0, sumY = 0, area = 0;
+    float size = 0, outline = 0, shadow1 = 0, shadow2 = 0, connectedness = 0, largest = 0, opacity = 0;
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+    for (int i = cell.First; i < cell.First + cell.Count; i++)
+    {
+        const GardenNode& node = nodes[m_items[i]];
+        m_owner[m_items[i]] = index;
+
+        sumX += node.X;
+        sumY += node.Y;
+        area += (double)node.Size * node.Size;
+        size += node.Size;
+        outline += node.OutlineSize;
+        shadow1 += node.Shadow1Size;
+        shadow2 += node.Shadow2Size;
+        connectedness += node.NormalisedConnectedness;
+        if (node.Size > largest) largest = node.Size;
+        if (node.Opacity > opacity) opacity = node.Opacity;
+        if (node.X < minX) minX = node.X;
+        if (node.Y < minY) minY = node.Y;
+        if (node.X > maxX) maxX = node.X;
+        if (node.Y > maxY) maxY = node.Y;
+    }
+
+    // as wide as the members' areas added up, but no wider than they spread plus the
+    // largest of them
+    float extent = (maxX - minX > maxY - minY ? maxX - minX : maxY - minY) + largest;
+    float clusterSize = (float)sqrt(area);
+    if (clusterSize > extent)
+        clusterSize = extent;
+
+    float members = (float)cell.Count;
+    float scale = size > 0 ? clusterSize / (size / members) : 0;
+
+    GardenNode cluster;
+    cluster.X = (float)(sumX / cell.Count);
+    cluster.Y = (float)(sumY / cell.Count);
+    cluster.TargetX = cluster.X;
+    cluster.TargetY = cluster.Y;
+    cluster.Size = clusterSize;
+    cluster.OutlineSize = outline / members * scale;
+    cluster.Shadow1Size = shadow1 / members * scale;
+    cluster.Shadow2Size = shadow2 / members * scale;
+    cluster.Connectedness = connectedness;
+    cluster.NormalisedConnectedness = connectedness / members;
+    cluster.Opacity = opacity;              // only fades once every member is
+    cluster.Id = -1;
+
+    m_nodes.push_back(cluster);
+    m_memberCounts.push_back(cell.Count);
+    m_clusterCount++;
+}
+
+static const uint64_t NoPair = ~0ull;
+
+void GardenLod::MergeEdges(const std::vector<GardenEdge>& edges)
+{
+    // there are only as many pairs as super-nodes can see each other, however many edges
+    // run between them, so the table stays small enough to live in cache
+    if (m_pairKeys.empty())
+    {
+        m_pairKeys.resize(1024);
+        m_pairStrengths.resize(1024);
+    }
+    std::fill(m_pairKeys.begin(), m_pairKeys.end(), NoPair);
+    m_pairCount = 0;
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        int first = m_owner[edges[i].First];
+        int second = m_owner[edges[i].Second];
+        if (first == second)
+            continue;
+
+        // node to node edges are drawn as they are
+        if (m_memberCounts[first] == 1 && m_memberCounts[second] == 1)
+        {
+            GardenEdge edge = { first < second ? first : second, first < second ? second : first, edges[i].Distance };
+            m_edges.push_back(edge);
+            continue;
+        }
+
+        // strengths add up in edge order, so the same garden merges the same every time
+        uint64_t key = first < second ? (uint64_t)first << 32 | (uint32_t)second : (uint64_t)second << 32 | (uint32_t)first;
+        *FindPair(key) += Garden::Map(edges[i].Distance, 0, Garden::MinDist, 1, 0);
+    }
+
+    m_pairOrder.clear();
+    for (size_t slot = 0; slot < m_pairKeys.size(); slot++)
+    {
+        if (m_pairKeys[slot] != NoPair)
+            m_pairOrder.push_back(m_pairKeys[slot]);
+    }
+    std::sort(m_pairOrder.begin(), m_pairOrder.end());
+
+    for (size_t i = 0; i < m_pairOrder.size(); i++)
+    {
+        // drawn as the single edge that strong, which LineConnection makes thicker and brighter
+        float strength = *FindPair(m_pairOrder[i]);
+        if (strength > 1)
+            strength = 1;
+
+        GardenEdge edge = { (int)(m_pairOrder[i] >> 32), (int)(uint32_t)m_pairOrder[i], Garden::Map(strength, 0, 1, Garden::MinDist, 0) };
+        m_edges.push_back(edge);
+    }
+}
+
+float* GardenLod::FindPair(uint64_t key)
+{
+    size_t mask = m_pairKeys.size() - 1;
+    size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (m_pairKeys[slot] != NoPair)
+    {
+        if (m_pairKeys[slot] == key)
+            return &m_pairStrengths[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    if ((m_pairCount + 1) * 2 > m_pairKeys.size())
+    {
+        // double and put everything back, then look again
+        std::vector<uint64_t> keys(m_pairKeys.size() * 2, NoPair);
+        std::vector<float> strengths(keys.size());
+        keys.swap(m_pairKeys);
+        strengths.swap(m_pairStrengths);
+        m_pairCount = 0;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            if (keys[i] != NoPair)
+                *FindPair(keys[i]) = strengths[i];
+        }
+        return FindPair(key);
+    }
+
+    m_pairKeys[slot] = key;
+    m_pairStrengths[slot] = 0;
+    m_pairCount++;
+    return &m_pairStrengths[slot];
+}
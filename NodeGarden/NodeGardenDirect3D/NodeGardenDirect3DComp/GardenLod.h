@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Garden.h"
+#include <vector>
+#include <stdint.h>
+
+// What to draw of a garden too big to draw node by node.
+//
+// Build cuts a quadtree over the nodes Barnes-Hut style: a cell is opened up when it is within
+// DetailRadius of the focus, usually the local node, or large next to its distance from it,
+// and drawn as one super-node otherwise. Detail falls away with distance, and a crowd far
+// off, which ends up in small cells, goes down to a single sprite.
+//
+// A super-node sits at its members' centroid with an area the sum of theirs, so a crowd of
+// well connected nodes outweighs one of loners, but no wider than the space they cover. Its
+// outline and shadows are its average member's, scaled up to match. Edges inside one
+// super-node aren't drawn; the edges between two are merged in to one, as strong as the sum
+// of theirs up to the strength of a single edge at zero distance.
+class GardenLod
+{
+public:
+    GardenLod(void);
+    ~GardenLod(void) {};
+
+    // everything within this many garden units of the focus is drawn as itself
+    void SetDetailRadius(float radius);
+    float GetDetailRadius() const;
+
+    // a cell narrower than this fraction of its distance from the focus is drawn as one
+    void SetAngle(float angle);
+    float GetAngle() const;
+
+    void Build(const Garden& garden, float focusX, float focusY);
+    void Build(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges, bool hasMyNode, float focusX, float focusY);
+
+    // nodes and super-nodes, with the edges indexing in to them
+    const std::vector<GardenNode>& GetNodes() const;
+    const std::vector<GardenEdge>& GetEdges() const;
+    const std::vector<int>& GetMemberCounts() const;    // 1 for a node drawn as itself
+    int GetClusterCount() const;
+
+    // where the local node is drawn, or -1 if it has none or it went in to a super-node
+    int GetMyNodeIndex() const;
+
+    static const float DefaultDetailRadius;
+    static const float DefaultAngle;
+    static const int MaxDepth = 16;
+
+private:
+    struct Cell
+    {
+        float X;                    // the square the cell covers
+        float Y;
+        float Size;
+        int First;                  // in to m_items
+        int Count;
+        int Depth;
+    };
+
+    void AddNode(const GardenNode& node, int item);
+    void AddCluster(const std::vector<GardenNode>& nodes, const Cell& cell);
+    void MergeEdges(const std::vector<GardenEdge>& edges);
+    float* FindPair(uint64_t key);
+
+    float m_detailRadius;
+    float m_angle;
+
+    std::vector<Cell> m_cells;
+    std::vector<int> m_items;               // node indices, each cell's contiguous
+    std::vector<int> m_scratch;
+    std::vector<int> m_owner;               // draw index by node index
+
+    std::vector<GardenNode> m_nodes;
+    std::vector<GardenEdge> m_edges;
+    std::vector<int> m_memberCounts;
+
+    // open addressed, pairs of draw indices to summed strength, sized to stay at most half full
+    std::vector<uint64_t> m_pairKeys;
+    std::vector<float> m_pairStrengths;
+    size_t m_pairCount;
+    std::vector<uint64_t> m_pairOrder;
+
+    int m_clusterCount;
+    int m_myNode;
+};
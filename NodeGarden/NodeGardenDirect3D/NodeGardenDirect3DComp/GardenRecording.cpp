@@ -0,0 +1,353 @@
+#include "GardenRecording.h"
+#include <string.h>
+
+int GardenRecording::Apply(Garden& garden, GardenEvent& event)
+{
+    switch (event.Type)
+    {
+    case GardenEvent_Frame:
+        garden.Update(event.X, event.Y);
+        event.Checksum = garden.Checksum();
+        break;
+
+    case GardenEvent_PointerPressed:
+        garden.BeginDrag(event.X, event.Y);
+        break;
+
+    case GardenEvent_PointerMoved:
+        garden.Drag(event.X, event.Y);
+        break;
+
+    case GardenEvent_PointerReleased:
+        garden.EndDrag();
+        break;
+
+    case GardenEvent_MyNode:
+        return event.Id = garden.AddMyNode();
+
+    case GardenEvent_NodeCount:
+        garden.SetNodeCount(event.Id);
+        break;
+
+    case GardenEvent_AddNode:
+        return event.Id = garden.AddNode(event.X, event.Y);
+
+    case GardenEvent_UpdateNode:
+        garden.UpdateNodePosition(event.Id, event.X, event.Y);
+        break;
+
+    case GardenEvent_RemoveNode:
+        return garden.RemoveNode(event.Id) ? 1 : 0;
+
+    case GardenEvent_Size:
+        garden.SetSize(event.X, event.Y);
+        break;
+
+    case GardenEvent_MaxDegree:
+        garden.SetMaxDegree(event.Id);
+        break;
+
+    case GardenEvent_DensityField:
+        garden.SetDensityFieldAbove(event.Id);
+        garden.SetDensityFieldResolution((int)event.X);
+        break;
+
+    case GardenEvent_NodeExpiry:
+        garden.SetNodeExpiry(event.X);
+        break;
+    }
+
+    return 0;
+}
+
+GardenRecorder::GardenRecorder(void)
+{
+    m_file = nullptr;
+    m_frames = 0;
+    m_failed = false;
+}
+
+GardenRecorder::~GardenRecorder(void)
+{
+    Stop();
+}
+
+bool GardenRecorder::Start(const std::string& path, const Garden& garden)
+{
+    Stop();
+
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == nullptr)
+        return false;
+
+    m_buffer.clear();
+    m_buffer.reserve(FlushSize * 2);
+    m_frames = 0;
+    m_failed = false;
+
+    GardenState state;
+    garden.SaveState(&state);
+
+    uint32_t header[2] = { GardenRecording::Magic, GardenRecording::Version };
+    uint8_t flags[2] = { (uint8_t)state.HasMyNode, (uint8_t)state.IsBeingDragged };
+    uint32_t nodeCount = (uint32_t)state.Nodes.size();
+
+    Put(header, sizeof(header));
+    Put(&state.Width, sizeof(float));
+    Put(&state.Height, sizeof(float));
+    Put(&state.MaxConnectedness, sizeof(float));
+    Put(&state.RandomState, sizeof(uint32_t));
+    Put(&state.NextId, sizeof(int));
+    Put(&state.ReorderInterval, sizeof(int));
+    Put(&state.FramesSinceReorder, sizeof(int));
+    Put(&state.MaxDegree, sizeof(int));
+    Put(&state.DensityFieldAbove, sizeof(int));
+    Put(&state.DensityFieldResolution, sizeof(int));
+    Put(&state.NodeExpiry, sizeof(float));
+    Put(&state.Clock, sizeof(double));
+    Put(flags, sizeof(flags));
+    Put(&nodeCount, sizeof(nodeCount));
+    if (nodeCount > 0)
+    {
+        Put(&state.Nodes[0], nodeCount * sizeof(GardenNode));
+        Put(&state.WanderDue[0], nodeCount * sizeof(uint64_t));
+        Put(&state.ExpiryDue[0], nodeCount * sizeof(uint64_t));
+        Put(&state.LastSeen[0], nodeCount * sizeof(double));
+        Put(&state.FadeStart[0], nodeCount * sizeof(double));
+    }
+
+    return true;
+}
+
+void GardenRecorder::Stop()
+{
+    if (m_file == nullptr)
+        return;
+
+    Flush();
+    if (fclose(m_file) != 0)
+        m_failed = true;
+    m_file = nullptr;
+}
+
+bool GardenRecorder::IsRecording() const
+{
+    return m_file != nullptr;
+}
+
+void GardenRecorder::Record(const GardenEvent& event)
+{
+    if (m_file == nullptr)
+        return;
+
+    uint8_t type = (uint8_t)event.Type;
+    Put(&type, 1);
+
+    switch (event.Type)
+    {
+    case GardenEvent_Frame:
+        Put(&event.X, sizeof(float));
+        Put(&event.Y, sizeof(float));
+        Put(&event.Checksum, sizeof(uint32_t));
+        m_frames++;
+        break;
+
+    case GardenEvent_PointerPressed:
+    case GardenEvent_PointerMoved:
+    case GardenEvent_Size:
+    case GardenEvent_NodeExpiry:
+        Put(&event.X, sizeof(float));
+        Put(&event.Y, sizeof(float));
+        break;
+
+    case GardenEvent_PointerReleased:
+        break;
+
+    case GardenEvent_MyNode:
+    case GardenEvent_NodeCount:
+    case GardenEvent_RemoveNode:
+    case GardenEvent_MaxDegree:
+        Put(&event.Id, sizeof(int));
+        break;
+
+    case GardenEvent_AddNode:
+    case GardenEvent_UpdateNode:
+    case GardenEvent_DensityField:
+        Put(&event.Id, sizeof(int));
+        Put(&event.X, sizeof(float));
+        Put(&event.Y, sizeof(float));
+        break;
+    }
+
+    if (m_buffer.size() >= FlushSize)
+        Flush();
+}
+
+uint32_t GardenRecorder::GetFrameCount() const
+{
+    return m_frames;
+}
+
+bool GardenRecorder::HasFailed() const
+{
+    return m_failed;
+}
+
+void GardenRecorder::Put(const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
+
+void GardenRecorder::Flush()
+{
+    if (!m_buffer.empty() && fwrite(&m_buffer[0], 1, m_buffer.size(), m_file) != m_buffer.size())
+        m_failed = true;
+
+    m_buffer.clear();
+}
+
+GardenReplayer::GardenReplayer(void)
+{
+    m_eventsOffset = 0;
+    m_offset = 0;
+    m_truncated = false;
+}
+
+bool GardenReplayer::Open(const std::string& path)
+{
+    m_data.clear();
+    m_offset = 0;
+    m_truncated = false;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    uint8_t chunk[64 * 1024];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        m_data.insert(m_data.end(), chunk, chunk + got);
+    }
+    fclose(file);
+
+    uint32_t header[2];
+    uint8_t flags[2];
+    uint32_t nodeCount;
+    if (!Get(header, sizeof(header)) || header[0] != GardenRecording::Magic || header[1] != GardenRecording::Version)
+        return false;
+
+    if (!Get(&m_start.Width, sizeof(float)) ||
+        !Get(&m_start.Height, sizeof(float)) ||
+        !Get(&m_start.MaxConnectedness, sizeof(float)) ||
+        !Get(&m_start.RandomState, sizeof(uint32_t)) ||
+        !Get(&m_start.NextId, sizeof(int)) ||
+        !Get(&m_start.ReorderInterval, sizeof(int)) ||
+        !Get(&m_start.FramesSinceReorder, sizeof(int)) ||
+        !Get(&m_start.MaxDegree, sizeof(int)) ||
+        !Get(&m_start.DensityFieldAbove, sizeof(int)) ||
+        !Get(&m_start.DensityFieldResolution, sizeof(int)) ||
+        !Get(&m_start.NodeExpiry, sizeof(float)) ||
+        !Get(&m_start.Clock, sizeof(double)) ||
+        !Get(flags, sizeof(flags)) ||
+        !Get(&nodeCount, sizeof(nodeCount)))
+        return false;
+
+    // checked against what's left before allocating anything
+    if (nodeCount > (m_data.size() - m_offset) / (sizeof(GardenNode) + 2 * sizeof(uint64_t) + 2 * sizeof(double)))
+        return false;
+
+    m_start.HasMyNode = flags[0] != 0;
+    m_start.IsBeingDragged = flags[1] != 0;
+    m_start.Nodes.resize(nodeCount);
+    m_start.WanderDue.resize(nodeCount);
+    m_start.ExpiryDue.resize(nodeCount);
+    m_start.LastSeen.resize(nodeCount);
+    m_start.FadeStart.resize(nodeCount);
+    if (nodeCount > 0 && (!Get(&m_start.Nodes[0], nodeCount * sizeof(GardenNode)) ||
+        !Get(&m_start.WanderDue[0], nodeCount * sizeof(uint64_t)) ||
+        !Get(&m_start.ExpiryDue[0], nodeCount * sizeof(uint64_t)) ||
+        !Get(&m_start.LastSeen[0], nodeCount * sizeof(double)) ||
+        !Get(&m_start.FadeStart[0], nodeCount * sizeof(double))))
+        return false;
+
+    m_eventsOffset = m_offset;
+    return true;
+}
+
+void GardenReplayer::Restart(Garden& garden)
+{
+    garden.LoadState(m_start);
+    m_offset = m_eventsOffset;
+    m_truncated = false;
+}
+
+bool GardenReplayer::Next(GardenEvent* event)
+{
+    if (m_offset == m_data.size())
+        return false;
+
+    uint8_t type;
+    Get(&type, 1);
+
+    memset(event, 0, sizeof(*event));
+    event->Type = (GardenEventType)type;
+
+    bool ok = true;
+    switch (event->Type)
+    {
+    case GardenEvent_Frame:
+        ok = Get(&event->X, sizeof(float)) && Get(&event->Y, sizeof(float)) && Get(&event->Checksum, sizeof(uint32_t));
+        break;
+
+    case GardenEvent_PointerPressed:
+    case GardenEvent_PointerMoved:
+    case GardenEvent_Size:
+    case GardenEvent_NodeExpiry:
+        ok = Get(&event->X, sizeof(float)) && Get(&event->Y, sizeof(float));
+        break;
+
+    case GardenEvent_PointerReleased:
+        break;
+
+    case GardenEvent_MyNode:
+    case GardenEvent_NodeCount:
+    case GardenEvent_RemoveNode:
+    case GardenEvent_MaxDegree:
+        ok = Get(&event->Id, sizeof(int));
+        break;
+
+    case GardenEvent_AddNode:
+    case GardenEvent_UpdateNode:
+    case GardenEvent_DensityField:
+        ok = Get(&event->Id, sizeof(int)) && Get(&event->X, sizeof(float)) && Get(&event->Y, sizeof(float));
+        break;
+
+    default:
+        ok = false;
+        break;
+    }
+
+    m_truncated = !ok;
+    return ok;
+}
+
+bool GardenReplayer::IsTruncated() const
+{
+    return m_truncated;
+}
+
+bool GardenReplayer::Get(void* data, size_t size)
+{
+    if (m_data.size() - m_offset < size)
+    {
+        // a log the app didn't get to finish stops short of a whole event
+        m_truncated = true;
+        return false;
+    }
+
+    memcpy(data, &m_data[m_offset], size);
+    m_offset += size;
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Garden.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Everything that changes the garden from outside, in the order it happened
+enum GardenEventType
+{
+    GardenEvent_Frame = 1,          // X = total time, Y = delta; Checksum is the state after the update
+    GardenEvent_PointerPressed,     // X, Y
+    GardenEvent_PointerMoved,       // X, Y
+    GardenEvent_PointerReleased,
+    GardenEvent_MyNode,             // Id = the id it was given
+    GardenEvent_NodeCount,          // Id = count
+    GardenEvent_AddNode,            // X, Y; Id = the id it was given
+    GardenEvent_UpdateNode,         // Id, X, Y
+    GardenEvent_RemoveNode,         // Id
+    GardenEvent_Size,               // X = width, Y = height
+    GardenEvent_MaxDegree,          // Id = degree
+    GardenEvent_DensityField,       // Id = the node count it's used above, X = cells per MinDist
+    GardenEvent_NodeExpiry,         // X = seconds
+};
+
+struct GardenEvent
+{
+    GardenEventType Type;
+    int Id;
+    float X;
+    float Y;
+    uint32_t Checksum;
+};
+
+// Log layout, little endian: "NGRL", version, the GardenState the recording starts from, then
+// one byte of event type per event followed by only the fields that type uses.
+class GardenRecording
+{
+public:
+    static const uint32_t Magic = 0x4c52474e;      // "NGRL"
+    static const uint32_t Version = 6;
+
+    // The one place events reach the garden, for both live input and replay, so the two can't
+    // drift apart. Returns the id for MyNode and AddNode, 1 for a RemoveNode that found its
+    // node, otherwise 0. Frame events update the garden and fill in the checksum.
+    static int Apply(Garden& garden, GardenEvent& event);
+};
+
+// Writes a log while the app runs. Not thread safe: the caller keeps events in the order they
+// were applied, which XTKRenderer does with the lock it applies them under.
+class GardenRecorder
+{
+public:
+    GardenRecorder(void);
+    ~GardenRecorder(void);
+
+    bool Start(const std::string& path, const Garden& garden);
+    void Stop();
+    bool IsRecording() const;
+    void Record(const GardenEvent& event);
+
+    uint32_t GetFrameCount() const;
+    bool HasFailed() const;
+
+private:
+    static const size_t FlushSize = 64 * 1024;
+
+    void Put(const void* data, size_t size);
+    void Flush();
+
+    FILE* m_file;
+    std::vector<uint8_t> m_buffer;
+    uint32_t m_frames;
+    bool m_failed;
+};
+
+// Reads a whole log in to memory so replaying costs nothing but the simulation
+class GardenReplayer
+{
+public:
+    GardenReplayer(void);
+    ~GardenReplayer(void) {};
+
+    bool Open(const std::string& path);
+
+    // puts the garden back to where the recording started and rewinds
+    void Restart(Garden& garden);
+
+    // false at the end of the log, or if it's cut short
+    bool Next(GardenEvent* event);
+
+    bool IsTruncated() const;
+
+private:
+    bool Get(void* data, size_t size);
+
+    std::vector<uint8_t> m_data;
+    size_t m_eventsOffset;
+    size_t m_offset;
+    GardenState m_start;
+    bool m_truncated;
+};
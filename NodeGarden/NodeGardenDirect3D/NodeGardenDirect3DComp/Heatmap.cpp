@@ -0,0 +1,325 @@
+#include "Heatmap.h"
+#include <math.h>
+
+// about a node's width on the phone; the garden is a few dozen cells across
+const float Heatmap::DefaultCellSize = 16.0f;
+
+// per frame, so the peak halves in a little over a second at 60Hz
+static const float PeakDecay = 0.99f;
+
+Heatmap::Heatmap(void)
+{
+    m_source = HeatmapSource_Edges;
+    m_cellSize = DefaultCellSize;
+    m_blurRadius = DefaultBlurRadius;
+    m_columns = 0;
+    m_rows = 0;
+    m_peak = 0;
+}
+
+void Heatmap::SetSource(HeatmapSource source)
+{
+    m_source = source;
+}
+
+HeatmapSource Heatmap::GetSource() const
+{
+    return m_source;
+}
+
+void Heatmap::SetCellSize(float size)
+{
+    m_cellSize = size >= 1 ? size : 1;
+}
+
+float Heatmap::GetCellSize() const
+{
+    return m_cellSize;
+}
+
+void Heatmap::SetBlurRadius(int cells)
+{
+    m_blurRadius = cells > 0 ? cells : 0;
+    m_weights.clear();
+}
+
+int Heatmap::GetBlurRadius() const
+{
+    return m_blurRadius;
+}
+
+void Heatmap::Build(const Garden& garden, float width, float height)
+{
+    Build(garden.GetNodes(), garden.GetEdges(), width, height);
+}
+
+void Heatmap::Build(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges, float width, float height)
+{
+    m_columns = width > 0 ? (int)ceilf(width / m_cellSize) : 1;
+    m_rows = height > 0 ? (int)ceilf(height / m_cellSize) : 1;
+    m_density.assign((size_t)m_columns * m_rows, 0.0f);
+
+    if (m_source == HeatmapSource_Edges)
+        AddEdges(nodes, edges);
+    else
+        AddConnectedness(nodes);
+
+    Blur();
+
+    float framePeak = 0;
+    for (size_t i = 0; i < m_density.size(); i++)
+    {
+        if (m_density[i] > framePeak)
+            framePeak = m_density[i];
+    }
+
+    m_peak *= PeakDecay;
+    if (framePeak > m_peak)
+        m_peak = framePeak;
+
+    // the square root lifts the sparse parts, which would otherwise all be the first colour
+    m_levels.resize(m_density.size());
+    for (size_t i = 0; i < m_density.size(); i++)
+    {
+        float level = m_peak > 0 ? sqrtf(m_density[i] / m_peak) * 255 + 0.5f : 0;
+        m_levels[i] = (uint8_t)(level < 255 ? level : 255);
+    }
+}
+
+int Heatmap::GetColumns() const
+{
+    return m_columns;
+}
+
+int Heatmap::GetRows() const
+{
+    return m_rows;
+}
+
+const std::vector<float>& Heatmap::GetDensity() const
+{
+    return m_density;
+}
+
+const std::vector<uint8_t>& Heatmap::GetLevels() const
+{
+    return m_levels;
+}
+
+float Heatmap::GetPeak() const
+{
+    return m_peak;
+}
+
+const uint32_t* Heatmap::GetPalette()
+{
+    struct Stop
+    {
+        float At;
+        float Colour[4];
+    };
+
+    static const Stop stops[] =
+    {
+        { 0.0f,  {   0,   0,   0,   0 } },
+        { 0.15f, {  30,  40, 150, 140 } },
+        { 0.4f,  {  40, 150, 220, 200 } },
+        { 0.65f, { 250, 150,  40, 230 } },
+        { 0.85f, { 255, 230, 120, 245 } },
+        { 1.0f,  { 255, 255, 255, 255 } },
+    };
+
+    static uint32_t palette[PaletteSize];
+    static bool built = false;
+    if (built)
+        return palette;
+
+    int stop = 0;
+    for (int i = 0; i < PaletteSize; i++)
+    {
+        float at = (float)i / (PaletteSize - 1);
+        while (at > stops[stop + 1].At)
+            stop++;
+
+        float t = (at - stops[stop].At) / (stops[stop + 1].At - stops[stop].At);
+        uint32_t packed = 0;
+        for (int channel = 0; channel < 4; channel++)
+        {
+            float value = stops[stop].Colour[channel] + (stops[stop + 1].Colour[channel] - stops[stop].Colour[channel]) * t;
+            packed |= (uint32_t)(value + 0.5f) << (channel * 8);
+        }
+        palette[i] = packed;
+    }
+
+    built = true;
+    return palette;
+}
+
+void Heatmap::Colourise(int width, int height, std::vector<uint32_t>* pixels) const
+{
+    const uint32_t* palette = GetPalette();
+    pixels->assign((size_t)(width > 0 ? width : 0) * (height > 0 ? height : 0), 0);
+    if (m_levels.empty())
+        return;
+
+    // bilinear between cell centres, clamped at the edges, as the sampler does
+    for (int y = 0; y < height; y++)
+    {
+        float v = (y + 0.5f) * m_rows / height - 0.5f;
+        if (v < 0) v = 0;
+        if (v > m_rows - 1) v = (float)(m_rows - 1);
+        int row = (int)v;
+        int nextRow = row + 1 < m_rows ? row + 1 : row;
+        float fy = v - row;
+
+        for (int x = 0; x < width; x++)
+        {
+            float u = (x + 0.5f) * m_columns / width - 0.5f;
+            if (u < 0) u = 0;
+            if (u > m_columns - 1) u = (float)(m_columns - 1);
+            int column = (int)u;
+            int nextColumn = column + 1 < m_columns ? column + 1 : column;
+            float fx = u - column;
+
+            float top = m_levels[row * m_columns + column] * (1 - fx) + m_levels[row * m_columns + nextColumn] * fx;
+            float bottom = m_levels[nextRow * m_columns + column] * (1 - fx) + m_levels[nextRow * m_columns + nextColumn] * fx;
+            int level = (int)(top * (1 - fy) + bottom * fy + 0.5f);
+
+            (*pixels)[(size_t)y * width + x] = palette[level < PaletteSize ? level : PaletteSize - 1];
+        }
+    }
+}
+
+void Heatmap::AddEdges(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges)
+{
+    float scale = 1 / m_cellSize;
+
+    // The blur's sigma is half its radius, and samples two sigma apart come out of it with
+    // well under 2% ripple, so an edge only needs a sample every blur radius rather than
+    // every cell. Unblurred, every cell it crosses still gets one
+    float spacing = m_blurRadius > 1 ? (float)m_blurRadius : 1.0f;
+    float perSample = 1 / spacing;
+    float* density = &m_density[0];
+    int columns = m_columns;
+
+    // as much as the line would put down: its strength along its length, spread over samples
+    // evenly along it. Walked in cell units so each sample is an add and a bounds check
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const GardenNode& node1 = nodes[edges[i].First];
+        const GardenNode& node2 = nodes[edges[i].Second];
+        float x = node1.X * scale;
+        float y = node1.Y * scale;
+        float dx = node2.X * scale - x;
+        float dy = node2.Y * scale - y;
+        float length = sqrtf(dx * dx + dy * dy);
+        float strength = Garden::Map(edges[i].Distance, 0, Garden::MinDist, 1, 0);
+
+        int steps = (int)ceilf(length * perSample);
+        if (steps < 1)
+            steps = 1;
+
+        float amount = strength * length / steps;
+        float stepX = dx / steps;
+        float stepY = dy / steps;
+
+        // every sample lies between the ends, so with both ends on the grid none needs checking
+        if (IsOnGrid(x, y) && IsOnGrid(x + dx, y + dy))
+        {
+            x += stepX / 2;
+            y += stepY / 2;
+            for (int step = 0; step < steps; step++, x += stepX, y += stepY)
+            {
+                density[(int)y * columns + (int)x] += amount;
+            }
+            continue;
+        }
+
+        x += stepX / 2;
+        y += stepY / 2;
+        for (int step = 0; step < steps; step++, x += stepX, y += stepY)
+        {
+            Add(x, y, amount);
+        }
+    }
+}
+
+void Heatmap::AddConnectedness(const std::vector<GardenNode>& nodes)
+{
+    float scale = 1 / m_cellSize;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        Add(nodes[i].X * scale, nodes[i].Y * scale, nodes[i].NormalisedConnectedness);
+    }
+}
+
+bool Heatmap::IsOnGrid(float column, float row) const
+{
+    return column >= 0 && column < m_columns && row >= 0 && row < m_rows;
+}
+
+void Heatmap::Add(float column, float row, float amount)
+{
+    // anything off the visible part of the garden is dropped
+    if (!IsOnGrid(column, row))
+        return;
+
+    m_density[(int)row * m_columns + (int)column] += amount;
+}
+
+void Heatmap::Blur()
+{
+    if (m_blurRadius == 0)
+        return;
+
+    // gaussian with the radius at two sigma, normalised so the blur only moves weight around
+    if ((int)m_weights.size() != m_blurRadius + 1)
+    {
+        float sigma = m_blurRadius / 2.0f;
+        float total = 0;
+        m_weights.resize(m_blurRadius + 1);
+        for (int k = 0; k <= m_blurRadius; k++)
+        {
+            m_weights[k] = expf(-(float)(k * k) / (2 * sigma * sigma));
+            total += k == 0 ? m_weights[k] : 2 * m_weights[k];
+        }
+        for (int k = 0; k <= m_blurRadius; k++)
+        {
+            m_weights[k] /= total;
+        }
+    }
+
+    // across in to the scratch grid, then down back in to the density; what falls off the
+    // edge is lost, as it would be off screen
+    m_scratch.resize(m_density.size());
+    for (int row = 0; row < m_rows; row++)
+    {
+        const float* in = &m_density[(size_t)row * m_columns];
+        float* out = &m_scratch[(size_t)row * m_columns];
+        for (int column = 0; column < m_columns; column++)
+        {
+            float sum = in[column] * m_weights[0];
+            for (int k = 1; k <= m_blurRadius; k++)
+            {
+                if (column - k >= 0) sum += in[column - k] * m_weights[k];
+                if (column + k < m_columns) sum += in[column + k] * m_weights[k];
+            }
+            out[column] = sum;
+        }
+    }
+
+    for (int row = 0; row < m_rows; row++)
+    {
+        float* out = &m_density[(size_t)row * m_columns];
+        for (int column = 0; column < m_columns; column++)
+        {
+            float sum = m_scratch[(size_t)row * m_columns + column] * m_weights[0];
+            for (int k = 1; k <= m_blurRadius; k++)
+            {
+                if (row - k >= 0) sum += m_scratch[(size_t)(row - k) * m_columns + column] * m_weights[k];
+                if (row + k < m_rows) sum += m_scratch[(size_t)(row + k) * m_columns + column] * m_weights[k];
+            }
+            out[column] = sum;
+        }
+    }
+}
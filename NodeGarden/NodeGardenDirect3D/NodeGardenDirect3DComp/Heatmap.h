@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Garden.h"
+#include <vector>
+#include <stdint.h>
+
+// What the heatmap is built from
+enum HeatmapSource
+{
+    HeatmapSource_Edges,            // every live connection, along its length, as strong as its line
+    HeatmapSource_Connectedness,    // every node's normalised connectedness, for when there are no edges
+};
+
+// A coarse picture of where the garden is connected, for gardens with too many lines to draw.
+//
+// Build drops the source in to a grid of cells over the visible part of the garden, blurs it
+// with a separable gaussian and turns each cell in to a level from 0 to 255 against a
+// running peak, which decays as Garden's running maximum connectedness does so a single busy
+// frame doesn't dim everything after it. The renderer uploads the levels as a texture and
+// draws it once over the whole garden, stretched with bilinear filtering and coloured through
+// GetPalette by HeatmapPixelShader; Colourise is the same pass on the CPU, for checking
+// without a device.
+class Heatmap
+{
+public:
+    static const float DefaultCellSize;
+    static const int DefaultBlurRadius = 3;
+    static const int PaletteSize = 256;
+
+    Heatmap(void);
+    ~Heatmap(void) {};
+
+    void SetSource(HeatmapSource source);
+    HeatmapSource GetSource() const;
+
+    // garden units per cell
+    void SetCellSize(float size);
+    float GetCellSize() const;
+
+    // cells either side the blur reaches, 0 for none
+    void SetBlurRadius(int cells);
+    int GetBlurRadius() const;
+
+    // covers 0,0 to width,height in garden units
+    void Build(const Garden& garden, float width, float height);
+    void Build(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges, float width, float height);
+
+    int GetColumns() const;
+    int GetRows() const;
+    const std::vector<float>& GetDensity() const;      // blurred, before it's levelled
+    const std::vector<uint8_t>& GetLevels() const;     // row by row, GetColumns wide
+    float GetPeak() const;
+
+    // RGBA, red in the low byte, from transparent at level 0 up through blue and orange to white
+    static const uint32_t* GetPalette();
+
+    // the pixel shader's output for a width by height target, in the same RGBA layout
+    void Colourise(int width, int height, std::vector<uint32_t>* pixels) const;
+
+private:
+    void AddEdges(const std::vector<GardenNode>& nodes, const std::vector<GardenEdge>& edges);
+    void AddConnectedness(const std::vector<GardenNode>& nodes);
+    bool IsOnGrid(float column, float row) const;      // in cells
+    void Add(float column, float row, float amount);   // in cells
+    void Blur();
+
+    HeatmapSource m_source;
+    float m_cellSize;
+    int m_blurRadius;
+
+    int m_columns;
+    int m_rows;
+    std::vector<float> m_density;
+    std::vector<float> m_scratch;
+    std::vector<float> m_weights;           // the blur kernel's right half, centre first
+    std::vector<uint8_t> m_levels;
+    float m_peak;
+};
@@ -0,0 +1,15 @@
+// Colours the heatmap's levels, which SpriteBatch stretches over the garden from t0 with its
+// own linear sampler, through Heatmap::GetPalette in t1. Heatmap::Colourise does the same on
+// the CPU.
+Texture2D levels : register(t0);
+Texture2D palette : register(t1);
+SamplerState stretch : register(s0);
+SamplerState lookup : register(s1);
+
+float4 main(float4 color : COLOR0, float2 texCoord : TEXCOORD0) : SV_TARGET
+{
+	float level = levels.Sample(stretch, texCoord).r;
+
+	// the centre of the level's texel in the 256 wide palette
+	return palette.Sample(lookup, float2(level * (255.0f / 256.0f) + 0.5f / 256.0f, 0.5f)) * color;
+}
@@ -1,21 +1,26 @@
 #include "pch.h"
 #include "LineConnection.h"
+#include <math.h>
 
 const float LineConnection::StrokeWeightMin = 2.0f; 
 const float LineConnection::StrokeWeightMax = 7.0f;
 
+static const float PIOVER2 = 1.5707963f;
+
 LineConnection::LineConnection()
 {
     m_zDepth = 1.0f;
+    m_visible = false;
 }
 
-void LineConnection::FormConnection(XMVECTOR node1Pos, XMVECTOR node2Pos, float distance)
+void LineConnection::FormConnection(XMVECTOR node1Pos, XMVECTOR node2Pos, float distance, float opacity)
 {
     m_visible = true;
-    // draw a line between 2 nodes. The thickness/alpha varies depending on distance
-    m_strokeThickness = Node::Map(distance, 0, MinDist, StrokeWeightMax, StrokeWeightMin);
+    // draw a line between 2 nodes. The thickness/alpha varies depending on distance, and the
+    // alpha fades with the fainter of the two nodes
+    m_strokeThickness = Garden::Map(distance, 0, Garden::MinDist, StrokeWeightMax, StrokeWeightMin);
     
-    XMVECTORF32 color = {1, 1, 1, Node::Map(distance, 0, MinDist, 1.0f, 0)};
+    XMVECTORF32 color = {1, 1, 1, Garden::Map(distance, 0, Garden::MinDist, 1.0f, 0) * opacity};
     m_color = color;
 
     XMStoreFloat2(&m_start, node1Pos);
@@ -34,6 +39,16 @@ void LineConnection::BreakConnection()
     m_visible = false;
 }
 
+bool LineConnection::IsConnected()
+{
+    return m_visible;
+}
+
+bool LineConnection::Intersects(const CullRect& rect)
+{
+    return rect.IntersectsSegment(m_start.x, m_start.y, m_end.x, m_end.y, m_strokeThickness);
+}
+
 float LineConnection::Distance(const XMVECTOR& vector1,const XMVECTOR& vector2)
 {
     XMVECTOR vectorSub = XMVectorSubtract(vector1,vector2);
@@ -1,7 +1,8 @@
 #pragma once
 
 #include "Sprite.h"
-#include "Node.h"
+#include "Garden.h"
+#include "CullRect.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
@@ -12,8 +13,10 @@ public:
     LineConnection(void);
     ~LineConnection(void) {};
 
-    virtual void FormConnection(XMVECTOR node1Pos, XMVECTOR node2Pos, float distance);
+    virtual void FormConnection(XMVECTOR node1Pos, XMVECTOR node2Pos, float distance, float opacity);
     virtual void BreakConnection();
+    bool IsConnected();
+    bool Intersects(const CullRect& rect);
 
     static float Distance(const XMVECTOR& vector1, const XMVECTOR& vector2);
 
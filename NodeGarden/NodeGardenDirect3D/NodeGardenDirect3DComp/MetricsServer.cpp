@@ -0,0 +1,319 @@
+#include "MetricsServer.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#define CloseSocket closesocket
+#define PollSockets WSAPoll
+#define SendFlags 0
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CloseSocket close
+#define PollSockets poll
+// a scraper hanging up mid-response must fail the send, not SIGPIPE the whole process
+#if defined(MSG_NOSIGNAL)
+#define SendFlags MSG_NOSIGNAL
+#else
+#define SendFlags 0
+#endif
+#endif
+
+static const int PollMilliseconds = 200;    // how long Stop can wait on the server thread
+static const int RequestLimit = 4096;
+
+MetricsServer::MetricsServer(void)
+{
+    m_sequence = 0;
+    for (int i = 0; i < SnapshotWords; i++)
+    {
+        m_words[i] = 0;
+    }
+
+    m_listener = (intptr_t)INVALID_SOCKET;
+    m_port = 0;
+    m_running = false;
+    m_stop = false;
+    m_scrapes = 0;
+}
+
+MetricsServer::~MetricsServer(void)
+{
+    Stop();
+}
+
+bool MetricsServer::Start(uint16_t port)
+{
+    Stop();
+
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+        return false;
+#endif
+
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET)
+        return false;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    socklen_t length = sizeof(address);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listener, 4) != 0 ||
+        getsockname(listener, (sockaddr*)&address, &length) != 0)
+    {
+        CloseSocket(listener);
+        return false;
+    }
+
+    m_listener = (intptr_t)listener;
+    m_port = ntohs(address.sin_port);
+    m_stop = false;
+    m_thread = std::thread(&MetricsServer::Serve, this);
+    m_running = true;
+
+    return true;
+}
+
+void MetricsServer::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_running = false;
+    m_stop = true;
+    m_thread.join();
+
+    CloseSocket((SocketHandle)m_listener);
+    m_listener = (intptr_t)INVALID_SOCKET;
+    m_port = 0;
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+bool MetricsServer::IsRunning() const
+{
+    return m_running.load(std::memory_order_relaxed);
+}
+
+uint16_t MetricsServer::GetPort() const
+{
+    return m_port;
+}
+
+void MetricsServer::Publish(const MetricsSnapshot& snapshot)
+{
+    uint64_t words[SnapshotWords];
+    memcpy(words, &snapshot, sizeof(words));
+
+    // odd while the words are being replaced
+    uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int i = 0; i < SnapshotWords; i++)
+    {
+        m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool MetricsServer::GetSnapshot(MetricsSnapshot* snapshot) const
+{
+    uint64_t words[SnapshotWords];
+
+    for (;;)
+    {
+        uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false;
+
+        if ((before & 1) != 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (int i = 0; i < SnapshotWords; i++)
+        {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before)
+            break;
+    }
+
+    memcpy(snapshot, words, sizeof(words));
+    return true;
+}
+
+uint32_t MetricsServer::GetScrapeCount() const
+{
+    return m_scrapes.load(std::memory_order_relaxed);
+}
+
+static void AppendMetric(std::string* text, const char* name, const char* type, const char* help, double value)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %.9g\n", name, help, name, type, name, value);
+    text->append(line);
+}
+
+void MetricsServer::Format(const MetricsSnapshot& snapshot, std::string* text)
+{
+    char line[256];
+    text->clear();
+
+    text->append("# HELP nodegarden_frame_seconds Time between frames.\n# TYPE nodegarden_frame_seconds summary\n");
+    snprintf(line, sizeof(line),
+        "nodegarden_frame_seconds{quantile=\"0.5\"} %.9g\n"
+        "nodegarden_frame_seconds{quantile=\"0.9\"} %.9g\n"
+        "nodegarden_frame_seconds{quantile=\"0.99\"} %.9g\n"
+        "nodegarden_frame_seconds_sum %.9g\n"
+        "nodegarden_frame_seconds_count %.0f\n",
+        snapshot.FrameTimeMedian, snapshot.FrameTimeP90, snapshot.FrameTimeP99, snapshot.FrameTimeTotal, snapshot.Frames);
+    text->append(line);
+
+    AppendMetric(text, "nodegarden_sim_seconds", "gauge", "Average time in Update over recent frames.", snapshot.SimTimeAverage);
+    AppendMetric(text, "nodegarden_render_seconds", "gauge", "Average time in Render over recent frames.", snapshot.RenderTimeAverage);
+    AppendMetric(text, "nodegarden_nodes", "gauge", "Nodes in the garden, the local node included.", snapshot.Nodes);
+    AppendMetric(text, "nodegarden_connections", "gauge", "Connected pairs in the last frame.", snapshot.Connections);
+    AppendMetric(text, "nodegarden_pairs_tested", "gauge", "Pairs the last connection pass tested.", snapshot.PairsTested);
+    AppendMetric(text, "nodegarden_network_updates_total", "counter", "Remote node position updates received.", snapshot.NetworkUpdates);
+    AppendMetric(text, "nodegarden_network_updates_per_second", "gauge", "Remote node position updates over the last second or so.", snapshot.NetworkUpdatesPerSecond);
+    AppendMetric(text, "nodegarden_network_updates_dropped_total", "counter", "Network updates that were refused or named no known node.", snapshot.DroppedUpdates);
+}
+
+void MetricsServer::FromFrameMetrics(FrameMetrics& metrics, MetricsSnapshot* snapshot)
+{
+    FrameSummary summary;
+    metrics.Summarise(&summary);
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->Frames = metrics.GetFrameCount();
+    snapshot->FrameTimeTotal = metrics.GetTotalFrameTime();
+    snapshot->FrameTimeMedian = summary.MedianFrameTime;
+    snapshot->FrameTimeP90 = summary.P90FrameTime;
+    snapshot->FrameTimeP99 = summary.P99FrameTime;
+    snapshot->SimTimeAverage = summary.AverageSimTime;
+    snapshot->RenderTimeAverage = summary.AverageRenderTime;
+    snapshot->Nodes = summary.Last.Nodes;
+    snapshot->Connections = summary.Last.Connections;
+    snapshot->PairsTested = summary.Last.PairsTested;
+    snapshot->NetworkUpdates = metrics.GetNetworkUpdates();
+    snapshot->NetworkUpdatesPerSecond = summary.NetworkUpdatesPerSecond;
+}
+
+void MetricsServer::Serve()
+{
+    SocketHandle listener = (SocketHandle)m_listener;
+
+    while (!m_stop.load())
+    {
+        pollfd ready;
+        ready.fd = listener;
+        ready.events = POLLIN;
+        ready.revents = 0;
+
+        if (PollSockets(&ready, 1, PollMilliseconds) <= 0 || (ready.revents & POLLIN) == 0)
+            continue;
+
+        SocketHandle client = accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET)
+            continue;
+
+        Respond((intptr_t)client);
+        CloseSocket(client);
+    }
+}
+
+void MetricsServer::Respond(intptr_t handle)
+{
+    SocketHandle client = (SocketHandle)handle;
+
+    // one request per connection; a client that never finishes its headers is dropped
+    // rather than allowed to park the server thread
+#if defined(_WIN32)
+    DWORD timeout = 1000;
+#else
+    timeval timeout = { 1, 0 };
+#endif
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+    int noSigPipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noSigPipe, sizeof(noSigPipe));
+#endif
+
+    char request[RequestLimit + 1];
+    int received = 0;
+    while (received < RequestLimit)
+    {
+        int got = (int)recv(client, request + received, RequestLimit - received, 0);
+        if (got <= 0)
+            return;
+
+        received += got;
+        request[received] = 0;
+        if (strstr(request, "\r\n\r\n") != nullptr)
+            break;
+    }
+
+    std::string body;
+    const char* status = "200 OK";
+    const char* contentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    MetricsSnapshot snapshot;
+    if (strncmp(request, "GET /metrics ", 13) != 0 && strncmp(request, "GET /metrics?", 13) != 0)
+    {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "metrics are at /metrics\n";
+    }
+    else if (!GetSnapshot(&snapshot))
+    {
+        status = "503 Service Unavailable";
+        contentType = "text/plain";
+        body = "no frames yet\n";
+    }
+    else
+    {
+        Format(snapshot, &body);
+        m_scrapes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+        status, contentType, (unsigned)body.size());
+
+    std::string response(header, headerLength);
+    response += body;
+
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        int wrote = (int)send(client, response.data() + sent, (int)(response.size() - sent), SendFlags);
+        if (wrote <= 0)
+            return;
+        sent += wrote;
+    }
+}
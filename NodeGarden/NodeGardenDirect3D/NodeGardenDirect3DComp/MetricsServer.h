@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FrameMetrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+// Everything a scrape reports. All doubles, so it can be published a word at a time
+struct MetricsSnapshot
+{
+    double Frames;                  // since startup
+    double FrameTimeTotal;          // seconds, since startup
+    double FrameTimeMedian;         // seconds, over the recent history
+    double FrameTimeP90;
+    double FrameTimeP99;
+    double SimTimeAverage;
+    double RenderTimeAverage;
+    double Nodes;
+    double Connections;
+    double PairsTested;
+    double NetworkUpdates;          // since startup
+    double NetworkUpdatesPerSecond;
+    double DroppedUpdates;          // since startup
+};
+
+// Serves the latest MetricsSnapshot at http://127.0.0.1:port/metrics in the Prometheus text
+// exposition format, from its own thread.
+//
+// The render thread publishes a snapshot per frame through a seqlock: it never waits, and a
+// scrape copies the words out and tries again if a publish overlapped the copy. Nothing the
+// scrape does can hold up a frame. Only loopback is bound; anything further afield is for a
+// local agent to forward.
+class MetricsServer
+{
+public:
+    MetricsServer(void);
+    ~MetricsServer(void);
+
+    // port 0 picks a free one; GetPort says which
+    bool Start(uint16_t port);
+    void Stop();
+    bool IsRunning() const;     // any thread
+    uint16_t GetPort() const;
+
+    // render thread
+    void Publish(const MetricsSnapshot& snapshot);
+
+    // any thread; false until the first Publish
+    bool GetSnapshot(MetricsSnapshot* snapshot) const;
+
+    uint32_t GetScrapeCount() const;
+
+    // the body of a scrape
+    static void Format(const MetricsSnapshot& snapshot, std::string* text);
+
+    // fills in everything FrameMetrics knows; the caller adds dropped updates
+    static void FromFrameMetrics(FrameMetrics& metrics, MetricsSnapshot* snapshot);
+
+private:
+    MetricsServer(const MetricsServer&);
+    MetricsServer& operator=(const MetricsServer&);
+
+    static const int SnapshotWords = sizeof(MetricsSnapshot) / sizeof(uint64_t);
+
+    void Serve();
+    void Respond(intptr_t client);
+
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<uint64_t> m_words[SnapshotWords];
+
+    intptr_t m_listener;
+    uint16_t m_port;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stop;
+    std::atomic<uint32_t> m_scrapes;
+    std::thread m_thread;
+};
@@ -0,0 +1,379 @@
+#include "MotionIntegrator.h"
+#include "Garden.h"
+#include <math.h>
+
+#if !defined(NODEGARDEN_SCALAR_MOTION)
+#if defined(__AVX__)
+#define MOTION_AVX
+#include <immintrin.h>
+#elif defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define MOTION_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MOTION_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(MOTION_AVX)
+static const int Lanes = 8;
+static const char* const PathName = "avx";
+#elif defined(MOTION_SSE2)
+static const int Lanes = 4;
+static const char* const PathName = "sse2";
+#elif defined(MOTION_NEON)
+static const int Lanes = 4;
+static const char* const PathName = "neon";
+#else
+static const int Lanes = 1;
+static const char* const PathName = "scalar";
+#endif
+
+const float MotionIntegrator::RestDistance = 0.5f;
+
+static bool IsMoving(float x, float y, float targetX, float targetY)
+{
+    return fabsf(targetX - x) > MotionIntegrator::RestDistance || fabsf(targetY - y) > MotionIntegrator::RestDistance;
+}
+
+// what every path has to come out with. Returns true if the node is still moving
+static bool StepOne(float* x, float* y, float targetX, float targetY, float speed, float timeDelta)
+{
+    // the inertia calculation. Only move the ellipse a fraction of the distance in the direction of the lead node
+    float dx = targetX - *x;
+    float dy = targetY - *y;
+    if (fabsf(dx) > MotionIntegrator::RestDistance)
+        *x += dx * speed * timeDelta;
+    if (fabsf(dy) > MotionIntegrator::RestDistance)
+        *y += dy * speed * timeDelta;
+
+    return IsMoving(*x, *y, targetX, targetY);
+}
+
+#if defined(MOTION_AVX)
+
+// steps Lanes nodes in place. Bit k of the result is set if node k is still moving
+static int StepBlock(float* xs, float* ys, const float* targetXs, const float* targetYs, float speed, float timeDelta)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 rest = _mm256_set1_ps(MotionIntegrator::RestDistance);
+    const __m256 speeds = _mm256_set1_ps(speed);
+    const __m256 deltas = _mm256_set1_ps(timeDelta);
+
+    __m256 x = _mm256_loadu_ps(xs);
+    __m256 y = _mm256_loadu_ps(ys);
+    __m256 tx = _mm256_loadu_ps(targetXs);
+    __m256 ty = _mm256_loadu_ps(targetYs);
+
+    __m256 dx = _mm256_sub_ps(tx, x);
+    __m256 dy = _mm256_sub_ps(ty, y);
+    __m256 moveX = _mm256_cmp_ps(_mm256_andnot_ps(sign, dx), rest, _CMP_GT_OQ);
+    __m256 moveY = _mm256_cmp_ps(_mm256_andnot_ps(sign, dy), rest, _CMP_GT_OQ);
+    x = _mm256_blendv_ps(x, _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(dx, speeds), deltas)), moveX);
+    y = _mm256_blendv_ps(y, _mm256_add_ps(y, _mm256_mul_ps(_mm256_mul_ps(dy, speeds), deltas)), moveY);
+    _mm256_storeu_ps(xs, x);
+    _mm256_storeu_ps(ys, y);
+
+    __m256 moving = _mm256_or_ps(
+        _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(tx, x)), rest, _CMP_GT_OQ),
+        _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(ty, y)), rest, _CMP_GT_OQ));
+    return _mm256_movemask_ps(moving);
+}
+
+#elif defined(MOTION_SSE2)
+
+static int StepBlock(float* xs, float* ys, const float* targetXs, const float* targetYs, float speed, float timeDelta)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 rest = _mm_set1_ps(MotionIntegrator::RestDistance);
+    const __m128 speeds = _mm_set1_ps(speed);
+    const __m128 deltas = _mm_set1_ps(timeDelta);
+
+    __m128 x = _mm_loadu_ps(xs);
+    __m128 y = _mm_loadu_ps(ys);
+    __m128 tx = _mm_loadu_ps(targetXs);
+    __m128 ty = _mm_loadu_ps(targetYs);
+
+    __m128 dx = _mm_sub_ps(tx, x);
+    __m128 dy = _mm_sub_ps(ty, y);
+    __m128 moveX = _mm_cmpgt_ps(_mm_andnot_ps(sign, dx), rest);
+    __m128 moveY = _mm_cmpgt_ps(_mm_andnot_ps(sign, dy), rest);
+    __m128 stepX = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(dx, speeds), deltas));
+    __m128 stepY = _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(dy, speeds), deltas));
+    x = _mm_or_ps(_mm_and_ps(moveX, stepX), _mm_andnot_ps(moveX, x));
+    y = _mm_or_ps(_mm_and_ps(moveY, stepY), _mm_andnot_ps(moveY, y));
+    _mm_storeu_ps(xs, x);
+    _mm_storeu_ps(ys, y);
+
+    __m128 moving = _mm_or_ps(
+        _mm_cmpgt_ps(_mm_andnot_ps(sign, _mm_sub_ps(tx, x)), rest),
+        _mm_cmpgt_ps(_mm_andnot_ps(sign, _mm_sub_ps(ty, y)), rest));
+    return _mm_movemask_ps(moving);
+}
+
+#elif defined(MOTION_NEON)
+
+static int StepBlock(float* xs, float* ys, const float* targetXs, const float* targetYs, float speed, float timeDelta)
+{
+    const float32x4_t rest = vdupq_n_f32(MotionIntegrator::RestDistance);
+    const float32x4_t speeds = vdupq_n_f32(speed);
+    const float32x4_t deltas = vdupq_n_f32(timeDelta);
+
+    float32x4_t x = vld1q_f32(xs);
+    float32x4_t y = vld1q_f32(ys);
+    float32x4_t tx = vld1q_f32(targetXs);
+    float32x4_t ty = vld1q_f32(targetYs);
+
+    float32x4_t dx = vsubq_f32(tx, x);
+    float32x4_t dy = vsubq_f32(ty, y);
+    uint32x4_t moveX = vcgtq_f32(vabsq_f32(dx), rest);
+    uint32x4_t moveY = vcgtq_f32(vabsq_f32(dy), rest);
+    x = vbslq_f32(moveX, vaddq_f32(x, vmulq_f32(vmulq_f32(dx, speeds), deltas)), x);
+    y = vbslq_f32(moveY, vaddq_f32(y, vmulq_f32(vmulq_f32(dy, speeds), deltas)), y);
+    vst1q_f32(xs, x);
+    vst1q_f32(ys, y);
+
+    // no movemask; each lane keeps its own bit and the pairwise adds sum them
+    static const uint32_t Bits[4] = { 1, 2, 4, 8 };
+    uint32x4_t moving = vorrq_u32(
+        vcgtq_f32(vabsq_f32(vsubq_f32(tx, x)), rest),
+        vcgtq_f32(vabsq_f32(vsubq_f32(ty, y)), rest));
+    uint32x4_t bits = vandq_u32(moving, vld1q_u32(Bits));
+    uint32x2_t pairs = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return (int)vget_lane_u32(vpadd_u32(pairs, pairs), 0);
+}
+
+#endif
+
+MotionIntegrator::MotionIntegrator(void)
+{
+    m_rebuild = true;
+}
+
+int MotionIntegrator::GetLanes()
+{
+    return Lanes;
+}
+
+const char* MotionIntegrator::GetPath()
+{
+    return PathName;
+}
+
+void MotionIntegrator::Invalidate()
+{
+    m_rebuild = true;
+}
+
+void MotionIntegrator::Wake(const std::vector<GardenNode>& nodes, int index)
+{
+    // a rebuild finds it anyway
+    if (m_rebuild)
+        return;
+
+    if (index >= (int)m_slots.size())
+    {
+        m_slots.resize(nodes.size(), -1);
+        Reserve((int)nodes.capacity());
+    }
+
+    const GardenNode& node = nodes[index];
+    int slot = m_slots[index];
+    if (slot < 0)
+    {
+        Add(node, index);
+        return;
+    }
+
+    m_x[slot] = node.X;
+    m_y[slot] = node.Y;
+    m_targetX[slot] = node.TargetX;
+    m_targetY[slot] = node.TargetY;
+}
+
+void MotionIntegrator::Remove(int index, int last)
+{
+    if (m_rebuild)
+        return;
+
+    int count = (int)m_slots.size();
+    int slot = index < count ? m_slots[index] : -1;
+    if (slot >= 0)
+    {
+        // the last slot fills the gap
+        int end = (int)m_active.size() - 1;
+        int moved = m_active[end];
+        m_x[slot] = m_x[end];
+        m_y[slot] = m_y[end];
+        m_targetX[slot] = m_targetX[end];
+        m_targetY[slot] = m_targetY[end];
+        m_active[slot] = moved;
+        m_slots[moved] = slot;
+        m_x.pop_back();
+        m_y.pop_back();
+        m_targetX.pop_back();
+        m_targetY.pop_back();
+        m_active.pop_back();
+        m_slots[index] = -1;
+    }
+
+    if (last != index && last < count)
+    {
+        slot = m_slots[last];
+        m_slots[index] = slot;
+        if (slot >= 0)
+            m_active[slot] = index;
+    }
+
+    if (last < count)
+        m_slots.resize(last);
+}
+
+int MotionIntegrator::GetActiveCount() const
+{
+    return (int)m_active.size();
+}
+
+int MotionIntegrator::Step(std::vector<GardenNode>& nodes, int first, float speed, float timeDelta)
+{
+    if (m_rebuild)
+        Rebuild(nodes, first);
+
+    int count = (int)m_active.size();
+    if (count == 0)
+        return 0;
+
+    GardenNode* base = &nodes[0];
+    float* xs = &m_x[0];
+    float* ys = &m_y[0];
+    float* targetXs = &m_targetX[0];
+    float* targetYs = &m_targetY[0];
+    int* active = &m_active[0];
+    int* slots = &m_slots[0];
+
+    // nodes come to rest are packed out as the step goes, everything after moving down over
+    // them; until the first one every slot stays where it is
+    int kept = 0;
+    int i = 0;
+
+#if defined(MOTION_AVX) || defined(MOTION_SSE2) || defined(MOTION_NEON)
+    for (; i + Lanes <= count; i += Lanes)
+    {
+        int moving = StepBlock(xs + i, ys + i, targetXs + i, targetYs + i, speed, timeDelta);
+        for (int k = i; k < i + Lanes; k++)
+        {
+            GardenNode& node = base[active[k]];
+            node.X = xs[k];
+            node.Y = ys[k];
+        }
+
+        if (moving == (1 << Lanes) - 1 && kept == i)
+        {
+            kept += Lanes;
+            continue;
+        }
+
+        for (int k = i; k < i + Lanes; k++, moving >>= 1)
+        {
+            int index = active[k];
+            if ((moving & 1) == 0)
+            {
+                slots[index] = -1;
+                continue;
+            }
+
+            xs[kept] = xs[k];
+            ys[kept] = ys[k];
+            targetXs[kept] = targetXs[k];
+            targetYs[kept] = targetYs[k];
+            active[kept] = index;
+            slots[index] = kept;
+            kept++;
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        int index = active[i];
+        bool moving = StepOne(&xs[i], &ys[i], targetXs[i], targetYs[i], speed, timeDelta);
+        base[index].X = xs[i];
+        base[index].Y = ys[i];
+        if (!moving)
+        {
+            slots[index] = -1;
+            continue;
+        }
+
+        if (kept == i)
+        {
+            kept++;
+            continue;
+        }
+
+        xs[kept] = xs[i];
+        ys[kept] = ys[i];
+        targetXs[kept] = targetXs[i];
+        targetYs[kept] = targetYs[i];
+        active[kept] = index;
+        slots[index] = kept;
+        kept++;
+    }
+
+    m_x.resize(kept);
+    m_y.resize(kept);
+    m_targetX.resize(kept);
+    m_targetY.resize(kept);
+    m_active.resize(kept);
+    return kept;
+}
+
+void MotionIntegrator::StepScalar(std::vector<GardenNode>& nodes, int first, float speed, float timeDelta)
+{
+    size_t count = nodes.size();
+    for (size_t i = first; i < count; i++)
+    {
+        GardenNode& node = nodes[i];
+        StepOne(&node.X, &node.Y, node.TargetX, node.TargetY, speed, timeDelta);
+    }
+}
+
+void MotionIntegrator::Rebuild(const std::vector<GardenNode>& nodes, int first)
+{
+    m_x.clear();
+    m_y.clear();
+    m_targetX.clear();
+    m_targetY.clear();
+    m_active.clear();
+    m_slots.assign(nodes.size(), -1);
+    Reserve((int)nodes.capacity());
+
+    for (size_t i = first; i < nodes.size(); i++)
+    {
+        const GardenNode& node = nodes[i];
+        if (IsMoving(node.X, node.Y, node.TargetX, node.TargetY))
+            Add(node, (int)i);
+    }
+
+    m_rebuild = false;
+}
+
+// room for every node to be moving at once, so waking them never allocates during a frame
+void MotionIntegrator::Reserve(int nodes)
+{
+    m_x.reserve(nodes);
+    m_y.reserve(nodes);
+    m_targetX.reserve(nodes);
+    m_targetY.reserve(nodes);
+    m_active.reserve(nodes);
+}
+
+void MotionIntegrator::Add(const GardenNode& node, int index)
+{
+    m_slots[index] = (int)m_active.size();
+    m_x.push_back(node.X);
+    m_y.push_back(node.Y);
+    m_targetX.push_back(node.TargetX);
+    m_targetY.push_back(node.TargetY);
+    m_active.push_back(index);
+}
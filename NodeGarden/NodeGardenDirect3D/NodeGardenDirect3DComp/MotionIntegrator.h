@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+struct GardenNode;
+
+// Eases nodes towards their targets a vector of nodes at a time, keeping only the ones still
+// moving so that nodes at rest cost nothing.
+//
+// Each axis moves on its own: it closes speed * timeDelta of the gap while the gap is over
+// RestDistance, so a node level with its target still slides sideways. A node is at rest
+// once neither axis has anything left to close, and is dropped. Wake picks a node up again
+// when its position or target moves, Remove follows a node moved in to a removed one's place,
+// and Invalidate starts again from the nodes when their indices change otherwise.
+//
+// The moving nodes' positions and targets are kept packed in arrays of their own, so a step
+// is straight runs of vector arithmetic over them, AVX 8 nodes at a time when it's compiled
+// in and SSE2 or NEON 4, with the new positions written back to the nodes afterwards. The
+// leftovers, or every node with NODEGARDEN_SCALAR_MOTION defined, go through the arithmetic
+// StepScalar does, and the results are the same bit for bit.
+class MotionIntegrator
+{
+public:
+    static const float RestDistance;
+
+    MotionIntegrator(void);
+    ~MotionIntegrator(void) {};
+
+    // nodes a step takes at once, and which instructions do it
+    static int GetLanes();
+    static const char* GetPath();
+
+    void Invalidate();
+    void Wake(const std::vector<GardenNode>& nodes, int index);
+    // the node at index has gone and the one at last moved in to its place
+    void Remove(int index, int last);
+    int GetActiveCount() const;             // as of the last Step
+
+    // moves every moving node from first on. Returns how many are still moving
+    int Step(std::vector<GardenNode>& nodes, int first, float speed, float timeDelta);
+
+    // the same over every node from first on, one at a time and keeping nothing
+    static void StepScalar(std::vector<GardenNode>& nodes, int first, float speed, float timeDelta);
+
+private:
+    void Rebuild(const std::vector<GardenNode>& nodes, int first);
+    void Reserve(int nodes);
+    void Add(const GardenNode& node, int index);
+
+    // by slot, for the moving nodes only
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_targetX;
+    std::vector<float> m_targetY;
+    std::vector<int> m_active;              // the node in each slot
+
+    std::vector<int> m_slots;               // by node, its slot, -1 at rest
+    bool m_rebuild;
+};
@@ -1,28 +1,33 @@
 #include "pch.h"
-#include "ShadowNode.h"
+#include "NodeSprite.h"
 
-ShadowNode::ShadowNode(XMFLOAT2 screenSize) : Node(screenSize)
+NodeSprite::NodeSprite()
 {
     m_zDepth = 0.1f;
+    m_opacity = 1.0f;
 }
 
-ShadowNode::ShadowNode(XMFLOAT2 screenSize, XMFLOAT2 position) : Node(screenSize)
+void NodeSprite::SetColor(const XMVECTORF32& color)
 {
-    m_zDepth = 0.1f;
-	m_position = position;
+    m_color = color;
+}
+
+void NodeSprite::SetDepth(float zDepth)
+{
+    m_zDepth = zDepth;
 }
 
-void ShadowNode::FinishConnection()
+void NodeSprite::SetNode(const GardenNode& node)
 {
-    // calculate the shadow sizes from NormalisedConnectedness
-    m_outlineSize = m_size + Map(m_normalisedConnectedness, 0, 1, (float)EllipseOutlineMin, (float)EllipseOutlineMax);
-    m_shadow1Size = (m_normalisedConnectedness * Shadow1Multiplier);
-    m_shadow2Size = (m_normalisedConnectedness * Shadow2Multiplier);
-   
-    Node::FinishConnection();
+    m_position = XMFLOAT2(node.X, node.Y);
+    m_size = node.Size;
+    m_outlineSize = node.OutlineSize;
+    m_shadow1Size = node.Shadow1Size;
+    m_shadow2Size = node.Shadow2Size;
+    m_opacity = node.Opacity;
 }
 
-void ShadowNode::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
+void NodeSprite::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
 {
     // center all the ellipses on our position taking in to account their sizes
     m_halfSize = m_size / 2;
@@ -31,7 +36,9 @@ void ShadowNode::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
     m_destRect.top =    (long)(m_position.y - m_halfSize);  
     m_destRect.right  = (long)(m_destRect.left + m_size);  
     m_destRect.bottom = (long)(m_destRect.top + m_size);
-    sb->Draw(texture, m_destRect, NULL, m_color, 0.0f, XMFLOAT2(0,0), SpriteEffects_None, m_zDepth);
+    XMVECTORF32 fill = m_color;
+    fill.f[3] *= m_opacity;
+    sb->Draw(texture, m_destRect, NULL, fill, 0.0f, XMFLOAT2(0,0), SpriteEffects_None, m_zDepth);
     
     m_halfSize -= (m_size - m_outlineSize) / 2;
 
@@ -39,7 +46,7 @@ void ShadowNode::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
     m_destRect.top =    (long)(m_position.y - m_halfSize);  
     m_destRect.right  = (long)(m_destRect.left + m_outlineSize);  
     m_destRect.bottom = (long)(m_destRect.top + m_outlineSize);
-    XMVECTORF32 color = {0.6f, 0.6f, 0.6f, 1.0f};
+    XMVECTORF32 color = {0.6f, 0.6f, 0.6f, m_opacity};
     sb->Draw(texture, m_destRect, NULL, color, 0.0f, XMFLOAT2(0,0), SpriteEffects_None, 0.2f);
             
     m_halfSize -= (m_outlineSize - m_shadow1Size) / 2;
@@ -48,7 +55,7 @@ void ShadowNode::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
     m_destRect.top =    (long)(m_position.y - m_halfSize);  
     m_destRect.right  = (long)(m_destRect.left + m_shadow1Size);  
     m_destRect.bottom = (long)(m_destRect.top + m_shadow1Size);
-    color.f[0] = 1.0f; color.f[1] = 1.0f; color.f[2] = 1.0f; color.f[3] = 0.3f;
+    color.f[0] = 1.0f; color.f[1] = 1.0f; color.f[2] = 1.0f; color.f[3] = 0.3f * m_opacity;
     sb->Draw(texture, m_destRect, NULL, color, 0.0f, XMFLOAT2(0,0), SpriteEffects_None, 0.3f);
             
     m_halfSize -= (m_shadow1Size - m_shadow2Size) / 2;
@@ -57,8 +64,6 @@ void ShadowNode::DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture)
     m_destRect.top =    (long)(m_position.y - m_halfSize);  
     m_destRect.right  = (long)(m_destRect.left + m_shadow2Size);  
     m_destRect.bottom = (long)(m_destRect.top + m_shadow2Size);
-    color.f[3] = 0.2f;
+    color.f[3] = 0.2f * m_opacity;
     sb->Draw(texture, m_destRect, NULL, color, 0.0f, XMFLOAT2(0,0), SpriteEffects_None, 0.4f);
-    
-    MaxConnectedness -= 0.00001f;
-}
\ No newline at end of file
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Sprite.h"
+#include "Garden.h"
+
+using namespace DirectX;
+
+// Draws a garden node as a filled ellipse with an outline and two soft shadows
+class NodeSprite : public Sprite
+{
+public:
+    NodeSprite(void);
+    ~NodeSprite(void) {};
+
+    void SetColor(const XMVECTORF32& color);
+    void SetDepth(float zDepth);
+    void SetNode(const GardenNode& node);
+
+    virtual void DrawSprites(SpriteBatch* sb, ID3D11ShaderResourceView* texture) override;
+
+    static const int SpritesPerNode = 4;            // fill, outline and two shadows
+
+protected:
+    XMFLOAT2 m_position;
+    float m_size;
+    float m_halfSize;
+    float m_outlineSize;
+    float m_shadow1Size;
+    float m_shadow2Size;
+    float m_opacity;                                // scales every ellipse's alpha
+};
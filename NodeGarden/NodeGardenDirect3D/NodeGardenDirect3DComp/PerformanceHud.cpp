@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "PerformanceHud.h"
+#include <stdio.h>
+
+using namespace Microsoft::WRL;
+
+const float PerformanceHud::TargetFrameTime = 1.0f / 60.0f;
+
+PerformanceHud::PerformanceHud(void)
+{
+    m_framesUntilRefresh = 0;
+    m_text[0] = L'\0';
+}
+
+void PerformanceHud::CreateDeviceResources(ID3D11Device* device)
+{
+    try
+    {
+        m_font = std::unique_ptr<SpriteFont>(new SpriteFont(device, L"hud.spritefont"));
+    }
+    catch (std::exception& e)
+    {
+        // the graph still draws without the text, but say why it's missing
+        char message[256];
+        sprintf(message, "PerformanceHud: couldn't load hud.spritefont (%.200s), drawing the graph alone\n", e.what());
+        OutputDebugStringA(message);
+        m_font = nullptr;
+    }
+    catch (...)
+    {
+        OutputDebugStringA("PerformanceHud: couldn't load hud.spritefont, drawing the graph alone\n");
+        m_font = nullptr;
+    }
+
+    // a single white texel, tinted and stretched for the graph bars
+    static const uint32_t white = 0xffffffff;
+    D3D11_SUBRESOURCE_DATA initData = { &white, sizeof(uint32_t), 0 };
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+
+    ComPtr<ID3D11Texture2D> texture;
+    DX::ThrowIfFailed(
+        device->CreateTexture2D(&desc, &initData, &texture)
+        );
+
+    DX::ThrowIfFailed(
+        device->CreateShaderResourceView(texture.Get(), nullptr, &m_whiteTexture)
+        );
+}
+
+void PerformanceHud::Draw(SpriteBatch* sb, FrameMetrics& metrics)
+{
+    int count = metrics.GetSampleCount();
+    long graphTop = Margin;
+    long graphWidth = FrameMetrics::HistoryLength * BarWidth;
+
+    XMVECTORF32 background = { 0.0f, 0.0f, 0.0f, 0.6f };
+    DrawRect(sb, Margin, graphTop, graphWidth, GraphHeight, background);
+
+    // newest frame on the right; the graph spans two target frames
+    for (int age = 0; age < count; age++)
+    {
+        float frameTime = metrics.GetSample(age).FrameTime;
+        float fraction = frameTime / (TargetFrameTime * 2);
+        if (fraction > 1.0f)
+            fraction = 1.0f;
+
+        long height = (long)(fraction * GraphHeight);
+        long left = Margin + graphWidth - (age + 1) * BarWidth;
+
+        XMVECTORF32 color = { 0.3f, 0.9f, 0.3f, 0.9f };
+        if (frameTime > TargetFrameTime * 1.5f)
+        {
+            color.f[0] = 0.9f; color.f[1] = 0.3f;
+        }
+        else if (frameTime > TargetFrameTime * 1.05f)
+        {
+            color.f[0] = 0.9f; color.f[1] = 0.8f;
+        }
+
+        DrawRect(sb, left, graphTop + GraphHeight - height, BarWidth - 1, height, color);
+    }
+
+    XMVECTORF32 targetLine = { 1.0f, 1.0f, 1.0f, 0.5f };
+    DrawRect(sb, Margin, graphTop + GraphHeight / 2, graphWidth, 1, targetLine);
+
+    if (!m_font)
+        return;
+
+    if (--m_framesUntilRefresh <= 0)
+    {
+        m_framesUntilRefresh = TextRefreshFrames;
+
+        FrameSummary summary;
+        metrics.Summarise(&summary);
+
+        swprintf(m_text, sizeof(m_text) / sizeof(m_text[0]),
+            L"frame %.1f ms avg  %.1f ms p99\n"
+            L"sim %.1f ms  render %.1f ms\n"
+            L"nodes %u  pairs %llu  connections %u\n"
+            L"sprites %u  net %.0f/s",
+            summary.AverageFrameTime * 1000.0f, summary.P99FrameTime * 1000.0f,
+            summary.AverageSimTime * 1000.0f, summary.AverageRenderTime * 1000.0f,
+            summary.Last.Nodes, (unsigned long long)summary.Last.PairsTested, summary.Last.Connections,
+            summary.Last.SpritesSubmitted, summary.NetworkUpdatesPerSecond);
+    }
+
+    m_font->DrawString(sb, m_text, XMFLOAT2((float)Margin, (float)(graphTop + GraphHeight + Margin)));
+}
+
+void PerformanceHud::DrawRect(SpriteBatch* sb, long left, long top, long width, long height, FXMVECTOR color)
+{
+    RECT rect = { left, top, left + width, top + height };
+    sb->Draw(m_whiteTexture.Get(), rect, color);
+}
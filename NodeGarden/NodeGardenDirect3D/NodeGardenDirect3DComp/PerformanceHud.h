@@ -0,0 +1,36 @@
+#pragma once
+
+#include "DirectXHelper.h"
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+#include "FrameMetrics.h"
+
+using namespace DirectX;
+
+// Overlay showing where frame time goes, drawn in render target pixels over the garden.
+// Text needs hud.spritefont (built with MakeSpriteFont) in the package; without it only
+// the frame time graph is drawn.
+class PerformanceHud
+{
+public:
+    PerformanceHud(void);
+    ~PerformanceHud(void) {};
+
+    void CreateDeviceResources(ID3D11Device* device);
+    void Draw(SpriteBatch* sb, FrameMetrics& metrics);
+
+protected:
+    static const int TextRefreshFrames = 15;    // the numbers are unreadable if they change every frame
+    static const int BarWidth = 3;
+    static const int GraphHeight = 80;
+    static const int Margin = 10;
+    static const float TargetFrameTime;
+
+private:
+    void DrawRect(SpriteBatch* sb, long left, long top, long width, long height, FXMVECTOR color);
+
+    std::unique_ptr<SpriteFont> m_font;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_whiteTexture;
+    int m_framesUntilRefresh;
+    wchar_t m_text[512];
+};
@@ -0,0 +1,316 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#include <time.h>
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+    // Written only by its own thread. Written counts every event ever recorded, so a capture
+    // can start by remembering where it is instead of resetting a ring another thread owns.
+    struct ThreadBuffer
+    {
+        ProfileEvent Events[Profiler::EventsPerThread];
+        std::atomic<uint64_t> Written;
+        uint64_t CaptureStart;
+        uint32_t Depth;
+        uint32_t Thread;
+        std::string Name;
+    };
+
+    std::mutex s_mutex;
+    std::vector<ThreadBuffer*> s_buffers;
+    uint64_t s_captureStartTime;
+    PROFILER_THREAD_LOCAL ThreadBuffer* t_buffer;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (t_buffer == nullptr)
+        {
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->Written = 0;
+            buffer->CaptureStart = 0;
+            buffer->Depth = 0;
+
+            // buffers live until the process exits, so a trace can still name threads that are gone
+            std::lock_guard<std::mutex> lock(s_mutex);
+            buffer->Thread = (uint32_t)s_buffers.size() + 1;
+            s_buffers.push_back(buffer);
+            t_buffer = buffer;
+        }
+
+        return t_buffer;
+    }
+
+    // the oldest event still in the ring that belongs to this capture
+    uint64_t FirstEvent(const ThreadBuffer* buffer, uint64_t written)
+    {
+        uint64_t first = written > Profiler::EventsPerThread ? written - Profiler::EventsPerThread : 0;
+        return first > buffer->CaptureStart ? first : buffer->CaptureStart;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double percentile)
+    {
+        size_t index = (size_t)(percentile * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+}
+
+std::atomic<bool> Profiler::s_capturing(false);
+std::atomic<int> Profiler::s_framesLeft(0);
+
+void Profiler::StartCapture(int frameCount)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (size_t i = 0; i < s_buffers.size(); i++)
+    {
+        s_buffers[i]->CaptureStart = s_buffers[i]->Written.load(std::memory_order_acquire);
+    }
+
+    s_captureStartTime = Now();
+    s_framesLeft.store(frameCount > 0 ? frameCount : 1, std::memory_order_relaxed);
+    s_capturing.store(true, std::memory_order_release);
+}
+
+void Profiler::StopCapture()
+{
+    s_capturing.store(false, std::memory_order_release);
+}
+
+bool Profiler::IsCapturing()
+{
+    return s_capturing.load(std::memory_order_relaxed);
+}
+
+bool Profiler::EndFrame()
+{
+    if (!s_capturing.load(std::memory_order_relaxed))
+        return false;
+
+    if (s_framesLeft.fetch_sub(1, std::memory_order_relaxed) > 1)
+        return false;
+
+    StopCapture();
+    return true;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    buffer->Name = name;
+}
+
+bool Profiler::BeginScope()
+{
+    if (!s_capturing.load(std::memory_order_relaxed))
+        return false;
+
+    GetThreadBuffer()->Depth++;
+    return true;
+}
+
+void Profiler::EndScope(const char* name, uint64_t start)
+{
+    uint64_t end = Now();
+    ThreadBuffer* buffer = t_buffer;
+    buffer->Depth--;
+
+    uint64_t written = buffer->Written.load(std::memory_order_relaxed);
+    ProfileEvent& event = buffer->Events[written % EventsPerThread];
+    event.Name = name;
+    event.Start = start;
+    event.End = end;
+    event.Depth = buffer->Depth;
+    event.Thread = buffer->Thread;
+
+    // publishes the event to readers
+    buffer->Written.store(written + 1, std::memory_order_release);
+}
+
+void Profiler::GetEvents(std::vector<ProfileEvent>* events)
+{
+    events->clear();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (size_t i = 0; i < s_buffers.size(); i++)
+    {
+        const ThreadBuffer* buffer = s_buffers[i];
+        uint64_t written = buffer->Written.load(std::memory_order_acquire);
+
+        for (uint64_t index = FirstEvent(buffer, written); index < written; index++)
+        {
+            events->push_back(buffer->Events[index % EventsPerThread]);
+        }
+    }
+}
+
+uint64_t Profiler::GetDroppedEvents()
+{
+    uint64_t dropped = 0;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (size_t i = 0; i < s_buffers.size(); i++)
+    {
+        uint64_t written = s_buffers[i]->Written.load(std::memory_order_acquire);
+        dropped += FirstEvent(s_buffers[i], written) - s_buffers[i]->CaptureStart;
+    }
+
+    return dropped;
+}
+
+void Profiler::GetHistograms(std::vector<ScopeHistogram>* histograms)
+{
+    std::vector<ProfileEvent> events;
+    GetEvents(&events);
+    histograms->clear();
+
+    // scope names are string literals, but the same text can live at different addresses
+    std::vector<std::pair<std::string, std::vector<double> > > scopes;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        size_t scope = 0;
+        while (scope < scopes.size() && scopes[scope].first != events[i].Name)
+            scope++;
+
+        if (scope == scopes.size())
+            scopes.push_back(std::make_pair(std::string(events[i].Name), std::vector<double>()));
+
+        scopes[scope].second.push_back(TicksToNs(events[i].End - events[i].Start));
+    }
+
+    for (size_t i = 0; i < scopes.size(); i++)
+    {
+        std::vector<double>& durations = scopes[i].second;
+        std::sort(durations.begin(), durations.end());
+
+        ScopeHistogram histogram;
+        histogram.Name = scopes[i].first;
+        histogram.Count = (uint32_t)durations.size();
+        histogram.TotalNs = 0;
+        histogram.MinNs = durations.front();
+        histogram.MedianNs = Percentile(durations, 0.5);
+        histogram.P99Ns = Percentile(durations, 0.99);
+        histogram.MaxNs = durations.back();
+        memset(histogram.Buckets, 0, sizeof(histogram.Buckets));
+
+        for (size_t j = 0; j < durations.size(); j++)
+        {
+            histogram.TotalNs += durations[j];
+
+            int bucket = 0;
+            for (double limit = 2; durations[j] >= limit && bucket < ScopeHistogram::BucketCount - 1; limit *= 2)
+                bucket++;
+            histogram.Buckets[bucket]++;
+        }
+
+        histograms->push_back(histogram);
+    }
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+    std::vector<ProfileEvent> events;
+    GetEvents(&events);
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (size_t i = 0; i < s_buffers.size(); i++)
+        {
+            if (s_buffers[i]->Name.empty())
+                continue;
+
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",\n", s_buffers[i]->Thread, s_buffers[i]->Name.c_str());
+            first = false;
+        }
+    }
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        // microseconds from the start of the capture
+        double start = events[i].Start > s_captureStartTime ? TicksToNs(events[i].Start - s_captureStartTime) / 1000 : 0;
+        double duration = TicksToNs(events[i].End - events[i].Start) / 1000;
+
+        fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+            first ? "" : ",\n", events[i].Name, events[i].Thread, start, duration);
+        first = false;
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+bool Profiler::WriteHistograms(const std::string& path)
+{
+    std::vector<ScopeHistogram> histograms;
+    GetHistograms(&histograms);
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "%-24s %8s %12s %12s %12s %12s %12s\n", "scope", "count", "mean ns", "min ns", "median ns", "p99 ns", "max ns");
+    for (size_t i = 0; i < histograms.size(); i++)
+    {
+        const ScopeHistogram& histogram = histograms[i];
+        fprintf(file, "%-24s %8u %12.0f %12.0f %12.0f %12.0f %12.0f\n", histogram.Name.c_str(), histogram.Count,
+            histogram.TotalNs / histogram.Count, histogram.MinNs, histogram.MedianNs, histogram.P99Ns, histogram.MaxNs);
+
+        // one row per power of two that has anything in it
+        for (int bucket = 0; bucket < ScopeHistogram::BucketCount; bucket++)
+        {
+            if (histogram.Buckets[bucket] != 0)
+                fprintf(file, "    >= %10.0f ns %8u\n", (double)(1u << bucket), histogram.Buckets[bucket]);
+        }
+    }
+
+    fprintf(file, "dropped events: %llu\n", (unsigned long long)GetDroppedEvents());
+    return fclose(file) == 0;
+}
+
+uint64_t Profiler::Now()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+double Profiler::TicksToNs(uint64_t ticks)
+{
+#if defined(_WIN32)
+    static double nsPerTick = 0;
+    if (nsPerTick == 0)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        nsPerTick = 1e9 / (double)frequency.QuadPart;
+    }
+    return ticks * nsPerTick;
+#else
+    return (double)ticks;
+#endif
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Scopes are compiled in for debug builds, and for release builds that define
+// NODEGARDEN_PROFILE. Otherwise PROFILE_SCOPE expands to nothing.
+#if defined(_DEBUG) || defined(NODEGARDEN_PROFILE)
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+
+// One timed scope, in Profiler::Now ticks
+struct ProfileEvent
+{
+    const char* Name;
+    uint64_t Start;
+    uint64_t End;
+    uint32_t Depth;             // how many scopes were open around it on its thread
+    uint32_t Thread;
+};
+
+struct ScopeHistogram
+{
+    static const int BucketCount = 32;  // bucket i counts durations in [2^i, 2^(i+1)) ns; bucket 0 starts at 0
+
+    std::string Name;
+    uint32_t Count;
+    double TotalNs;
+    double MinNs;
+    double MedianNs;
+    double P99Ns;
+    double MaxNs;
+    uint32_t Buckets[BucketCount];
+};
+
+// Records named scopes while a capture is running. Each thread writes its own ring, so a
+// scope costs two clock reads and a store with no locks; when nothing is capturing it is one
+// relaxed load. Reading the results (events, histograms, Chrome trace) is meant for after the
+// capture has finished and takes a lock.
+class Profiler
+{
+public:
+    static const int EventsPerThread = 1 << 16;     // older events are overwritten
+
+    // record the next frameCount frames, as counted by EndFrame
+    static void StartCapture(int frameCount);
+    static void StopCapture();
+    static bool IsCapturing();
+
+    // call once per frame on the render thread. Returns true on the frame a capture ends
+    static bool EndFrame();
+
+    // shown in the trace viewer; call on the thread being named
+    static void SetThreadName(const char* name);
+
+    static void GetEvents(std::vector<ProfileEvent>* events);
+    static void GetHistograms(std::vector<ScopeHistogram>* histograms);
+    static uint64_t GetDroppedEvents();
+
+    // chrome://tracing and Perfetto load this directly
+    static bool WriteChromeTrace(const std::string& path);
+    static bool WriteHistograms(const std::string& path);
+
+    static uint64_t Now();
+    static double TicksToNs(uint64_t ticks);
+
+    // for ProfileScope
+    static bool BeginScope();
+    static void EndScope(const char* name, uint64_t start);
+
+private:
+    static std::atomic<bool> s_capturing;
+    static std::atomic<int> s_framesLeft;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name)
+    {
+        m_name = Profiler::BeginScope() ? name : nullptr;
+        m_start = m_name != nullptr ? Profiler::Now() : 0;
+    }
+
+    ~ProfileScope()
+    {
+        if (m_name != nullptr)
+            Profiler::EndScope(m_name, m_start);
+    }
+
+private:
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+    const char* m_name;
+    uint64_t m_start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,230 @@
+#include "Quadtree.h"
+#include "Garden.h"
+#include <float.h>
+
+Quadtree::Quadtree(void)
+{
+    m_nodeCount = 0;
+    m_builtSpread = 0;
+    m_spread = 0;
+    m_depth = 0;
+    m_builds = 0;
+}
+
+void Quadtree::Build(const std::vector<GardenNode>& nodes)
+{
+    int count = (int)nodes.size();
+    m_nodeCount = nodes.size();
+    m_builds++;
+    m_depth = 0;
+
+    m_items.resize(count);
+    m_scratch.resize(count);
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        m_items[i] = i;
+
+        const GardenNode& node = nodes[i];
+        if (node.X < minX) minX = node.X;
+        if (node.Y < minY) minY = node.Y;
+        if (node.X > maxX) maxX = node.X;
+        if (node.Y > maxY) maxY = node.Y;
+    }
+
+    m_cells.clear();
+    m_regions.clear();
+
+    Cell root = { 0, 0, 0, 0, 0, count, -1 };
+    float size = maxX - minX > maxY - minY ? maxX - minX : maxY - minY;
+    Region rootRegion = { minX, minY, count > 0 ? size : 0, 0 };
+    m_cells.push_back(root);
+    m_regions.push_back(rootRegion);
+
+    // children are always added after their parent, so walking the list in order visits every
+    // cell once, and walking it backwards visits children before parents
+    for (size_t c = 0; c < m_cells.size(); c++)
+    {
+        Region region = m_regions[c];
+        if (region.Depth > m_depth)
+            m_depth = region.Depth;
+
+        if (m_cells[c].Count <= LeafSize || region.Depth >= MaxDepth || !(region.Size > 0))
+            continue;
+
+        // counting sort of the cell's items in to its quarters
+        int first = m_cells[c].First;
+        int last = first + m_cells[c].Count;
+        float half = region.Size / 2;
+        float midX = region.X + half;
+        float midY = region.Y + half;
+        int counts[4] = { 0, 0, 0, 0 };
+        for (int i = first; i < last; i++)
+        {
+            const GardenNode& node = nodes[m_items[i]];
+            counts[(node.X >= midX ? 1 : 0) + (node.Y >= midY ? 2 : 0)]++;
+        }
+
+        int starts[4] = { first, first + counts[0], first + counts[0] + counts[1], first + counts[0] + counts[1] + counts[2] };
+        int next[4] = { starts[0], starts[1], starts[2], starts[3] };
+        for (int i = first; i < last; i++)
+        {
+            const GardenNode& node = nodes[m_items[i]];
+            m_scratch[next[(node.X >= midX ? 1 : 0) + (node.Y >= midY ? 2 : 0)]++] = m_items[i];
+        }
+        for (int i = first; i < last; i++)
+        {
+            m_items[i] = m_scratch[i];
+        }
+
+        m_cells[c].Children = (int)m_cells.size();
+        for (int quarter = 0; quarter < 4; quarter++)
+        {
+            Cell child = { 0, 0, 0, 0, starts[quarter], counts[quarter], -1 };
+            Region childRegion = { quarter & 1 ? midX : region.X, quarter & 2 ? midY : region.Y, half, region.Depth + 1 };
+            m_cells.push_back(child);
+            m_regions.push_back(childRegion);
+        }
+    }
+
+    m_x.resize(count);
+    m_y.resize(count);
+    Refit(nodes);
+    m_builtSpread = m_spread;
+}
+
+void Quadtree::Refit(const std::vector<GardenNode>& nodes)
+{
+    int count = (int)m_items.size();
+    for (int i = 0; i < count; i++)
+    {
+        const GardenNode& node = nodes[m_items[i]];
+        m_x[i] = node.X;
+        m_y[i] = node.Y;
+    }
+
+    for (int c = (int)m_cells.size() - 1; c >= 0; c--)
+    {
+        Cell& cell = m_cells[c];
+        cell.MinX = FLT_MAX;
+        cell.MinY = FLT_MAX;
+        cell.MaxX = -FLT_MAX;
+        cell.MaxY = -FLT_MAX;
+
+        if (cell.Children < 0)
+        {
+            for (int i = cell.First; i < cell.First + cell.Count; i++)
+            {
+                if (m_x[i] < cell.MinX) cell.MinX = m_x[i];
+                if (m_y[i] < cell.MinY) cell.MinY = m_y[i];
+                if (m_x[i] > cell.MaxX) cell.MaxX = m_x[i];
+                if (m_y[i] > cell.MaxY) cell.MaxY = m_y[i];
+            }
+            continue;
+        }
+
+        for (int quarter = 0; quarter < 4; quarter++)
+        {
+            const Cell& child = m_cells[cell.Children + quarter];
+            if (child.Count == 0)
+                continue;
+
+            if (child.MinX < cell.MinX) cell.MinX = child.MinX;
+            if (child.MinY < cell.MinY) cell.MinY = child.MinY;
+            if (child.MaxX > cell.MaxX) cell.MaxX = child.MaxX;
+            if (child.MaxY > cell.MaxY) cell.MaxY = child.MaxY;
+        }
+    }
+
+    m_spread = LeafSpread();
+}
+
+bool Quadtree::NeedsRebuild(const std::vector<GardenNode>& nodes) const
+{
+    if (nodes.size() != m_nodeCount || m_cells.empty())
+        return true;
+
+    // a pixel a leaf of slack, so a tree built over nodes sitting on one spot isn't rebuilt
+    // the moment any of them moves
+    return m_spread > m_builtSpread * 2 + (float)m_cells.size();
+}
+
+uint64_t Quadtree::Query(float x, float y, float radiusSquared, int after, std::vector<QuadtreeHit>* hits) const
+{
+    if (m_cells.empty() || m_cells[0].Count == 0)
+        return 0;
+
+    int stack[MaxDepth * 3 + 4];
+    int depth = 0;
+    uint64_t tested = 0;
+    stack[depth++] = 0;
+
+    while (depth > 0)
+    {
+        const Cell& cell = m_cells[stack[--depth]];
+
+        // nearest point of the bounds. Rounding never makes this further than the
+        // distance to a node inside them, so nothing in range is skipped
+        float dx = x < cell.MinX ? cell.MinX - x : (x > cell.MaxX ? x - cell.MaxX : 0);
+        float dy = y < cell.MinY ? cell.MinY - y : (y > cell.MaxY ? y - cell.MaxY : 0);
+        if (dx * dx + dy * dy >= radiusSquared)
+            continue;
+
+        if (cell.Children >= 0)
+        {
+            for (int quarter = 0; quarter < 4; quarter++)
+            {
+                if (m_cells[cell.Children + quarter].Count > 0)
+                    stack[depth++] = cell.Children + quarter;
+            }
+            continue;
+        }
+
+        for (int i = cell.First; i < cell.First + cell.Count; i++)
+        {
+            if (m_items[i] <= after)
+                continue;
+
+            float nodeDx = x - m_x[i];
+            float nodeDy = y - m_y[i];
+            float distanceSquared = nodeDx * nodeDx + nodeDy * nodeDy;
+            tested++;
+
+            if (distanceSquared < radiusSquared)
+            {
+                QuadtreeHit hit = { m_items[i], distanceSquared };
+                hits->push_back(hit);
+            }
+        }
+    }
+
+    return tested;
+}
+
+int Quadtree::GetCellCount() const
+{
+    return (int)m_cells.size();
+}
+
+int Quadtree::GetDepth() const
+{
+    return m_depth;
+}
+
+uint32_t Quadtree::GetBuildCount() const
+{
+    return m_builds;
+}
+
+float Quadtree::LeafSpread() const
+{
+    float spread = 0;
+    for (size_t c = 0; c < m_cells.size(); c++)
+    {
+        const Cell& cell = m_cells[c];
+        if (cell.Children < 0 && cell.Count > 0)
+            spread += (cell.MaxX - cell.MinX) + (cell.MaxY - cell.MinY);
+    }
+
+    return spread;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+struct GardenNode;
+
+// A node found by Quadtree::Query
+struct QuadtreeHit
+{
+    int Index;
+    float DistanceSquared;
+};
+
+// An adaptive quadtree over the garden's node positions, for fixed radius queries.
+//
+// Build splits any cell holding more than LeafSize nodes in to quarters, so it goes deep only
+// where nodes crowd together; a garden where everyone stands in a few spots ends up with a
+// few deep branches rather than a uniform grid with a handful of overfull cells. Each leaf
+// keeps its nodes contiguous, with their positions copied alongside in the same order.
+//
+// Nodes move a little every frame, so rather than rebuilding, Refit copies the new positions
+// in and grows each cell's bounds to cover wherever its nodes have got to. Queries test
+// against those bounds, so a refitted tree always gives exact answers; it only gets slower
+// as the bounds spread, which NeedsRebuild watches for.
+class Quadtree
+{
+public:
+    static const int LeafSize = 16;
+    static const int MaxDepth = 16;         // nodes piled on one spot stop splitting here
+
+    Quadtree(void);
+    ~Quadtree(void) {};
+
+    void Build(const std::vector<GardenNode>& nodes);
+    void Refit(const std::vector<GardenNode>& nodes);
+
+    // true if the node count changed since Build, or refitting has spread the leaves to more
+    // than twice the size they were built at
+    bool NeedsRebuild(const std::vector<GardenNode>& nodes) const;
+
+    // Appends every node with an index above after whose squared distance from (x, y),
+    // worked out as (x - X)^2 + (y - Y)^2, is under radiusSquared. Hits come out in no
+    // particular order. Returns how many distances were worked out.
+    uint64_t Query(float x, float y, float radiusSquared, int after, std::vector<QuadtreeHit>* hits) const;
+
+    int GetCellCount() const;
+    int GetDepth() const;
+    uint32_t GetBuildCount() const;
+
+private:
+    struct Cell
+    {
+        float MinX;                 // bounds of the nodes in the cell, as of the last Refit
+        float MinY;
+        float MaxX;
+        float MaxY;
+        int First;                  // in to m_items
+        int Count;
+        int Children;               // first of four consecutive cells, or -1 for a leaf
+    };
+
+    // the square a cell covers while building, which the bounds can later grow past
+    struct Region
+    {
+        float X;
+        float Y;
+        float Size;
+        int Depth;
+    };
+
+    float LeafSpread() const;
+
+    std::vector<Cell> m_cells;
+    std::vector<Region> m_regions;
+    std::vector<int> m_items;               // node indices, each cell's contiguous
+    std::vector<int> m_scratch;
+    std::vector<float> m_x;                 // positions in m_items order
+    std::vector<float> m_y;
+
+    size_t m_nodeCount;
+    float m_builtSpread;
+    float m_spread;
+    int m_depth;
+    uint32_t m_builds;
+};
@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "ResourceCache.h"
+#include "DDSTextureLoader.h"
+
+using namespace Concurrency;
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+ResourceCache::ResourceCache(ID3D11Device* device) :
+    m_device(device)
+{
+}
+
+void ResourceCache::LoadTextureAsync(const std::wstring& fileName)
+{
+    if (m_textures.find(fileName) != m_textures.end())
+        return;
+
+    // the loader only holds on to the entry and device, so the cache can go away mid-load
+    auto entry = std::make_shared<TextureEntry>();
+    m_textures[fileName] = entry;
+    ComPtr<ID3D11Device> device = m_device;
+
+    auto folder = Windows::ApplicationModel::Package::Current->InstalledLocation;
+    Platform::String^ path = folder->Path + L"\\" + ref new Platform::String(fileName.c_str());
+
+    create_task([entry, device, path] ()
+    {
+        // Open validates the header and every subresource before anything reaches the device
+        DDSReader reader;
+        if (reader.Open(path->Data()) != DDSResult_Ok)
+        {
+            entry->result = E_FAIL;
+        }
+        else
+        {
+            entry->result = CreateTexture(device.Get(), reader, &entry->view);
+        }
+
+        entry->ready = true;
+    });
+}
+
+ID3D11ShaderResourceView* ResourceCache::GetTexture(const std::wstring& fileName)
+{
+    auto it = m_textures.find(fileName);
+    if (it == m_textures.end() || !it->second->ready || FAILED(it->second->result))
+        return nullptr;
+
+    return it->second->view.Get();
+}
+
+HRESULT ResourceCache::CreateTexture(ID3D11Device* device, const DDSReader& reader, ID3D11ShaderResourceView** textureView)
+{
+    const DDSInfo& info = reader.GetInfo();
+
+    // cube maps and volumes are rare enough to leave to DDSTextureLoader, which still
+    // reads from the mapping rather than a copy
+    if (info.IsCubeMap || info.IsVolume)
+    {
+        return CreateDDSTextureFromMemory(device, reader.GetData(), reader.GetSize(), nullptr, textureView);
+    }
+
+    // initial data points straight into the mapped file
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(reader.GetSubresourceCount());
+    const DDSSubresource* subresources = reader.GetSubresources();
+    for (size_t i = 0; i < initData.size(); i++)
+    {
+        initData[i].pSysMem = subresources[i].Data;
+        initData[i].SysMemPitch = static_cast<UINT>(subresources[i].RowPitch);
+        initData[i].SysMemSlicePitch = static_cast<UINT>(subresources[i].SlicePitch);
+    }
+
+    CD3D11_TEXTURE2D_DESC desc(
+        static_cast<DXGI_FORMAT>(info.Format),
+        info.Width,
+        info.Height,
+        info.ArraySize,
+        info.MipCount,
+        D3D11_BIND_SHADER_RESOURCE
+        );
+
+    ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = device->CreateTexture2D(&desc, &initData[0], &texture);
+    if (FAILED(hr))
+        return hr;
+
+    return device->CreateShaderResourceView(texture.Get(), nullptr, textureView);
+}
+
+ID3D11BlendState* ResourceCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+    for (auto it = m_blendStates.begin(); it != m_blendStates.end(); ++it)
+    {
+        if (memcmp(&it->first, &desc, sizeof(D3D11_BLEND_DESC)) == 0)
+            return it->second.Get();
+    }
+
+    ComPtr<ID3D11BlendState> blendState;
+    DX::ThrowIfFailed(
+        m_device->CreateBlendState(&desc, &blendState)
+        );
+
+    m_blendStates.push_back(std::make_pair(desc, blendState));
+    return blendState.Get();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DirectXHelper.h"
+#include "DDSReader.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Resources that live as long as the device: textures that are loaded once on a background
+// thread, and state objects shared by description. Nothing in here depends on the render
+// target size, so resizing the surface never touches it.
+class ResourceCache
+{
+public:
+    explicit ResourceCache(ID3D11Device* device);
+    ~ResourceCache(void) {};
+
+    // Starts loading a DDS file from the app package unless it's already loaded or loading.
+    // The file is memory mapped and the texture created straight from the mapping.
+    void LoadTextureAsync(const std::wstring& fileName);
+
+    // The texture's view, or nullptr while it is still loading or if it failed to load.
+    ID3D11ShaderResourceView* GetTexture(const std::wstring& fileName);
+
+    ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+
+private:
+    static HRESULT CreateTexture(ID3D11Device* device, const DDSReader& reader, ID3D11ShaderResourceView** textureView);
+
+    struct TextureEntry
+    {
+        TextureEntry() : result(S_OK), ready(false) {};
+
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view;
+        HRESULT result;
+        std::atomic<bool> ready;    // set by the loader once view and result are written
+    };
+
+    Microsoft::WRL::ComPtr<ID3D11Device> m_device;
+    std::map<std::wstring, std::shared_ptr<TextureEntry>> m_textures;
+    std::vector<std::pair<D3D11_BLEND_DESC, Microsoft::WRL::ComPtr<ID3D11BlendState>>> m_blendStates;
+};
@@ -0,0 +1,166 @@
+#include "TaskPool.h"
+#include "Profiler.h"
+#include <atomic>
+
+TaskPool::TaskPool(int workerCount)
+{
+    m_quit = false;
+    for (int i = 0; i < workerCount; i++)
+    {
+        m_threads.push_back(std::thread(&TaskPool::Run, this));
+    }
+}
+
+TaskPool::~TaskPool(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); i++)
+    {
+        m_threads[i].join();
+    }
+}
+
+int TaskPool::GetWorkerCount() const
+{
+    return (int)m_threads.size();
+}
+
+int TaskPool::DefaultWorkerCount()
+{
+    // hardware_concurrency is 0 when it can't tell
+    int cores = (int)std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+void TaskPool::ForEach(int count, const std::function<void(int)>& job)
+{
+    if (count <= 0)
+        return;
+
+    // the indices are handed out from a counter rather than queued one by one, so a worker
+    // that wakes late just finds less to do
+    std::atomic<int> next(0);
+    std::function<void()> drain = [&]()
+    {
+        for (int i = next++; i < count; i = next++)
+        {
+            job(i);
+        }
+    };
+
+    // queued copies of drain that start after this returns would read next and left after
+    // they're gone, so every helper submitted is waited for, not just every index. The
+    // counter is on this call's stack, so its address is an owner no one else is using
+    int helpers = (int)m_threads.size() < count - 1 ? (int)m_threads.size() : count - 1;
+    std::atomic<int> helpersLeft(helpers);
+    for (int i = 0; i < helpers; i++)
+    {
+        Submit([&]()
+        {
+            drain();
+            helpersLeft--;
+        }, &next);
+    }
+    drain();
+
+    WaitUntil([&]() { return helpersLeft == 0; }, &next);
+}
+
+void TaskPool::Submit(const std::function<void()>& job, const void* owner)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        Job queued = { job, owner };
+        m_queue.push_back(queued);
+    }
+    m_wake.notify_one();
+
+    // the owner may be asleep in WaitUntil with nothing of its own to run until now
+    m_finished.notify_all();
+}
+
+bool TaskPool::RunOne(const void* owner)
+{
+    std::function<void()> job;
+    {
+        // only ever a few jobs queued, so finding the owner's is a short walk
+        std::lock_guard<std::mutex> lock(m_lock);
+        std::deque<Job>::iterator queued = m_queue.begin();
+        while (queued != m_queue.end() && queued->Owner != owner)
+            ++queued;
+        if (queued == m_queue.end())
+            return false;
+
+        job = std::move(queued->Work);
+        m_queue.erase(queued);
+    }
+
+    job();
+    Finished();
+    return true;
+}
+
+void TaskPool::WaitUntil(const std::function<bool()>& done, const void* owner)
+{
+    for (;;)
+    {
+        // help first; only sleep when there's nothing of ours left to take
+        if (done())
+            return;
+        if (RunOne(owner))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (done())
+            return;
+        if (!HasJob(owner))
+            m_finished.wait(lock);
+    }
+}
+
+bool TaskPool::HasJob(const void* owner) const
+{
+    for (std::deque<Job>::const_iterator queued = m_queue.begin(); queued != m_queue.end(); ++queued)
+    {
+        if (queued->Owner == owner)
+            return true;
+    }
+    return false;
+}
+
+void TaskPool::Finished()
+{
+    // taken so a waiter between checking done and sleeping can't miss the wakeup
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+    }
+    m_finished.notify_all();
+}
+
+void TaskPool::Run()
+{
+    Profiler::SetThreadName("TaskPool");
+
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            while (m_queue.empty() && !m_quit)
+                m_wake.wait(lock);
+            if (m_queue.empty())
+                return;
+
+            job = std::move(m_queue.front().Work);
+            m_queue.pop_front();
+        }
+
+        job();
+        Finished();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads that live as long as the pool, for work that used to start threads every
+// frame. Jobs go on one queue and any worker takes the next.
+//
+// Whoever waits on the pool helps, but only with its own jobs. Each job is queued under an
+// owner; workers take any job, while ForEach and FrameGraph::Run take only their own off the
+// queue on the calling thread while those are outstanding. So a pool with no workers still
+// gets everything done, just serially, and a caller never ends up running someone else's
+// job: the render thread waiting on its draw stages doesn't pick up a capture the frame
+// worker queued and lose the overlap. A job must not itself wait on the pool it runs on.
+class TaskPool
+{
+public:
+    // workerCount 0 or less runs everything on the callers
+    explicit TaskPool(int workerCount);
+    ~TaskPool(void);
+
+    int GetWorkerCount() const;
+
+    // the number of workers that, with the calling thread, gives one thread per core
+    static int DefaultWorkerCount();
+
+    // job(0) to job(count - 1), spread over the workers and the calling thread; returns once
+    // they have all finished
+    void ForEach(int count, const std::function<void(int)>& job);
+
+    // for FrameGraph: queue a job under owner, and run the oldest queued job of owner's on
+    // this thread, false if there was none
+    void Submit(const std::function<void()>& job, const void* owner);
+    bool RunOne(const void* owner);
+
+    // runs owner's queued jobs until done returns true, sleeping while there are none. done
+    // is checked again after every job that finishes anywhere
+    void WaitUntil(const std::function<bool()>& done, const void* owner);
+
+private:
+    TaskPool(const TaskPool&);
+    TaskPool& operator=(const TaskPool&);
+
+    struct Job
+    {
+        std::function<void()> Work;
+        const void* Owner;
+    };
+
+    void Run();
+    void Finished();
+    bool HasJob(const void* owner) const;     // with m_lock held
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock;
+    std::condition_variable m_wake;         // a job was queued, or the pool is closing
+    std::condition_variable m_finished;     // a job was queued or finished
+    std::deque<Job> m_queue;
+    bool m_quit;
+};
@@ -0,0 +1,172 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(void)
+{
+    Reset(0);
+}
+
+void TimerWheel::Reset(uint64_t now)
+{
+    m_timers.clear();
+    m_heads.assign(OverflowSlot + 1, -1);
+    m_free = -1;
+    m_count = 0;
+    m_now = now;
+}
+
+uint64_t TimerWheel::GetNow() const
+{
+    return m_now;
+}
+
+void TimerWheel::Reserve(int timers)
+{
+    m_timers.reserve(timers);
+}
+
+int TimerWheel::Schedule(uint64_t due, int item)
+{
+    int timer = m_free;
+    if (timer >= 0)
+    {
+        m_free = m_timers[timer].Next;
+    }
+    else
+    {
+        timer = (int)m_timers.size();
+        m_timers.push_back(Timer());
+    }
+
+    m_timers[timer].Due = due > m_now ? due : m_now + 1;
+    m_timers[timer].Item = item;
+    Link(timer);
+    m_count++;
+
+    return timer;
+}
+
+void TimerWheel::Cancel(int timer)
+{
+    if (timer < 0 || timer >= (int)m_timers.size() || m_timers[timer].Slot < 0)
+        return;
+
+    Unlink(timer);
+    m_timers[timer].Next = m_free;
+    m_free = timer;
+    m_count--;
+}
+
+int TimerWheel::GetItem(int timer) const
+{
+    return m_timers[timer].Item;
+}
+
+void TimerWheel::SetItem(int timer, int item)
+{
+    m_timers[timer].Item = item;
+}
+
+uint64_t TimerWheel::GetDue(int timer) const
+{
+    return m_timers[timer].Due;
+}
+
+int TimerWheel::GetCount() const
+{
+    return m_count;
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<int>* fired)
+{
+    while (m_now < now)
+    {
+        // nothing to step through
+        if (m_count == 0)
+        {
+            m_now = now;
+            return;
+        }
+
+        uint64_t tick = ++m_now;
+
+        // a tick that ends a level 1 slot's span may end the spans above it too; the highest
+        // empties first, so what it drops in to the levels below moves on down with them
+        if ((tick & (Slots - 1)) == 0)
+        {
+            int top = 1;
+            while (top < Levels - 1 && ((tick >> (SlotBits * top)) & (Slots - 1)) == 0)
+                top++;
+
+            if (top == Levels - 1 && ((tick >> (SlotBits * top)) & (Slots - 1)) == 0)
+                Cascade(OverflowSlot);
+            for (int level = top; level >= 1; level--)
+                Cascade(level * Slots + (int)((tick >> (SlotBits * level)) & (Slots - 1)));
+        }
+
+        int slot = (int)(tick & (Slots - 1));
+        int timer = m_heads[slot];
+        m_heads[slot] = -1;
+        while (timer >= 0)
+        {
+            Timer& due = m_timers[timer];
+            int next = due.Next;
+            fired->push_back(due.Item);
+
+            due.Slot = -1;
+            due.Next = m_free;
+            m_free = timer;
+            m_count--;
+            timer = next;
+        }
+    }
+}
+
+int TimerWheel::SlotFor(uint64_t due) const
+{
+    // the lowest level where due and now only differ in that level's bits or below
+    for (int level = 0; level < Levels; level++)
+    {
+        int shift = SlotBits * (level + 1);
+        if ((due >> shift) == (m_now >> shift))
+            return level * Slots + (int)((due >> (SlotBits * level)) & (Slots - 1));
+    }
+
+    return OverflowSlot;
+}
+
+void TimerWheel::Link(int timer)
+{
+    Timer& linked = m_timers[timer];
+    linked.Slot = SlotFor(linked.Due);
+    linked.Previous = -1;
+    linked.Next = m_heads[linked.Slot];
+    if (linked.Next >= 0)
+        m_timers[linked.Next].Previous = timer;
+    m_heads[linked.Slot] = timer;
+}
+
+void TimerWheel::Unlink(int timer)
+{
+    Timer& unlinked = m_timers[timer];
+    if (unlinked.Previous >= 0)
+        m_timers[unlinked.Previous].Next = unlinked.Next;
+    else
+        m_heads[unlinked.Slot] = unlinked.Next;
+
+    if (unlinked.Next >= 0)
+        m_timers[unlinked.Next].Previous = unlinked.Previous;
+
+    unlinked.Slot = -1;
+}
+
+void TimerWheel::Cascade(int slot)
+{
+    int timer = m_heads[slot];
+    m_heads[slot] = -1;
+    while (timer >= 0)
+    {
+        int next = m_timers[timer].Next;
+        Link(timer);
+        timer = next;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+// Timers for many items at once, each due at a whole tick, where scheduling, cancelling and
+// firing a timer are all constant time however many are waiting.
+//
+// Four levels of 64 slots. A timer goes in the lowest level whose slots still tell its tick
+// apart from now: level 0 holds the next 64 ticks one to a slot, level 1 the next 64 * 64 in
+// slots of 64 ticks, and so on, with anything past 2^24 ticks on an overflow list. When the
+// wheel turns past the end of a slot's span at one level the slot above is emptied back in to
+// the levels below, so each timer moves at most once per level. Each slot is a doubly linked
+// list through the timer pool, which is how a timer comes out of the middle of one in O(1).
+class TimerWheel
+{
+public:
+    static const int SlotBits = 6;
+    static const int Slots = 1 << SlotBits;
+    static const int Levels = 4;
+
+    TimerWheel(void);
+    ~TimerWheel(void) {};
+
+    // drops every timer and sets the time
+    void Reset(uint64_t now);
+    uint64_t GetNow() const;
+
+    // makes room for this many timers at once, so Schedule won't allocate until there are more
+    void Reserve(int timers);
+
+    // returns the timer. One due now or earlier fires at the next Advance
+    int Schedule(uint64_t due, int item);
+    void Cancel(int timer);
+
+    int GetItem(int timer) const;
+    void SetItem(int timer, int item);      // for when items are renumbered
+    uint64_t GetDue(int timer) const;
+    int GetCount() const;                   // timers waiting
+
+    // turns the wheel to now, appending the item of every timer due by then to fired, earliest
+    // tick first. Fired timers are freed, and their numbers reused by later Schedules
+    void Advance(uint64_t now, std::vector<int>* fired);
+
+private:
+    static const int OverflowSlot = Levels * Slots;
+
+    struct Timer
+    {
+        uint64_t Due;
+        int Item;
+        int Slot;                           // -1 while free
+        int Previous;
+        int Next;                           // the free list, while free
+    };
+
+    int SlotFor(uint64_t due) const;
+    void Link(int timer);
+    void Unlink(int timer);
+    void Cascade(int slot);
+
+    std::vector<Timer> m_timers;
+    std::vector<int> m_heads;               // first timer in each slot, overflow last
+    int m_free;
+    int m_count;
+    uint64_t m_now;
+};
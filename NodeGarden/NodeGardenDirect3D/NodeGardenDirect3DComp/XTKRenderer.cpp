@@ -6,11 +6,42 @@ using namespace Microsoft::WRL;
 using namespace Windows::Foundation;
 using namespace Windows::UI::Core;
 
+static const wchar_t* NodeTextureFile = L"node.DDS";
+static Platform::String^ HeatmapShaderFile = "HeatmapPixelShader.cso";
+
+// frames between sorting the nodes back in to spatial order; a sort costs about as much as
+// a few hundred nodes' worth of connection pass, so every couple of seconds is plenty
+static const int NodeReorderInterval = 120;
 
 XTKRenderer::XTKRenderer()
 {
     srand((unsigned)time(0));
+    m_garden.SetSeed((uint32_t)time(0));
+    m_garden.SetReorderInterval(NodeReorderInterval);
+    m_myNodeColor = Colors::White;
     m_isLoaded = false;
+    m_gardenSize = Size(0, 0);
+    m_cullStats.Reset();
+    m_captureRequest = CaptureRequest_None;
+    m_captureFormat = CaptureFormat_Png;
+    m_phaseTimer = ref new BasicTimer();
+    m_simTimer = ref new BasicTimer();
+    m_framesSimulated = 0;
+    m_pipelineRequested = false;
+    m_pipelining = false;
+    m_stepTotal = 0;
+    m_stepDelta = 0;
+    m_drawHeatmap = false;
+    m_taskPool = std::unique_ptr<TaskPool>(new TaskPool(TaskPool::DefaultWorkerCount()));
+    CreateFrameGraphs();
+    m_hudVisible = false;
+    m_lodEnabled = false;
+    m_heatmapEnabled = false;
+    m_heatmapShaderReady = false;
+    m_heatmapColumns = 0;
+    m_heatmapRows = 0;
+    memset(&m_frameSample, 0, sizeof(m_frameSample));
+    m_droppedUpdates = 0;
 }
 
 void XTKRenderer::CreateDeviceResources()
@@ -18,42 +49,11 @@ void XTKRenderer::CreateDeviceResources()
     Direct3DBase::CreateDeviceResources();
 
     m_pSpriteBatch = std::unique_ptr<SpriteBatch>(new SpriteBatch(m_d3dContext.Get()));
-}
-
-void XTKRenderer::ChangeNodeAmount(int newAmount)
-{
-    NodeNum = newAmount;
-    LineNum = (((NodeNum)*((NodeNum)-1))/2);
 
-    m_nodes.resize(NodeNum);
-    m_lines.resize(LineNum);
-
-    for (int i = 1; i < NodeNum; i++)
-    {
-        m_nodes[i] = new ShadowNode(XMFLOAT2(m_renderTargetSize.Width, m_renderTargetSize.Height));
-    }
-    
-    for (int i = 0; i < LineNum; i++)
-    {
-        m_lines[i] = new LineConnection();
-    }
-
-    m_isLoaded = true;
-}
-
-Windows::Foundation::Point XTKRenderer::CreateMyNode()
-{
-    m_nodes.clear();
-    m_nodes.push_back(new MyNode(XMFLOAT2(m_renderTargetSize.Width, m_renderTargetSize.Height)));
-
-    return GetMyNodePosition();
-}
-
-void XTKRenderer::CreateWindowSizeDependentResources()
-{
-    Direct3DBase::CreateWindowSizeDependentResources();
-
-    CreateDDSTextureFromFile(m_d3dDevice.Get(), L"node.DDS", nullptr, &m_pTexture );
+    // textures and states only depend on the device, so they're created once here and
+    // render resolution changes only rebuild the targets in Direct3DBase
+    m_pResourceCache = std::unique_ptr<ResourceCache>(new ResourceCache(m_d3dDevice.Get()));
+    m_pResourceCache->LoadTextureAsync(NodeTextureFile);
 
     // blend state description - alpha blend
     D3D11_BLEND_DESC bDesc;
@@ -70,74 +70,200 @@ void XTKRenderer::CreateWindowSizeDependentResources()
     bDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
     bDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL ;
 
-    m_d3dDevice->CreateBlendState( &bDesc, &m_pBlendState );           // create a  new blend state
+    m_pBlendState = m_pResourceCache->GetBlendState(bDesc);
+
+    m_hud.CreateDeviceResources(m_d3dDevice.Get());
+
+    // the heatmap's levels texture is made the first time it's drawn, at the size it's built
+    m_heatmapTexture = nullptr;
+    m_heatmapView = nullptr;
+    m_heatmapShaderReady = false;
+    DX::ReadDataAsync(HeatmapShaderFile).then([this](Platform::Array<byte>^ data)
+    {
+        DX::ThrowIfFailed(
+            m_d3dDevice->CreatePixelShader(data->Data, data->Length, nullptr, &m_heatmapShader)
+            );
+        m_heatmapShaderReady = true;
+    });
+
+    D3D11_SUBRESOURCE_DATA paletteData = { Heatmap::GetPalette(), Heatmap::PaletteSize * sizeof(uint32_t), 0 };
+    CD3D11_TEXTURE2D_DESC paletteDesc(DXGI_FORMAT_R8G8B8A8_UNORM, Heatmap::PaletteSize, 1, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+    ComPtr<ID3D11Texture2D> palette;
+    DX::ThrowIfFailed(
+        m_d3dDevice->CreateTexture2D(&paletteDesc, &paletteData, &palette)
+        );
+    DX::ThrowIfFailed(
+        m_d3dDevice->CreateShaderResourceView(palette.Get(), nullptr, &m_heatmapPalette)
+        );
+
+    // one palette entry per level, never blended with the next
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+    DX::ThrowIfFailed(
+        m_d3dDevice->CreateSamplerState(&samplerDesc, &m_heatmapPaletteSampler)
+        );
+}
+
+int XTKRenderer::ApplyEvent(GardenEvent& event)
+{
+    int result = GardenRecording::Apply(m_garden, event);
+    m_recorder.Record(event);
+
+    return result;
+}
+
+int XTKRenderer::ApplyEvent(GardenEventType type, int id, float x, float y)
+{
+    GardenEvent event = { type, id, x, y, 0 };
+    return ApplyEvent(event);
+}
+
+void XTKRenderer::ChangeNodeAmount(int newAmount)
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_NodeCount, newAmount, 0, 0);
+
+    m_isLoaded = true;
+}
+
+Windows::Foundation::Point XTKRenderer::CreateMyNode()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_gardenLock);
+        ApplyEvent(GardenEvent_MyNode, 0, 0, 0);
+    }
+
+    // from rand rather than the garden's generator, so colours don't affect replays
+    m_myNodeColor.f[0] = ((float)rand() / RAND_MAX) * 0.5f + 0.5f;
+    m_myNodeColor.f[1] = ((float)rand() / RAND_MAX) * 0.5f + 0.5f;
+    m_myNodeColor.f[2] = ((float)rand() / RAND_MAX) * 0.5f + 0.5f;
+    m_myNodeColor.f[3] = 1.0f;
+
+    return GetMyNodePosition();
 }
 
 void XTKRenderer::OnPointerPressed(Windows::Phone::Input::Interop::DrawingSurfaceManipulationHost^ sender, Windows::UI::Core::PointerEventArgs^ args)
 {
-    m_nodes[0]->OnPointerPressed(XMFLOAT2(args->CurrentPoint->Position.X, args->CurrentPoint->Position.Y));
+    PROFILE_SCOPE("Input");
+    ALLOCATION_PHASE("Input");
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_PointerPressed, 0, args->CurrentPoint->Position.X, args->CurrentPoint->Position.Y);
 }
 
 void XTKRenderer::OnPointerMoved(Windows::Phone::Input::Interop::DrawingSurfaceManipulationHost^ sender, Windows::UI::Core::PointerEventArgs^ args)
 {
-    m_nodes[0]->OnPointerMoved(XMFLOAT2(args->CurrentPoint->Position.X, args->CurrentPoint->Position.Y));
+    PROFILE_SCOPE("Input");
+    ALLOCATION_PHASE("Input");
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_PointerMoved, 0, args->CurrentPoint->Position.X, args->CurrentPoint->Position.Y);
 }
 
 void XTKRenderer::OnPointerReleased(Windows::Phone::Input::Interop::DrawingSurfaceManipulationHost^ sender, Windows::UI::Core::PointerEventArgs^ args)
 {
-    m_nodes[0]->OnPointerReleased();
+    PROFILE_SCOPE("Input");
+    ALLOCATION_PHASE("Input");
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_PointerReleased, 0, 0, 0);
 }
 
 Windows::Foundation::Point XTKRenderer::GetMyNodePosition()
 {
-    XMFLOAT2 pos = m_nodes[0]->GetPositionF();
-    return Windows::Foundation::Point(pos.x, pos.y);
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    const GardenNode& myNode = m_garden.GetNodes()[0];
+    return Windows::Foundation::Point(myNode.X, myNode.Y);
 }
 
-float Distance(const XMVECTOR& vector1,const XMVECTOR& vector2)
+void XTKRenderer::Update(float timeTotal, float timeDelta)
 {
-    XMVECTOR vectorSub = XMVectorSubtract(vector1,vector2);
-    XMVECTOR length = XMVector3Length(vectorSub);
-
-    float distance = 0.0f;
-    XMStoreFloat(&distance,length);
-    return distance;
+    Simulate(timeTotal, timeDelta);
+    m_frames.Swap();
 }
 
-void XTKRenderer::Update(float timeTotal, float timeDelta)
+void XTKRenderer::BeginUpdate(float timeTotal, float timeDelta)
 {
-    int currentLine = 0;
-    for (int i = 0; i < NodeNum; i++)
+    m_pipelining = m_pipelineRequested;
+    if (!m_pipelining)
     {
-        m_nodes[i]->Update(timeTotal, timeDelta);
-        
-        float distance, connectedness;
-        for (int j = i + 1; j != NodeNum; ++j)
-        {
-            // calculate the distance between each 2 nodes
-            distance = Distance(m_nodes[i]->GetPosition(), m_nodes[j]->GetPosition());
+        Update(timeTotal, timeDelta);
+        return;
+    }
 
-            // if distance is within the threshold
-            if (distance < MinDist)
-            {
-                // add a mapped value between 1-0 to each node's connectedness value
-                connectedness = Node::Map(distance, 0, MinDist, 1, 0);
-                m_nodes[i]->ApplyConnection(connectedness, m_nodes[j]);
-                m_nodes[j]->ApplyConnection(connectedness, m_nodes[i]);
+    if (!m_worker)
+        m_worker = std::unique_ptr<FrameWorker>(new FrameWorker());
+    m_worker->Start([this, timeTotal, timeDelta]()
+    {
+        Simulate(timeTotal, timeDelta);
+    });
+}
 
-                m_lines[currentLine]->FormConnection(m_nodes[i]->GetPosition(), m_nodes[j]->GetPosition(), distance);
-            }
-            else
-            {
-                m_lines[currentLine]->BreakConnection();
-            }
+void XTKRenderer::EndUpdate()
+{
+    if (!m_pipelining)
+        return;
 
-            // switch the currently used line in the pool
-            currentLine = (currentLine + 1) % LineNum;
-        }
+    // Render has finished with the front, and the worker with the back
+    m_worker->Wait();
+    m_frames.Swap();
+}
 
-        m_nodes[i]->FinishConnection();
-    }
+void XTKRenderer::Simulate(float timeTotal, float timeDelta)
+{
+    // held through the stages, wherever they run, so input waits for the whole step
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    m_stepTotal = timeTotal;
+    m_stepDelta = timeDelta;
+    m_framesSimulated++;
+    m_simGraph.Run(*m_taskPool);
+}
+
+void XTKRenderer::CreateFrameGraphs()
+{
+    int update = m_simGraph.AddStage("Update", [this]()
+    {
+        m_simTimer->Reset();
+        ApplyEvent(GardenEvent_Frame, 0, m_stepTotal, m_stepDelta);
+        m_simTimer->Update();
+    });
+
+    // both only read the garden
+    int capture = m_simGraph.AddStage("CaptureFrame", [this]()
+    {
+        FrameState& next = m_frames.Back();
+        next.Capture(m_garden, m_framesSimulated);
+        next.FrameTime = m_stepDelta;
+        next.SimTime = m_simTimer->Total;
+    });
+    int publish = m_simGraph.AddStage("StateExport", [this]()
+    {
+        if (m_stateExport.IsOpen())
+            m_stateExport.Publish(m_garden);
+    });
+    m_simGraph.AddDependency(capture, update);
+    m_simGraph.AddDependency(publish, update);
+
+    // both only read the front frame state, and each writes its own output
+    m_drawGraph.AddStage("BuildHeatmap", [this]()
+    {
+        if (!m_drawHeatmap)
+            return;
+
+        ALLOCATION_PHASE("BuildHeatmap");
+        const FrameState& frame = m_frames.Front();
+        m_heatmap.Build(frame.Nodes, frame.Edges, m_gardenSize.Width, m_gardenSize.Height);
+    });
+    m_drawGraph.AddStage("BuildLod", [this]()
+    {
+        if (!m_lodEnabled)
+            return;
+
+        // detail stays around the local node, or the middle of the garden without one
+        ALLOCATION_PHASE("BuildLod");
+        const FrameState& frame = m_frames.Front();
+        bool focusOnMe = frame.HasMyNode && !frame.Nodes.empty();
+        float focusX = focusOnMe ? frame.Nodes[0].X : m_gardenSize.Width / 2;
+        float focusY = focusOnMe ? frame.Nodes[0].Y : m_gardenSize.Height / 2;
+        m_lod.Build(frame.Nodes, frame.Edges, frame.HasMyNode, focusX, focusY);
+    });
 }
 
 // clear screen to light grey
@@ -145,107 +271,438 @@ const float bgColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };
 
 void XTKRenderer::Render()
 {
+    m_phaseTimer->Reset();
+
+    if (m_captureRequest != CaptureRequest_None)
+        ApplyCaptureRequest();
+
     m_d3dContext->ClearRenderTargetView(m_renderTargetView.Get(), bgColor);
     m_d3dContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), NULL);
 
+    // nothing to draw with until the background load has finished
+    ID3D11ShaderResourceView* texture = m_pResourceCache->GetTexture(NodeTextureFile);
+    if (texture == nullptr)
+        return;
+
+    // the front state is this thread's until EndUpdate, so none of the drawing takes the garden lock
+    std::lock_guard<std::mutex> drawLock(m_drawLock);
+
+    // nor anything to scale to the target until the garden has a size
+    if (m_gardenSize.Width <= 0 || m_gardenSize.Height <= 0)
+        return;
+
+    // scale garden coordinates to whatever size the render target currently is
+    XMMATRIX gardenToTarget = XMMatrixScaling(
+        m_renderTargetSize.Width / m_gardenSize.Width,
+        m_renderTargetSize.Height / m_gardenSize.Height,
+        1.0f);
+
+    const FrameState& frame = m_frames.Front();
+    m_drawHeatmap = m_heatmapEnabled && m_heatmapShaderReady;
+    m_drawGraph.Run(*m_taskPool);
+
+    // the heatmap goes under everything else, in a batch of its own for its shader
+    if (m_drawHeatmap)
+    {
+        PROFILE_SCOPE("DrawHeatmap");
+        DrawHeatmap(gardenToTarget);
+    }
+
     // begin the spritebatch using the alpha blend state
-    m_pSpriteBatch->Begin(SpriteSortMode_BackToFront, m_pBlendState.Get());
-    for (int i = 0; i < NodeNum; i++)
+    m_pSpriteBatch->Begin(SpriteSortMode_BackToFront, m_pBlendState.Get(), nullptr, nullptr, nullptr, nullptr, gardenToTarget);
+
+    // skip anything that can't touch the visible part of the garden. Remote nodes can sit
+    // anywhere in the shared space; culling only affects drawing, not the connection pass
+    CullRect visible(0, 0, m_gardenSize.Width, m_gardenSize.Height);
+    m_cullStats.Reset();
+
     {
-        m_nodes[i]->DrawSprites(m_pSpriteBatch.get(), m_pTexture.Get());
+        PROFILE_SCOPE("DrawSprites");
+        ALLOCATION_PHASE("DrawSprites");
+        const std::vector<GardenNode>* drawNodes = &frame.Nodes;
+        const std::vector<GardenEdge>* drawEdges = &frame.Edges;
+        int myNode = frame.HasMyNode ? 0 : -1;
+
+        if (m_lodEnabled)
+        {
+            drawNodes = &m_lod.GetNodes();
+            drawEdges = &m_lod.GetEdges();
+            myNode = m_lod.GetMyNodeIndex();
+        }
+
+        const std::vector<GardenNode>& nodes = *drawNodes;
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const GardenNode& node = nodes[i];
+            if (!visible.IntersectsCircle(node.X, node.Y, Garden::GetDrawRadius(node)))
+            {
+                m_cullStats.NodesCulled++;
+                continue;
+            }
+
+            // the local node is drawn on top in its own colour
+            bool isMyNode = (int)i == myNode;
+            m_nodeSprite.SetColor(isMyNode ? m_myNodeColor : Colors::White);
+            m_nodeSprite.SetDepth(isMyNode ? 0.0f : 0.1f);
+            m_nodeSprite.SetNode(node);
+            m_nodeSprite.DrawSprites(m_pSpriteBatch.get(), texture);
+            m_cullStats.NodesDrawn++;
+        }
+
+        // lines only exist for connected pairs, so one sprite is reused for all of them. The
+        // heatmap stands in for them while it's on
+        const std::vector<GardenEdge>& edges = *drawEdges;
+        size_t lineCount = m_drawHeatmap ? 0 : edges.size();
+        for (size_t i = 0; i < lineCount; i++)
+        {
+            const GardenNode& node1 = nodes[edges[i].First];
+            const GardenNode& node2 = nodes[edges[i].Second];
+            float opacity = node1.Opacity < node2.Opacity ? node1.Opacity : node2.Opacity;
+            m_lineSprite.FormConnection(XMVectorSet(node1.X, node1.Y, 0, 0), XMVectorSet(node2.X, node2.Y, 0, 0), edges[i].Distance, opacity);
+
+            if (!m_lineSprite.Intersects(visible))
+            {
+                m_cullStats.LinesCulled++;
+                continue;
+            }
+
+            m_lineSprite.DrawSprites(m_pSpriteBatch.get(), texture);
+            m_cullStats.LinesDrawn++;
+        }
     }
 
-    for (int i = 0; i < LineNum; i++)
     {
-        m_lines[i]->DrawSprites(m_pSpriteBatch.get(), m_pTexture.Get());
+        PROFILE_SCOPE("SpriteBatch::End");
+        ALLOCATION_PHASE("SpriteBatch::End");
+        m_pSpriteBatch->End();
     }
-    m_pSpriteBatch->End();
 
-}
+    // the update numbers are the drawn frame's, which is the last one simulated unless pipelined
+    m_phaseTimer->Update();
+    m_frameSample.FrameTime = frame.FrameTime;
+    m_frameSample.SimTime = frame.SimTime;
+    m_frameSample.Nodes = (uint32_t)frame.Nodes.size();
+    m_frameSample.PairsTested = frame.PairsTested;
+    m_frameSample.Connections = (uint32_t)frame.Edges.size();
+    m_frameSample.RenderTime = m_phaseTimer->Total;
+    m_frameSample.SpritesSubmitted = m_cullStats.NodesDrawn * NodeSprite::SpritesPerNode + m_cullStats.LinesDrawn;
+    m_metrics.AddFrame(m_frameSample);
+
+    if (m_metricsServer.IsRunning())
+    {
+        PROFILE_SCOPE("MetricsPublish");
+        MetricsServer::FromFrameMetrics(m_metrics, &m_metricsSnapshot);
+        m_metricsSnapshot.DroppedUpdates = m_droppedUpdates.load(std::memory_order_relaxed);
+        m_metricsServer.Publish(m_metricsSnapshot);
+    }
 
-XTKRenderer::~XTKRenderer()
-{
-    for (unsigned int i = 0; i < m_nodes.size(); i++)
+    if (m_frameCapture.IsCapturing())
     {
-        delete m_nodes[i];
-        m_nodes[i] = NULL;
+        m_frameCapture.CaptureFrame(m_d3dDevice.Get(), m_d3dContext.Get(), m_renderTarget.Get());
     }
-    m_nodes.clear();
 
-    for (unsigned int i = 0; i < m_lines.size(); i++)
+    // drawn after capture, in render target pixels rather than garden space
+    if (m_hudVisible)
     {
-        delete m_lines[i];
-        m_lines[i] = NULL;
+        m_pSpriteBatch->Begin(SpriteSortMode_Deferred, m_pBlendState.Get());
+        m_hud.Draw(m_pSpriteBatch.get(), m_metrics);
+        m_pSpriteBatch->End();
     }
-    m_lines.clear();
 }
 
-void XTKRenderer::UpdateNodePosition(int nodeId, float nodeX, float nodeY)
+void XTKRenderer::DrawHeatmap(CXMMATRIX gardenToTarget)
 {
-    for (int i = 1; i < m_nodes.size(); i++)
+    int columns = m_heatmap.GetColumns();
+    int rows = m_heatmap.GetRows();
+    if (!m_heatmapTexture || columns != m_heatmapColumns || rows != m_heatmapRows)
+    {
+        CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, columns, rows, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+        m_heatmapView = nullptr;
+        DX::ThrowIfFailed(
+            m_d3dDevice->CreateTexture2D(&desc, nullptr, &m_heatmapTexture)
+            );
+        DX::ThrowIfFailed(
+            m_d3dDevice->CreateShaderResourceView(m_heatmapTexture.Get(), nullptr, &m_heatmapView)
+            );
+        m_heatmapColumns = columns;
+        m_heatmapRows = rows;
+    }
+
+    // the level in every channel; the shader only reads red
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DX::ThrowIfFailed(
+        m_d3dContext->Map(m_heatmapTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)
+        );
+    const std::vector<uint8_t>& levels = m_heatmap.GetLevels();
+    for (int row = 0; row < rows; row++)
     {
-        if(m_nodes[i]->GetId() == nodeId)
+        uint32_t* texels = (uint32_t*)((uint8_t*)mapped.pData + row * mapped.RowPitch);
+        for (int column = 0; column < columns; column++)
         {
-            m_nodes[i]->SetPosition(nodeX, nodeY);
-            return;
+            texels[column] = levels[row * columns + column] * 0x01010101u;
         }
     }
+    m_d3dContext->Unmap(m_heatmapTexture.Get(), 0);
 
-    for (int i = 1; i < m_nodes.size(); i++)
+    // a texel per cell, scaled up to the cell size in garden units
+    m_pSpriteBatch->Begin(SpriteSortMode_Immediate, m_pBlendState.Get(), nullptr, nullptr, nullptr, [this]()
     {
-        if(m_nodes[i]->GetId() == -1)
+        ID3D11ShaderResourceView* palette = m_heatmapPalette.Get();
+        ID3D11SamplerState* sampler = m_heatmapPaletteSampler.Get();
+        m_d3dContext->PSSetShader(m_heatmapShader.Get(), nullptr, 0);
+        m_d3dContext->PSSetShaderResources(1, 1, &palette);
+        m_d3dContext->PSSetSamplers(1, 1, &sampler);
+    }, gardenToTarget);
+
+    float cellSize = m_heatmap.GetCellSize();
+    m_pSpriteBatch->Draw(m_heatmapView.Get(), XMFLOAT2(0, 0), nullptr, Colors::White, 0, XMFLOAT2(0, 0), XMFLOAT2(cellSize, cellSize));
+    m_pSpriteBatch->End();
+}
+
+void XTKRenderer::StartCapture(CaptureFormat format, const std::string& outputFolder)
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_captureFormat = format;
+    m_captureFolder = outputFolder;
+    m_captureRequest = CaptureRequest_Start;
+}
+
+void XTKRenderer::StopCapture()
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_captureRequest = CaptureRequest_Stop;
+}
+
+// on the render thread, which owns the context the staging textures are mapped on
+void XTKRenderer::ApplyCaptureRequest()
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    int request = m_captureRequest.exchange(CaptureRequest_None);
+    if (request == CaptureRequest_None)
+        return;
+
+    m_frameCapture.Stop(m_d3dContext.Get());
+    if (request == CaptureRequest_Start)
+        m_frameCapture.Start(m_captureFormat, m_captureFolder);
+}
+
+const FrameCaptureQueue& XTKRenderer::GetCaptureQueue()
+{
+    return m_frameCapture.GetQueue();
+}
+
+void XTKRenderer::SetHudVisible(bool visible)
+{
+    m_hudVisible = visible;
+}
+
+bool XTKRenderer::IsHudVisible()
+{
+    return m_hudVisible;
+}
+
+void XTKRenderer::SetPipelined(bool pipelined)
+{
+    m_pipelineRequested = pipelined;
+}
+
+bool XTKRenderer::IsPipelined()
+{
+    return m_pipelineRequested;
+}
+
+std::string XTKRenderer::GetStageTimes()
+{
+    // the graphs' timings are written on the threads running them
+    std::string text;
+    char line[96];
+    const FrameGraph* graphs[] = { &m_simGraph, &m_drawGraph };
+    std::lock_guard<std::mutex> gardenLock(m_gardenLock);
+    std::lock_guard<std::mutex> drawLock(m_drawLock);
+    for (int g = 0; g < 2; g++)
+    {
+        for (int i = 0; i < graphs[g]->GetStageCount(); i++)
         {
-            m_nodes[i]->SetId(nodeId);
-            m_nodes[i]->SetPosition(nodeX, nodeY);
-			return;
+            sprintf(line, "%s %.3f ms\n", graphs[g]->GetStageName(i), graphs[g]->GetStageTime(i));
+            text += line;
         }
     }
+    return text;
+}
 
-	CreateNode(nodeX, nodeY);
+void XTKRenderer::SetMaxDegree(int degree)
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_MaxDegree, degree, 0, 0);
 }
 
-bool XTKRenderer::IsLoaded()
+int XTKRenderer::GetMaxDegree()
 {
-    return m_isLoaded;
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_garden.GetMaxDegree();
 }
 
-int XTKRenderer::CreateNode(float nodeX, float nodeY)
+void XTKRenderer::SetDensityField(int aboveNodeCount, int cellsPerRadius)
 {
-	m_nodes.push_back(new ShadowNode(XMFLOAT2(m_renderTargetSize.Width, m_renderTargetSize.Height), XMFLOAT2(nodeX, nodeY)));
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_DensityField, aboveNodeCount, (float)cellsPerRadius, 0);
+}
 
-	int oldLineNum = LineNum;
-	NodeNum = m_nodes.size();
-    LineNum = (((NodeNum)*((NodeNum)-1))/2);
+int XTKRenderer::GetDensityFieldAbove()
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_garden.GetDensityFieldAbove();
+}
 
-	for (int i = 0; i < LineNum - oldLineNum; i++)
-	{
-		m_lines.push_back(new LineConnection());
-	}
+void XTKRenderer::SetNodeExpiry(float seconds)
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_NodeExpiry, 0, seconds, 0);
+}
 
-	return m_nodes[m_nodes.size() - 1]->SetUniqueId();
+float XTKRenderer::GetNodeExpiry()
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_garden.GetNodeExpiry();
+}
+
+void XTKRenderer::EnableLevelOfDetail(float detailRadius, float angle)
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_lod.SetDetailRadius(detailRadius);
+    m_lod.SetAngle(angle);
+    m_lodEnabled = true;
+}
+
+void XTKRenderer::DisableLevelOfDetail()
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_lodEnabled = false;
+}
+
+void XTKRenderer::EnableHeatmap(HeatmapSource source, float cellSize, int blurRadius)
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_heatmap.SetSource(source);
+    m_heatmap.SetCellSize(cellSize);
+    m_heatmap.SetBlurRadius(blurRadius);
+    m_heatmapEnabled = true;
+}
+
+void XTKRenderer::DisableHeatmap()
+{
+    std::lock_guard<std::mutex> lock(m_drawLock);
+    m_heatmapEnabled = false;
+}
+
+bool XTKRenderer::StartRecording(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_recorder.Start(path, m_garden);
+}
+
+void XTKRenderer::StopRecording()
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    m_recorder.Stop();
+}
+
+uint32_t XTKRenderer::GetRecordedFrames()
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_recorder.GetFrameCount();
+}
+
+bool XTKRenderer::StartStateExport(const std::string& name, uint32_t nodeCapacity, uint32_t edgeCapacity)
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    return m_stateExport.Create(name, nodeCapacity, edgeCapacity);
+}
+
+void XTKRenderer::StopStateExport()
+{
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    m_stateExport.Close();
+}
+
+bool XTKRenderer::StartMetricsServer(uint16_t port)
+{
+    return m_metricsServer.Start(port);
+}
+
+void XTKRenderer::StopMetricsServer()
+{
+    m_metricsServer.Stop();
+}
+
+uint16_t XTKRenderer::GetMetricsPort()
+{
+    return m_metricsServer.GetPort();
+}
+
+XTKRenderer::~XTKRenderer()
+{
+    if (m_worker)
+        m_worker->Wait();
+    m_frameCapture.Stop(m_d3dContext.Get());
+}
+
+void XTKRenderer::UpdateNodePosition(int nodeId, float nodeX, float nodeY)
+{
+    ALLOCATION_PHASE("Network");
+    m_metrics.AddNetworkUpdate();
+
+    // a NaN or infinity would spread through every distance it touches; x - x is only 0 for
+    // finite values
+    if (nodeX - nodeX != 0 || nodeY - nodeY != 0)
+    {
+        m_droppedUpdates.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_UpdateNode, nodeId, nodeX, nodeY);
+}
+
+void XTKRenderer::SetGardenSize(float width, float height)
+{
+    // Render divides by it; a surface that isn't laid out yet has no size to take
+    if (!(width > 0 && height > 0))
+        return;
+
+    {
+        std::lock_guard<std::mutex> drawLock(m_drawLock);
+        m_gardenSize.Width = width;
+        m_gardenSize.Height = height;
+    }
+
+    std::lock_guard<std::mutex> lock(m_gardenLock);
+    ApplyEvent(GardenEvent_Size, 0, width, height);
+}
+
+CullStats XTKRenderer::GetCullStats()
+{
+    return m_cullStats;
+}
+
+bool XTKRenderer::IsLoaded()
+{
+    return m_isLoaded;
+}
+
+int XTKRenderer::CreateNode(float nodeX, float nodeY)
+{
+	ALLOCATION_PHASE("Network");
+	std::lock_guard<std::mutex> lock(m_gardenLock);
+	return ApplyEvent(GardenEvent_AddNode, 0, nodeX, nodeY);
 }
 
 void XTKRenderer::RemoveNode(int nativeId)
 {
-	for (std::vector<ShadowNode*>::iterator it = m_nodes.begin(); it != m_nodes.end(); )
+	ALLOCATION_PHASE("Network");
+	std::lock_guard<std::mutex> lock(m_gardenLock);
+	if (ApplyEvent(GardenEvent_RemoveNode, nativeId, 0, 0) == 0)
 	{
-		if( (*it)->GetId() == nativeId )
-		{
-			if((*it)->GetId() == m_nodes[0]->GetId())
-				return;
-
-			delete * it;
-			it = m_nodes.erase(it);
-			int oldLineNum = LineNum;
-			NodeNum = m_nodes.size();
-			LineNum = (((NodeNum)*((NodeNum)-1))/2);
-			m_lines.resize(LineNum);
-		}
-		else 
-		{
-			++it;
-		}
+		m_droppedUpdates.fetch_add(1, std::memory_order_relaxed);
 	}
 }
-
-
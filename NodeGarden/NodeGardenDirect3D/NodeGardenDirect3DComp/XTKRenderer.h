@@ -5,14 +5,27 @@
 #include "Effects.h"
 #include "PrimitiveBatch.h"
 #include "VertexTypes.h"
-#include "ShadowNode.h"
-#include "MyNode.h"
+#include "Garden.h"
+#include "GardenRecording.h"
+#include "GardenExport.h"
+#include "GardenLod.h"
+#include "FrameState.h"
+#include "FrameGraph.h"
+#include "Heatmap.h"
+#include "MetricsServer.h"
+#include "NodeSprite.h"
 #include "LineConnection.h"
-#include "DDSTextureLoader.h"
+#include "CullRect.h"
+#include "ResourceCache.h"
+#include "FrameCapture.h"
+#include "FrameMetrics.h"
+#include "PerformanceHud.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "BasicTimer.h"
 #include <time.h>
-
-//#define NodeNum 50
-//#define LineNum (((NodeNum)*((NodeNum)-1))/2)
+#include <atomic>
+#include <mutex>
 
 using namespace DirectX;
 
@@ -30,36 +43,167 @@ public:
 
     // Direct3DBase methods.
     virtual void CreateDeviceResources(void) override;
-    virtual void CreateWindowSizeDependentResources(void) override;
     virtual void Render(void) override;
 	int CreateNode(float nodeX, float nodeY);
 	void RemoveNode(int nativeId);
 
-    // Method for updating time-dependent objects.
+    // Method for updating time-dependent objects. Update simulates a frame and hands it
+    // straight to Render. BeginUpdate and EndUpdate go either side of Render instead: with
+    // pipelining on, the next frame is simulated on a worker while Render draws the last one,
+    // a frame behind; with it off they're Update and nothing.
     void Update(float timeTotal, float timeDelta);
+    void BeginUpdate(float timeTotal, float timeDelta);
+    void EndUpdate();
 
     void ChangeNodeAmount(int newAmount);
     Windows::Foundation::Point GetMyNodePosition();
     Windows::Foundation::Point CreateMyNode();
     void UpdateNodePosition(int nodeId, float nodeX, float nodeY);
 
+    // Size of the coordinate space the garden is simulated in. The render target may be
+    // smaller or larger than this; rendering scales to fit so node positions don't move.
+    void SetGardenSize(float width, float height);
+
     bool IsLoaded();
 
+internal:
+    // what the last Render call drew and skipped
+    CullStats GetCullStats();
+
+    // record every rendered frame into outputFolder until StopCapture. Both only ask; the next
+    // Render starts or stops the capture, since only the render thread may use the context
+    void StartCapture(CaptureFormat format, const std::string& outputFolder);
+    void StopCapture();
+    const FrameCaptureQueue& GetCaptureQueue();
+
+    void SetHudVisible(bool visible);
+    bool IsHudVisible();
+
+    // simulate the next frame while drawing this one; takes effect from the next BeginUpdate
+    void SetPipelined(bool pipelined);
+    bool IsPipelined();
+
+    // "name ms" a line for every stage of the last update and draw, update first
+    std::string GetStageTimes();
+
+    // at most this many connections per node, 0 for no limit; see Garden::SetMaxDegree
+    void SetMaxDegree(int degree);
+    int GetMaxDegree();
+
+    // estimate connectedness instead of testing pairs past aboveNodeCount nodes, 0 for never;
+    // see Garden::SetDensityFieldAbove
+    void SetDensityField(int aboveNodeCount, int cellsPerRadius);
+    int GetDensityFieldAbove();
+
+    // fade out and remove remote nodes silent this long, 0 for never; see Garden::SetNodeExpiry
+    void SetNodeExpiry(float seconds);
+    float GetNodeExpiry();
+
+    // draw distant and crowded parts of the garden as super-nodes; see GardenLod
+    void EnableLevelOfDetail(float detailRadius, float angle);
+    void DisableLevelOfDetail();
+
+    // draw the connections as one blurred, colour mapped density pass instead of a line each;
+    // see Heatmap
+    void EnableHeatmap(HeatmapSource source, float cellSize, int blurRadius);
+    void DisableHeatmap();
+
+    // log everything that changes the garden from now on, for GardenReplay to re-run
+    bool StartRecording(const std::string& path);
+    void StopRecording();
+    uint32_t GetRecordedFrames();
+
+    // publish each frame's nodes and edges to a shared memory region other processes can read
+    bool StartStateExport(const std::string& name, uint32_t nodeCapacity, uint32_t edgeCapacity);
+    void StopStateExport();
+
+    // serve frame and network metrics at http://127.0.0.1:port/metrics; port 0 picks one
+    bool StartMetricsServer(uint16_t port);
+    void StopMetricsServer();
+    uint16_t GetMetricsPort();
+
 private:
+    // every change to the garden goes through here, with m_gardenLock held
+    int ApplyEvent(GardenEvent& event);
+    int ApplyEvent(GardenEventType type, int id, float x, float y);
+    void DrawHeatmap(CXMMATRIX gardenToTarget);
+    void ApplyCaptureRequest();
+
+    // one step of the garden, captured in to the back frame state. On the worker when pipelined
+    void Simulate(float timeTotal, float timeDelta);
+    void CreateFrameGraphs();
+
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_pTextureView;
     std::unique_ptr<SpriteBatch> m_pSpriteBatch;
     Microsoft::WRL::ComPtr<ID3D11BlendState> m_pBlendState;
-    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_pTexture;
+    std::unique_ptr<ResourceCache> m_pResourceCache;
 
     XMMATRIX m_world;
     XMMATRIX m_view; 
     XMMATRIX m_projection;
 
-    int NodeNum;
-    int LineNum;
+    Windows::Foundation::Size m_gardenSize;
+
+    Garden m_garden;
+    GardenRecorder m_recorder;
+    GardenExport m_stateExport;
+    GardenLod m_lod;
+    bool m_lodEnabled;
+
+    Heatmap m_heatmap;
+    bool m_heatmapEnabled;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_heatmapShader;
+    std::atomic<bool> m_heatmapShaderReady;     // set once the shader has loaded
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_heatmapPalette;
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> m_heatmapPaletteSampler;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_heatmapTexture;     // the levels, rewritten each frame
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_heatmapView;
+    int m_heatmapColumns;
+    int m_heatmapRows;
 
-    std::vector<ShadowNode*> m_nodes;
-    std::vector<LineConnection*> m_lines;
+    // input and network calls arrive on the UI thread while the render thread, or the worker,
+    // updates. Render only reads the front frame state, so it never takes this
+    std::mutex m_gardenLock;
+
+    // the LOD and heatmap settings, held through Render so they don't change mid frame
+    std::mutex m_drawLock;
+
+    FrameStateBuffer m_frames;
+    uint64_t m_framesSimulated;
+    std::atomic<bool> m_pipelineRequested;
+    bool m_pipelining;                          // whether this frame's BeginUpdate started the worker
+    BasicTimer^ m_simTimer;
+
+    // Simulate's stages: the update, then capturing it and publishing it side by side. Render's:
+    // the heatmap levels and the LOD build side by side, ahead of the device work
+    FrameGraph m_simGraph;
+    FrameGraph m_drawGraph;
+    float m_stepTotal;                          // Simulate's arguments, for its stages
+    float m_stepDelta;
+    bool m_drawHeatmap;                         // whether this frame's heatmap is built and drawn
+    NodeSprite m_nodeSprite;
+    LineConnection m_lineSprite;
+    XMVECTORF32 m_myNodeColor;
+
+    CullStats m_cullStats;
+    FrameCapture m_frameCapture;
+    enum CaptureRequest { CaptureRequest_None, CaptureRequest_Start, CaptureRequest_Stop };
+    std::atomic<int> m_captureRequest;          // the latest ask, for Render to act on
+    CaptureFormat m_captureFormat;              // for a start, under m_drawLock
+    std::string m_captureFolder;
+
+    FrameMetrics m_metrics;
+    FrameSample m_frameSample;
+    MetricsServer m_metricsServer;
+    MetricsSnapshot m_metricsSnapshot;
+    std::atomic<uint32_t> m_droppedUpdates;
+    BasicTimer^ m_phaseTimer;
+    PerformanceHud m_hud;
+    bool m_hudVisible;
 
     bool m_isLoaded;
+
+    // last, so they're gone before anything a job they're running could use
+    std::unique_ptr<TaskPool> m_taskPool;
+    std::unique_ptr<FrameWorker> m_worker;
 };
\ No newline at end of file